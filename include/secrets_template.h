@@ -6,5 +6,11 @@
 const char* WIFI_SSID = "your_wifi_ssid";
 const char* WIFI_PASS = "your_wifi_password";
 
-#endif
+// Required as &token=... by POST /control and /config; without it both
+// are refused
+// #define HTTP_TOKEN "long-random-string"
+
+// Required as &token=... by POST /update; OTA_ENABLED won't build without it
+// #define OTA_TOKEN "another-long-random-string"
 
+#endif
@@ -0,0 +1,131 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Just enough of the Arduino-ESP32 core for the firmware to run on Linux.
+// Time is virtual (see SimWorld.h): it only moves while the firmware waits.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <algorithm>
+#include <deque>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define SERIAL_8N1 0x800001c
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+
+using std::min;
+using std::max;
+
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolutionBits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+uint32_t ledcRead(uint8_t channel);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t print(unsigned int value) { return printf("%u", value); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+};
+
+// TX goes to the sim's log output; RX is whatever the world delivers
+class HardwareSerial : public Print {
+public:
+    HardwareSerial() : rxCapacity(256), rxOverflows(0) {}
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {
+        (void)baud, (void)config, (void)rxPin, (void)txPin;
+    }
+    void setRxBufferSize(size_t size) { rxCapacity = size; }
+    int available() { return (int)rx.size(); }
+    int read();
+    size_t read(uint8_t* buffer, size_t size);
+    void flush();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    // Simulator side: bytes arriving on the RX line
+    void receive(const uint8_t* data, size_t size);
+    uint32_t getRxOverflows() const { return rxOverflows; }
+
+private:
+    std::deque<uint8_t> rx;
+    size_t rxCapacity;
+    uint32_t rxOverflows;
+};
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+class IPAddress {
+public:
+    IPAddress() : addr(0) {}
+    IPAddress(uint32_t raw) : addr(raw) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : addr((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    operator uint32_t() const { return addr; }
+    uint8_t operator[](int index) const { return (uint8_t)(addr >> (8 * index)); }
+
+private:
+    uint32_t addr;  // First octet in the low byte, as on the ESP32
+};
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 240 * 1024; }
+    uint32_t getCycleCount();  // Host nanoseconds, not CPU cycles
+    uint64_t getEfuseMac() { return 0x0000C0FFEE5151ULL; }
+    [[noreturn]] void restart();
+};
+extern EspClass ESP;
+
+// The sketch, from src/main.cpp
+void setup();
+void loop();
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,20 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS kept in memory for the length of the run
+class Preferences {
+public:
+    Preferences() : ns(nullptr), readOnly(false) {}
+    bool begin(const char* name, bool readOnly = false);
+    void end() { ns = nullptr; }
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+    const char* ns;
+    bool readOnly;
+};
+
+#endif // SIM_PREFERENCES_H
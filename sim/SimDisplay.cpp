@@ -0,0 +1,269 @@
+#include "TFT_eSPI.h"
+#include <driver/ledc.h>
+
+static const uint8_t ST7789_PTLON = 0x12;
+static const uint8_t ST7789_NORON = 0x13;
+static const uint8_t ST7789_PTLAR = 0x30;
+static const uint8_t ST7789_VSCSAD = 0x37;
+static const uint8_t ST7789_IDMOFF = 0x38;
+static const uint8_t ST7789_IDMON = 0x39;
+
+static uint32_t readBe32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint16_t blend(uint8_t alpha, uint16_t fg, uint16_t bg) {
+    uint32_t a = alpha + (alpha >> 7);  // 0..256
+    uint32_t r = (((fg >> 11) & 0x1F) * a + ((bg >> 11) & 0x1F) * (256 - a)) >> 8;
+    uint32_t g = (((fg >> 5) & 0x3F) * a + ((bg >> 5) & 0x3F) * (256 - a)) >> 8;
+    uint32_t b = ((fg & 0x1F) * a + (bg & 0x1F) * (256 - a)) >> 8;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+TFT_eSPI::TFT_eSPI(int16_t width, int16_t height)
+    : w(0), h(0), written(0), clipX0(0), clipY0(0), clipX1(0), clipY1(0), command(0),
+      paramCount(0), scrollStart(0), partial(false), partialFirst(0), partialLast(0), idle(false),
+      modeSwitches(0), litSwitches(0), fontLoaded(false), maxAscent(0), maxDescent(0), spaceWidth(0),
+      datum(TL_DATUM), textFg(TFT_WHITE), textBg(TFT_BLACK), padding(0) {
+    resize(width, height);
+}
+
+void TFT_eSPI::resize(int16_t nw, int16_t nh) {
+    w = nw;
+    h = nh;
+    buffer.assign((size_t)nw * nh, 0);
+    resetViewport();
+}
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t vw, int32_t vh, bool vpDatum) {
+    (void)vpDatum;
+    clipX0 = std::max<int32_t>(x, 0);
+    clipY0 = std::max<int32_t>(y, 0);
+    clipX1 = std::min<int32_t>(x + vw, w);
+    clipY1 = std::min<int32_t>(y + vh, h);
+}
+
+// Counted when it changes what is shown
+static void modeSwitch(bool changed, uint32_t& switches, uint32_t& lit) {
+    if (!changed) {
+        return;
+    }
+    switches++;
+    if (ledc_get_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0) != 0) {
+        lit++;
+    }
+}
+
+void TFT_eSPI::writecommand(uint8_t c) {
+    command = c;
+    paramCount = 0;
+    if (c == ST7789_PTLON || c == ST7789_NORON) {
+        modeSwitch(partial != (c == ST7789_PTLON), modeSwitches, litSwitches);
+        partial = c == ST7789_PTLON;
+    } else if (c == ST7789_IDMON || c == ST7789_IDMOFF) {
+        modeSwitch(idle != (c == ST7789_IDMON), modeSwitches, litSwitches);
+        idle = c == ST7789_IDMON;
+    }
+}
+
+void TFT_eSPI::writedata(uint8_t d) {
+    if (paramCount >= sizeof(params)) {
+        return;
+    }
+    params[paramCount++] = d;
+    if (command == ST7789_VSCSAD && paramCount == 2) {
+        scrollStart = (uint16_t)((params[0] << 8) | params[1]);
+    } else if (command == ST7789_PTLAR && paramCount == 4) {
+        uint16_t first = (uint16_t)((params[0] << 8) | params[1]);
+        uint16_t last = (uint16_t)((params[2] << 8) | params[3]);
+        modeSwitch(partial && (first != partialFirst || last != partialLast), modeSwitches, litSwitches);
+        partialFirst = first;
+        partialLast = last;
+    }
+}
+
+uint16_t TFT_eSPI::shownPixel(int16_t x, int16_t y) const {
+    // The long side is the panel's gate (scroll) direction; partial mode
+    // leaves the lines outside its area black
+    int16_t line = w > h ? x : y;
+    if (partial && (line < partialFirst || line > partialLast)) {
+        return 0;
+    }
+    if (w > h) {
+        x = (int16_t)((x + scrollStart) % w);
+    } else {
+        y = (int16_t)((y + scrollStart) % h);
+    }
+    uint16_t c = buffer[(size_t)y * w + x];
+    if (idle) {
+        // 8 colors: each channel's top bit, at full scale
+        c = (uint16_t)(((c & 0x8000) ? 0xF800 : 0) | ((c & 0x0400) ? 0x07E0 : 0) | ((c & 0x0010) ? 0x001F : 0));
+    }
+    return c;
+}
+
+void TFT_eSPI::setRotation(uint8_t r) {
+    // Landscape for odd rotations; the contents are not carried over
+    int16_t shortSide = std::min(w, h);
+    int16_t longSide = std::max(w, h);
+    if (r & 1) {
+        resize(longSide, shortSide);
+    } else {
+        resize(shortSide, longSide);
+    }
+}
+
+uint32_t TFT_eSPI::takeWritten() {
+    uint32_t n = written;
+    written = 0;
+    return n;
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color) {
+    int32_t x0 = std::max<int32_t>(x, clipX0);
+    int32_t y0 = std::max<int32_t>(y, clipY0);
+    int32_t x1 = std::min<int32_t>(x + rw, clipX1);
+    int32_t y1 = std::min<int32_t>(y + rh, clipY1);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    for (int32_t row = y0; row < y1; row++) {
+        std::fill(&buffer[(size_t)row * w + x0], &buffer[(size_t)row * w + x1], (uint16_t)color);
+    }
+    written += (uint32_t)((x1 - x0) * (y1 - y0));
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t iw, int32_t ih, const uint16_t* data) {
+    for (int32_t row = 0; row < ih; row++) {
+        for (int32_t col = 0; col < iw; col++) {
+            int32_t px = x + col;
+            int32_t py = y + row;
+            if (px >= clipX0 && px < clipX1 && py >= clipY0 && py < clipY1) {
+                buffer[(size_t)py * w + px] = data[(size_t)row * iw + col];
+                written++;
+            }
+        }
+    }
+}
+
+void TFT_eSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+    // One span per row, the same shape BinaryClockDisplay counts
+    for (int32_t dy = -r; dy <= r; dy++) {
+        int32_t half = 0;
+        while ((half + 1) * (half + 1) + dy * dy <= r * r) {
+            half++;
+        }
+        fillRect(x - half, y + dy, 2 * half + 1, 1, color);
+    }
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    fillRect(x, y, 1, 1, color);
+}
+
+void TFT_eSPI::loadFont(const uint8_t* vlw) {
+    // VLW: 6 big-endian words of header, 7 words per glyph, then the
+    // 8-bit alpha bitmaps in glyph order
+    uint32_t count = readBe32(vlw);
+    const uint8_t* meta = vlw + 24;
+    const uint8_t* bitmap = meta + count * 28;
+
+    glyphs.clear();
+    maxAscent = 0;
+    maxDescent = 0;
+    for (uint32_t i = 0; i < count; i++, meta += 28) {
+        Glyph g;
+        g.code = readBe32(meta);
+        g.height = (int16_t)readBe32(meta + 4);
+        g.width = (int16_t)readBe32(meta + 8);
+        g.advance = (int16_t)readBe32(meta + 12);
+        g.dy = (int16_t)(int32_t)readBe32(meta + 16);
+        g.dx = (int16_t)(int32_t)readBe32(meta + 20);
+        g.bitmap = bitmap;
+        bitmap += (size_t)g.width * g.height;
+        glyphs.push_back(g);
+
+        // Same metric rules as TFT_eSPI: printable ASCII except '_'
+        if (g.code > 0x20 && g.code < 0xA0 && g.code != 0x5F) {
+            maxAscent = std::max(maxAscent, g.dy);
+            maxDescent = std::max<int16_t>(maxDescent, (int16_t)(g.height - g.dy));
+        }
+    }
+    spaceWidth = (int16_t)(readBe32(vlw + 8) * 2 / 7);
+    fontLoaded = true;
+}
+
+const TFT_eSPI::Glyph* TFT_eSPI::glyph(uint32_t code) const {
+    for (const Glyph& g : glyphs) {
+        if (g.code == code) {
+            return &g;
+        }
+    }
+    return nullptr;
+}
+
+int16_t TFT_eSPI::textWidth(const char* text) {
+    int16_t width = 0;
+    for (const char* p = text; *p; p++) {
+        const Glyph* g = glyph((uint8_t)*p);
+        width += g ? g->advance : spaceWidth;
+    }
+    return width;
+}
+
+int16_t TFT_eSPI::drawString(const char* text, int32_t x, int32_t y) {
+    int16_t width = textWidth(text);
+    int16_t height = fontHeight();
+
+    // Datum: 0-2 top, 3-5 middle, 6-8 bottom; left, centre, right
+    uint8_t col = datum % 3;
+    uint8_t row = datum / 3;
+    x -= col == 1 ? width / 2 : (col == 2 ? width : 0);
+    y -= row == 1 ? height / 2 : (row == 2 ? height : 0);
+
+    if (padding > width) {
+        int16_t extra = (int16_t)(padding - width);
+        int16_t left = col == 1 ? extra / 2 : (col == 2 ? extra : 0);
+        fillRect(x - left, y, left, height, textBg);
+        fillRect(x + width, y, extra - left, height, textBg);
+    }
+
+    int32_t cursor = x;
+    for (const char* p = text; *p; p++) {
+        const Glyph* g = glyph((uint8_t)*p);
+        int16_t advance = g ? g->advance : spaceWidth;
+        if (textBg != textFg) {
+            fillRect(cursor, y, advance, height, textBg);
+        }
+        if (g) {
+            int32_t top = y + maxAscent - g->dy;
+            for (int16_t gy = 0; gy < g->height; gy++) {
+                for (int16_t gx = 0; gx < g->width; gx++) {
+                    uint8_t alpha = g->bitmap[gy * g->width + gx];
+                    int32_t px = cursor + g->dx + gx;
+                    int32_t py = top + gy;
+                    if (alpha == 0 || px < clipX0 || py < clipY0 || px >= clipX1 || py >= clipY1) {
+                        continue;
+                    }
+                    uint16_t& dst = buffer[(size_t)py * w + px];
+                    dst = blend(alpha, textFg, textBg != textFg ? textBg : dst);
+                    written++;
+                }
+            }
+        }
+        cursor += advance;
+    }
+    return width;
+}
+
+void* TFT_eSprite::createSprite(int16_t sw, int16_t sh, uint8_t frames) {
+    (void)frames;
+    resize(sw, sh);
+    created = true;
+    return buffer.data();
+}
+
+void TFT_eSprite::deleteSprite() {
+    resize(0, 0);
+    created = false;
+}
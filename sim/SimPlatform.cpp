@@ -0,0 +1,481 @@
+// Arduino core, ESP-IDF and FreeRTOS calls the firmware makes, answered
+// from SimWorld. Only the loop task exists; every wait moves virtual time.
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <esp_ota_ops.h>
+#include <driver/ledc.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#include <lwip/dns.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <map>
+#include <string>
+#include "SimWorld.h"
+
+extern "C" int __real_clock_gettime(clockid_t clock, struct timespec* ts);
+extern "C" ssize_t __real_sendto(int sock, const void* buf, size_t len, int flags,
+                                 const struct sockaddr* to, socklen_t toLen);
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+EspClass ESP;
+WiFiClass WiFi;
+
+FILE* simSerialOut = stdout;
+
+// ==================== TIME ====================
+unsigned long millis() {
+    return (uint32_t)(world.nowUs() / 1000);  // Wraps like the 32-bit original
+}
+
+unsigned long micros() {
+    return (uint32_t)world.nowUs();
+}
+
+void delay(unsigned long ms) {
+    world.advanceTo(world.nowUs() + (int64_t)ms * 1000);
+}
+
+int64_t esp_timer_get_time() {
+    return world.nowUs();
+}
+
+uint32_t EspClass::getCycleCount() {
+    struct timespec ts;
+    __real_clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+void EspClass::restart() {
+    fflush(simSerialOut);
+    fprintf(stderr, "sim: firmware restarted itself at t=%.3f s, stopping\n", world.nowUs() / 1e6);
+    exit(3);
+}
+
+// ==================== TASKS ====================
+static struct SimTask {
+    int unused;
+} loopTask;
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return &loopTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    if (world.pendingNotifications() == 0) {
+        world.sleep(ticksToWait == portMAX_DELAY ? INT64_MAX / 2 : (int64_t)ticksToWait * 1000);
+    }
+    return world.takeNotifications(clearOnExit != pdFALSE);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+    world.notify();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*code)(void*), const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core) {
+    // Never started; see SimWorld::setWaitHook
+    (void)code, (void)name, (void)stackDepth, (void)param, (void)priority, (void)core;
+    if (created) {
+        *created = nullptr;
+    }
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+// ==================== TIMERS ====================
+static SimWorld::Timer* asTimer(esp_timer_handle_t handle) {
+    return reinterpret_cast<SimWorld::Timer*>(handle);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    *out = reinterpret_cast<esp_timer_handle_t>(world.createTimer(args->callback, args->arg));
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+    if (asTimer(timer)->armed) {
+        return ESP_FAIL;  // ESP_ERR_INVALID_STATE
+    }
+    world.startTimer(asTimer(timer), timeoutUs, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs) {
+    if (asTimer(timer)->armed) {
+        return ESP_FAIL;
+    }
+    world.startTimer(asTimer(timer), periodUs, periodUs);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!asTimer(timer)->armed) {
+        return ESP_FAIL;
+    }
+    world.stopTimer(asTimer(timer));
+    return ESP_OK;
+}
+
+// ==================== GPIO ====================
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin, (void)mode;
+}
+
+int digitalRead(uint8_t pin) {
+    return world.pin(pin) ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    world.setPin(pin, value != LOW);
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+    world.attachInterrupt(pin, handler, arg, mode);
+}
+
+void detachInterrupt(uint8_t pin) {
+    world.attachInterrupt(pin, nullptr, nullptr, 0);
+}
+
+uint32_t simReadRegister(uint32_t address) {
+    if (address == GPIO_IN_REG) {
+        return (uint32_t)world.pinWord();
+    }
+    if (address == GPIO_IN1_REG) {
+        return (uint32_t)(world.pinWord() >> 32);
+    }
+    return 0;
+}
+
+// ==================== BACKLIGHT ====================
+// One channel is all the firmware uses; a fade is a straight line in time
+static struct {
+    uint32_t duty;
+    uint32_t fromDuty;
+    int64_t fadeStartUs;
+    int64_t fadeEndUs;
+    uint32_t generation;
+    ledc_cb_t callback;
+    void* callbackArg;
+} backlight;
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolutionBits) {
+    (void)channel, (void)resolutionBits;
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    (void)pin, (void)channel;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    (void)channel;
+    backlight.duty = duty;
+    backlight.fadeEndUs = 0;
+    backlight.generation++;  // Cuts a running fade short, without its callback
+}
+
+uint32_t ledcRead(uint8_t channel) {
+    return ledc_get_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel);
+}
+
+esp_err_t ledc_fade_func_install(int intrAllocFlags) {
+    (void)intrAllocFlags;
+    return ESP_OK;
+}
+
+esp_err_t ledc_cb_register(ledc_mode_t mode, ledc_channel_t channel, ledc_cbs_t* cbs, void* arg) {
+    (void)mode, (void)channel;
+    backlight.callback = cbs->fade_cb;
+    backlight.callbackArg = arg;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_fade_time_and_start(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty,
+                                       uint32_t fadeMs, ledc_fade_mode_t waitMode) {
+    (void)waitMode;
+    backlight.fromDuty = ledc_get_duty(mode, channel);
+    backlight.duty = duty;
+    backlight.fadeStartUs = world.nowUs();
+    backlight.fadeEndUs = world.nowUs() + (int64_t)fadeMs * 1000;
+    uint32_t generation = ++backlight.generation;
+    world.at(backlight.fadeEndUs, [generation]() {
+        if (generation != backlight.generation) {
+            return;
+        }
+        backlight.fadeEndUs = 0;
+        if (backlight.callback) {
+            ledc_cb_param_t param = {LEDC_FADE_END_EVT, LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, backlight.duty};
+            backlight.callback(&param, backlight.callbackArg);
+        }
+    });
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t mode, ledc_channel_t channel) {
+    (void)mode, (void)channel;
+    int64_t now = world.nowUs();
+    if (backlight.fadeEndUs == 0 || now >= backlight.fadeEndUs) {
+        return backlight.duty;
+    }
+    double t = (double)(now - backlight.fadeStartUs) / (double)(backlight.fadeEndUs - backlight.fadeStartUs);
+    return (uint32_t)(backlight.fromDuty + t * ((double)backlight.duty - (double)backlight.fromDuty));
+}
+
+// ==================== NVS ====================
+static std::map<std::string, std::string> nvs;
+
+bool Preferences::begin(const char* name, bool ro) {
+    ns = name;
+    readOnly = ro;
+    return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!ns || readOnly) {
+        return 0;
+    }
+    nvs[std::string(ns) + "/" + key].assign((const char*)value, len);
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!ns) {
+        return 0;
+    }
+    auto it = nvs.find(std::string(ns) + "/" + key);
+    if (it == nvs.end() || it->second.size() > maxLen) {
+        return 0;
+    }
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+// ==================== WIFI ====================
+static const uint32_t WIFI_DIRECTED_MS = 350;  // Known BSSID and channel
+static const uint32_t WIFI_SCAN_MS = 1800;     // Full scan plus DHCP
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* pass, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    (void)ssid, (void)pass, (void)channel;
+    if (connect) {
+        world.joinWifi(bssid ? WIFI_DIRECTED_MS : WIFI_SCAN_MS);
+    }
+    return status();
+}
+
+bool WiFiClass::config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns) {
+    (void)ip, (void)gateway, (void)subnet, (void)dns;
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    (void)wifiOff, (void)eraseAp;
+    world.leaveWifi();
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    return world.wifiConnected() ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    static uint8_t bssid[6] = {0x02, 0x51, 0x4D, 0x00, 0x00, 0x01};
+    return bssid;
+}
+
+// Answered at once from the host resolver: a wait here would take no
+// virtual time anyway
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found,
+                        void* callback_arg) {
+    (void)found, (void)callback_arg;
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    addrinfo* res = nullptr;
+    if (!hostname || getaddrinfo(hostname, nullptr, &hints, &res) != 0 || res == nullptr) {
+        return ERR_ARG;
+    }
+    addr->type = IPADDR_TYPE_V4;
+    addr->u_addr.ip4.addr = ((sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(res);
+    return ERR_OK;
+}
+
+// ==================== OTA ====================
+static const esp_partition_t runningPartition = {0x10000, 0x300000};
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start) {
+    (void)start;
+    return nullptr;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &runningPartition;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t size, esp_ota_handle_t* out) {
+    (void)partition, (void)size, (void)out;
+    return ESP_FAIL;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+    (void)handle, (void)data, (void)size;
+    return ESP_FAIL;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    (void)handle;
+    return ESP_FAIL;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    (void)partition;
+    return ESP_FAIL;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* state) {
+    (void)partition;
+    *state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot() {
+    ESP.restart();
+}
+
+// ==================== SERIAL ====================
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buf, std::min((size_t)len, sizeof(buf) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return simSerialOut ? fwrite(&c, 1, 1, simSerialOut) : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return simSerialOut ? fwrite(buffer, 1, size, simSerialOut) : size;
+}
+
+void HardwareSerial::receive(const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (rx.size() >= rxCapacity) {
+            rxOverflows++;  // The driver drops what doesn't fit
+        } else {
+            rx.push_back(data[i]);
+        }
+    }
+}
+
+size_t HardwareSerial::read(uint8_t* buffer, size_t size) {
+    size_t n = std::min(size, rx.size());
+    std::copy(rx.begin(), rx.begin() + (std::ptrdiff_t)n, buffer);
+    rx.erase(rx.begin(), rx.begin() + (std::ptrdiff_t)n);
+    return n;
+}
+
+int HardwareSerial::read() {
+    uint8_t c;
+    return read(&c, 1) ? c : -1;
+}
+
+void HardwareSerial::flush() {
+    if (simSerialOut) {
+        fflush(simSerialOut);
+    }
+}
+
+// ==================== SYSTEM CLOCK AND SOCKETS ====================
+// Linked with -Wl,--wrap=<name>: the firmware's calls land here and see the
+// device clock; everything else keeps the host's
+extern "C" {
+
+ssize_t __wrap_sendto(int sock, const void* buf, size_t len, int flags,
+                      const struct sockaddr* to, socklen_t toLen) {
+    world.packetSent();
+    return __real_sendto(sock, buf, len, flags, to, toLen);
+}
+
+int __wrap_gettimeofday(struct timeval* tv, void* tz) {
+    (void)tz;
+    int64_t us = world.deviceUs();
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+int __wrap_settimeofday(const struct timeval* tv, const void* tz) {
+    (void)tz;
+    world.setDevice((int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+    return 0;
+}
+
+int __wrap_adjtime(const struct timeval* delta, struct timeval* oldDelta) {
+    int64_t remaining = world.slewRemaining();
+    if (delta) {
+        world.slewDevice((int64_t)delta->tv_sec * 1000000 + delta->tv_usec, &remaining);
+    }
+    if (oldDelta) {
+        oldDelta->tv_sec = (time_t)(remaining / 1000000);
+        oldDelta->tv_usec = (suseconds_t)(remaining % 1000000);
+    }
+    return 0;
+}
+
+time_t __wrap_time(time_t* out) {
+    time_t now = (time_t)(world.deviceUs() / 1000000);
+    if (out) {
+        *out = now;
+    }
+    return now;
+}
+
+int __wrap_clock_gettime(clockid_t clock, struct timespec* ts) {
+    int64_t us;
+    if (clock == CLOCK_MONOTONIC) {
+        us = world.nowUs();
+    } else if (clock == CLOCK_REALTIME) {
+        us = world.deviceUs();
+    } else {
+        return __real_clock_gettime(clock, ts);
+    }
+    ts->tv_sec = (time_t)(us / 1000000);
+    ts->tv_nsec = (long)(us % 1000000) * 1000;
+    return 0;
+}
+
+}
@@ -0,0 +1,356 @@
+#include "SimWorld.h"
+#include "Arduino.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <string>
+
+static const int64_t NTP_UNIX_DELTA_S = 2208988800LL;
+static const uint8_t NTP_PACKET_SIZE = 48;
+static const uint32_t BOUNCE_US = 300;       // Between contact bounces
+static const uint32_t RECONNECT_MS = 2500;   // Auto-reconnect once the network is back
+static const uint32_t GPS_TX_START_US = 30000;  // Receiver starts sending this long after the second
+static const uint32_t PPS_WIDTH_US = 100000;
+
+SimWorld world;
+
+SimWorld::SimWorld()
+    : now(0), eventOrder(0), notifications(0), trueStartUs(0), deviceWallUs(0),
+      driftPpm(0), driftCarryUs(0), slewRemainingUs(0), pinLevels(~0ULL),
+      wifi(true), wifiJoined(false), wifiConnectAt(0), ntp(true), sent(false), rng(0x2545F491),
+      gpsPpsPin(0), gpsBaud(0), gpsFix(true), ppsOut(true) {
+    memset(isr, 0, sizeof(isr));
+    memset(isrArg, 0, sizeof(isrArg));
+    memset(isrMode, 0, sizeof(isrMode));
+    memset(&stats, 0, sizeof(stats));
+}
+
+// ==================== VIRTUAL TIME ====================
+void SimWorld::at(int64_t whenUs, std::function<void()> fn) {
+    queue.push(Event{whenUs < now ? now : whenUs, eventOrder++, std::move(fn)});
+}
+
+void SimWorld::tick(int64_t toUs) {
+    if (toUs <= now) {
+        return;
+    }
+    int64_t elapsed = toUs - now;
+    now = toUs;
+
+    double drift = (double)elapsed * driftPpm * 1e-6 + driftCarryUs;
+    int64_t driftUs = (int64_t)drift;
+    driftCarryUs = drift - (double)driftUs;
+
+    int64_t slew = 0;
+    if (slewRemainingUs != 0) {
+        int64_t limit = elapsed >> 6;
+        slew = slewRemainingUs > 0 ? std::min(slewRemainingUs, limit)
+                                   : std::max(slewRemainingUs, -limit);
+        slewRemainingUs -= slew;
+    }
+    deviceWallUs += elapsed + driftUs + slew;
+}
+
+void SimWorld::runUntil(int64_t untilUs) {
+    while (!queue.empty() && queue.top().when <= untilUs) {
+        Event event = queue.top();
+        queue.pop();
+        tick(event.when);
+        event.fn();
+        stats.events++;
+        serviceNtp();
+    }
+    tick(untilUs);
+}
+
+void SimWorld::advanceTo(int64_t untilUs) {
+    if (waitHook) {
+        waitHook();
+    }
+    // Requests the firmware sent since time last moved
+    serviceNtp();
+    runUntil(untilUs);
+}
+
+bool SimWorld::sleep(int64_t timeoutUs) {
+    int64_t deadline = now + timeoutUs;
+    if (waitHook) {
+        waitHook();
+    }
+    serviceNtp();
+    while (notifications == 0 && now < deadline) {
+        int64_t next = queue.empty() ? deadline : std::min(queue.top().when, deadline);
+        runUntil(next);
+    }
+    stats.wakeups++;
+    if (notifications > 0) {
+        stats.notifyWakeups++;
+        return true;
+    }
+    return false;
+}
+
+uint32_t SimWorld::takeNotifications(bool clear) {
+    uint32_t n = notifications;
+    if (clear) {
+        notifications = 0;
+    } else if (notifications > 0) {
+        notifications--;
+    }
+    return n;
+}
+
+// ==================== TIMERS ====================
+SimWorld::Timer* SimWorld::createTimer(void (*callback)(void*), void* arg) {
+    Timer* timer = new Timer{callback, arg, 0, 0, false};
+    timers.push_back(timer);
+    return timer;
+}
+
+void SimWorld::startTimer(Timer* timer, uint64_t delayUs, uint64_t periodUs) {
+    timer->generation++;
+    timer->armed = true;
+    timer->periodUs = periodUs;
+    fireAt(timer, now + (int64_t)delayUs, timer->generation);
+}
+
+void SimWorld::fireAt(Timer* timer, int64_t whenUs, uint32_t generation) {
+    at(whenUs, [this, timer, generation]() {
+        if (!timer->armed || timer->generation != generation) {
+            return;  // Stopped or restarted since
+        }
+        if (timer->periodUs) {
+            fireAt(timer, now + (int64_t)timer->periodUs, generation);
+        } else {
+            timer->armed = false;
+        }
+        timer->callback(timer->arg);
+    });
+}
+
+void SimWorld::stopTimer(Timer* timer) {
+    timer->armed = false;
+    timer->generation++;
+}
+
+// ==================== CLOCKS ====================
+void SimWorld::setDevice(int64_t epochUs) {
+    deviceWallUs = epochUs;
+    slewRemainingUs = 0;  // As in ESP-IDF, a step cancels a running slew
+    stats.clockSteps++;
+}
+
+void SimWorld::slewDevice(int64_t deltaUs, int64_t* remainingUs) {
+    if (remainingUs) {
+        *remainingUs = slewRemainingUs;
+    }
+    slewRemainingUs = deltaUs;
+    stats.clockSlews++;
+}
+
+// ==================== GPIO ====================
+void SimWorld::attachInterrupt(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+    isr[pin] = handler;
+    isrArg[pin] = arg;
+    isrMode[pin] = (uint8_t)mode;
+}
+
+void SimWorld::setPin(uint8_t pin, bool level) {
+    if (this->pin(pin) == level) {
+        return;
+    }
+    pinLevels ^= 1ULL << pin;
+    if (isr[pin] && (isrMode[pin] & (level ? RISING : FALLING))) {
+        stats.interrupts++;
+        isr[pin](isrArg[pin]);
+    }
+}
+
+void SimWorld::pressButton(uint8_t pin, uint32_t holdMs) {
+    int64_t t = now;
+    for (uint8_t edge = 0; edge < 3; edge++) {
+        at(t + edge * BOUNCE_US, [this, pin, edge]() { setPin(pin, edge & 1); });
+    }
+    int64_t release = t + (int64_t)holdMs * 1000;
+    for (uint8_t edge = 0; edge < 3; edge++) {
+        at(release + edge * BOUNCE_US, [this, pin, edge]() { setPin(pin, !(edge & 1)); });
+    }
+}
+
+// ==================== NETWORK ====================
+void SimWorld::setWifiUp(bool up) {
+    if (up && !wifi) {
+        wifiConnectAt = now + (int64_t)RECONNECT_MS * 1000;
+    }
+    wifi = up;
+}
+
+void SimWorld::joinWifi(uint32_t assocMs) {
+    wifiJoined = true;
+    wifiConnectAt = now + (int64_t)assocMs * 1000;
+}
+
+uint32_t SimWorld::random(uint32_t range) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return range ? rng % range : 0;
+}
+
+bool SimWorld::startNtpServers(uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        NtpServer server;
+        server.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (server.sock < 0) {
+            return false;
+        }
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(server.sock, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            getsockname(server.sock, (sockaddr*)&addr, &len) != 0) {
+            return false;
+        }
+        fcntl(server.sock, F_SETFL, fcntl(server.sock, F_GETFL, 0) | O_NONBLOCK);
+        server.port = ntohs(addr.sin_port);
+        server.baseRttUs = 12000 + 14000 * i;  // Near, mid and far server
+        servers.push_back(server);
+    }
+    return true;
+}
+
+static void writeTimestamp(uint8_t* p, int64_t unixUs) {
+    uint64_t secs = (uint64_t)(unixUs / 1000000 + NTP_UNIX_DELTA_S);
+    uint64_t frac = ((uint64_t)(unixUs % 1000000) << 32) / 1000000;
+    uint64_t ts = (secs << 32) | frac;
+    for (uint8_t i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(ts >> (56 - 8 * i));
+    }
+}
+
+void SimWorld::serviceNtp() {
+    if (!sent) {
+        return;
+    }
+    sent = false;
+    for (const NtpServer& server : servers) {
+        for (;;) {
+            uint8_t request[NTP_PACKET_SIZE];
+            sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            ssize_t len = recvfrom(server.sock, request, sizeof(request), 0, (sockaddr*)&from, &fromLen);
+            if (len < 0) {
+                break;
+            }
+            if (len < NTP_PACKET_SIZE) {
+                continue;
+            }
+            if (!ntp || !wifiConnected()) {
+                stats.ntpDropped++;
+                continue;
+            }
+
+            // Stratum 1 with true time, reached over a path with some jitter
+            int64_t rtt = server.baseRttUs + random(8000);
+            uint8_t reply[NTP_PACKET_SIZE];
+            memset(reply, 0, sizeof(reply));
+            reply[0] = (0 << 6) | (4 << 3) | 4;
+            reply[1] = 1;
+            reply[2] = request[2];
+            reply[3] = (uint8_t)-20;
+            memcpy(reply + 12, "SIM", 4);
+            int64_t received = trueUs() + rtt / 2;
+            writeTimestamp(reply + 16, received);
+            memcpy(reply + 24, request + 40, 8);
+            writeTimestamp(reply + 32, received);
+            writeTimestamp(reply + 40, received + 30);
+            stats.ntpAnswered++;
+
+            int sock = server.sock;
+            at(now + rtt, [sock, reply, from]() {
+                sendto(sock, reply, sizeof(reply), 0, (const sockaddr*)&from, sizeof(from));
+            });
+        }
+    }
+}
+
+// ==================== GPS ====================
+void SimWorld::startGps(uint8_t ppsPin, uint32_t baud, std::function<void(const uint8_t*, size_t)> uart) {
+    gpsPpsPin = ppsPin;
+    gpsBaud = baud;
+    gpsUart = std::move(uart);
+    setPin(ppsPin, false);
+    int64_t sinceSecond = trueUs() % 1000000;
+    gpsEpoch(trueUs() - sinceSecond + (sinceSecond ? 1000000 : 0));
+}
+
+static size_t nmeaSentence(char* out, size_t cap, const char* body) {
+    uint8_t sum = 0;
+    for (const char* p = body; *p; p++) {
+        sum ^= (uint8_t)*p;
+    }
+    int n = snprintf(out, cap, "$%s*%02X\r\n", body, sum);
+    return n > 0 ? (size_t)n : 0;
+}
+
+void SimWorld::gpsEpoch(int64_t secondUs) {
+    // The event runs at the true second, secondUs
+    at(secondUs - trueStartUs, [this, secondUs]() {
+        gpsEpoch(secondUs + 1000000);
+
+        if (gpsFix && ppsOut) {
+            setPin(gpsPpsPin, true);
+            at(now + PPS_WIDTH_US, [this]() { setPin(gpsPpsPin, false); });
+        }
+
+        time_t secs = (time_t)(secondUs / 1000000);
+        struct tm utc;
+        gmtime_r(&secs, &utc);
+        char hms[16];
+        char body[96];
+        snprintf(hms, sizeof(hms), "%02d%02d%02d.00", utc.tm_hour, utc.tm_min, utc.tm_sec);
+
+        std::string burst;
+        char sentence[112];
+        auto add = [&]() { burst.append(sentence, nmeaSentence(sentence, sizeof(sentence), body)); };
+        if (gpsFix) {
+            // u-blox order: RMC first, ZDA (when enabled) last
+            stats.gpsSeconds++;
+            snprintf(body, sizeof(body), "GNRMC,%s,A,4530.0000,N,07334.2000,W,0.012,,%02d%02d%02d,,,A", hms,
+                     utc.tm_mday, utc.tm_mon + 1, utc.tm_year % 100);
+            add();
+            snprintf(body, sizeof(body), "GNGGA,%s,4530.0000,N,07334.2000,W,1,09,0.95,36.2,M,-32.9,M,,", hms);
+            add();
+            snprintf(body, sizeof(body), "GNGSA,A,3,02,05,12,15,18,24,25,29,31,,,,1.62,0.95,1.31");
+            add();
+            snprintf(body, sizeof(body), "GNZDA,%s,%02d,%02d,%04d,00,00", hms, utc.tm_mday, utc.tm_mon + 1,
+                     utc.tm_year + 1900);
+            add();
+        } else {
+            snprintf(body, sizeof(body), "GNRMC,,V,,,,,,,,,,N");
+            add();
+            snprintf(body, sizeof(body), "GNZDA,,,,,,");
+            add();
+        }
+
+        // One sentence at a time, as the UART sees each complete; 10 bits a byte
+        int64_t when = now + GPS_TX_START_US;
+        size_t from = 0;
+        while (from < burst.size()) {
+            size_t end = burst.find('\n', from) + 1;
+            when += (int64_t)(end - from) * 10000000 / gpsBaud;
+            std::string piece = burst.substr(from, end - from);
+            at(when, [this, piece]() {
+                stats.gpsBytes += (uint32_t)piece.size();
+                gpsUart((const uint8_t*)piece.data(), piece.size());
+            });
+            from = end;
+        }
+    });
+}
@@ -0,0 +1,163 @@
+#ifndef SIM_WORLD_H
+#define SIM_WORLD_H
+
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Everything outside the firmware, on one virtual timeline. Time only moves
+// when the loop task waits (ulTaskNotifyTake, delay): the world then jumps
+// straight to the next thing that happens (a timer, a fade end, a button
+// edge, an NTP reply) instead of sleeping, which is where the speed-up
+// comes from. Code between waits takes no virtual time.
+//
+// Three clocks: virtual time since boot (esp_timer, millis), true UTC, and
+// the device's system clock, which starts at 0 like after a cold boot,
+// drifts by a configurable ppm and is stepped (settimeofday) or slewed
+// (adjtime, 1/64 of elapsed time as in ESP-IDF) by the firmware.
+class SimWorld {
+public:
+    struct Stats {
+        uint64_t wakeups;        // Loop task waits that ended
+        uint64_t notifyWakeups;  // ...of which by a notification
+        uint64_t events;         // Callbacks run (timers, fades, scenario)
+        uint32_t clockSteps;
+        uint32_t clockSlews;
+        uint32_t ntpAnswered;
+        uint32_t ntpDropped;
+        uint32_t interrupts;     // GPIO edges that reached an ISR
+        uint32_t gpsSeconds;     // Epochs sent with a fix
+        uint32_t gpsBytes;
+    };
+
+    SimWorld();
+
+    // ---- Virtual time
+    int64_t nowUs() const { return now; }
+    void at(int64_t whenUs, std::function<void()> fn);
+    void advanceTo(int64_t untilUs);
+    // Loop task blocked for up to timeoutUs; true if woken by a notification
+    bool sleep(int64_t timeoutUs);
+    void notify() { notifications++; }
+    uint32_t pendingNotifications() const { return notifications; }
+    // Runs whenever the loop task is about to wait, standing in for the
+    // tasks that would get the CPU then (the logger's drain task)
+    void setWaitHook(std::function<void()> fn) { waitHook = std::move(fn); }
+    uint32_t takeNotifications(bool clear);
+
+    // ---- Timers (esp_timer)
+    struct Timer {
+        void (*callback)(void*);
+        void* arg;
+        uint64_t periodUs;
+        uint32_t generation;
+        bool armed;
+    };
+    Timer* createTimer(void (*callback)(void*), void* arg);
+    void startTimer(Timer* timer, uint64_t delayUs, uint64_t periodUs);
+    void stopTimer(Timer* timer);
+
+    // ---- Clocks
+    void setTrueStart(int64_t epochUs) { trueStartUs = epochUs; }
+    int64_t trueUs() const { return trueStartUs + now; }
+    int64_t deviceUs() const { return deviceWallUs; }
+    void setDevice(int64_t epochUs);
+    void slewDevice(int64_t deltaUs, int64_t* remainingUs);
+    int64_t slewRemaining() const { return slewRemainingUs; }
+    void setDriftPpm(double ppm) { driftPpm = ppm; }
+    bool deviceEverSet() const { return stats.clockSteps > 0; }
+
+    // ---- GPIO: levels plus RISING/FALLING/CHANGE interrupts
+    void attachInterrupt(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+    void setPin(uint8_t pin, bool level);
+    bool pin(uint8_t pin) const { return (pinLevels >> pin) & 1; }
+    uint64_t pinWord() const { return pinLevels; }
+    // Active-low press with contact bounce on both edges
+    void pressButton(uint8_t pin, uint32_t holdMs);
+
+    // ---- Network
+    void setWifiUp(bool up);
+    // WiFi.begin(): associated assocMs later, if the network is up by then
+    void joinWifi(uint32_t assocMs);
+    void leaveWifi() { wifiJoined = false; }
+    bool wifiConnected() const { return wifi && wifiJoined && now >= wifiConnectAt; }
+    void setNtpUp(bool up) { ntp = up; }
+    // Starts count SNTP servers on 127.0.0.1; returns false if sockets fail
+    bool startNtpServers(uint8_t count);
+    uint16_t ntpPort(uint8_t index) const { return servers[index].port; }
+    // A datagram went out (sendto is wrapped); the servers only look for
+    // requests after one did, which saves a recvfrom per server per wait
+    void packetSent() { sent = true; }
+
+    // ---- GPS receiver: 1 Hz NMEA (GGA, GSA, RMC, ZDA) for true time on a
+    // UART, each sentence delivered when its last byte is on the line, and
+    // a 100 ms PPS pulse on ppsPin starting at the true second
+    void startGps(uint8_t ppsPin, uint32_t baud, std::function<void(const uint8_t*, size_t)> uart);
+    // No fix: RMC says "V", ZDA has no fields and PPS stays low
+    void setGpsUp(bool up) { gpsFix = up; }
+    void setPpsUp(bool up) { ppsOut = up; }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Event {
+        int64_t when;
+        uint64_t order;
+        std::function<void()> fn;
+        bool operator>(const Event& other) const {
+            return when != other.when ? when > other.when : order > other.order;
+        }
+    };
+
+    struct NtpServer {
+        int sock;
+        uint16_t port;
+        uint32_t baseRttUs;
+    };
+
+    void runUntil(int64_t untilUs);
+    void fireAt(Timer* timer, int64_t whenUs, uint32_t generation);
+    void tick(int64_t toUs);
+    void serviceNtp();
+    void gpsEpoch(int64_t secondUs);
+    uint32_t random(uint32_t range);
+
+    int64_t now;
+    uint64_t eventOrder;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+    std::vector<Timer*> timers;
+    uint32_t notifications;
+    std::function<void()> waitHook;
+
+    int64_t trueStartUs;
+    int64_t deviceWallUs;
+    double driftPpm;
+    double driftCarryUs;
+    int64_t slewRemainingUs;
+
+    uint64_t pinLevels;
+    void (*isr[64])(void*);
+    void* isrArg[64];
+    uint8_t isrMode[64];
+
+    bool wifi;
+    bool wifiJoined;
+    int64_t wifiConnectAt;
+    bool ntp;
+    std::vector<NtpServer> servers;
+    bool sent;
+    uint32_t rng;
+
+    std::function<void(const uint8_t*, size_t)> gpsUart;
+    uint8_t gpsPpsPin;
+    uint32_t gpsBaud;
+    bool gpsFix;
+    bool ppsOut;
+
+    Stats stats;
+};
+
+extern SimWorld world;
+
+#endif // SIM_WORLD_H
@@ -0,0 +1,139 @@
+#ifndef SIM_TFT_ESPI_H
+#define SIM_TFT_ESPI_H
+
+#include <Arduino.h>
+#include <vector>
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_MAROON 0x7800
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+// Framebuffer-backed panel. Drawing follows TFT_eSPI closely enough for the
+// face to look right in a dump: smooth (VLW) fonts are rendered from the
+// real glyph data, the numbered built-in fonts fall back to the last loaded
+// smooth font. Every written pixel is counted.
+class TFT_eSPI {
+public:
+    TFT_eSPI(int16_t w = 170, int16_t h = 320);
+    virtual ~TFT_eSPI() {}
+
+    void init(uint8_t tc = 0) { (void)tc; }
+    void setRotation(uint8_t r);
+    int16_t width() const { return w; }
+    int16_t height() const { return h; }
+
+    void fillScreen(uint32_t color) { fillRect(0, 0, w, h, color); }
+    void fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void pushImage(int32_t x, int32_t y, int32_t iw, int32_t ih, const uint16_t* data);
+
+    void loadFont(const uint8_t* vlw);
+    void unloadFont() { fontLoaded = false; }
+    void setTextDatum(uint8_t d) { datum = d; }
+    void setTextColor(uint16_t fg) { textFg = fg; textBg = fg; }
+    void setTextColor(uint16_t fg, uint16_t bg, bool fill = false) { (void)fill; textFg = fg; textBg = bg; }
+    void setTextPadding(uint16_t width) { padding = width; }
+    int16_t drawString(const char* text, int32_t x, int32_t y);
+    int16_t drawString(const char* text, int32_t x, int32_t y, uint8_t font) { (void)font; return drawString(text, x, y); }
+    int16_t textWidth(const char* text);
+    int16_t fontHeight() const { return (int16_t)(maxAscent + maxDescent); }
+
+    // Clips all drawing; coordinates stay absolute (vpDatum isn't modelled)
+    void setViewport(int32_t x, int32_t y, int32_t vw, int32_t vh, bool vpDatum = true);
+    void resetViewport() { setViewport(0, 0, w, h, false); }
+
+    // Panel commands: the vertical scroll start (VSCSAD), partial display
+    // (PTLAR, PTLON, NORON) and idle mode (IDMON, IDMOFF) are modelled, on
+    // panel lines along the long side as it is wired; the rest are ignored.
+    // A change to what the panel shows counts as a mode switch, and as a
+    // lit one (a visible artifact) if the backlight isn't off.
+    void writecommand(uint8_t c);
+    void writedata(uint8_t d);
+    uint32_t getModeSwitches() const { return modeSwitches; }
+    uint32_t getLitSwitches() const { return litSwitches; }
+
+    const uint16_t* pixels() const { return buffer.data(); }
+    // What the panel shows at (x, y), with scroll, partial and idle mode
+    uint16_t shownPixel(int16_t x, int16_t y) const;
+    // Pixels written since the last call
+    uint32_t takeWritten();
+
+protected:
+    struct Glyph {
+        uint32_t code;
+        int16_t height, width, advance, dy, dx;
+        const uint8_t* bitmap;
+    };
+
+    const Glyph* glyph(uint32_t code) const;
+    void resize(int16_t nw, int16_t nh);
+
+    int16_t w;
+    int16_t h;
+    std::vector<uint16_t> buffer;
+    uint32_t written;
+    int32_t clipX0, clipY0, clipX1, clipY1;
+    uint8_t command;
+    uint8_t params[4];
+    uint8_t paramCount;
+    uint16_t scrollStart;
+    bool partial;
+    uint16_t partialFirst;
+    uint16_t partialLast;
+    bool idle;
+    uint32_t modeSwitches;
+    uint32_t litSwitches;
+
+    std::vector<Glyph> glyphs;
+    bool fontLoaded;
+    int16_t maxAscent;
+    int16_t maxDescent;
+    int16_t spaceWidth;
+    uint8_t datum;
+    uint16_t textFg;
+    uint16_t textBg;
+    uint16_t padding;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+    explicit TFT_eSprite(TFT_eSPI* parent) : TFT_eSPI(0, 0), parent(parent), created(false) {}
+    void* setColorDepth(int8_t bits) { (void)bits; return nullptr; }
+    void* createSprite(int16_t sw, int16_t sh, uint8_t frames = 1);
+    void deleteSprite();
+    void fillSprite(uint32_t color) { fillScreen(color); }
+    void* getPointer() { return created ? buffer.data() : nullptr; }
+    void pushSprite(int32_t x, int32_t y) { parent->pushImage(x, y, w, h, buffer.data()); }
+    bool pushToSprite(TFT_eSprite* target, int32_t x, int32_t y) {
+        target->pushImage(x, y, w, h, buffer.data());
+        return true;
+    }
+
+private:
+    TFT_eSPI* parent;
+    bool created;
+};
+
+#endif // SIM_TFT_ESPI_H
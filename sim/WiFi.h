@@ -0,0 +1,38 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+#define WIFI_STA 1
+
+// Associates after a fixed virtual delay while the scenario has the
+// network up; the NTP servers it leads to live in SimWorld
+class WiFiClass {
+public:
+    bool mode(int mode) { (void)mode; return true; }
+    void persistent(bool persistent) { (void)persistent; }
+    wl_status_t begin(const char* ssid, const char* pass, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    bool config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns = (uint32_t)0);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    wl_status_t status();
+    IPAddress localIP() { return IPAddress(192, 168, 4, 2); }
+    IPAddress gatewayIP() { return IPAddress(192, 168, 4, 1); }
+    IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+    IPAddress dnsIP(uint8_t index = 0) { (void)index; return IPAddress(192, 168, 4, 1); }
+    uint8_t* BSSID();
+    int32_t channel() { return 6; }
+    int8_t RSSI() { return -58; }
+};
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,32 @@
+#ifndef SIM_DRIVER_LEDC_H
+#define SIM_DRIVER_LEDC_H
+
+#include <stdint.h>
+#include "esp_timer.h"
+
+// Backlight PWM. Fades complete after their virtual duration and then call
+// the registered end-of-fade callback, like the hardware interrupt.
+typedef enum { LEDC_LOW_SPEED_MODE = 0 } ledc_mode_t;
+typedef enum { LEDC_CHANNEL_0 = 0 } ledc_channel_t;
+typedef enum { LEDC_FADE_NO_WAIT = 0, LEDC_FADE_WAIT_DONE } ledc_fade_mode_t;
+typedef enum { LEDC_FADE_END_EVT } ledc_cb_event_t;
+
+typedef struct {
+    ledc_cb_event_t event;
+    uint32_t speed_mode;
+    uint32_t channel;
+    uint32_t duty;
+} ledc_cb_param_t;
+
+typedef bool (*ledc_cb_t)(const ledc_cb_param_t* param, void* arg);
+typedef struct {
+    ledc_cb_t fade_cb;
+} ledc_cbs_t;
+
+esp_err_t ledc_fade_func_install(int intrAllocFlags);
+esp_err_t ledc_cb_register(ledc_mode_t mode, ledc_channel_t channel, ledc_cbs_t* cbs, void* arg);
+esp_err_t ledc_set_fade_time_and_start(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty,
+                                       uint32_t fadeMs, ledc_fade_mode_t waitMode);
+uint32_t ledc_get_duty(ledc_mode_t mode, ledc_channel_t channel);
+
+#endif // SIM_DRIVER_LEDC_H
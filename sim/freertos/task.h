@@ -0,0 +1,18 @@
+#ifndef SIM_FREERTOS_TASK_H
+#define SIM_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+// Only the loop task exists. Waiting moves virtual time forward; other tasks
+// are recorded but never run (the simulator drains the logger itself).
+typedef struct SimTask* TaskHandle_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+BaseType_t xTaskCreatePinnedToCore(void (*code)(void*), const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+
+#endif // SIM_FREERTOS_TASK_H
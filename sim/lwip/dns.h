@@ -0,0 +1,39 @@
+#ifndef SIM_LWIP_DNS_H
+#define SIM_LWIP_DNS_H
+
+#include <stdint.h>
+
+// The slice of lwIP's DNS API the firmware uses, with the dual-stack
+// ip_addr_t layout of ESP-IDF (only IPv4 is ever filled in)
+typedef int8_t err_t;
+#define ERR_OK 0
+#define ERR_INPROGRESS -5
+#define ERR_VAL -6
+#define ERR_ARG -16
+
+#define IPADDR_TYPE_V4 0U
+#define IPADDR_TYPE_V6 6U
+
+typedef struct {
+    uint32_t addr;  // Network byte order
+} ip4_addr_t;
+
+typedef struct {
+    union {
+        ip4_addr_t ip4;
+    } u_addr;
+    uint8_t type;
+} ip_addr_t;
+
+#define IP_IS_V4(ipaddr) ((ipaddr)->type == IPADDR_TYPE_V4)
+#define ip_2_ip4(ipaddr) (&((ipaddr)->u_addr.ip4))
+#define ip4_addr_get_u32(src_ipaddr) ((src_ipaddr)->addr)
+
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* ipaddr, void* callback_arg);
+
+// ERR_OK with addr filled in when answered at once, ERR_INPROGRESS when
+// found() will be called later (from another thread), else an error
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found,
+                        void* callback_arg);
+
+#endif // SIM_LWIP_DNS_H
@@ -0,0 +1,621 @@
+// Time-warp simulator: runs the real setup()/loop() against SimWorld for
+// days or weeks of virtual time, driven by a scenario script.
+//
+//   binclock-sim --start 2026-03-06T12:00:00Z --duration 7d
+//                --script sim/scenarios/dst-week.txt --frames frames --log -
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "SimWorld.h"
+#include "config.h"
+#include "ConfigStore.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "SyncStats.h"
+#include "TimeKeeper.h"
+
+extern "C" int __real_clock_gettime(clockid_t clock, struct timespec* ts);
+extern FILE* simSerialOut;
+
+// From src/main.cpp
+extern TFT_eSPI tft;
+extern ConfigStore configStore;
+extern SyncStats syncStats;
+extern TimeKeeper timeKeeper;
+bool onHttpCommand(const char* name, const char* value);
+
+static const int64_t US_PER_S = 1000000;
+static const int64_t STALL_GAP_US = 1100000;    // Seconds digit should change every 1 s
+static const int64_t CLOCK_ERROR_LIMIT_US = 500000;
+static const uint32_t DEFAULT_PRESS_MS = 80;
+
+enum GpsWiring : uint8_t {
+    GPS_OFF = 0,    // No receiver on the UART
+    GPS_NMEA,       // Sentences only
+    GPS_PPS         // Sentences and the PPS line
+};
+
+struct Options {
+    int64_t startUs = 1772798400LL * US_PER_S;  // 2026-03-06T12:00:00Z
+    int64_t durationUs = 7 * 24 * 3600 * US_PER_S;
+    const char* script = nullptr;
+    const char* framesDir = nullptr;
+    int64_t frameEveryUs = 3600 * US_PER_S;
+    const char* timezone = nullptr;
+    double driftPpm = 20;
+    const char* logPath = nullptr;
+    bool metrics = false;
+    uint8_t gps = GPS_OFF;
+};
+
+static Options options;
+
+// ==================== HELPERS ====================
+static int64_t hostNowUs() {
+    struct timespec ts;
+    __real_clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * US_PER_S + ts.tv_nsec / 1000;
+}
+
+// "250ms", "90s", "15m", "2h", "7d"; a bare number is seconds
+static bool parseDuration(const char* text, int64_t& us) {
+    char* end = nullptr;
+    double value = strtod(text, &end);
+    if (end == text || value < 0) {
+        return false;
+    }
+    double scale = US_PER_S;
+    if (strcmp(end, "ms") == 0) {
+        scale = 1000;
+    } else if (strcmp(end, "m") == 0) {
+        scale = 60.0 * US_PER_S;
+    } else if (strcmp(end, "h") == 0) {
+        scale = 3600.0 * US_PER_S;
+    } else if (strcmp(end, "d") == 0) {
+        scale = 86400.0 * US_PER_S;
+    } else if (*end != '\0' && strcmp(end, "s") != 0) {
+        return false;
+    }
+    us = (int64_t)(value * scale);
+    return true;
+}
+
+// 2026-03-08T06:59:30Z, always UTC
+static bool parseUtc(const char* text, int64_t& epochUs) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char* end = strptime(text, "%Y-%m-%dT%H:%M:%S", &tm);
+    if (!end || (*end != '\0' && strcmp(end, "Z") != 0)) {
+        return false;
+    }
+    epochUs = (int64_t)timegm(&tm) * US_PER_S;
+    return true;
+}
+
+// Scenario times are offsets from boot or absolute UTC instants
+static bool parseWhen(const char* text, int64_t& virtualUs) {
+    if (strchr(text, 'T') && strchr(text, '-')) {
+        int64_t epochUs;
+        if (!parseUtc(text, epochUs)) {
+            return false;
+        }
+        virtualUs = epochUs - options.startUs;
+        return virtualUs >= 0;
+    }
+    return parseDuration(text, virtualUs);
+}
+
+static void note(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static void note(const char* format, ...) {
+    if (!simSerialOut) {
+        return;
+    }
+    uint64_t ms = (uint64_t)world.nowUs() / 1000;
+    fprintf(simSerialOut, "[%5lu.%03lu] sim: ", (unsigned long)(ms / 1000), (unsigned long)(ms % 1000));
+    va_list args;
+    va_start(args, format);
+    vfprintf(simSerialOut, format, args);
+    va_end(args);
+    fputc('\n', simSerialOut);
+}
+
+class NullPrint : public Print {
+public:
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { (void)buffer; return size; }
+};
+
+// ==================== FRAME DUMPS ====================
+static uint32_t framesWritten = 0;
+
+// Binary PPM, named by the true local time the panel should be showing
+static void dumpFrame(const char* label) {
+    if (!options.framesDir) {
+        return;
+    }
+    time_t trueSecs = (time_t)(world.trueUs() / US_PER_S);
+    struct tm local;
+    localtime_r(&trueSecs, &local);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+
+    std::string path = std::string(options.framesDir) + "/" + stamp;
+    if (label && *label) {
+        path += std::string("-") + label;
+    }
+    path += ".ppm";
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "sim: cannot write %s: %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+    int16_t w = tft.width();
+    int16_t h = tft.height();
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    std::vector<uint8_t> row((size_t)w * 3);
+    for (int16_t y = 0; y < h; y++) {
+        for (int16_t x = 0; x < w; x++) {
+            uint16_t c = tft.shownPixel(x, y);
+            row[x * 3] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+            row[x * 3 + 1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+            row[x * 3 + 2] = (uint8_t)((c & 0x1F) * 255 / 31);
+        }
+        fwrite(row.data(), 1, row.size(), f);
+    }
+    fclose(f);
+    framesWritten++;
+}
+
+static void scheduleFrames(int64_t whenUs) {
+    world.at(whenUs, [whenUs]() {
+        dumpFrame(nullptr);
+        scheduleFrames(whenUs + options.frameEveryUs);
+    });
+}
+
+// ==================== EXPECTATIONS ====================
+static int64_t maxGapUs = 0;
+static uint32_t expectChecked = 0;
+static uint32_t expectFailed = 0;
+
+static void expectResult(bool ok, const std::string& what, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+static void expectResult(bool ok, const std::string& what, const char* format, ...) {
+    char actual[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(actual, sizeof(actual), format, args);
+    va_end(args);
+
+    expectChecked++;
+    note("expect %s: %s%s", what.c_str(), actual, ok ? "" : " FAILED");
+    if (!ok) {
+        expectFailed++;
+        uint64_t ms = (uint64_t)world.nowUs() / 1000;
+        fprintf(stderr, "sim: at %lu.%03lu s, expected %s, got %s\n", (unsigned long)(ms / 1000),
+                (unsigned long)(ms % 1000), what.c_str(), actual);
+    }
+}
+
+// "expect error <max>", "expect source wall|uptime", "expect sync never|ok|stale",
+// "expect gap <max>" (longest time between panel updates so far)
+static bool compileExpect(const std::vector<std::string>& words, std::function<void()>& action) {
+    static const char* const sourceNames[] = {"wall", "uptime"};
+    static const char* const healthNames[] = {"never", "ok", "stale"};
+    if (words.size() != 3) {
+        return false;
+    }
+    const std::string& what = words[1];
+    const std::string& arg = words[2];
+    std::string text = what + " " + arg;
+
+    if (what == "error") {
+        int64_t maxUs;
+        if (!parseDuration(arg.c_str(), maxUs)) {
+            return false;
+        }
+        action = [maxUs, text]() {
+            if (!world.deviceEverSet()) {
+                expectResult(false, text, "clock never set");
+                return;
+            }
+            int64_t error = world.deviceUs() - world.trueUs();
+            expectResult((error < 0 ? -error : error) <= maxUs, text, "%+.3f ms", error / 1e3);
+        };
+    } else if (what == "source" && (arg == "wall" || arg == "uptime")) {
+        action = [arg, text]() {
+            struct tm timeinfo;
+            const char* source = sourceNames[timeKeeper.read(timeinfo, millis())];
+            expectResult(arg == source, text, "%s", source);
+        };
+    } else if (what == "sync" && (arg == "never" || arg == "ok" || arg == "stale")) {
+        action = [arg, text]() {
+            const char* health = healthNames[syncStats.health(millis())];
+            expectResult(arg == health, text, "%s", health);
+        };
+    } else if (what == "gap") {
+        int64_t maxUs;
+        if (!parseDuration(arg.c_str(), maxUs)) {
+            return false;
+        }
+        action = [maxUs, text]() {
+            expectResult(maxGapUs <= maxUs, text, "%.3f s", maxGapUs / 1e6);
+        };
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ==================== SCENARIO ====================
+static void pressButtons(uint8_t mask, uint32_t holdMs) {
+    if (mask & 1) {
+        world.pressButton(PIN_BUTTON_BOOT, holdMs);
+    }
+    if (mask & 2) {
+        world.pressButton(PIN_BUTTON_IO14, holdMs);
+    }
+}
+
+static bool parseUpDown(const std::string& word, bool& up) {
+    if (word == "up") {
+        up = true;
+    } else if (word == "down") {
+        up = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Checks a command and returns the action that runs it
+static bool compileCommand(const std::vector<std::string>& words, std::function<void()>& action) {
+    const std::string& cmd = words[0];
+    std::string arg = words.size() > 1 ? words[1] : "";
+    bool up = false;
+
+    if (cmd == "press") {
+        uint8_t mask = arg == "boot" ? 1 : arg == "io14" ? 2 : arg == "both" ? 3 : 0;
+        uint32_t holdMs = words.size() > 2 ? (uint32_t)atoi(words[2].c_str()) : DEFAULT_PRESS_MS;
+        if (!mask || holdMs == 0) {
+            return false;
+        }
+        action = [mask, holdMs, arg]() {
+            note("press %s %u ms", arg.c_str(), (unsigned)holdMs);
+            pressButtons(mask, holdMs);
+        };
+    } else if (cmd == "wifi" && parseUpDown(arg, up)) {
+        action = [up]() {
+            note("wifi %s", up ? "up" : "down");
+            world.setWifiUp(up);
+        };
+    } else if (cmd == "ntp" && parseUpDown(arg, up)) {
+        action = [up]() {
+            note("ntp %s", up ? "up" : "down");
+            world.setNtpUp(up);
+        };
+    } else if (cmd == "gps" && parseUpDown(arg, up)) {
+        action = [up]() {
+            note("gps %s", up ? "fix" : "no fix");
+            world.setGpsUp(up);
+        };
+    } else if (cmd == "pps" && parseUpDown(arg, up)) {
+        action = [up]() {
+            note("pps %s", up ? "up" : "down");
+            world.setPpsUp(up);
+        };
+    } else if (cmd == "drift" && !arg.empty()) {
+        double ppm = atof(arg.c_str());
+        action = [ppm]() {
+            note("drift %.1f ppm", ppm);
+            world.setDriftPpm(ppm);
+        };
+    } else if (cmd == "set" && words.size() == 3) {
+        // Same path as /config?name=value
+        std::string value = words[2];
+        action = [arg, value]() {
+            bool ok = configStore.set(arg.c_str(), value.c_str(), millis());
+            note("set %s=%s%s", arg.c_str(), value.c_str(), ok ? "" : " (rejected)");
+        };
+    } else if (cmd == "control" && words.size() == 3) {
+        // Same path as /control?name=value
+        std::string value = words[2];
+        action = [arg, value]() {
+            bool ok = onHttpCommand(arg.c_str(), value.c_str());
+            note("control %s=%s%s", arg.c_str(), value.c_str(), ok ? "" : " (rejected)");
+        };
+    } else if (cmd == "expect") {
+        return compileExpect(words, action);
+    } else if (cmd == "dump") {
+        action = [arg]() {
+            note("dump %s", arg.c_str());
+            dumpFrame(arg.c_str());
+        };
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void repeat(int64_t whenUs, int64_t periodUs, std::function<void()> action) {
+    world.at(whenUs, [whenUs, periodUs, action]() {
+        action();
+        repeat(whenUs + periodUs, periodUs, action);
+    });
+}
+
+// One command per line: "<when> <command...>" or "every <period> <command...>",
+// where <when> is an offset from boot (90s, 2d) or a UTC time; # comments
+static bool loadScript(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "sim: cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char line[256];
+    uint32_t lineNo = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char* hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        std::vector<std::string> words;
+        for (char* tok = strtok(line, " \t\r\n"); tok; tok = strtok(nullptr, " \t\r\n")) {
+            words.push_back(tok);
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        size_t every = words[0] == "every" ? 1 : 0;
+        int64_t whenUs = 0;
+        std::function<void()> action;
+        if (words.size() < 2 + every ||
+            !(every ? parseDuration(words[1].c_str(), whenUs) : parseWhen(words[0].c_str(), whenUs)) ||
+            !compileCommand(std::vector<std::string>(words.begin() + 1 + every, words.end()), action) ||
+            (every && whenUs == 0)) {
+            fprintf(stderr, "%s:%u: cannot parse\n", path, (unsigned)lineNo);
+            ok = false;
+            continue;
+        }
+        if (every) {
+            repeat(whenUs, whenUs, action);
+        } else {
+            world.at(whenUs, action);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+// ==================== SETUP ====================
+static void usage() {
+    fprintf(stderr,
+            "usage: binclock-sim [options]\n"
+            "  --start UTC          true time at boot (default 2026-03-06T12:00:00Z)\n"
+            "  --duration D         virtual run length, e.g. 36h, 7d (default 7d)\n"
+            "  --script FILE        scenario: button presses, outages, drift, checks\n"
+            "  --frames DIR         write PPM frame dumps to DIR\n"
+            "  --frame-every D      periodic dump interval (default 1h)\n"
+            "  --tz POSIX-TZ        timezone setting (default from config.h)\n"
+            "  --drift-ppm N        device oscillator error (default 20)\n"
+            "  --log FILE|-         serial output (default: discarded)\n"
+            "  --gps nmea|pps       attach a GPS receiver, with or without PPS (needs GPS_ENABLED)\n"
+            "  --metrics            print /metrics at the end\n");
+}
+
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        if (strcmp(opt, "--metrics") == 0) {
+            options.metrics = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        bool ok = true;
+        if (strcmp(opt, "--start") == 0) {
+            ok = parseUtc(value, options.startUs);
+        } else if (strcmp(opt, "--duration") == 0) {
+            ok = parseDuration(value, options.durationUs);
+        } else if (strcmp(opt, "--script") == 0) {
+            options.script = value;
+        } else if (strcmp(opt, "--frames") == 0) {
+            options.framesDir = value;
+        } else if (strcmp(opt, "--frame-every") == 0) {
+            ok = parseDuration(value, options.frameEveryUs) && options.frameEveryUs > 0;
+        } else if (strcmp(opt, "--tz") == 0) {
+            options.timezone = value;
+        } else if (strcmp(opt, "--drift-ppm") == 0) {
+            options.driftPpm = atof(value);
+        } else if (strcmp(opt, "--log") == 0) {
+            options.logPath = value;
+        } else if (strcmp(opt, "--gps") == 0) {
+            options.gps = strcmp(value, "nmea") == 0 ? GPS_NMEA : strcmp(value, "pps") == 0 ? GPS_PPS : GPS_OFF;
+            ok = options.gps != GPS_OFF && GPS_ENABLED;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "sim: bad %s %s\n", opt, value);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Points the firmware's NTP servers at the in-process ones, as if they had
+// been set over /config before this boot
+static void seedConfig() {
+    ConfigStore seed;
+    seed.load();
+    for (uint8_t i = 0; i < NTP_SERVER_COUNT; i++) {
+        char name[8];
+        char value[32];
+        snprintf(name, sizeof(name), "ntp%u", (unsigned)(i + 1));
+        snprintf(value, sizeof(value), "127.0.0.1:%u", (unsigned)world.ntpPort(i));
+        seed.set(name, value, 0);
+    }
+    if (options.timezone && !seed.set("timezone", options.timezone, 0)) {
+        fprintf(stderr, "sim: timezone rejected: %s\n", options.timezone);
+    }
+    seed.update(CONFIG_SAVE_MAX_DELAY_MS);
+
+    NullPrint discard;
+    logger.drain(discard);
+}
+
+// ==================== RUN ====================
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        usage();
+        return 2;
+    }
+    if (options.logPath == nullptr) {
+        simSerialOut = nullptr;
+    } else if (strcmp(options.logPath, "-") != 0) {
+        simSerialOut = fopen(options.logPath, "w");
+        if (!simSerialOut) {
+            fprintf(stderr, "sim: cannot write %s: %s\n", options.logPath, strerror(errno));
+            return 2;
+        }
+    }
+    if (options.framesDir) {
+        mkdir(options.framesDir, 0755);
+    }
+
+    world.setTrueStart(options.startUs);
+    world.setDriftPpm(options.driftPpm);
+    if (!world.startNtpServers(NTP_SERVER_COUNT)) {
+        fprintf(stderr, "sim: cannot open NTP server sockets: %s\n", strerror(errno));
+        return 1;
+    }
+    seedConfig();
+    if (options.gps != GPS_OFF) {
+        world.setPpsUp(options.gps == GPS_PPS);
+        world.startGps(GPS_PPS_PIN < 0 ? 0 : GPS_PPS_PIN, GPS_BAUD,
+                       [](const uint8_t* data, size_t size) { Serial1.receive(data, size); });
+    }
+    // The drain task's share of the CPU comes whenever the loop task waits
+    world.setWaitHook([]() { logger.drain(Serial); });
+
+    if (options.script && !loadScript(options.script)) {
+        return 2;
+    }
+    if (options.framesDir) {
+        scheduleFrames(options.frameEveryUs);
+    }
+
+    int64_t hostStartUs = hostNowUs();
+    setup();
+    int64_t endUs = options.durationUs;
+
+    // Aggregates over the run
+    uint64_t passes = 0;
+    int64_t loopHostUs = 0;
+    int64_t loopHostMaxUs = 0;
+    uint64_t pixels = tft.takeWritten();
+    int64_t lastWriteUs = world.nowUs();
+    uint32_t stalls = 0;
+    int64_t firstSyncUs = -1;
+    int64_t maxErrorUs = 0;
+    int64_t badClockUs = 0;
+    int64_t lastCheckUs = world.nowUs();
+
+    while (world.nowUs() < endUs) {
+        int64_t passStartUs = world.nowUs();
+        int64_t hostBeforeUs = hostNowUs();
+        loop();
+        int64_t hostUs = hostNowUs() - hostBeforeUs;
+        loopHostUs += hostUs;
+        loopHostMaxUs = std::max(loopHostMaxUs, hostUs);
+        passes++;
+
+        // loop() ends in its wait, so this is the time it woke up for next
+        uint32_t written = tft.takeWritten();
+        if (written) {
+            pixels += written;
+            int64_t gap = passStartUs - lastWriteUs;
+            if (gap > STALL_GAP_US) {
+                stalls++;
+            }
+            maxGapUs = std::max(maxGapUs, gap);
+            lastWriteUs = passStartUs;
+        }
+
+        if (world.deviceEverSet()) {
+            if (firstSyncUs < 0) {
+                firstSyncUs = world.nowUs();
+            }
+            int64_t error = world.deviceUs() - world.trueUs();
+            error = error < 0 ? -error : error;
+            maxErrorUs = std::max(maxErrorUs, error);
+            if (error > CLOCK_ERROR_LIMIT_US) {
+                badClockUs += world.nowUs() - lastCheckUs;
+            }
+        }
+        lastCheckUs = world.nowUs();
+    }
+    logger.drain(Serial);
+    Serial.flush();
+    int64_t hostUs = hostNowUs() - hostStartUs;
+
+    const SimWorld::Stats& stats = world.getStats();
+    double simHours = world.nowUs() / 3.6e9;
+    double hostSecs = hostUs / 1e6;
+    printf("simulated       %.2f h in %.2f s host (%.0f simulated h/s)\n",
+           simHours, hostSecs, hostSecs > 0 ? simHours / hostSecs : 0.0);
+    printf("loop passes     %llu, %.2f us host each (max %lld us)\n",
+           (unsigned long long)passes, passes ? (double)loopHostUs / passes : 0.0,
+           (long long)loopHostMaxUs);
+    printf("wakeups         %llu (%llu by notification), %.0f per simulated hour\n",
+           (unsigned long long)stats.wakeups, (unsigned long long)stats.notifyWakeups,
+           simHours > 0 ? stats.wakeups / simHours : 0.0);
+    printf("events          %llu, %u interrupts\n",
+           (unsigned long long)stats.events, (unsigned)stats.interrupts);
+    printf("panel           %llu pixels, longest gap %.3f s, %u stalls over %.1f s\n",
+           (unsigned long long)pixels, maxGapUs / 1e6, (unsigned)stalls, STALL_GAP_US / 1e6);
+    if (tft.getModeSwitches()) {
+        printf("panel modes     %u switches, %u with the backlight on\n",
+               (unsigned)tft.getModeSwitches(), (unsigned)tft.getLitSwitches());
+    }
+    if (firstSyncUs >= 0) {
+        printf("clock           first set at %.3f s, max error %.3f ms, %.1f s off by > %lld ms\n",
+               firstSyncUs / 1e6, maxErrorUs / 1e3, badClockUs / 1e6,
+               (long long)(CLOCK_ERROR_LIMIT_US / 1000));
+    } else {
+        printf("clock           never set\n");
+    }
+    printf("clock changes   %u steps, %u slews\n", (unsigned)stats.clockSteps, (unsigned)stats.clockSlews);
+    printf("ntp             %u answered, %u dropped\n", (unsigned)stats.ntpAnswered, (unsigned)stats.ntpDropped);
+    if (options.gps != GPS_OFF) {
+        printf("gps             %u seconds with a fix, %u bytes, %u lost to RX overflow\n",
+               (unsigned)stats.gpsSeconds, (unsigned)stats.gpsBytes, (unsigned)Serial1.getRxOverflows());
+    }
+    printf("logger          %u records, %u dropped, %u ns avg per call\n",
+           (unsigned)logger.getCalls(), (unsigned)logger.getDropped(), (unsigned)logger.getAvgCycles());
+    if (options.framesDir) {
+        printf("frames          %u written to %s\n", (unsigned)framesWritten, options.framesDir);
+    }
+    if (expectChecked) {
+        printf("expect          %u checked, %u failed\n", (unsigned)expectChecked, (unsigned)expectFailed);
+    }
+
+    if (options.metrics) {
+        char buf[1024];
+        uint32_t cursor = 0;
+        size_t n;
+        while ((n = Metric::serialize(buf, sizeof(buf), cursor)) > 0) {
+            fwrite(buf, 1, n, stdout);
+        }
+    }
+    return expectFailed ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#ifndef SIM_SOC_GPIO_REG_H
+#define SIM_SOC_GPIO_REG_H
+
+#define GPIO_IN_REG 0x6000403C
+#define GPIO_IN1_REG 0x60004040
+
+#endif // SIM_SOC_GPIO_REG_H
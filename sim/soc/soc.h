@@ -0,0 +1,10 @@
+#ifndef SIM_SOC_H
+#define SIM_SOC_H
+
+#include <stdint.h>
+
+// GPIO input registers are backed by the simulated pin levels
+uint32_t simReadRegister(uint32_t address);
+#define REG_READ(address) simReadRegister(address)
+
+#endif // SIM_SOC_H
@@ -0,0 +1,21 @@
+#ifndef ACCESS_TOKEN_H
+#define ACCESS_TOKEN_H
+
+#include <stdint.h>
+#include <string.h>
+
+// True if a request's ?token= matches the configured one. Every byte of the
+// configured token is compared whatever the input, so response times don't
+// show how much of a guess was right. An empty configured token matches
+// nothing: endpoints without a token set stay closed.
+inline bool accessTokenMatches(const char* given, const char* expected) {
+    size_t expectedLength = strlen(expected);
+    size_t givenLength = strlen(given);
+    uint8_t diff = expectedLength == 0 || givenLength != expectedLength;
+    for (size_t i = 0; i < expectedLength; i++) {
+        diff |= (uint8_t)(expected[i] ^ (i < givenLength ? given[i] : 0));
+    }
+    return diff == 0;
+}
+
+#endif // ACCESS_TOKEN_H
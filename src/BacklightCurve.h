@@ -0,0 +1,109 @@
+#ifndef BACKLIGHT_CURVE_H
+#define BACKLIGHT_CURVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include "config.h"
+
+// Perceptual backlight curve. Brightness is expressed as CIE 1931 lightness
+// L* (0..100) and converted to a linear PWM duty, so equal steps in level
+// look like equal steps in brightness. The level table is generated at
+// compile time and checked below with static_asserts.
+namespace BacklightCurve {
+
+constexpr uint32_t MAX_DUTY = (1u << PWM_RESOLUTION) - 1;
+
+// L* -> relative luminance Y (0..1)
+constexpr float lightnessToLuminance(float lightness) {
+    if (lightness <= 8.0f) {
+        return lightness / 903.3f;
+    }
+    float t = (lightness + 16.0f) / 116.0f;
+    return t * t * t;
+}
+
+constexpr float cubeRoot(float x) {
+    // Newton iterations, good to float precision for 0 < x <= 1
+    float r = x > 0.5f ? x : 0.5f;
+    for (int i = 0; i < 24; i++) {
+        r = r - (r * r * r - x) / (3.0f * r * r);
+    }
+    return r;
+}
+
+// Relative luminance Y (0..1) -> L*
+constexpr float luminanceToLightness(float luminance) {
+    if (luminance <= 0.008856f) {
+        return luminance * 903.3f;
+    }
+    return 116.0f * cubeRoot(luminance) - 16.0f;
+}
+
+constexpr uint32_t dutyForLightness(float lightness) {
+    return (uint32_t)(lightnessToLuminance(lightness) * MAX_DUTY + 0.5f);
+}
+
+// Continuous control: 0..1 maps evenly across [BRIGHTNESS_MIN_LIGHTNESS,
+// BRIGHTNESS_MAX_LIGHTNESS] in perceptual space. Values below 0 keep going
+// down to L* = 0, so automatic sources can dim past the lowest level.
+constexpr uint32_t dutyForFraction(float fraction) {
+    float lightness = BRIGHTNESS_MIN_LIGHTNESS +
+                      (BRIGHTNESS_MAX_LIGHTNESS - BRIGHTNESS_MIN_LIGHTNESS) * fraction;
+    if (lightness < 0.0f) {
+        lightness = 0.0f;
+    }
+    if (lightness > 100.0f) {
+        lightness = 100.0f;
+    }
+    return dutyForLightness(lightness);
+}
+
+template <size_t N>
+constexpr std::array<uint16_t, N> makeLevelTable() {
+    std::array<uint16_t, N> table{};
+    for (size_t i = 0; i < N; i++) {
+        float fraction = N > 1 ? (float)i / (float)(N - 1) : 1.0f;
+        table[i] = (uint16_t)dutyForFraction(fraction);
+    }
+    return table;
+}
+
+template <size_t N>
+constexpr bool strictlyIncreasing(const std::array<uint16_t, N>& table) {
+    for (size_t i = 1; i < N; i++) {
+        if (table[i] <= table[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every step's L* delta, after quantization to the PWM resolution, must be
+// within tolerancePct of the nominal step
+template <size_t N>
+constexpr bool evenPerceptualSteps(const std::array<uint16_t, N>& table, float tolerancePct) {
+    const float nominal = N > 1 ? (BRIGHTNESS_MAX_LIGHTNESS - BRIGHTNESS_MIN_LIGHTNESS) / (N - 1) : 0.0f;
+    for (size_t i = 1; i < N; i++) {
+        float lo = luminanceToLightness((float)table[i - 1] / MAX_DUTY);
+        float hi = luminanceToLightness((float)table[i] / MAX_DUTY);
+        float error = (hi - lo) - nominal;
+        if (error < 0) {
+            error = -error;
+        }
+        if (error > nominal * tolerancePct / 100.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr std::array<uint16_t, BRIGHTNESS_LEVELS> LEVEL_DUTY = makeLevelTable<BRIGHTNESS_LEVELS>();
+
+static_assert(PWM_RESOLUTION <= 16, "Level table stores 16-bit duties");
+static_assert(strictlyIncreasing(LEVEL_DUTY), "Brightness levels must be strictly increasing");
+static_assert(evenPerceptualSteps(LEVEL_DUTY, 5.0f), "Brightness steps must be perceptually even");
+
+}  // namespace BacklightCurve
+
+#endif // BACKLIGHT_CURVE_H
@@ -1,11 +1,62 @@
 #include "BinaryClockDisplay.h"
 #include "font18.h"
+#include "BacklightCurve.h"
+#include "DisplayMirror.h"
+
+using FaceGeometry::circlePixels;
+using FaceGeometry::WorldFace;
+
+static constexpr uint32_t STATUS_DOT_PIXELS = circlePixels(STATUS_DOT_RADIUS);
+static const uint16_t DIGIT_PADDING = 12;  // Per character: erases the old digit
+static const uint8_t DIGIT_MAX_CHARS = 3;   // Widest label, a hex byte or 3 decimal digits
+
+// ST7789 vertical scroll. In rotation 1 (MV set, MY clear) the screen's x
+// is the GRAM row the panel scrolls by: with all 320 rows as the scroll
+// area, column x shows row (x + start) mod 320.
+static const uint8_t ST7789_VSCRDEF = 0x33;  // Top fixed, scroll and bottom fixed rows
+static const uint8_t ST7789_VSCSAD = 0x37;   // First row shown
+
+// World clock faces for WORLD_CLOCK_ZONES, below the top strip
+static constexpr WorldFace worldFaceAt(uint8_t index) {
+    return FaceGeometry::worldFace(WORLD_CLOCK_ZONES, index, SCREEN_W, CLOCK_TOP, SCREEN_H,
+                                   WORLD_LABEL_H, CLOCK_DOT_RADIUS);
+}
+static constexpr WorldFace WORLD_FACES[FaceGeometry::MAX_WORLD_FACES] = {
+    worldFaceAt(0), worldFaceAt(1), worldFaceAt(2), worldFaceAt(3)};
+
+static const char* const WEEKDAY_NAMES[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char* const MONTH_NAMES[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
 
 BinaryClockDisplay::BinaryClockDisplay(TFT_eSPI& display) 
-    : tft(display), layoutInitialized(false), digitsInitialized(false) {
+    : tft(display), encoding(ClockEncoding::BCD), columnCount(0), rowCount(4),
+      layoutInitialized(false), dotsValid(false), digitsInitialized(false),
+      lastStatusColor(0), statusDrawn(false), unsyncedShown(false), markerStale(false),
+      datePanel(&display), datePanelReady(false), renderedDay(-1), dateShown(false),
+      worldMode(false), worldValid(false), timerFace(false),
+      shift(0), shiftStep(BURNIN_SHIFT_STEP), staleColumns(0), worldLabelsStale(0),
+      panelModes(*this), nightMode(false),
+      onColor(ON_COLOR), offColor(OFF_COLOR), bgColor(BG_COLOR), digitColor(DIGIT_COLOR),
+      colWidth(CLOCK_COL_WIDTH), dotRadius(CLOCK_DOT_RADIUS),
+      gapSmall(CLOCK_GAP_SMALL), gapLarge(CLOCK_GAP_LARGE), pixelsPushed(0), dotsDrawn(0),
+      mirrorCanvas(nullptr), mirror(nullptr),
+      brightnessLevel(DEFAULT_BRIGHTNESS_INDEX), fadeTimeMs(BACKLIGHT_FADE_MS),
+      targetDuty(BacklightCurve::LEVEL_DUTY[DEFAULT_BRIGHTNESS_INDEX]),
+      fadeActive(false), fadePending(false), backlightDark(false) {
     // Initialize last displayed digits to invalid values
-    for (uint8_t i = 0; i < 6; i++) {
+    for (uint8_t i = 0; i < MAX_COLUMNS; i++) {
         lastDisplayedDigits[i] = 255;  // Invalid value to force initial draw
+        shownBits[i] = 0;
+    }
+    for (uint8_t f = 0; f < WORLD_CLOCK_ZONES; f++) {
+        worldStale[f] = 0;
+    }
+}
+
+void BinaryClockDisplay::writeCommand(uint8_t command, const uint8_t* data, uint8_t length) {
+    tft.writecommand(command);
+    for (uint8_t i = 0; i < length; i++) {
+        tft.writedata(data[i]);
     }
 }
 
@@ -13,7 +64,12 @@ void BinaryClockDisplay::init() {
     // Setup PWM for backlight
     ledcSetup(PWM_CHANNEL, PWM_FREQ, PWM_RESOLUTION);
     ledcAttachPin(PIN_BACKLIGHT, PWM_CHANNEL);
-    ledcWrite(PWM_CHANNEL, BRIGHTNESS_VALUES[DEFAULT_BRIGHTNESS_INDEX]);
+    ledcWrite(PWM_CHANNEL, BacklightCurve::LEVEL_DUTY[DEFAULT_BRIGHTNESS_INDEX]);
+    
+    // Hardware fade engine, with an end-of-fade interrupt for retargeting
+    ledc_fade_func_install(0);
+    ledc_cbs_t callbacks = {onFadeEnd};
+    ledc_cb_register(LEDC_LOW_SPEED_MODE, (ledc_channel_t)PWM_CHANNEL, &callbacks, this);
     
     // Initialize display power
     pinMode(PIN_POWER, OUTPUT);
@@ -21,150 +77,645 @@ void BinaryClockDisplay::init() {
     
     tft.init();
     tft.setRotation(1);
-    tft.fillScreen(BG_COLOR);
+    tft.fillScreen(bgColor);
+    
+#if BURNIN_SHIFT_ENABLED
+    // The whole panel scrolls, no fixed rows at either end
+    static const uint8_t area[6] = {0, 0, SCREEN_W >> 8, SCREEN_W & 0xFF, 0, 0};
+    writeCommand(ST7789_VSCRDEF, area, sizeof(area));
+    sendScrollStart();
+    clipToShown();
+#endif
     
     // Load custom font for time digits
     tft.loadFont(font18);
     
-    // Pre-calculate digit layouts with number of bits needed per column
-    // Column 0: Hours tens (0-2) = 2 bits
-    // Column 1: Hours ones (0-9) = 4 bits
-    // Column 2: Minutes tens (0-5) = 3 bits
-    // Column 3: Minutes ones (0-9) = 4 bits
-    // Column 4: Seconds tens (0-5) = 3 bits
-    // Column 5: Seconds ones (0-9) = 4 bits
-    const int totalWidth = (6 * CLOCK_COL_WIDTH) + (2 * CLOCK_GAP_SMALL) + (2 * CLOCK_GAP_LARGE) + (2 * CLOCK_GAP_SMALL);
-    int16_t x = (int16_t)((SCREEN_W - totalWidth) / 2);
-    
-    digitLayouts[0].x = x; digitLayouts[0].w = CLOCK_COL_WIDTH; digitLayouts[0].dotR = CLOCK_DOT_RADIUS; digitLayouts[0].numBits = 2;
-    x += CLOCK_COL_WIDTH + CLOCK_GAP_SMALL;
+#if DATE_PANEL_ENABLED
+    // Without the memory the clock just goes without a date
+    datePanel.setColorDepth(16);
+    datePanelReady = datePanel.createSprite(DATE_PANEL_W, DATE_PANEL_H) != nullptr;
+#endif
     
-    digitLayouts[1].x = x; digitLayouts[1].w = CLOCK_COL_WIDTH; digitLayouts[1].dotR = CLOCK_DOT_RADIUS; digitLayouts[1].numBits = 4;
-    x += CLOCK_COL_WIDTH + CLOCK_GAP_LARGE;
-    
-    digitLayouts[2].x = x; digitLayouts[2].w = CLOCK_COL_WIDTH; digitLayouts[2].dotR = CLOCK_DOT_RADIUS; digitLayouts[2].numBits = 3;
-    x += CLOCK_COL_WIDTH + CLOCK_GAP_SMALL;
-    
-    digitLayouts[3].x = x; digitLayouts[3].w = CLOCK_COL_WIDTH; digitLayouts[3].dotR = CLOCK_DOT_RADIUS; digitLayouts[3].numBits = 4;
-    x += CLOCK_COL_WIDTH + CLOCK_GAP_LARGE;
+    computeLayout();
+    layoutInitialized = true;
+}
+
+const ClockEncoding::Layout& BinaryClockDisplay::faceLayout() const {
+    return timerFace ? ClockEncoding::durationLayout() : ClockEncoding::layout(encoding);
+}
+
+void BinaryClockDisplay::computeLayout() {
+    // Columns as the encoding defines them (BCD: hours tens 2 bits, hours
+    // ones 4, minutes tens 3, ...), small gaps within a group and large ones
+    // between. Too wide for the screen (epoch) scales widths and gaps down.
+    const ClockEncoding::Layout& enc = faceLayout();
+    columnCount = enc.columns;
+    rowCount = enc.rows;
+    ClockEncoding::Fit fit = ClockEncoding::fit(enc, SCREEN_W, colWidth, gapSmall, gapLarge);
     
-    digitLayouts[4].x = x; digitLayouts[4].w = CLOCK_COL_WIDTH; digitLayouts[4].dotR = CLOCK_DOT_RADIUS; digitLayouts[4].numBits = 3;
-    x += CLOCK_COL_WIDTH + CLOCK_GAP_SMALL;
+    // Dots fit both the column and the row pitch
+    int r = dotRadius;
+    r = min(r, (fit.width - 1) / 2);
+    r = min(r, (CLOCK_BOTTOM - CLOCK_TOP) / rowCount / 2 - 1);
+    uint16_t dotPixels = (uint16_t)circlePixels(r);
     
-    digitLayouts[5].x = x; digitLayouts[5].w = CLOCK_COL_WIDTH; digitLayouts[5].dotR = CLOCK_DOT_RADIUS; digitLayouts[5].numBits = 4;
+    int16_t x = (int16_t)((SCREEN_W - fit.total) / 2);
+    for (uint8_t i = 0; i < columnCount; i++) {
+        digitLayouts[i].x = x;
+        digitLayouts[i].w = (uint8_t)fit.width;
+        digitLayouts[i].dotR = (uint8_t)r;
+        digitLayouts[i].numBits = enc.bits[i];
+        digitLayouts[i].dotPixels = dotPixels;
+        x += fit.width + (((enc.largeGapAfter >> i) & 1) ? fit.gapLarge : fit.gapSmall);
+    }
+}
+
+void BinaryClockDisplay::relayout() {
+    computeLayout();
     
-    layoutInitialized = true;
+    // Old dots may sit anywhere in the band; the digit row moves with them
+    paint(0, CLOCK_TOP, SCREEN_W, CLOCK_BOTTOM - CLOCK_TOP, [&](TFT_eSPI& g) {
+        g.fillRect(0, CLOCK_TOP, SCREEN_W, CLOCK_BOTTOM - CLOCK_TOP, bgColor);
+    });
+    pixelsPushed += SCREEN_W * (CLOCK_BOTTOM - CLOCK_TOP);
+    invalidateDigits();
+    dotsValid = false;
+    worldValid = false;
+    requestPanelMode();
 }
 
 void BinaryClockDisplay::setBrightness(uint8_t level) {
     if (level >= BRIGHTNESS_LEVELS) {
         level = BRIGHTNESS_LEVELS - 1;
     }
+    brightnessLevel = level;
+    startFade(BacklightCurve::LEVEL_DUTY[level]);
+}
+
+void BinaryClockDisplay::startFade(uint32_t duty) {
+    targetDuty = duty;
+    driveBacklight();
+}
+
+void BinaryClockDisplay::driveBacklight() {
+    uint32_t duty = backlightDark ? 0 : targetDuty;
+    
+    // The fade engine blocks if restarted mid-ramp; park the new target and
+    // let update() start it once the running ramp ends
+    if (fadeActive) {
+        fadePending = true;
+        return;
+    }
+    fadePending = false;
     
-    // Detach, reattach, write
-    ledcDetachPin(PIN_BACKLIGHT);
-    delay(10);
-    ledcAttachPin(PIN_BACKLIGHT, PWM_CHANNEL);
-    ledcWrite(PWM_CHANNEL, BRIGHTNESS_VALUES[level]);
+    uint32_t current = ledc_get_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)PWM_CHANNEL);
+    if (current == duty) {
+        return;
+    }
+    
+    // Scale the ramp by distance so small steps stay quick
+    const uint32_t maxDuty = BacklightCurve::MAX_DUTY;
+    uint32_t distance = current > duty ? current - duty : duty - current;
+    uint32_t ms = (uint32_t)fadeTimeMs * distance / maxDuty;
+    if (ms == 0) {
+        ledcWrite(PWM_CHANNEL, duty);
+        return;
+    }
+    
+    fadeActive = true;
+    ledc_set_fade_time_and_start(LEDC_LOW_SPEED_MODE, (ledc_channel_t)PWM_CHANNEL,
+                                 duty, ms, LEDC_FADE_NO_WAIT);
 }
 
-void BinaryClockDisplay::drawBCDDigit(uint8_t value, const DigitLayout& layout) {
-    const int vSpacing = (CLOCK_BOTTOM - CLOCK_TOP) / 4;
-    const int cx = layout.x + layout.w / 2;
+bool IRAM_ATTR BinaryClockDisplay::onFadeEnd(const ledc_cb_param_t* param, void* arg) {
+    if (param->event == LEDC_FADE_END_EVT) {
+        static_cast<BinaryClockDisplay*>(arg)->fadeActive = false;
+    }
+    return false;
+}
+
+void BinaryClockDisplay::update() {
+    if (fadePending && !fadeActive) {
+        driveBacklight();
+    }
+    panelModes.update(millis());
+}
+
+void BinaryClockDisplay::darkenBacklight(bool dark) {
+    backlightDark = dark;
+    driveBacklight();
+}
+
+void BinaryClockDisplay::setNightMode(bool on) {
+    nightMode = on;
+    requestPanelMode();
+}
+
+void BinaryClockDisplay::requestPanelMode() {
+    // Panel lines are screen columns in landscape: those under the dots and
+    // digit labels, plus the burn-in walk. World faces fill the width.
+    int first = 0;
+    int last = SCREEN_W - 1;
+    if (!worldMode && columnCount > 0) {
+        const int labelHalf = DIGIT_PADDING * DIGIT_MAX_CHARS / 2;
+        const DigitLayout& left = digitLayouts[0];
+        const DigitLayout& right = digitLayouts[columnCount - 1];
+        first = min((int)left.x, left.x + left.w / 2 - labelHalf) - BURNIN_SHIFT_MAX;
+        last = max(right.x + right.w - 1, right.x + right.w / 2 + labelHalf) + BURNIN_SHIFT_MAX;
+        first = max(first, 0);
+        last = min(last, SCREEN_W - 1);
+    }
+    panelModes.request(nightMode, (uint16_t)first, (uint16_t)last);
+}
+
+uint32_t BinaryClockDisplay::getBacklightDuty() const {
+    return ledc_get_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)PWM_CHANNEL);
+}
+
+void BinaryClockDisplay::setPalette(uint16_t on, uint16_t off) {
+    if (on == onColor && off == offColor) {
+        return;
+    }
+    onColor = on;
+    offColor = off;
+    dotsValid = false;
+    worldValid = false;
+}
+
+void BinaryClockDisplay::setEncoding(ClockEncoding::Type type) {
+    if (type == encoding || type >= ClockEncoding::TYPE_COUNT) {
+        return;
+    }
+    encoding = type;
+    if (layoutInitialized) {
+        relayout();
+    }
+}
+
+void BinaryClockDisplay::invalidateDigits() {
+    // A shown digit row is cleared and redrawn by the next drawClock()
+    for (uint8_t i = 0; i < MAX_COLUMNS; i++) {
+        lastDisplayedDigits[i] = 255;
+    }
+    digitsInitialized = false;
+}
+
+void BinaryClockDisplay::setBackground(uint16_t color) {
+    if (color == bgColor) {
+        return;
+    }
+    bgColor = color;
+    renderedDay = -1;
+    if (layoutInitialized) {
+        clearScreen();
+    }
+}
+
+void BinaryClockDisplay::clearScreen() {
+    // Wrapped edge columns too, they must match a new background
+    tft.resetViewport();
+    paint(0, 0, SCREEN_W, SCREEN_H, [&](TFT_eSPI& g) {
+        g.fillRect(0, 0, SCREEN_W, SCREEN_H, bgColor);
+    });
+    clipToShown();
+    pixelsPushed += SCREEN_W * SCREEN_H;
+    invalidateDigits();
+    dotsValid = false;
+    statusDrawn = false;
+    unsyncedShown = false;
+    markerStale = false;
+    dateShown = false;
+    worldValid = false;
+}
+
+void BinaryClockDisplay::setDigitColor(uint16_t color) {
+    if (color == digitColor) {
+        return;
+    }
+    digitColor = color;
+    invalidateDigits();
+    renderedDay = -1;
+    worldValid = false;
+}
+
+void BinaryClockDisplay::setLayout(uint8_t width, uint8_t radius, uint8_t small, uint8_t large) {
+    if (width == colWidth && radius == dotRadius && small == gapSmall && large == gapLarge) {
+        return;
+    }
+    colWidth = width;
+    dotRadius = radius;
+    gapSmall = small;
+    gapLarge = large;
+    if (!layoutInitialized) {
+        return;
+    }
+    relayout();
+}
+
+void BinaryClockDisplay::attachMirror(TFT_eSprite* canvas, DisplayMirror* target) {
+    mirrorCanvas = canvas;
+    mirror = target;
+    if (!canvas) {
+        return;
+    }
+    canvas->fillSprite(bgColor);
+    canvas->loadFont(font18);
     
-    static const uint8_t weights[4] = {8, 4, 2, 1};
+    // The canvas starts blank, so forget what the panel already shows
+    invalidateDigits();
+    dotsValid = false;
+    statusDrawn = false;
+    unsyncedShown = false;
+    markerStale = false;
+    dateShown = false;
+    worldValid = false;
+}
+
+template<typename Draw>
+void BinaryClockDisplay::paint(int16_t x, int16_t y, int16_t w, int16_t h, Draw draw) {
+    draw(tft);
+    if (mirrorCanvas) {
+        draw(*mirrorCanvas);
+        mirror->addDamage(x, y, w, h);
+    }
+}
+
+void BinaryClockDisplay::drawText(const char* text, int16_t x, int16_t y, uint8_t datum,
+                                  uint16_t fg, uint16_t bg, uint16_t padding) {
+    // Smooth fonts render the glyph box; padding widens it to erase old text
+    int16_t w = tft.textWidth(text);
+    if (w < (int16_t)padding) {
+        w = (int16_t)padding;
+    }
+    int16_t h = tft.fontHeight();
+    pixelsPushed += (uint32_t)w * h;
     
-    // Only draw the number of LEDs needed for this column
+    // Damage box from the datum, with a pixel of slack for glyph overhang
+    int16_t left = datum == MC_DATUM ? x - w / 2 : x;
+    int16_t top = datum == MC_DATUM ? y - h / 2 : y;
+    paint(left - 1, top - 1, w + 2, h + 2, [&](TFT_eSPI& g) {
+        g.setTextDatum(datum);
+        g.setTextColor(fg, bg);
+        g.setTextPadding(padding);
+        g.drawString(text, x, y);
+    });
+}
+
+void BinaryClockDisplay::drawStatusDot(uint16_t color) {
+    // Only touch the panel when the status actually changes
+    if (statusDrawn && color == lastStatusColor) {
+        return;
+    }
+    paint(STATUS_DOT_X - STATUS_DOT_RADIUS, STATUS_DOT_Y - STATUS_DOT_RADIUS,
+          2 * STATUS_DOT_RADIUS + 1, 2 * STATUS_DOT_RADIUS + 1, [&](TFT_eSPI& g) {
+        g.fillCircle(STATUS_DOT_X, STATUS_DOT_Y, STATUS_DOT_RADIUS, color);
+    });
+    pixelsPushed += STATUS_DOT_PIXELS;
+    lastStatusColor = color;
+    statusDrawn = true;
+}
+
+void BinaryClockDisplay::drawUnsyncedMarker(bool show) {
+    if (show == unsyncedShown && !markerStale) {
+        return;
+    }
+    if (show) {
+        drawText("NTP?", 4, 2, TL_DATUM, TFT_RED, bgColor, 0);
+    } else {
+        paint(0, 0, UNSYNCED_MARKER_W, CLOCK_TOP - 2, [&](TFT_eSPI& g) {
+            g.fillRect(0, 0, UNSYNCED_MARKER_W, CLOCK_TOP - 2, bgColor);
+        });
+        pixelsPushed += UNSYNCED_MARKER_W * (CLOCK_TOP - 2);
+    }
+    unsyncedShown = show;
+    markerStale = false;
+}
+
+void BinaryClockDisplay::renderDate(const struct tm& local) {
+    char text[16];
+    snprintf(text, sizeof(text), "%s %d %s", WEEKDAY_NAMES[local.tm_wday % 7], local.tm_mday,
+             MONTH_NAMES[local.tm_mon % 12]);
+    
+    // The sprite keeps its own font state; its glyph tables are only
+    // needed for this once-a-day render, so they don't stay on the heap
+    datePanel.loadFont(font18);
+    datePanel.fillSprite(bgColor);
+    datePanel.setTextDatum(MC_DATUM);
+    datePanel.setTextColor(digitColor, bgColor);
+    datePanel.drawString(text, DATE_PANEL_W / 2, DATE_PANEL_H / 2);
+    datePanel.unloadFont();
+}
+
+void BinaryClockDisplay::drawDate(const struct tm& local) {
+    if (!datePanelReady || worldMode) {
+        return;
+    }
+    int32_t day = local.tm_year * 366 + local.tm_yday;
+    if (day != renderedDay) {
+        renderDate(local);
+        renderedDay = day;
+        dateShown = false;
+    }
+    if (dateShown) {
+        return;
+    }
+    datePanel.pushSprite(DATE_PANEL_X, DATE_PANEL_Y);
+    if (mirrorCanvas) {
+        datePanel.pushToSprite(mirrorCanvas, DATE_PANEL_X, DATE_PANEL_Y);
+        mirror->addDamage(DATE_PANEL_X, DATE_PANEL_Y, DATE_PANEL_W, DATE_PANEL_H);
+    }
+    pixelsPushed += DATE_PANEL_W * DATE_PANEL_H;
+    dateShown = true;
+}
+
+void BinaryClockDisplay::paintDot(int16_t cx, int16_t cy, uint8_t r, uint16_t color, uint16_t pixels) {
+    paint(cx - r, cy - r, 2 * r + 1, 2 * r + 1, [&](TFT_eSPI& g) {
+        g.fillCircle(cx, cy, r, color);
+    });
+    pixelsPushed += pixels;
+    dotsDrawn++;
+}
+
+void BinaryClockDisplay::drawColumn(uint8_t value, uint8_t changed, const DigitLayout& layout) {
+    const int vSpacing = (CLOCK_BOTTOM - CLOCK_TOP) / rowCount;
+    const int16_t cx = (int16_t)(layout.x + layout.w / 2);
+    
+    // Columns are bottom-aligned: the least significant bit is the lowest dot
     for (uint8_t i = 0; i < layout.numBits; i++) {
-        // Start from the bottom (least significant bit position)
-        uint8_t bitPos = 4 - layout.numBits + i;
-        int cy = CLOCK_TOP + bitPos * vSpacing + vSpacing / 2;
-        bool on = (value & weights[bitPos]);
-        uint16_t color = on ? ON_COLOR : OFF_COLOR;
-        tft.fillCircle(cx, cy, layout.dotR, color);
+        uint8_t weight = (uint8_t)(1u << (layout.numBits - 1 - i));
+        if (!(changed & weight)) {
+            continue;
+        }
+        uint8_t row = rowCount - layout.numBits + i;
+        int16_t cy = (int16_t)(CLOCK_TOP + row * vSpacing + vSpacing / 2);
+        paintDot(cx, cy, layout.dotR, (value & weight) ? onColor : offColor, layout.dotPixels);
     }
 }
 
 void BinaryClockDisplay::clearTextArea() {
-    tft.fillRect(0, TEXT_AREA_TOP, SCREEN_W, TEXT_AREA_HEIGHT, BG_COLOR);
-}
-
-void BinaryClockDisplay::drawTimeDigits(uint8_t hour, uint8_t minute, uint8_t second,
-                                       const DigitLayout layouts[6]) {
-    // Extract current digits
-    uint8_t digits[6];
-    digits[0] = (uint8_t)(hour / 10);
-    digits[1] = (uint8_t)(hour % 10);
-    digits[2] = (uint8_t)(minute / 10);
-    digits[3] = (uint8_t)(minute % 10);
-    digits[4] = (uint8_t)(second / 10);
-    digits[5] = (uint8_t)(second % 10);
-    
-    // Setup font once (already loaded in init())
-    tft.setTextDatum(MC_DATUM);
-    tft.setTextColor(TFT_LIGHTGREY);
-    tft.setTextPadding(0);
-    
-    // First time: clear area and draw all digits
-    if (!digitsInitialized) {
+    paint(0, TEXT_AREA_TOP, SCREEN_W, TEXT_AREA_HEIGHT, [&](TFT_eSPI& g) {
+        g.fillRect(0, TEXT_AREA_TOP, SCREEN_W, TEXT_AREA_HEIGHT, bgColor);
+    });
+    pixelsPushed += SCREEN_W * TEXT_AREA_HEIGHT;
+}
+
+uint32_t BinaryClockDisplay::takePixelsPushed() {
+    uint32_t n = pixelsPushed;
+    pixelsPushed = 0;
+    return n;
+}
+
+uint32_t BinaryClockDisplay::takeDotsDrawn() {
+    uint32_t n = dotsDrawn;
+    dotsDrawn = 0;
+    return n;
+}
+
+void BinaryClockDisplay::drawTimeDigits(const ClockEncoding::Frame& frame) {
+    static const char* const formats[] = {"%u", "%02u", "%X"};
+    const char* format = formats[faceLayout().label];
+    
+    // First time: clear area and draw all labels (font already loaded in
+    // init()); after that only the ones that changed, padded to erase
+    bool first = !digitsInitialized;
+    if (first) {
         clearTextArea();
-        char buf[2] = {0, 0};
-        for (uint8_t i = 0; i < 6; i++) {
-            buf[0] = '0' + digits[i];
-            int cx = layouts[i].x + layouts[i].w / 2;
-            tft.drawString(buf, cx, TEXT_Y_POSITION);
-            lastDisplayedDigits[i] = digits[i];
-        }
-        digitsInitialized = true;
-    } else {
-        // Only update digits that changed (use padding to erase old text smoothly)
-        tft.setTextPadding(12);  // Padding width to cover old digit
-        char buf[2] = {0, 0};
-        for (uint8_t i = 0; i < 6; i++) {
-            if (digits[i] != lastDisplayedDigits[i]) {
-                int cx = layouts[i].x + layouts[i].w / 2;
-                
-                // Draw new digit with background padding (automatically erases old)
-                buf[0] = '0' + digits[i];
-                tft.setTextColor(TFT_LIGHTGREY, BG_COLOR);
-                tft.drawString(buf, cx, TEXT_Y_POSITION);
-                
-                lastDisplayedDigits[i] = digits[i];
-            }
+    }
+    char buf[4];
+    for (uint8_t i = 0; i < columnCount; i++) {
+        if (!first && frame.values[i] == lastDisplayedDigits[i]) {
+            continue;
         }
-        tft.setTextPadding(0);  // Reset padding
+        int len = snprintf(buf, sizeof(buf), format, frame.values[i]);
+        int cx = digitLayouts[i].x + digitLayouts[i].w / 2;
+        drawText(buf, cx, TEXT_Y_POSITION, MC_DATUM, digitColor, bgColor,
+                 first ? 0 : (uint16_t)(DIGIT_PADDING * len));
+        lastDisplayedDigits[i] = frame.values[i];
     }
+    digitsInitialized = true;
 }
 
-void BinaryClockDisplay::drawClock(uint8_t hour, uint8_t minute, uint8_t second, bool showDigits) {
-    if (!layoutInitialized) {
+void BinaryClockDisplay::drawClock(const struct tm& local, uint32_t epoch, bool showDigits) {
+    if (!layoutInitialized || worldMode || timerFace) {
         return;
     }
     
-    // Draw BCD digits
-    uint8_t digits[6];
-    digits[0] = (uint8_t)(hour / 10);
-    digits[1] = (uint8_t)(hour % 10);
-    digits[2] = (uint8_t)(minute / 10);
-    digits[3] = (uint8_t)(minute % 10);
-    digits[4] = (uint8_t)(second / 10);
-    digits[5] = (uint8_t)(second % 10);
-    
-    for (uint8_t i = 0; i < 6; i++) {
-        drawBCDDigit(digits[i], digitLayouts[i]);
+    ClockEncoding::Frame frame;
+    ClockEncoding::encode(encoding, local, epoch, frame);
+    drawFrame(frame, showDigits);
+}
+
+void BinaryClockDisplay::drawTimer(uint32_t ms, bool showDigits) {
+    if (!layoutInitialized || worldMode || !timerFace) {
+        return;
+    }
+    ClockEncoding::Frame frame;
+    ClockEncoding::encodeDuration(ms, frame);
+    drawFrame(frame, showDigits);
+}
+
+void BinaryClockDisplay::drawFrame(const ClockEncoding::Frame& frame, bool showDigits) {
+    // Only the dots whose bit flipped; every dot after an invalidation
+    for (uint8_t i = 0; i < columnCount; i++) {
+        uint8_t all = (uint8_t)((1u << digitLayouts[i].numBits) - 1);
+        bool known = dotsValid && !((staleColumns >> i) & 1);
+        uint8_t changed = known ? (uint8_t)((frame.bits[i] ^ shownBits[i]) & all) : all;
+        drawColumn(frame.bits[i], changed, digitLayouts[i]);
+        shownBits[i] = frame.bits[i];
     }
+    dotsValid = true;
+    staleColumns = 0;
     
     // Draw time digits if enabled
     if (showDigits) {
-        drawTimeDigits(hour, minute, second, digitLayouts);
+        drawTimeDigits(frame);
     } else {
         // Reset digits tracking when hiding
         if (digitsInitialized) {
             clearTextArea();
-            digitsInitialized = false;
-            for (uint8_t i = 0; i < 6; i++) {
-                lastDisplayedDigits[i] = 255;  // Reset to invalid
+            invalidateDigits();
+        }
+    }
+}
+
+void BinaryClockDisplay::setTimerFace(bool on) {
+    if (on == timerFace) {
+        return;
+    }
+    timerFace = on;
+    if (layoutInitialized) {
+        relayout();
+    }
+}
+
+void BinaryClockDisplay::setWorldMode(bool on) {
+    if (on == worldMode) {
+        return;
+    }
+    worldMode = on;
+    if (layoutInitialized) {
+        clearScreen();
+    }
+    requestPanelMode();
+}
+
+void BinaryClockDisplay::drawWorld(const struct tm* locals) {
+    if (!layoutInitialized || !worldMode) {
+        return;
+    }
+    for (uint8_t f = 0; f < WORLD_CLOCK_ZONES; f++) {
+        if (!worldValid || ((worldLabelsStale >> f) & 1)) {
+            drawText(WORLD_CLOCK_LABELS[f], WORLD_FACES[f].labelX, WORLD_FACES[f].labelY, MC_DATUM,
+                     digitColor, bgColor, 0);
+        }
+    }
+    worldLabelsStale = 0;
+    
+    const ClockEncoding::Layout& bcd = ClockEncoding::layout(ClockEncoding::BCD);
+    for (uint8_t f = 0; f < WORLD_CLOCK_ZONES; f++) {
+        const WorldFace& face = WORLD_FACES[f];
+        ClockEncoding::Frame frame;
+        ClockEncoding::encode(ClockEncoding::BCD, locals[f], 0, frame);
+        
+        // This face's dirty mask: columns with a flipped bit. Zones differ
+        // by whole quarter hours, so most ticks it is just the seconds.
+        uint8_t dirty = 0;
+        for (uint8_t c = 0; c < FaceGeometry::WORLD_COLUMNS; c++) {
+            if (!worldValid || frame.bits[c] != worldBits[f][c]) {
+                dirty |= (uint8_t)(1u << c);
+            }
+        }
+        uint8_t stale = worldStale[f];
+        dirty |= stale;
+        worldStale[f] = 0;
+        for (uint8_t c = 0; dirty; c++, dirty >>= 1) {
+            if (!(dirty & 1)) {
+                continue;
             }
+            uint8_t numBits = bcd.bits[c];
+            uint8_t all = (uint8_t)((1u << numBits) - 1);
+            bool known = worldValid && !((stale >> c) & 1);
+            uint8_t changed = known ? (uint8_t)((frame.bits[c] ^ worldBits[f][c]) & all) : all;
+            for (uint8_t i = 0; i < numBits; i++) {
+                uint8_t weight = (uint8_t)(1u << (numBits - 1 - i));
+                if (changed & weight) {
+                    paintDot(face.colX[c], face.rowY[FaceGeometry::WORLD_ROWS - numBits + i], face.dotR,
+                             (frame.bits[c] & weight) ? onColor : offColor, face.dotPixels);
+                }
+            }
+            worldBits[f][c] = frame.bits[c];
+        }
+    }
+    worldValid = true;
+}
+
+void BinaryClockDisplay::sendScrollStart() {
+    // Row -shift at the left edge moves everything shift to the right
+    uint16_t start = (uint16_t)((SCREEN_W - shift) % SCREEN_W);
+    uint8_t data[2] = {(uint8_t)(start >> 8), (uint8_t)start};
+    writeCommand(ST7789_VSCSAD, data, sizeof(data));
+}
+
+void BinaryClockDisplay::clipToShown() {
+    // Wrapped columns (the right edge while moved right, the left edge while
+    // moved left) would show at the far side, so drawing stays off them
+    int16_t left = shift < 0 ? -shift : 0;
+    int16_t right = shift > 0 ? shift : 0;
+    if (left || right) {
+        tft.setViewport(left, 0, SCREEN_W - left - right, SCREEN_H, false);
+    } else {
+        tft.resetViewport();
+    }
+}
+
+void BinaryClockDisplay::setShift(int8_t px) {
+    if (px > BURNIN_SHIFT_MAX) {
+        px = BURNIN_SHIFT_MAX;
+    } else if (px < -BURNIN_SHIFT_MAX) {
+        px = -BURNIN_SHIFT_MAX;
+    }
+    if (px == shift) {
+        return;
+    }
+    int16_t leftBefore = shift < 0 ? -shift : 0;
+    int16_t rightBefore = shift > 0 ? shift : 0;
+    shift = px;
+    if (!layoutInitialized) {
+        return;
+    }
+    int16_t left = shift < 0 ? -shift : 0;
+    int16_t right = shift > 0 ? shift : 0;
+    
+    // Cleared while still in place, so they show up at the far side blank
+    if (left > leftBefore) {
+        clearEdge(leftBefore, left - leftBefore);
+    }
+    if (right > rightBefore) {
+        clearEdge(SCREEN_W - right, right - rightBefore);
+    }
+    sendScrollStart();
+    clipToShown();
+    if (left < leftBefore) {
+        uncoverEdge(left, leftBefore - left);
+    }
+    if (right < rightBefore) {
+        uncoverEdge(SCREEN_W - rightBefore, rightBefore - right);
+    }
+}
+
+void BinaryClockDisplay::stepShift() {
+    // 0, 1, .. MAX, MAX-1, .. -MAX, .. and so on
+    if (shift + shiftStep > BURNIN_SHIFT_MAX || shift + shiftStep < -BURNIN_SHIFT_MAX) {
+        shiftStep = (int8_t)-shiftStep;
+    }
+    setShift((int8_t)(shift + shiftStep));
+}
+
+void BinaryClockDisplay::clearEdge(int16_t x, int16_t w) {
+    // Panel only: the mirror shows the face unshifted
+    tft.fillRect(x, 0, w, SCREEN_H, bgColor);
+    pixelsPushed += (uint32_t)w * SCREEN_H;
+}
+
+void BinaryClockDisplay::uncoverEdge(int16_t x, int16_t w) {
+    // These columns were cleared when they wrapped; whatever overlaps them
+    // is drawn again, whole, by its next draw call
+    auto touches = [&](int16_t left, int16_t width) {
+        return left < x + w && x < left + width;
+    };
+    if (statusDrawn && touches(STATUS_DOT_X - STATUS_DOT_RADIUS, 2 * STATUS_DOT_RADIUS + 1)) {
+        statusDrawn = false;
+    }
+    if (unsyncedShown && touches(0, UNSYNCED_MARKER_W)) {
+        markerStale = true;
+    }
+    if (dateShown && touches(DATE_PANEL_X, DATE_PANEL_W)) {
+        dateShown = false;
+    }
+    
+    if (worldMode) {
+        for (uint8_t f = 0; f < WORLD_CLOCK_ZONES; f++) {
+            const WorldFace& face = WORLD_FACES[f];
+            int16_t half = tft.textWidth(WORLD_CLOCK_LABELS[f]) / 2 + 1;
+            if (touches(face.labelX - half, 2 * half)) {
+                worldLabelsStale |= (uint8_t)(1u << f);
+            }
+            for (uint8_t c = 0; c < FaceGeometry::WORLD_COLUMNS; c++) {
+                if (touches(face.colX[c] - face.dotR, 2 * face.dotR + 1)) {
+                    worldStale[f] |= (uint8_t)(1u << c);
+                }
+            }
+        }
+        return;
+    }
+    const int16_t labelHalf = DIGIT_PADDING * DIGIT_MAX_CHARS / 2;
+    for (uint8_t i = 0; i < columnCount; i++) {
+        const DigitLayout& layout = digitLayouts[i];
+        if (touches(layout.x, layout.w)) {
+            staleColumns |= (uint8_t)(1u << i);
+        }
+        if (touches(layout.x + layout.w / 2 - labelHalf, 2 * labelHalf)) {
+            lastDisplayedDigits[i] = 255;
         }
     }
 }
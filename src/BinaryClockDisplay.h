@@ -2,15 +2,106 @@
 #define BINARY_CLOCK_DISPLAY_H
 
 #include <TFT_eSPI.h>
+#include <driver/ledc.h>
 #include "config.h"
+#include "ClockEncoding.h"
+#include "FaceGeometry.h"
+#include "PanelModeSequencer.h"
 
-class BinaryClockDisplay {
+class DisplayMirror;
+
+static_assert(DATE_PANEL_W * DATE_PANEL_H * 2 <= DATE_PANEL_BUDGET_BYTES,
+              "Date panel image exceeds DATE_PANEL_BUDGET_BYTES");
+static_assert(WORLD_CLOCK_ZONES >= 1 && WORLD_CLOCK_ZONES <= FaceGeometry::MAX_WORLD_FACES,
+              "WORLD_CLOCK_ZONES must be 1-4");
+static_assert(WORLD_CLOCK_ZONES <= sizeof(WORLD_CLOCK_TZ) / sizeof(WORLD_CLOCK_TZ[0]) &&
+              WORLD_CLOCK_ZONES <= sizeof(WORLD_CLOCK_LABELS) / sizeof(WORLD_CLOCK_LABELS[0]),
+              "WORLD_CLOCK_ZONES exceeds the zone list");
+static_assert(BURNIN_SHIFT_STEP >= 1 && BURNIN_SHIFT_STEP <= BURNIN_SHIFT_MAX &&
+              BURNIN_SHIFT_MAX <= 32, "BURNIN_SHIFT_STEP must be 1-MAX, BURNIN_SHIFT_MAX at most 32");
+
+class BinaryClockDisplay : private PanelPort {
 public:
     BinaryClockDisplay(TFT_eSPI& display);
     
     void init();
-    void drawClock(uint8_t hour, uint8_t minute, uint8_t second, bool showDigits);
+    // Repaints only the dots whose bit changed since the last call (all of
+    // them after anything that invalidated the face)
+    void drawClock(const struct tm& local, uint32_t epoch, bool showDigits);
+    
+    // Backlight: hardware fades, never blocks. A new target while a fade
+    // runs is picked up by update() as soon as the current ramp ends, and
+    // one set while a night mode switch holds it dark once that is done.
     void setBrightness(uint8_t level);
+    void setBacklightDuty(uint32_t duty) { startFade(duty); }
+    void setFadeTime(uint16_t ms) { fadeTimeMs = ms; }
+    void update();
+    uint8_t getBrightnessLevel() const { return brightnessLevel; }
+    uint32_t getBacklightDuty() const;
+    uint32_t getTargetDuty() const { return targetDuty; }
+    bool isFading() const { return fadeActive || fadePending; }
+    
+    // Dot colors; takes effect on the next drawClock()
+    void setPalette(uint16_t on, uint16_t off);
+    // Clears the dot area and digit row for the new layout, like setLayout()
+    void setEncoding(ClockEncoding::Type type);
+    ClockEncoding::Type getEncoding() const { return encoding; }
+    // Repaints only what depends on them: the background change clears the
+    // whole screen, a digit color change just the digit row, a layout change
+    // the dot area and digit row. The dots come back on the next drawClock().
+    // Before init() these only record the values.
+    void setBackground(uint16_t color);
+    void setDigitColor(uint16_t color);
+    void setLayout(uint8_t colWidth, uint8_t dotRadius, uint8_t gapSmall, uint8_t gapLarge);
+    void drawStatusDot(uint16_t color);
+    void drawUnsyncedMarker(bool show);
+    // Weekday, day and month above the dots. The text is rendered into a
+    // cached sprite only when the day changes and pushed only when the
+    // panel lost it; any other call is two compares.
+    void drawDate(const struct tm& local);
+    
+    // World clock: WORLD_CLOCK_ZONES compact BCD faces in place of the main
+    // face and date. Switching clears the screen; the faces come back on the
+    // next drawWorld(), which like drawClock() repaints only flipped dots.
+    // drawClock(), drawTimer() and drawDate() do nothing while it is on.
+    void setWorldMode(bool on);
+    bool isWorldMode() const { return worldMode; }
+    // locals: one local time per zone, in WORLD_CLOCK_TZ order
+    void drawWorld(const struct tm* locals);
+    
+    // Stopwatch/countdown: the dots show MM SS mmm (durationLayout()) in
+    // place of the encoding's layout. Switching relayouts like
+    // setEncoding(); drawTimer() repaints only flipped dots, like drawClock(),
+    // which does nothing meanwhile.
+    void setTimerFace(bool on);
+    bool isTimerFace() const { return timerFace; }
+    void drawTimer(uint32_t ms, bool showDigits);
+    
+    // Burn-in shift: the face moved px sideways (within +-BURNIN_SHIFT_MAX)
+    // by the panel's hardware scroll rather than redrawn. Edge columns that
+    // wrap round are cleared and left out of later draws; those that scroll
+    // back in make only the elements touching them stale, and the next
+    // draw calls repaint those. Before init() this only records px.
+    void setShift(int8_t px);
+    int8_t getShift() const { return shift; }
+    // One BURNIN_SHIFT_STEP along the walk between the bounds
+    void stepShift();
+    
+    // Night low-power panel: only the lines under the dots are driven, in
+    // 8 colors (PanelModeSequencer). The switch happens behind a dark
+    // backlight over the next update() calls; relayouts and the world
+    // clock move the driven lines along.
+    void setNightMode(bool on);
+    bool isNightMode() const { return nightMode; }
+    
+    // Pixels written to the panel since the last call (approximate for text)
+    uint32_t takePixelsPushed();
+    // Dots repainted since the last call
+    uint32_t takeDotsDrawn();
+    
+    // Repeat every draw on canvas (a created 16-bit sprite of the screen
+    // size) and report the touched areas to mirror. Forces a full redraw.
+    void attachMirror(TFT_eSprite* canvas, DisplayMirror* mirror);
     
 private:
     TFT_eSPI& tft;
@@ -20,17 +111,86 @@ private:
         uint8_t w;
         uint8_t dotR;
         uint8_t numBits;  // Number of LEDs to display for this column
+        uint16_t dotPixels;  // Pixels in one filled dot
     };
+    static const uint8_t MAX_COLUMNS = ClockEncoding::MAX_COLUMNS;
     
-    void drawBCDDigit(uint8_t value, const DigitLayout& layout);
-    void drawTimeDigits(uint8_t hour, uint8_t minute, uint8_t second, 
-                       const DigitLayout layouts[6]);
+    // Runs draw on the panel and, when mirroring, on the canvas too
+    template<typename Draw>
+    void paint(int16_t x, int16_t y, int16_t w, int16_t h, Draw draw);
+    void drawText(const char* text, int16_t x, int16_t y, uint8_t datum,
+                  uint16_t fg, uint16_t bg, uint16_t padding);
+    const ClockEncoding::Layout& faceLayout() const;
+    void computeLayout();
+    void relayout();
+    void invalidateDigits();
+    void paintDot(int16_t cx, int16_t cy, uint8_t r, uint16_t color, uint16_t pixels);
+    void drawColumn(uint8_t value, uint8_t changed, const DigitLayout& layout);
+    void drawTimeDigits(const ClockEncoding::Frame& frame);
+    void drawFrame(const ClockEncoding::Frame& frame, bool showDigits);
     void clearTextArea();
+    void clearScreen();
+    void renderDate(const struct tm& local);
+    void sendScrollStart();
+    void clipToShown();
+    void clearEdge(int16_t x, int16_t w);
+    void uncoverEdge(int16_t x, int16_t w);
+    void startFade(uint32_t duty);
+    void driveBacklight();
+    void requestPanelMode();
+    // PanelPort
+    void writeCommand(uint8_t command, const uint8_t* data, uint8_t length) override;
+    void darkenBacklight(bool dark) override;
+    bool backlightSettled() override { return !isFading(); }
+    static bool IRAM_ATTR onFadeEnd(const ledc_cb_param_t* param, void* arg);
     
-    DigitLayout digitLayouts[6];
+    ClockEncoding::Type encoding;
+    uint8_t columnCount;
+    uint8_t rowCount;
+    DigitLayout digitLayouts[MAX_COLUMNS];
     bool layoutInitialized;
-    uint8_t lastDisplayedDigits[6];  // Track last displayed digits to prevent flicker
+    uint8_t shownBits[MAX_COLUMNS];  // Dot pattern on the panel, per column
+    bool dotsValid;
+    uint8_t lastDisplayedDigits[MAX_COLUMNS];  // Track last displayed digits to prevent flicker
     bool digitsInitialized;
+    uint16_t lastStatusColor;
+    bool statusDrawn;
+    bool unsyncedShown;
+    bool markerStale;        // Shown but partly scrolled back in
+    TFT_eSprite datePanel;   // DATE_PANEL_W x DATE_PANEL_H, 16-bit
+    bool datePanelReady;     // Sprite allocated
+    int32_t renderedDay;     // Day the sprite holds, -1 when stale
+    bool dateShown;          // Sprite is on the panel
+    bool worldMode;
+    bool worldValid;         // Labels and worldBits are on the panel
+    uint8_t worldBits[WORLD_CLOCK_ZONES][FaceGeometry::WORLD_COLUMNS];
+    bool timerFace;
+    int8_t shift;            // Face offset in pixels, + is to the right
+    int8_t shiftStep;        // Next step of the walk, +-BURNIN_SHIFT_STEP
+    uint8_t staleColumns;    // Dot columns scrolled back in, redrawn whole
+    uint8_t worldStale[WORLD_CLOCK_ZONES];  // Likewise per world face
+    uint8_t worldLabelsStale;               // Faces whose label needs redrawing
+    PanelModeSequencer panelModes;
+    bool nightMode;
+    uint16_t onColor;
+    uint16_t offColor;
+    uint16_t bgColor;
+    uint16_t digitColor;
+    uint8_t colWidth;
+    uint8_t dotRadius;
+    uint8_t gapSmall;
+    uint8_t gapLarge;
+    uint32_t pixelsPushed;
+    uint32_t dotsDrawn;
+    TFT_eSprite* mirrorCanvas;
+    DisplayMirror* mirror;
+    
+    uint8_t brightnessLevel;
+    uint16_t fadeTimeMs;
+    uint32_t targetDuty;
+    volatile bool fadeActive;
+    bool fadePending;
+    bool backlightDark;      // Held off for a panel mode switch
 };
 
 #endif // BINARY_CLOCK_DISPLAY_H
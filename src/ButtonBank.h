@@ -0,0 +1,95 @@
+#ifndef BUTTON_BANK_H
+#define BUTTON_BANK_H
+
+#include <Arduino.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#include <algorithm>
+#include <type_traits>
+
+// Active-low buttons on the pins given as template arguments. All pins are
+// sampled with one read of the GPIO input register (two only if a pin is
+// >= 32) and debounced together with 2-bit vertical counters: a bit must
+// disagree with its debounced state for four consecutive samples before it
+// flips. State lives in the GPIO bit positions, so edge
+// detection is a handful of word-wide bitwise ops regardless of N.
+template <uint8_t... Pins>
+class ButtonBank {
+public:
+    static constexpr uint8_t COUNT = sizeof...(Pins);
+    static_assert(COUNT >= 1 && COUNT <= 32, "ButtonBank supports 1 to 32 buttons");
+
+private:
+    static constexpr uint8_t MAX_PIN = std::max({Pins...});
+    static_assert(MAX_PIN < 64, "GPIO number out of range");
+
+public:
+    // Narrowest word that covers every configured pin
+    typedef typename std::conditional<(MAX_PIN < 32), uint32_t, uint64_t>::type Word;
+
+    static constexpr Word MASK = ((Word(1) << Pins) | ...);
+
+    ButtonBank() : state(0), cnt0(0), cnt1(0) {
+        static const uint8_t pins[COUNT] = {Pins...};
+        memset(bitToIndex, 0xFF, sizeof(bitToIndex));
+        for (uint8_t i = 0; i < COUNT; i++) {
+            bitToIndex[pins[i]] = i;
+        }
+    }
+
+    void init() {
+        (pinMode(Pins, INPUT_PULLUP), ...);
+        state = readPressed();
+        cnt0 = cnt1 = 0;
+    }
+
+    static uint8_t pin(uint8_t index) {
+        static const uint8_t pins[COUNT] = {Pins...};
+        return pins[index];
+    }
+
+    // One sample. Returns the bits whose debounced state flipped.
+    Word step() {
+        Word delta = readPressed() ^ state;
+        cnt1 = (cnt1 ^ cnt0) & delta;
+        cnt0 = ~cnt0 & delta;
+        Word toggled = delta & ~(cnt0 | cnt1);
+        state ^= toggled;
+        pendingDelta = delta ^ toggled;
+        return toggled;
+    }
+
+    // Debounced pressed state, one bit per GPIO
+    Word pressed() const { return state; }
+
+    // No raw input disagrees with the debounced state
+    bool settled() const { return pendingDelta == 0; }
+
+    // Button index for a GPIO bit set in a Word returned by step()
+    uint8_t indexOfBit(uint8_t bit) const { return bitToIndex[bit]; }
+
+    static uint8_t lowestBit(Word word) {
+        if constexpr (sizeof(Word) == 4) {
+            return (uint8_t)__builtin_ctz(word);
+        } else {
+            return (uint8_t)__builtin_ctzll(word);
+        }
+    }
+
+private:
+    static Word readPressed() {
+        Word raw = REG_READ(GPIO_IN_REG);
+        if constexpr (sizeof(Word) == 8) {
+            raw |= (Word)REG_READ(GPIO_IN1_REG) << 32;
+        }
+        return ~raw & MASK;  // Active low
+    }
+
+    Word state;
+    Word cnt0;
+    Word cnt1;
+    Word pendingDelta = 0;
+    uint8_t bitToIndex[MAX_PIN + 1];
+};
+
+#endif // BUTTON_BANK_H
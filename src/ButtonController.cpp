@@ -1,15 +1,128 @@
 #include "ButtonController.h"
 
 ButtonController::ButtonController()
-    : lastBootState(HIGH), lastBrightnessState(HIGH),
-      lastBootPress(0), lastBrightnessPress(0),
-      brightnessLevel(DEFAULT_BRIGHTNESS_INDEX),
-      onTimeToggle(nullptr), onBrightnessChange(nullptr) {
+    : sampleTimer(nullptr), sampleLock(portMUX_INITIALIZER_UNLOCKED),
+      sampling(false), edgeCount(0), edgePending(0),
+      queueHead(0), queueTail(0), droppedEvents(0), notifyTask(nullptr),
+      brightnessLevel(DEFAULT_BRIGHTNESS_INDEX), brightnessButton(true),
+      onTimeToggle(nullptr), onBrightnessChange(nullptr), onOtherGesture(nullptr) {
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        slots[i].owner = this;
+        slots[i].index = i;
+        edgeUs[i] = 0;
+        pressedAtUs[i] = 0;
+    }
 }
 
 void ButtonController::init() {
-    pinMode(PIN_BUTTON_BOOT, INPUT_PULLUP);
-    pinMode(PIN_BUTTON_IO14, INPUT_PULLUP);
+    // setup() runs on the loop task, so this is who waitForEvent() wakes
+    notifyTask = xTaskGetCurrentTaskHandle();
+
+    static const GestureRecognizer::ButtonConfig gestureConfigs[BUTTON_COUNT] = {BUTTON_GESTURES};
+    gestures.begin(gestureConfigs, BUTTON_COUNT);
+    gestures.setCallback(onGesture, this);
+
+    bank.init();
+
+    esp_timer_create_args_t args = {};
+    args.callback = onSample;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "btn_sample";
+    esp_timer_create(&args, &sampleTimer);
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        attachInterruptArg(Bank::pin(i), onEdge, &slots[i], CHANGE);
+    }
+}
+
+void IRAM_ATTR ButtonController::onEdge(void* arg) {
+    EdgeSlot* slot = static_cast<EdgeSlot*>(arg);
+    ButtonController* self = slot->owner;
+    uint32_t bit = 1u << slot->index;
+
+    // Timestamp the first edge of a burst; the bounce that follows is
+    // absorbed by the vertical counters in the sample timer
+    portENTER_CRITICAL_ISR(&self->sampleLock);
+    self->edgeCount++;
+    if (!(self->edgePending & bit)) {
+        self->edgeUs[slot->index] = esp_timer_get_time();
+        self->edgePending |= bit;
+    }
+    if (!self->sampling) {
+        self->sampling = true;
+        esp_timer_start_periodic(self->sampleTimer, BUTTON_SAMPLE_US);
+    }
+    portEXIT_CRITICAL_ISR(&self->sampleLock);
+}
+
+void ButtonController::onSample(void* arg) {
+    ButtonController* self = static_cast<ButtonController*>(arg);
+    Bank& bank = self->bank;
+
+    // Edges up to here are in the sample below; any later one is not
+    portENTER_CRITICAL(&self->sampleLock);
+    uint32_t edgesSeen = self->edgeCount;
+    portEXIT_CRITICAL(&self->sampleLock);
+
+    Bank::Word toggled = bank.step();
+    Bank::Word pressed = bank.pressed();
+
+    // Visit only the bits that flipped, not every pin
+    while (toggled) {
+        uint8_t bit = Bank::lowestBit(toggled);
+        toggled &= toggled - 1;
+
+        uint8_t index = bank.indexOfBit(bit);
+        portENTER_CRITICAL(&self->sampleLock);
+        Event event = {index, (pressed >> bit) & 1 ? true : false, self->edgeUs[index]};
+        self->edgePending &= ~(1u << index);
+        portEXIT_CRITICAL(&self->sampleLock);
+
+        self->pushEvent(event);
+    }
+
+    // Stop sampling once every input agrees with its debounced state. An
+    // edge since the read above found sampling on and left the timer
+    // running, so keep it going to pick that edge up.
+    portENTER_CRITICAL(&self->sampleLock);
+    if (bank.settled() && self->edgeCount == edgesSeen) {
+        esp_timer_stop(self->sampleTimer);
+        self->sampling = false;
+        self->edgePending = 0;  // Bounce that settled back without a flip
+    }
+    portEXIT_CRITICAL(&self->sampleLock);
+}
+
+void ButtonController::pushEvent(const Event& event) {
+    uint8_t head = queueHead.load(std::memory_order_relaxed);
+    uint8_t next = (uint8_t)((head + 1) % BUTTON_EVENT_QUEUE_SIZE);
+    if (next == queueTail.load(std::memory_order_acquire)) {
+        droppedEvents++;
+        return;
+    }
+    queue[head] = event;
+    queueHead.store(next, std::memory_order_release);
+
+    if (notifyTask) {
+        xTaskNotifyGive(notifyTask);
+    }
+}
+
+bool ButtonController::popEvent(Event& event) {
+    uint8_t tail = queueTail.load(std::memory_order_relaxed);
+    if (tail == queueHead.load(std::memory_order_acquire)) {
+        return false;
+    }
+    event = queue[tail];
+    queueTail.store((uint8_t)((tail + 1) % BUTTON_EVENT_QUEUE_SIZE), std::memory_order_release);
+    return true;
+}
+
+bool ButtonController::waitForEvent(uint32_t timeoutMs) {
+    // Wake up in time for pending long-press/double-tap/repeat deadlines
+    timeoutMs = gestures.msUntilDeadline(millis(), timeoutMs);
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs)) > 0;
 }
 
 void ButtonController::setTimeToggleCallback(void (*callback)()) {
@@ -20,36 +133,52 @@ void ButtonController::setBrightnessCallback(void (*callback)(uint8_t)) {
     onBrightnessChange = callback;
 }
 
-void ButtonController::update() {
-    unsigned long now = millis();
-    
-    // GPIO 0: Time display toggle
-    bool bootState = digitalRead(PIN_BUTTON_BOOT);
-    if (bootState == LOW && lastBootState == HIGH) {
-        if (now - lastBootPress > BUTTON_DEBOUNCE_MS) {
-            if (onTimeToggle) {
-                onTimeToggle();
-            }
-            lastBootPress = now;
+void ButtonController::setGestureCallback(void (*callback)(uint8_t, GestureRecognizer::Gesture,
+                                                            uint8_t)) {
+    onOtherGesture = callback;
+}
+
+void ButtonController::onGesture(void* context, uint8_t button,
+                                 GestureRecognizer::Gesture gesture, uint8_t chordMask) {
+    static_cast<ButtonController*>(context)->handleGesture(button, gesture, chordMask);
+}
+
+void ButtonController::handleGesture(uint8_t button, GestureRecognizer::Gesture gesture,
+                                     uint8_t chordMask) {
+    if (button == BUTTON_BOOT && gesture == GestureRecognizer::GESTURE_SHORT) {
+        // GPIO 0: Time display toggle
+        if (onTimeToggle) {
+            onTimeToggle();
+        }
+    } else if (button == BUTTON_IO14 && brightnessButton &&
+               gesture != GestureRecognizer::GESTURE_DOUBLE &&
+               gesture != GestureRecognizer::GESTURE_CHORD) {
+        // GPIO 14: Brightness cycling, held down it keeps stepping
+        brightnessLevel++;
+        if (brightnessLevel >= BRIGHTNESS_LEVELS) {
+            brightnessLevel = 0;
         }
+        if (onBrightnessChange) {
+            onBrightnessChange(brightnessLevel);
+        }
+    } else if (onOtherGesture) {
+        onOtherGesture(button, gesture, chordMask);
     }
-    lastBootState = bootState;
-    
-    // GPIO 14: Brightness cycling
-    bool brightnessState = digitalRead(PIN_BUTTON_IO14);
-    if (brightnessState == LOW && lastBrightnessState == HIGH) {
-        if (now - lastBrightnessPress > BUTTON_DEBOUNCE_MS) {
-            brightnessLevel++;
-            if (brightnessLevel >= BRIGHTNESS_LEVELS) {
-                brightnessLevel = 0;
-            }
-            
-            if (onBrightnessChange) {
-                onBrightnessChange(brightnessLevel);
-            }
-            
-            lastBrightnessPress = now;
+}
+
+void ButtonController::update() {
+    // Gestures complete on an edge or on a deadline, but are reported with
+    // the first raw edge of the press behind them. Deadlines that fell
+    // before an edge fire first, while pressedAtUs still holds their press.
+    Event event;
+    while (popEvent(event)) {
+        uint32_t eventMs = (uint32_t)(event.timestampUs / 1000);
+        gestures.poll(eventMs);
+        if (event.pressed) {
+            pressedAtUs[event.button] = event.timestampUs;
         }
+        gestures.feed(event.button, event.pressed, eventMs);
     }
-    lastBrightnessState = brightnessState;
+
+    gestures.poll((uint32_t)(esp_timer_get_time() / 1000));
 }
@@ -2,30 +2,98 @@
 #define BUTTON_CONTROLLER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
 #include "config.h"
+#include "ButtonBank.h"
+#include "GestureRecognizer.h"
 
 class ButtonController {
 public:
+    typedef ButtonBank<BUTTON_PINS> Bank;
+
+    // Indices into BUTTON_PINS; extra external buttons follow these two
+    enum ButtonId : uint8_t {
+        BUTTON_BOOT = 0,
+        BUTTON_IO14 = 1
+    };
+    static constexpr uint8_t BUTTON_COUNT = Bank::COUNT;
+
+    // Debounced edge, timestamped at the first raw edge (esp_timer_get_time)
+    struct Event {
+        uint8_t button;
+        bool pressed;
+        int64_t timestampUs;
+    };
+
     ButtonController();
-    
+
     void init();
     void update();
-    
+
+    // Sleep until a button event arrives or the timeout expires
+    bool waitForEvent(uint32_t timeoutMs);
+
     void setTimeToggleCallback(void (*callback)());
     void setBrightnessCallback(void (*callback)(uint8_t));
-    
+    // Gestures not bound to the toggle/brightness actions above
+    void setGestureCallback(void (*callback)(uint8_t button, GestureRecognizer::Gesture gesture,
+                                             uint8_t chordMask));
+
     uint8_t getCurrentBrightnessLevel() const { return brightnessLevel; }
-    
+    // Keeps button cycling in step with levels set from elsewhere
+    void setCurrentBrightnessLevel(uint8_t level) { brightnessLevel = level; }
+    // First raw edge of the button's latest press, whenever its gesture
+    // fired: the start of a gesture's press-to-pixel time
+    int64_t getPressedAtUs(uint8_t button) const { return pressedAtUs[button]; }
+    // Off: IO14 gestures go to the gesture callback instead of cycling
+    // brightness (the stopwatch uses it for lap/reset)
+    void setBrightnessButton(bool enabled) { brightnessButton = enabled; }
+    uint32_t getDroppedEvents() const { return droppedEvents; }
+
 private:
-    bool lastBootState;
-    bool lastBrightnessState;
-    unsigned long lastBootPress;
-    unsigned long lastBrightnessPress;
-    
+    // Per-pin interrupt argument
+    struct EdgeSlot {
+        ButtonController* owner;
+        uint8_t index;
+    };
+
+    static void IRAM_ATTR onEdge(void* arg);
+    static void onSample(void* arg);
+
+    void pushEvent(const Event& event);
+    bool popEvent(Event& event);
+    static void onGesture(void* context, uint8_t button, GestureRecognizer::Gesture gesture,
+                          uint8_t chordMask);
+    void handleGesture(uint8_t button, GestureRecognizer::Gesture gesture, uint8_t chordMask);
+
+    Bank bank;
+    EdgeSlot slots[BUTTON_COUNT];
+    esp_timer_handle_t sampleTimer;
+
+    // Written by the edge ISR, consumed by the sample timer (under sampleLock)
+    portMUX_TYPE sampleLock;
+    volatile bool sampling;
+    volatile uint32_t edgeCount;         // Every edge, bounce included
+    volatile uint32_t edgePending;       // One bit per button index
+    volatile int64_t edgeUs[BUTTON_COUNT];
+
+    // Single producer (esp_timer task), single consumer (loop task)
+    Event queue[BUTTON_EVENT_QUEUE_SIZE];
+    std::atomic<uint8_t> queueHead;
+    std::atomic<uint8_t> queueTail;
+    volatile uint32_t droppedEvents;
+    TaskHandle_t notifyTask;
+
+    GestureRecognizer gestures;
+
     uint8_t brightnessLevel;
-    
+    bool brightnessButton;
+    int64_t pressedAtUs[BUTTON_COUNT];
+
     void (*onTimeToggle)();
     void (*onBrightnessChange)(uint8_t level);
+    void (*onOtherGesture)(uint8_t button, GestureRecognizer::Gesture gesture, uint8_t chordMask);
 };
 
 #endif // BUTTON_CONTROLLER_H
@@ -0,0 +1,119 @@
+#include "ClockEncoding.h"
+#include <string.h>
+
+namespace ClockEncoding {
+
+static const Layout LAYOUTS[TYPE_COUNT] = {
+    // BCD keeps the original face: pairs of columns, tens then ones
+    {"bcd",     6, 4, 0x0A, LABEL_DECIMAL,   {2, 4, 3, 4, 3, 4}},
+    {"binary",  3, 6, 0x03, LABEL_TWO_DIGIT, {5, 6, 6}},
+    {"seconds", 5, 4, 0x01, LABEL_HEX,       {1, 4, 4, 4, 4}},
+    {"epoch",   8, 4, 0x2A, LABEL_HEX,       {4, 4, 4, 4, 4, 4, 4, 4}},
+    {"gray",    3, 6, 0x03, LABEL_TWO_DIGIT, {5, 6, 6}},
+};
+
+static const Layout DURATION = {"timer", 7, 4, 0x0A, LABEL_DECIMAL, {4, 4, 3, 4, 4, 4, 4}};
+
+const Layout& layout(Type type) {
+    return LAYOUTS[type < TYPE_COUNT ? type : BCD];
+}
+
+const Layout& durationLayout() {
+    return DURATION;
+}
+
+Fit fit(const Layout& layout, int screenW, int colWidth, int gapSmall, int gapLarge) {
+    int largeGaps = 0;
+    for (uint8_t i = 0; i + 1 < layout.columns; i++) {
+        largeGaps += (layout.largeGapAfter >> i) & 1;
+    }
+    int smallGaps = layout.columns - 1 - largeGaps;
+    Fit f = {colWidth, gapSmall, gapLarge, 0};
+    f.total = layout.columns * f.width + smallGaps * f.gapSmall + largeGaps * f.gapLarge;
+    if (f.total > screenW) {
+        int total = f.total;
+        f.width = f.width * screenW / total;
+        f.gapSmall = f.gapSmall * screenW / total;
+        f.gapLarge = f.gapLarge * screenW / total;
+        f.total = layout.columns * f.width + smallGaps * f.gapSmall + largeGaps * f.gapLarge;
+    }
+    return f;
+}
+
+bool fromName(const char* name, Type& out) {
+    for (uint8_t i = 0; i < TYPE_COUNT; i++) {
+        if (strcmp(LAYOUTS[i].name, name) == 0) {
+            out = (Type)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t cyclicGray(uint8_t value, uint8_t period, uint8_t bits) {
+    // Codes g(i) and g(2^n - 1 - i) differ only in the top bit; keeping
+    // the first and last period/2 codes makes both seams one-bit steps
+    uint8_t index = value < period / 2 ? value : (uint8_t)(value + (1u << bits) - period);
+    return (uint8_t)(index ^ (index >> 1));
+}
+
+static void nibbles(uint32_t value, uint8_t count, Frame& out) {
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t nibble = (uint8_t)((value >> (4 * (count - 1 - i))) & 0x0F);
+        out.bits[i] = nibble;
+        out.values[i] = nibble;
+    }
+}
+
+void encodeDuration(uint32_t ms, Frame& out) {
+    uint32_t minutes = ms / 60000 % 100;
+    uint32_t seconds = ms / 1000 % 60;
+    uint32_t fraction = ms % 1000;
+    const uint8_t digits[7] = {(uint8_t)(minutes / 10), (uint8_t)(minutes % 10),
+                               (uint8_t)(seconds / 10), (uint8_t)(seconds % 10),
+                               (uint8_t)(fraction / 100), (uint8_t)(fraction / 10 % 10),
+                               (uint8_t)(fraction % 10)};
+    memset(&out, 0, sizeof(out));
+    for (uint8_t i = 0; i < 7; i++) {
+        out.bits[i] = digits[i];
+        out.values[i] = digits[i];
+    }
+}
+
+void encode(Type type, const struct tm& local, uint32_t epoch, Frame& out) {
+    uint8_t h = (uint8_t)local.tm_hour;
+    uint8_t m = (uint8_t)local.tm_min;
+    uint8_t s = (uint8_t)(local.tm_sec > 59 ? 59 : local.tm_sec);
+    memset(&out, 0, sizeof(out));
+
+    switch (type) {
+    case BINARY:
+    case GRAY: {
+        const uint8_t fields[3] = {h, m, s};
+        const uint8_t periods[3] = {24, 60, 60};
+        for (uint8_t i = 0; i < 3; i++) {
+            out.values[i] = fields[i];
+            out.bits[i] = type == GRAY ? cyclicGray(fields[i], periods[i], LAYOUTS[type].bits[i]) : fields[i];
+        }
+        break;
+    }
+    case SECONDS:
+        nibbles((uint32_t)h * 3600 + m * 60 + s, 5, out);
+        break;
+    case EPOCH:
+        nibbles(epoch, 8, out);
+        break;
+    case BCD:
+    default: {
+        const uint8_t digits[6] = {(uint8_t)(h / 10), (uint8_t)(h % 10), (uint8_t)(m / 10),
+                                   (uint8_t)(m % 10), (uint8_t)(s / 10), (uint8_t)(s % 10)};
+        for (uint8_t i = 0; i < 6; i++) {
+            out.bits[i] = digits[i];
+            out.values[i] = digits[i];
+        }
+        break;
+    }
+    }
+}
+
+}  // namespace ClockEncoding
@@ -0,0 +1,76 @@
+#ifndef CLOCK_ENCODING_H
+#define CLOCK_ENCODING_H
+
+#include <stdint.h>
+#include <time.h>
+
+// What the dots stand for. An encoding turns the time into columns of bits
+// (most significant at the top) and says how many rows and columns they
+// take and where the wide gaps go; BinaryClockDisplay only places and
+// repaints dots. No display code here, so tools/encoding_bench.cpp can
+// build it on the host.
+namespace ClockEncoding {
+
+enum Type : uint8_t {
+    BCD = 0,   // HH MM SS, one decimal digit per column
+    BINARY,    // Hours, minutes, seconds as plain binary, one column each
+    SECONDS,   // Seconds since local midnight, 17 bits in nibble columns
+    EPOCH,     // 32-bit Unix time, eight nibble columns
+    GRAY,      // Hours, minutes, seconds in cyclic Gray code: one dot per tick
+    TYPE_COUNT
+};
+
+// How the value under each column is written when digits are shown
+enum Label : uint8_t {
+    LABEL_DECIMAL = 0,  // "7"
+    LABEL_TWO_DIGIT,    // "07"
+    LABEL_HEX           // "A"
+};
+
+static const uint8_t MAX_COLUMNS = 8;
+static const uint8_t MAX_ROWS = 6;
+
+struct Layout {
+    const char* name;          // As used by /config?encoding=
+    uint8_t columns;
+    uint8_t rows;              // Row pitch is the clock band over this
+    uint8_t largeGapAfter;     // Bit i: wide gap after column i
+    Label label;
+    uint8_t bits[MAX_COLUMNS]; // Dots per column, bottom-aligned
+};
+
+struct Frame {
+    uint8_t bits[MAX_COLUMNS];    // Dot pattern, LSB is the bottom dot
+    uint8_t values[MAX_COLUMNS];  // What the column stands for (label)
+};
+
+const Layout& layout(Type type);
+bool fromName(const char* name, Type& out);
+
+// Column width and gaps of a layout on a screen screenW pixels wide. One
+// too wide for it (epoch) has widths and gaps scaled down, so total never
+// exceeds screenW. BinaryClockDisplay places its columns with this and
+// ConfigStore checks the dots still fit them.
+struct Fit {
+    int width;
+    int gapSmall;
+    int gapLarge;
+    int total;
+};
+Fit fit(const Layout& layout, int screenW, int colWidth, int gapSmall, int gapLarge);
+
+// local gives the fields, epoch the Unix time (only EPOCH uses it)
+void encode(Type type, const struct tm& local, uint32_t epoch, Frame& out);
+
+// Stopwatch and countdown face: MM SS mmm, one decimal digit per column.
+// Not a Type, since those are for the time of day; minutes wrap at 100.
+const Layout& durationLayout();
+void encodeDuration(uint32_t ms, Frame& out);
+
+// Reflected Gray code trimmed to an even period, so the wrap (59 -> 0)
+// flips a single bit like every other step
+uint8_t cyclicGray(uint8_t value, uint8_t period, uint8_t bits);
+
+}  // namespace ClockEncoding
+
+#endif // CLOCK_ENCODING_H
@@ -0,0 +1,368 @@
+#include "ConfigStore.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Logger.h"
+#include "ClockEncoding.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char* PREFS_NAMESPACE = "config";
+static const uint16_t STORED_MAGIC = 0xC0F1;
+
+static_assert(sizeof(ConfigStore::Settings) ==
+              7 * 2 + 6 + CONFIG_TZ_LEN + NTP_SERVER_COUNT * CONFIG_HOST_LEN,
+              "Settings must stay free of padding");
+static_assert(offsetof(ConfigStore::Settings, timezone) == 20,
+              "Render-path fields are the first 20 bytes");
+static_assert(NTP_SERVER_COUNT == 3, "Field table lists three NTP servers");
+
+namespace {
+
+enum FieldType : uint8_t { TYPE_U8, TYPE_U16, TYPE_COLOR, TYPE_TEXT, TYPE_ENCODING };
+
+struct Field {
+    const char* name;
+    FieldType type;
+    uint8_t group;
+    uint16_t offset;
+    uint16_t size;
+    uint16_t min;
+    uint16_t max;
+};
+
+#define FIELD(name, member, type, lo, hi, group)                               \
+    {name, type, ConfigStore::group, (uint16_t)offsetof(ConfigStore::Settings, member), \
+     (uint16_t)sizeof(((ConfigStore::Settings*)nullptr)->member), lo, hi}
+
+const Field FIELDS[] = {
+    FIELD("on_color",        onColor,         TYPE_COLOR, 0, 0xFFFF, GROUP_PALETTE),
+    FIELD("off_color",       offColor,        TYPE_COLOR, 0, 0xFFFF, GROUP_PALETTE),
+    FIELD("night_on_color",  nightOnColor,    TYPE_COLOR, 0, 0xFFFF, GROUP_PALETTE),
+    FIELD("night_off_color", nightOffColor,   TYPE_COLOR, 0, 0xFFFF, GROUP_PALETTE),
+    FIELD("bg_color",        bgColor,         TYPE_COLOR, 0, 0xFFFF, GROUP_BACKGROUND),
+    FIELD("digit_color",     digitColor,      TYPE_COLOR, 0, 0xFFFF, GROUP_DIGITS),
+    FIELD("fade_ms",         fadeMs,          TYPE_U16,   0, 5000,   GROUP_BACKLIGHT),
+    FIELD("col_width",       colWidth,        TYPE_U8,    8, 60,     GROUP_LAYOUT),
+    // Dots must fit the (CLOCK_BOTTOM - CLOCK_TOP) / 4 row pitch
+    FIELD("dot_radius",      dotRadius,       TYPE_U8,    2, (CLOCK_BOTTOM - CLOCK_TOP) / 8 - 1, GROUP_LAYOUT),
+    FIELD("gap_small",       gapSmall,        TYPE_U8,    0, 60,     GROUP_LAYOUT),
+    FIELD("gap_large",       gapLarge,        TYPE_U8,    0, 60,     GROUP_LAYOUT),
+    FIELD("brightness",      brightnessLevel, TYPE_U8,    1, BRIGHTNESS_LEVELS, GROUP_BACKLIGHT),
+    FIELD("encoding",        encoding,        TYPE_ENCODING, 0, ClockEncoding::TYPE_COUNT - 1, GROUP_LAYOUT),
+    FIELD("timezone",        timezone,        TYPE_TEXT,  1, 0,      GROUP_TIMEZONE),
+    FIELD("ntp1",            ntpServers[0],   TYPE_TEXT,  1, 0,      GROUP_NTP),
+    FIELD("ntp2",            ntpServers[1],   TYPE_TEXT,  0, 0,      GROUP_NTP),
+    FIELD("ntp3",            ntpServers[2],   TYPE_TEXT,  0, 0,      GROUP_NTP),
+};
+
+#undef FIELD
+
+const size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+// Whole blob as kept in NVS; size guards against a changed Settings layout
+struct Stored {
+    uint16_t magic;
+    uint16_t size;
+    ConfigStore::Settings settings;
+};
+
+uint16_t readNumber(const ConfigStore::Settings& s, const Field& f) {
+    const uint8_t* p = (const uint8_t*)&s + f.offset;
+    if (f.size == 1) {
+        return *p;
+    }
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void writeNumber(ConfigStore::Settings& s, const Field& f, uint16_t v) {
+    uint8_t* p = (uint8_t*)&s + f.offset;
+    if (f.size == 1) {
+        *p = (uint8_t)v;
+    } else {
+        memcpy(p, &v, sizeof(v));
+    }
+}
+
+// "#RRGGBB", or "0xHHHH" for a raw RGB565 value
+bool parseColor(const char* text, uint16_t& out) {
+    char* end;
+    if (text[0] == '#' && strlen(text) == 7) {
+        uint32_t rgb = strtoul(text + 1, &end, 16);
+        if (*end != '\0') {
+            return false;
+        }
+        out = (uint16_t)(((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F));
+        return true;
+    }
+    if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X') && text[2] != '\0') {
+        uint32_t raw = strtoul(text + 2, &end, 16);
+        if (*end != '\0' || raw > 0xFFFF) {
+            return false;
+        }
+        out = (uint16_t)raw;
+        return true;
+    }
+    return false;
+}
+
+bool parseNumber(const char* text, uint16_t& out) {
+    char* end;
+    unsigned long v = strtoul(text, &end, 10);
+    if (text[0] == '\0' || *end != '\0' || v > 0xFFFF) {
+        return false;
+    }
+    out = (uint16_t)v;
+    return true;
+}
+
+// Printable, and nothing that would need escaping in the JSON dump
+bool validText(const char* text, size_t size, size_t minLength) {
+    size_t len = strnlen(text, size);
+    if (len == size || len < minLength) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] <= ' ' || text[i] > '~' || text[i] == '"' || text[i] == '\\') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Groups whose fields differ between a and b
+uint8_t diffGroups(const ConfigStore::Settings& a, const ConfigStore::Settings& b) {
+    uint8_t groups = 0;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const Field& f = FIELDS[i];
+        if (memcmp((const uint8_t*)&a + f.offset, (const uint8_t*)&b + f.offset, f.size) != 0) {
+            groups |= f.group;
+        }
+    }
+    return groups;
+}
+
+}  // namespace
+
+ConfigStore::ConfigStore()
+    : changes(0), dirty(false), firstDirtyMs(0), lastChangeMs(0), saves(0) {
+    setDefaults(settings);
+    persisted = settings;
+}
+
+void ConfigStore::setDefaults(Settings& s) {
+    memset(&s, 0, sizeof(s));
+    s.onColor = ON_COLOR;
+    s.offColor = OFF_COLOR;
+    s.nightOnColor = NIGHT_ON_COLOR;
+    s.nightOffColor = NIGHT_OFF_COLOR;
+    s.bgColor = BG_COLOR;
+    s.digitColor = DIGIT_COLOR;
+    s.fadeMs = BACKLIGHT_FADE_MS;
+    s.colWidth = CLOCK_COL_WIDTH;
+    s.dotRadius = CLOCK_DOT_RADIUS;
+    s.gapSmall = CLOCK_GAP_SMALL;
+    s.gapLarge = CLOCK_GAP_LARGE;
+    s.brightnessLevel = DEFAULT_BRIGHTNESS_INDEX + 1;
+    s.encoding = CLOCK_ENCODING;
+    strncpy(s.timezone, TIMEZONE, sizeof(s.timezone) - 1);
+    for (uint8_t i = 0; i < NTP_SERVER_COUNT; i++) {
+        strncpy(s.ntpServers[i], NTP_SERVERS[i], sizeof(s.ntpServers[i]) - 1);
+    }
+}
+
+bool ConfigStore::valid(const Settings& s) {
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const Field& f = FIELDS[i];
+        if (f.type == TYPE_TEXT) {
+            if (!validText((const char*)&s + f.offset, f.size, f.min)) {
+                return false;
+            }
+        } else {
+            uint16_t v = readNumber(s, f);
+            if (v < f.min || v > f.max) {
+                return false;
+            }
+        }
+    }
+
+    // Columns as the display places them for this encoding, scaled down
+    // when too wide, and for the timer face, which shares the widths. The
+    // display would quietly shrink the dots instead; refuse that here.
+    const ClockEncoding::Layout* faces[] = {
+        &ClockEncoding::layout((ClockEncoding::Type)s.encoding),
+        &ClockEncoding::durationLayout(),
+    };
+    for (const ClockEncoding::Layout* face : faces) {
+        ClockEncoding::Fit fit = ClockEncoding::fit(*face, SCREEN_W, s.colWidth, s.gapSmall, s.gapLarge);
+        if (2 * s.dotRadius + 1 > fit.width) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ConfigStore::load() {
+    Stored stored;
+    Preferences prefs;
+    size_t len = 0;
+    if (prefs.begin(PREFS_NAMESPACE, true)) {
+        len = prefs.getBytes("cfg", &stored, sizeof(stored));
+        prefs.end();
+    }
+
+    Settings loaded;
+    if (len == sizeof(stored) && stored.magic == STORED_MAGIC &&
+        stored.size == sizeof(Settings) && valid(stored.settings)) {
+        loaded = stored.settings;
+        persisted = loaded;
+    } else {
+        // Nothing saved yet, or from an older layout: run on defaults and
+        // leave NVS alone until something is actually changed
+        setDefaults(loaded);
+        if (len > 0) {
+            LOG_EVENT(CONFIG_UNUSABLE);
+        }
+    }
+    settings = loaded;
+    changes = 0;
+    dirty = false;
+}
+
+void ConfigStore::markChanged(uint8_t groups, uint32_t nowMs) {
+    if (groups == 0) {
+        return;
+    }
+    changes |= groups;
+    if (!dirty) {
+        dirty = true;
+        firstDirtyMs = nowMs;
+    }
+    lastChangeMs = nowMs;
+}
+
+bool ConfigStore::set(const char* name, const char* value, uint32_t nowMs) {
+    const Field* field = nullptr;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (strcmp(FIELDS[i].name, name) == 0) {
+            field = &FIELDS[i];
+            break;
+        }
+    }
+    if (!field) {
+        return false;
+    }
+
+    Settings next = settings;
+    if (field->type == TYPE_TEXT) {
+        char* dst = (char*)&next + field->offset;
+        if (strlen(value) >= field->size) {
+            return false;
+        }
+        memset(dst, 0, field->size);
+        strcpy(dst, value);
+    } else {
+        uint16_t v;
+        ClockEncoding::Type type;
+        bool ok;
+        if (field->type == TYPE_ENCODING) {
+            ok = ClockEncoding::fromName(value, type);
+            v = type;
+        } else {
+            ok = field->type == TYPE_COLOR ? parseColor(value, v) : parseNumber(value, v);
+        }
+        if (!ok) {
+            return false;
+        }
+        writeNumber(next, *field, v);
+    }
+
+    if (!valid(next)) {
+        return false;
+    }
+    markChanged(diffGroups(settings, next), nowMs);
+    settings = next;
+    return true;
+}
+
+void ConfigStore::resetToDefaults(uint32_t nowMs) {
+    Settings defaults;
+    setDefaults(defaults);
+    markChanged(diffGroups(settings, defaults), nowMs);
+    settings = defaults;
+}
+
+uint8_t ConfigStore::takeChanges() {
+    uint8_t taken = changes;
+    changes = 0;
+    return taken;
+}
+
+void ConfigStore::update(uint32_t nowMs) {
+    if (!dirty) {
+        return;
+    }
+    if (nowMs - lastChangeMs >= CONFIG_SAVE_DELAY_MS || nowMs - firstDirtyMs >= CONFIG_SAVE_MAX_DELAY_MS) {
+        save();
+        dirty = false;
+    }
+}
+
+void ConfigStore::save() {
+    // Edits that cancelled out never reach flash
+    if (memcmp(&settings, &persisted, sizeof(settings)) == 0) {
+        return;
+    }
+
+    Stored stored;
+    stored.magic = STORED_MAGIC;
+    stored.size = sizeof(Settings);
+    stored.settings = settings;
+
+    Preferences prefs;
+    if (!prefs.begin(PREFS_NAMESPACE, false)) {
+        return;
+    }
+    if (prefs.putBytes("cfg", &stored, sizeof(stored)) == sizeof(stored)) {
+        persisted = settings;
+        saves++;
+        LOG_EVENT(CONFIG_SAVED, saves);
+    }
+    prefs.end();
+}
+
+size_t ConfigStore::writeJson(char* buf, size_t cap) const {
+    size_t used = 0;
+    for (size_t i = 0; i < FIELD_COUNT && used < cap; i++) {
+        const Field& f = FIELDS[i];
+        const char* sep = i == 0 ? "{" : ",";
+        int n;
+        if (f.type == TYPE_TEXT) {
+            n = snprintf(buf + used, cap - used, "%s\"%s\":\"%s\"", sep, f.name,
+                         (const char*)&settings + f.offset);
+        } else if (f.type == TYPE_COLOR) {
+            uint16_t c = readNumber(settings, f);
+            uint8_t r = (uint8_t)((c >> 11) & 0x1F);
+            uint8_t g = (uint8_t)((c >> 5) & 0x3F);
+            uint8_t b = (uint8_t)(c & 0x1F);
+            n = snprintf(buf + used, cap - used, "%s\"%s\":\"#%02X%02X%02X\"", sep, f.name,
+                         (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+        } else if (f.type == TYPE_ENCODING) {
+            n = snprintf(buf + used, cap - used, "%s\"%s\":\"%s\"", sep, f.name,
+                         ClockEncoding::layout((ClockEncoding::Type)readNumber(settings, f)).name);
+        } else {
+            n = snprintf(buf + used, cap - used, "%s\"%s\":%u", sep, f.name, readNumber(settings, f));
+        }
+        if (n < 0) {
+            return 0;
+        }
+        used += (size_t)n;
+    }
+    if (used < cap) {
+        int n = snprintf(buf + used, cap - used, "}");
+        used += n > 0 ? (size_t)n : 0;
+    }
+    return used;
+}
@@ -0,0 +1,85 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+// Settings that used to need a rebuild, changeable at runtime and kept in
+// NVS. The config.h macros are the defaults. Everything is loaded once into
+// a plain struct, so reads are a field access like the old macros; writes
+// go through set() (validated, by name) and reach flash only once changes
+// have settled, so a burst of edits costs a single NVS write.
+class ConfigStore {
+public:
+    // Ordered by access frequency and size, without padding: the values
+    // the render path touches are the first 20 bytes, ahead of the text
+    struct Settings {
+        uint16_t onColor;
+        uint16_t offColor;
+        uint16_t nightOnColor;
+        uint16_t nightOffColor;
+        uint16_t bgColor;
+        uint16_t digitColor;
+        uint16_t fadeMs;
+        uint8_t colWidth;
+        uint8_t dotRadius;
+        uint8_t gapSmall;
+        uint8_t gapLarge;
+        uint8_t brightnessLevel;  // Manual level at boot, 1-based like /control
+        uint8_t encoding;         // ClockEncoding::Type
+        // Cold: only read when they change
+        char timezone[CONFIG_TZ_LEN];
+        char ntpServers[NTP_SERVER_COUNT][CONFIG_HOST_LEN];
+    };
+
+    // What a change affects, as returned by takeChanges()
+    enum Group : uint8_t {
+        GROUP_PALETTE    = 1 << 0,  // Dot colors
+        GROUP_BACKGROUND = 1 << 1,  // Whole screen
+        GROUP_DIGITS     = 1 << 2,  // Decimal digit row
+        GROUP_LAYOUT     = 1 << 3,  // Dot columns and digit row, encoding
+        GROUP_BACKLIGHT  = 1 << 4,
+        GROUP_TIMEZONE   = 1 << 5,
+        GROUP_NTP        = 1 << 6,
+        GROUP_ALL        = 0x7F
+    };
+
+    ConfigStore();
+
+    // Defaults, overlaid with whatever valid values NVS holds
+    void load();
+    const Settings& get() const { return settings; }
+
+    // Parses and validates one setting; false for an unknown name or a bad
+    // value (nothing changes then)
+    bool set(const char* name, const char* value, uint32_t nowMs);
+    void resetToDefaults(uint32_t nowMs);
+
+    // Groups changed since the last call
+    uint8_t takeChanges();
+
+    // Writes pending changes once quiet for CONFIG_SAVE_DELAY_MS, or
+    // CONFIG_SAVE_MAX_DELAY_MS after the first one at the latest
+    void update(uint32_t nowMs);
+    bool savePending() const { return dirty; }
+    uint32_t getSaves() const { return saves; }
+
+    size_t writeJson(char* buf, size_t cap) const;
+
+private:
+    static void setDefaults(Settings& s);
+    static bool valid(const Settings& s);
+    void markChanged(uint8_t groups, uint32_t nowMs);
+    void save();
+
+    Settings settings;
+    Settings persisted;    // What NVS holds, to skip no-op writes
+    uint8_t changes;
+    bool dirty;
+    uint32_t firstDirtyMs;
+    uint32_t lastChangeMs;
+    uint32_t saves;
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,125 @@
+#include "DisplayMirror.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// IPv4 + UDP headers, counted against the bandwidth cap
+static const uint32_t UDP_OVERHEAD = 28;
+static const uint32_t BUCKET_MAX = (uint32_t)MIRROR_BURST_BYTES * 1000;
+static const uint32_t DATAGRAM_COST_MAX = (MIRROR_DATAGRAM_SIZE + UDP_OVERHEAD) * 1000;
+
+static_assert(MIRROR_BURST_BYTES >= MIRROR_DATAGRAM_SIZE + UDP_OVERHEAD,
+              "Burst must allow at least one full datagram");
+
+DisplayMirror::DisplayMirror()
+    : encoder(SCREEN_W, SCREEN_H), frame(nullptr), sock(-1), enabled(false),
+      tokens(0), lastRefillMs(0), lastRefreshMs(0), refreshRow(0),
+      datagramsSent(0), bytesSent(0), throttled(0), sendErrors(0) {
+    memset(&dest, 0, sizeof(dest));
+}
+
+bool DisplayMirror::begin(const char* host, uint16_t port, const uint16_t* pixels) {
+    end();
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || res == nullptr) {
+        return false;
+    }
+    memcpy(&dest, res->ai_addr, sizeof(dest));
+    dest.sin_port = htons(port);
+    freeaddrinfo(res);
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    frame = pixels;
+    return true;
+}
+
+void DisplayMirror::end() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    enabled = false;
+    encoder.clear();
+}
+
+void DisplayMirror::setEnabled(bool on) {
+    if (on == enabled || (on && sock < 0)) {
+        return;
+    }
+    enabled = on;
+    encoder.clear();
+    if (on) {
+        encoder.addDamage(0, 0, SCREEN_W, SCREEN_H);
+        tokens = BUCKET_MAX;
+        lastRefillMs = 0;
+        lastRefreshMs = 0;
+    }
+}
+
+void DisplayMirror::addDamage(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (enabled) {
+        encoder.addDamage(x, y, w, h);
+    }
+}
+
+void DisplayMirror::refill(uint32_t nowMs) {
+    uint32_t elapsed = nowMs - lastRefillMs;
+    lastRefillMs = nowMs;
+    if (elapsed >= BUCKET_MAX / MIRROR_RATE_BYTES_PER_S) {
+        tokens = BUCKET_MAX;
+        return;
+    }
+    tokens += elapsed * MIRROR_RATE_BYTES_PER_S;
+    if (tokens > BUCKET_MAX) {
+        tokens = BUCKET_MAX;
+    }
+}
+
+void DisplayMirror::update(uint32_t nowMs) {
+    if (!enabled) {
+        return;
+    }
+    refill(nowMs);
+
+    if (nowMs - lastRefreshMs >= MIRROR_REFRESH_INTERVAL_MS) {
+        lastRefreshMs = nowMs;
+        encoder.addDamage(0, (int16_t)refreshRow, SCREEN_W, MIRROR_REFRESH_ROWS);
+        refreshRow = (uint16_t)((refreshRow + MIRROR_REFRESH_ROWS) % SCREEN_H);
+    }
+
+    for (uint8_t i = 0; i < MIRROR_DATAGRAMS_PER_UPDATE && encoder.pending(); i++) {
+        // Only start a datagram the bucket could pay for at full size
+        if (tokens < DATAGRAM_COST_MAX) {
+            throttled++;
+            return;
+        }
+
+        MirrorEncoder::Rect strip;
+        size_t length = encoder.encode(frame, datagram, sizeof(datagram), &strip);
+        if (length == 0) {
+            return;
+        }
+        if (sendto(sock, datagram, length, 0, (sockaddr*)&dest, sizeof(dest)) < 0) {
+            // Out of lwIP buffers or the like: try these rows again later
+            sendErrors++;
+            encoder.addDamage((int16_t)strip.x, (int16_t)strip.y, (int16_t)strip.w, (int16_t)strip.h);
+            return;
+        }
+        tokens -= (uint32_t)(length + UDP_OVERHEAD) * 1000;
+        datagramsSent++;
+        bytesSent += (uint32_t)length;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef DISPLAY_MIRROR_H
+#define DISPLAY_MIRROR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include <netinet/in.h>
+#include "MirrorEncoder.h"
+
+// Streams a copy of the panel to tools/mirror_viewer.py over UDP.
+// BinaryClockDisplay draws every frame into an off-screen canvas as well and
+// reports what it touched; update() sends the damaged areas from that canvas
+// as MirrorEncoder datagrams. A token bucket caps the bandwidth (damage
+// simply waits when it runs dry) and a slow refresh sweep re-sends a band of
+// rows at a time so a viewer heals from lost packets or late joins.
+// Each update() encodes at most MIRROR_DATAGRAMS_PER_UPDATE datagrams. POSIX
+// sockets only, so it builds unchanged on Linux.
+class DisplayMirror {
+public:
+    DisplayMirror();
+
+    // frame: SCREEN_W x SCREEN_H pixels in panel byte order, must outlive
+    // this. Resolves host once (blocking DNS). Starts disabled.
+    bool begin(const char* host, uint16_t port, const uint16_t* frame);
+    void end();
+
+    // Enabling queues the whole screen
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled; }
+
+    void addDamage(int16_t x, int16_t y, int16_t w, int16_t h);
+    void update(uint32_t nowMs);
+
+    uint32_t getDatagramsSent() const { return datagramsSent; }
+    uint32_t getBytesSent() const { return bytesSent; }
+    uint32_t getThrottled() const { return throttled; }
+    uint32_t getSendErrors() const { return sendErrors; }
+
+private:
+    void refill(uint32_t nowMs);
+
+    MirrorEncoder encoder;
+    const uint16_t* frame;
+    int sock;
+    sockaddr_in dest;
+    bool enabled;
+
+    uint32_t tokens;          // Bytes x 1000, so slow refills don't round away
+    uint32_t lastRefillMs;
+    uint32_t lastRefreshMs;
+    uint16_t refreshRow;
+
+    uint8_t datagram[MIRROR_DATAGRAM_SIZE];
+
+    uint32_t datagramsSent;
+    uint32_t bytesSent;
+    uint32_t throttled;       // Passes that left damage waiting for tokens
+    uint32_t sendErrors;
+};
+
+#endif // DISPLAY_MIRROR_H
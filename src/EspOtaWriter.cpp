@@ -0,0 +1,58 @@
+#include "EspOtaWriter.h"
+
+EspOtaWriter::EspOtaWriter() : target(nullptr), handle(0), written(0) {
+}
+
+uint32_t EspOtaWriter::capacity() {
+    const esp_partition_t* next = esp_ota_get_next_update_partition(nullptr);
+    return next ? next->size : 0;
+}
+
+bool EspOtaWriter::begin() {
+    target = esp_ota_get_next_update_partition(nullptr);
+    if (!target) {
+        return false;
+    }
+    written = 0;
+    // The size argument doubles as the erase mode: a real size would erase
+    // that much of the slot here, up front
+    return esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &handle) == ESP_OK;
+}
+
+bool EspOtaWriter::write(uint32_t offset, const uint8_t* data, size_t len) {
+    // Sequential mode erases each sector on first touch; esp_ota_write() also
+    // rejects an image whose first byte isn't the app magic
+    if (offset != written || esp_ota_write(handle, data, len) != ESP_OK) {
+        return false;
+    }
+    written += len;
+    return true;
+}
+
+bool EspOtaWriter::finish() {
+    // esp_ota_end() checks the image header, segments and checksum
+    esp_err_t err = esp_ota_end(handle);
+    handle = 0;
+    return err == ESP_OK && esp_ota_set_boot_partition(target) == ESP_OK;
+}
+
+void EspOtaWriter::abort() {
+    if (handle) {
+        esp_ota_abort(handle);
+        handle = 0;
+    }
+}
+
+bool EspOtaWriter::runningImagePendingVerify() {
+    esp_ota_img_states_t state;
+    return esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+           state == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+void EspOtaWriter::markRunningImageValid() {
+    esp_ota_mark_app_valid_cancel_rollback();
+}
+
+void EspOtaWriter::rollBackAndReboot() {
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+}
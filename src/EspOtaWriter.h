@@ -0,0 +1,32 @@
+#ifndef ESP_OTA_WRITER_H
+#define ESP_OTA_WRITER_H
+
+#include <esp_ota_ops.h>
+#include "PartitionWriter.h"
+
+// PartitionWriter for the inactive OTA app slot. Uses sequential writes, so
+// each sector is erased just before it is written instead of the whole slot
+// up front (which would stall the loop for seconds).
+class EspOtaWriter : public PartitionWriter {
+public:
+    EspOtaWriter();
+
+    uint32_t capacity() override;
+    bool begin() override;
+    bool write(uint32_t offset, const uint8_t* data, size_t len) override;
+    bool finish() override;
+    void abort() override;
+
+    // First-boot verification of a freshly installed image (needs
+    // verifyRollbackLater() to return true so the core leaves it to us)
+    static bool runningImagePendingVerify();
+    static void markRunningImageValid();
+    static void rollBackAndReboot();
+
+private:
+    const esp_partition_t* target;
+    esp_ota_handle_t handle;
+    uint32_t written;
+};
+
+#endif // ESP_OTA_WRITER_H
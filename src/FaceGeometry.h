@@ -0,0 +1,71 @@
+#ifndef FACE_GEOMETRY_H
+#define FACE_GEOMETRY_H
+
+#include <stdint.h>
+
+// Pixel geometry worked out at compile time, shared by BinaryClockDisplay
+// and the host benchmarks. No display code here.
+namespace FaceGeometry {
+
+// Pixels covered by fillCircle(): one horizontal span per row
+constexpr uint32_t circlePixels(int r) {
+    uint32_t total = 0;
+    for (int dy = -r; dy <= r; dy++) {
+        int half = 0;
+        while ((half + 1) * (half + 1) + dy * dy <= r * r) {
+            half++;
+        }
+        total += 2 * half + 1;
+    }
+    return total;
+}
+
+// World clock: one compact BCD face per zone, a label over HH MM SS
+static const uint8_t MAX_WORLD_FACES = 4;
+static const uint8_t WORLD_COLUMNS = 6;
+static const uint8_t WORLD_ROWS = 4;
+
+struct WorldFace {
+    int16_t x, y, w, h;            // Cell, label and dots inside
+    int16_t labelX, labelY;        // Label center
+    int16_t colX[WORLD_COLUMNS];   // Column centers
+    int16_t rowY[WORLD_ROWS];      // Row centers, top to bottom
+    uint8_t dotR;
+    uint16_t dotPixels;            // Pixels in one filled dot
+};
+
+// Face index of count on the area [top, bottom) of a screen width wide:
+// side by side up to three, 2 x 2 for four. Columns sit one pitch apart
+// with an extra half pitch between the pairs, like the main face's gaps.
+constexpr WorldFace worldFace(uint8_t count, uint8_t index, int16_t width, int16_t top,
+                              int16_t bottom, int16_t labelH, int16_t maxR) {
+    WorldFace f{};
+    const int across = count == 4 ? 2 : count;
+    const int down = count == 4 ? 2 : 1;
+    f.w = (int16_t)(width / across);
+    f.h = (int16_t)((bottom - top) / down);
+    f.x = (int16_t)((index % across) * f.w);
+    f.y = (int16_t)(top + (index / across) * f.h);
+    f.labelX = (int16_t)(f.x + f.w / 2);
+    f.labelY = (int16_t)(f.y + labelH / 2);
+
+    // Six columns, two half-pitch gaps and a half-pitch margin each side
+    const int pitch = f.w / 8;
+    const int rowPitch = (f.h - labelH) / WORLD_ROWS;
+    int r = (pitch < rowPitch ? pitch : rowPitch) / 2 - 1;
+    f.dotR = (uint8_t)(r < maxR ? r : maxR);
+    f.dotPixels = (uint16_t)circlePixels(f.dotR);
+
+    const int left = f.x + (f.w - 7 * pitch) / 2 + pitch / 2;
+    for (int c = 0; c < WORLD_COLUMNS; c++) {
+        f.colX[c] = (int16_t)(left + c * pitch + (c / 2) * (pitch / 2));
+    }
+    for (int row = 0; row < WORLD_ROWS; row++) {
+        f.rowY[row] = (int16_t)(f.y + labelH + row * rowPitch + rowPitch / 2);
+    }
+    return f;
+}
+
+}  // namespace FaceGeometry
+
+#endif // FACE_GEOMETRY_H
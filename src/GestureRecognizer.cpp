@@ -0,0 +1,133 @@
+#include "GestureRecognizer.h"
+#include <string.h>
+
+#define NO_GESTURE -1
+
+// Rows: current state. Columns: press, release, timeout.
+const GestureRecognizer::Transition GestureRecognizer::TABLE[ST_COUNT][IN_COUNT] = {
+    // ST_IDLE
+    {{ST_DOWN, NO_GESTURE, TM_LONG},  {ST_IDLE, NO_GESTURE, TM_NONE},      {ST_IDLE, NO_GESTURE, TM_NONE}},
+    // ST_DOWN
+    {{ST_DOWN, NO_GESTURE, TM_KEEP},  {ST_UP_WAIT, NO_GESTURE, TM_DOUBLE}, {ST_HELD, GESTURE_LONG, TM_REPEAT}},
+    // ST_UP_WAIT
+    {{ST_DOWN2, NO_GESTURE, TM_NONE}, {ST_UP_WAIT, NO_GESTURE, TM_KEEP},   {ST_IDLE, GESTURE_SHORT, TM_NONE}},
+    // ST_DOWN2
+    {{ST_DOWN2, NO_GESTURE, TM_KEEP}, {ST_IDLE, GESTURE_DOUBLE, TM_NONE},  {ST_DOWN2, NO_GESTURE, TM_NONE}},
+    // ST_HELD
+    {{ST_HELD, NO_GESTURE, TM_KEEP},  {ST_IDLE, NO_GESTURE, TM_NONE},      {ST_HELD, GESTURE_REPEAT, TM_REPEAT}},
+    // ST_CHORD
+    {{ST_CHORD, NO_GESTURE, TM_KEEP}, {ST_IDLE, NO_GESTURE, TM_NONE},      {ST_CHORD, NO_GESTURE, TM_NONE}},
+};
+
+GestureRecognizer::GestureRecognizer()
+    : buttonCount(0), onGesture(nullptr), callbackContext(nullptr) {
+    memset(config, 0, sizeof(config));
+    memset(buttons, 0, sizeof(buttons));
+}
+
+void GestureRecognizer::begin(const ButtonConfig* configs, uint8_t count) {
+    buttonCount = count > GESTURE_MAX_BUTTONS ? GESTURE_MAX_BUTTONS : count;
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        config[i] = configs[i];
+        buttons[i].state = ST_IDLE;
+        buttons[i].armed = false;
+    }
+}
+
+void GestureRecognizer::step(uint8_t button, Input input, uint32_t timeMs) {
+    ButtonState& b = buttons[button];
+    const ButtonConfig& cfg = config[button];
+    const Transition& t = TABLE[b.state][input];
+
+    b.state = t.next;
+    if (t.emit != NO_GESTURE && onGesture) {
+        onGesture(callbackContext, button, (Gesture)t.emit, (uint8_t)(1u << button));
+    }
+
+    uint16_t duration = 0;
+    switch (t.timer) {
+        case TM_KEEP:   return;
+        case TM_LONG:   duration = cfg.longPressMs; break;
+        case TM_DOUBLE: duration = cfg.doubleTapMs; break;
+        case TM_REPEAT: duration = cfg.repeatMs; break;
+        case TM_NONE:   break;
+    }
+    b.armed = duration > 0;
+    b.deadline = timeMs + duration;
+
+    // A disabled double-tap window resolves immediately to a short press
+    if (t.timer == TM_DOUBLE && !b.armed) {
+        step(button, IN_TIMEOUT, timeMs);
+    }
+}
+
+bool GestureRecognizer::tryChord(uint8_t button, uint32_t timeMs) {
+    for (uint8_t other = 0; other < buttonCount; other++) {
+        ButtonState& o = buttons[other];
+        if (other == button || o.state != ST_DOWN ||
+            timeMs - o.pressedAt > GESTURE_CHORD_WINDOW_MS) {
+            continue;
+        }
+        // Both buttons swallow their own gestures until released
+        o.state = ST_CHORD;
+        o.armed = false;
+        buttons[button].state = ST_CHORD;
+        buttons[button].armed = false;
+        if (onGesture) {
+            onGesture(callbackContext, button, GESTURE_CHORD, (uint8_t)((1u << button) | (1u << other)));
+        }
+        return true;
+    }
+    return false;
+}
+
+void GestureRecognizer::feed(uint8_t button, bool pressed, uint32_t timeMs) {
+    if (button >= buttonCount) {
+        return;
+    }
+
+    // Deliver an expired deadline first so edges are handled in time order
+    ButtonState& b = buttons[button];
+    if (b.armed && (int32_t)(timeMs - b.deadline) >= 0) {
+        step(button, IN_TIMEOUT, b.deadline);
+    }
+
+    if (pressed) {
+        if (b.state == ST_IDLE && tryChord(button, timeMs)) {
+            return;
+        }
+        if (b.state == ST_IDLE) {
+            b.pressedAt = timeMs;
+        }
+        step(button, IN_PRESS, timeMs);
+    } else {
+        step(button, IN_RELEASE, timeMs);
+    }
+}
+
+void GestureRecognizer::poll(uint32_t nowMs) {
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        ButtonState& b = buttons[i];
+        if (b.armed && (int32_t)(nowMs - b.deadline) >= 0) {
+            step(i, IN_TIMEOUT, b.deadline);
+        }
+    }
+}
+
+uint32_t GestureRecognizer::msUntilDeadline(uint32_t nowMs, uint32_t maxMs) const {
+    uint32_t wait = maxMs;
+    for (uint8_t i = 0; i < buttonCount; i++) {
+        const ButtonState& b = buttons[i];
+        if (!b.armed) {
+            continue;
+        }
+        int32_t remaining = (int32_t)(b.deadline - nowMs);
+        if (remaining <= 0) {
+            return 0;
+        }
+        if ((uint32_t)remaining < wait) {
+            wait = (uint32_t)remaining;
+        }
+    }
+    return wait;
+}
@@ -0,0 +1,85 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Table-driven recognizer for short press, long press, double tap,
+// hold-repeat and two-button chords. Fixed-size state, no heap, and poll()
+// costs one deadline compare per button.
+class GestureRecognizer {
+public:
+    enum Gesture : uint8_t {
+        GESTURE_SHORT = 0,
+        GESTURE_LONG,
+        GESTURE_DOUBLE,
+        GESTURE_REPEAT,
+        GESTURE_CHORD
+    };
+
+    // Per-button timing, 0 disables the gesture. With doubleTapMs == 0 a
+    // short press fires on release instead of after the double-tap window.
+    struct ButtonConfig {
+        uint16_t longPressMs;
+        uint16_t doubleTapMs;
+        uint16_t repeatMs;
+    };
+
+    // For GESTURE_CHORD, `button` is the second button pressed and
+    // `chordMask` has one bit per button in the chord
+    typedef void (*Callback)(void* context, uint8_t button, Gesture gesture, uint8_t chordMask);
+
+    GestureRecognizer();
+
+    void begin(const ButtonConfig* configs, uint8_t count);
+    void setCallback(Callback callback, void* context) {
+        onGesture = callback;
+        callbackContext = context;
+    }
+
+    void feed(uint8_t button, bool pressed, uint32_t timeMs);
+    void poll(uint32_t nowMs);
+
+    // Milliseconds until the earliest pending deadline, capped at maxMs
+    uint32_t msUntilDeadline(uint32_t nowMs, uint32_t maxMs) const;
+
+private:
+    enum State : uint8_t {
+        ST_IDLE = 0,
+        ST_DOWN,       // Pressed, waiting for release or long-press deadline
+        ST_UP_WAIT,    // Released, waiting for a second tap
+        ST_DOWN2,      // Second tap held
+        ST_HELD,       // Long press fired, optional repeats
+        ST_CHORD,      // Part of a chord, waiting for release
+        ST_COUNT
+    };
+
+    enum Input : uint8_t { IN_PRESS = 0, IN_RELEASE, IN_TIMEOUT, IN_COUNT };
+    enum Timer : uint8_t { TM_NONE = 0, TM_KEEP, TM_LONG, TM_DOUBLE, TM_REPEAT };
+
+    struct Transition {
+        State next;
+        int8_t emit;   // Gesture to emit, or -1
+        Timer timer;   // Deadline to arm on entry, TM_KEEP leaves it running
+    };
+
+    struct ButtonState {
+        State state;
+        bool armed;
+        uint32_t deadline;
+        uint32_t pressedAt;
+    };
+
+    static const Transition TABLE[ST_COUNT][IN_COUNT];
+
+    void step(uint8_t button, Input input, uint32_t timeMs);
+    bool tryChord(uint8_t button, uint32_t timeMs);
+
+    ButtonConfig config[GESTURE_MAX_BUTTONS];
+    ButtonState buttons[GESTURE_MAX_BUTTONS];
+    uint8_t buttonCount;
+    Callback onGesture;
+    void* callbackContext;
+};
+
+#endif // GESTURE_RECOGNIZER_H
@@ -0,0 +1,136 @@
+#include "GpsClock.h"
+#include <sys/time.h>
+
+static const uint32_t RING_MASK = GPS_RING_SIZE - 1;
+static const int64_t PPS_SILENT_US = 2000000;  // No edge for this long: PPS lost
+
+GpsClock::GpsClock()
+    : port(nullptr), head(0), lastFillUs(0), ppsLock(portMUX_INITIALIZER_UNLOCKED), ppsUs(0),
+      ppsWired(false), lastUtcUs(0), haveEdge(false), seconds(0), synced(false), lastSyncMs(0) {
+    memset(&edge, 0, sizeof(edge));
+    memset(&result, 0, sizeof(result));
+}
+
+void GpsClock::begin(HardwareSerial& serial, uint32_t baud, int8_t rxPin, int8_t ppsPin) {
+    port = &serial;
+    port->setRxBufferSize(GPS_UART_BUFFER);  // Only takes effect before begin()
+    port->begin(baud, SERIAL_8N1, rxPin, -1);
+
+    if (ppsPin >= 0) {
+        pinMode(ppsPin, INPUT);
+        attachInterruptArg(ppsPin, onPps, this, RISING);
+        ppsWired = true;
+    }
+}
+
+void IRAM_ATTR GpsClock::onPps(void* arg) {
+    GpsClock* self = static_cast<GpsClock*>(arg);
+    portENTER_CRITICAL_ISR(&self->ppsLock);
+    self->ppsUs = esp_timer_get_time();
+    portEXIT_CRITICAL_ISR(&self->ppsLock);
+}
+
+int64_t GpsClock::lastPpsUs() {
+    portENTER_CRITICAL(&ppsLock);
+    int64_t us = ppsUs;
+    portEXIT_CRITICAL(&ppsLock);
+    return us;
+}
+
+bool GpsClock::hasPps() {
+    int64_t pps = lastPpsUs();
+    return ppsWired && pps != 0 && esp_timer_get_time() - pps < PPS_SILENT_US;
+}
+
+void GpsClock::fill(int64_t nowUs) {
+    // A sentence read now arrived since the last read. After a long gap
+    // (setup, a blocking call) that says nothing about when: parse it to
+    // keep in step, but don't time anything from it
+    bool timely = lastFillUs != 0 && nowUs - lastFillUs <= (int64_t)GPS_MAX_POLL_GAP_MS * 1000;
+    lastFillUs = nowUs;
+
+    // The driver's buffer is copied into the ring once; the parser works
+    // on the ring and hands back space as sentences complete
+    for (;;) {
+        uint32_t room = GPS_RING_SIZE - (head - parser.keepFrom());
+        int available = port->available();
+        if (room == 0 || available <= 0) {
+            return;
+        }
+        uint32_t at = head & RING_MASK;
+        size_t want = min((size_t)min(room, GPS_RING_SIZE - at), (size_t)available);
+        size_t got = port->read(&ring[at], want);
+        if (got == 0) {
+            return;
+        }
+        head += (uint32_t)got;
+
+        NmeaParser::Time time;
+        while (parser.scan(ring, RING_MASK, head, time)) {
+            if (timely) {
+                onTime(time, nowUs);
+            }
+        }
+    }
+}
+
+void GpsClock::onTime(const NmeaParser::Time& time, int64_t nowUs) {
+    // Only a whole second has an edge (10 Hz receivers send the rest too)
+    if (time.utcUs % 1000000 != 0) {
+        return;
+    }
+    if (time.utcUs == lastUtcUs) {
+        return;  // RMC and ZDA for the same second
+    }
+    lastUtcUs = time.utcUs;
+    seconds++;
+
+    int64_t pps = ppsWired ? lastPpsUs() : 0;
+    Edge next;
+    next.utcUs = time.utcUs;
+    if (pps != 0 && nowUs - pps < (int64_t)GPS_PPS_MAX_AGE_MS * 1000) {
+        next.localUs = pps;
+        next.pps = true;
+    } else if (pps != 0 && nowUs - pps < PPS_SILENT_US) {
+        return;  // PPS is running but this sentence is too late to pair
+    } else {
+        next.localUs = nowUs - (int64_t)GPS_NMEA_LAG_MS * 1000;
+        next.pps = false;
+    }
+
+    // A PPS edge always wins; between estimates, the one least late
+    // (lowest local time for its UTC) is closest to the real edge
+    if (!haveEdge || next.pps ||
+        (!edge.pps && next.localUs - next.utcUs < edge.localUs - edge.utcUs)) {
+        edge = next;
+        haveEdge = true;
+    }
+}
+
+bool GpsClock::update(uint32_t nowMs) {
+    if (!port) {
+        return false;
+    }
+    int64_t nowUs = esp_timer_get_time();
+    fill(nowUs);
+    if (!haveEdge || (synced && nowMs - lastSyncMs < GPS_SYNC_INTERVAL_MS)) {
+        return false;
+    }
+
+    // Where the system clock was at the edge
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    int64_t wallUs = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+    int64_t wallAtEdgeUs = wallUs - (esp_timer_get_time() - edge.localUs);
+
+    result.valid = true;
+    result.pps = edge.pps;
+    result.offsetUs = edge.utcUs - wallAtEdgeUs;
+    result.seconds = seconds;
+
+    haveEdge = false;
+    seconds = 0;
+    synced = true;
+    lastSyncMs = nowMs;
+    return true;
+}
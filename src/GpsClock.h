@@ -0,0 +1,80 @@
+#ifndef GPS_CLOCK_H
+#define GPS_CLOCK_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "NmeaParser.h"
+
+static_assert((GPS_RING_SIZE & (GPS_RING_SIZE - 1)) == 0, "GPS_RING_SIZE must be a power of two");
+static_assert(GPS_RING_SIZE >= 2 * NmeaParser::MAX_SENTENCE, "GPS_RING_SIZE must hold two sentences");
+
+// Time from a serial GPS receiver, for installs without WiFi. NMEA bytes
+// go from the UART driver into a ring and are parsed there (NmeaParser).
+//
+// With a PPS line the second edge is the interrupt timestamp and the next
+// whole-second RMC/ZDA names it, good to a few microseconds; the sentence
+// has to be complete within GPS_PPS_MAX_AGE_MS of its edge. Without PPS the
+// edge is put GPS_NMEA_LAG_MS before the loop pass that saw the sentence,
+// which can be up to a pass late; of all the seconds seen between results
+// the least late one is used, like NtpClient keeps its fastest reply.
+// Either way only sentences read within GPS_MAX_POLL_GAP_MS of the previous
+// read count, since older ones may have sat in the driver's buffer.
+//
+// Results have the same shape as NtpClient's, an offset to add to the
+// system clock, so they go down the same step/slew path.
+class GpsClock {
+public:
+    struct Result {
+        bool valid;
+        bool pps;            // Edge from the PPS interrupt
+        int64_t offsetUs;    // To add to the local clock
+        uint16_t seconds;    // Time sentences seen since the last result
+    };
+
+    GpsClock();
+
+    // ppsPin < 0: no PPS line
+    void begin(HardwareSerial& port, uint32_t baud, int8_t rxPin, int8_t ppsPin);
+
+    // Non-blocking: reads what the UART holds and parses it. Returns true
+    // when a new result is ready, at most every GPS_SYNC_INTERVAL_MS.
+    bool update(uint32_t nowMs);
+    const Result& lastResult() const { return result; }
+
+    bool hasPps();
+    const NmeaParser::Stats& getStats() const { return parser.getStats(); }
+
+private:
+    // A second edge: local monotonic time and the UTC it stands for
+    struct Edge {
+        int64_t localUs;
+        int64_t utcUs;
+        bool pps;
+    };
+
+    static void onPps(void* arg);
+    void fill(int64_t nowUs);
+    void onTime(const NmeaParser::Time& time, int64_t nowUs);
+    int64_t lastPpsUs();
+
+    HardwareSerial* port;
+    uint8_t ring[GPS_RING_SIZE];
+    uint32_t head;          // Next free byte, free-running
+    int64_t lastFillUs;
+    NmeaParser parser;
+
+    portMUX_TYPE ppsLock;
+    volatile int64_t ppsUs;  // Last PPS edge (esp_timer_get_time)
+    bool ppsWired;
+
+    int64_t lastUtcUs;       // Second of the last time sentence
+    Edge edge;               // Best one since the last result
+    bool haveEdge;
+    uint16_t seconds;
+    bool synced;
+    uint32_t lastSyncMs;
+    Result result;
+};
+
+#endif // GPS_CLOCK_H
@@ -0,0 +1,157 @@
+#include "HttpRequestParser.h"
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// %XX escapes, in place (the result is never longer). '+' is left alone:
+// it is literal in TZ strings like "<+03>-3".
+static void percentDecode(char* s) {
+    char* out = s;
+    while (*s) {
+        int hi, lo;
+        if (s[0] == '%' && (hi = hexValue(s[1])) >= 0 && (lo = hexValue(s[2])) >= 0) {
+            *out++ = (char)(hi * 16 + lo);
+            s += 3;
+        } else {
+            *out++ = *s++;
+        }
+    }
+    *out = '\0';
+}
+
+HttpRequestParser::HttpRequestParser() {
+    reset();
+}
+
+void HttpRequestParser::reset() {
+    used = 0;
+    headLength = 0;
+    status = NEED_MORE;
+    methodPtr = "";
+    pathPtr = "";
+    bodyLength = 0;
+    paramCount = 0;
+    buffer[0] = '\0';
+}
+
+HttpRequestParser::Status HttpRequestParser::feed(const char* data, size_t len) {
+    if (status != NEED_MORE) {
+        return status;
+    }
+
+    size_t room = HTTP_MAX_REQUEST_HEAD - used;
+    size_t take = len < room ? len : room;
+    memcpy(buffer + used, data, take);
+
+    // Only scan the new bytes (plus 3 back for a split "\r\n\r\n")
+    size_t from = used > 3 ? used - 3 : 0;
+    used += take;
+    buffer[used] = '\0';
+
+    for (size_t i = from; i + 3 < used; i++) {
+        if (buffer[i] == '\r' && buffer[i + 1] == '\n' && buffer[i + 2] == '\r' && buffer[i + 3] == '\n') {
+            headLength = i + 4;
+            status = parseHead();
+            return status;
+        }
+    }
+
+    if (used == HTTP_MAX_REQUEST_HEAD) {
+        status = TOO_LARGE;
+    }
+    return status;
+}
+
+HttpRequestParser::Status HttpRequestParser::parseHead() {
+    // The head is split with string functions; a NUL in it would hide the
+    // CRLFs feed() found
+    if (memchr(buffer, '\0', headLength)) {
+        return BAD_REQUEST;
+    }
+
+    // Request line: METHOD SP target SP version CRLF
+    char* line = buffer;
+    char* lineEnd = strstr(line, "\r\n");
+    *lineEnd = '\0';
+
+    char* sp1 = strchr(line, ' ');
+    if (!sp1) {
+        return BAD_REQUEST;
+    }
+    *sp1 = '\0';
+    char* target = sp1 + 1;
+    char* sp2 = strchr(target, ' ');
+    if (!sp2 || strncmp(sp2 + 1, "HTTP/1.", 7) != 0 || target[0] != '/') {
+        return BAD_REQUEST;
+    }
+    *sp2 = '\0';
+    methodPtr = line;
+    pathPtr = target;
+
+    // Split the query string into name/value pairs in place
+    char* query = strchr(target, '?');
+    if (query) {
+        *query++ = '\0';
+        while (*query && paramCount < HTTP_MAX_QUERY_PARAMS) {
+            char* next = strchr(query, '&');
+            if (next) {
+                *next = '\0';
+            }
+            char* eq = strchr(query, '=');
+            if (eq) {
+                *eq = '\0';
+                percentDecode(eq + 1);
+            }
+            percentDecode(query);
+            paramName[paramCount] = (uint16_t)(query - buffer);
+            paramValue[paramCount] = (uint16_t)(eq ? eq + 1 - buffer : lineEnd - buffer);
+            paramCount++;
+            if (!next) {
+                break;
+            }
+            query = next + 1;
+        }
+    }
+
+    // Headers: only Content-Length matters here
+    char* header = lineEnd + 2;
+    char* headEnd = buffer + headLength - 2;
+    while (header < headEnd) {
+        char* end = strstr(header, "\r\n");
+        *end = '\0';
+        if (strncasecmp(header, "Content-Length:", 15) == 0) {
+            bodyLength = (uint32_t)strtoul(header + 15, nullptr, 10);
+        }
+        header = end + 2;
+    }
+
+    return COMPLETE;
+}
+
+bool HttpRequestParser::queryParamAt(uint8_t index, const char*& name, const char*& value) const {
+    if (status != COMPLETE || index >= paramCount) {
+        return false;
+    }
+    name = buffer + paramName[index];
+    value = buffer + paramValue[index];
+    return true;
+}
+
+bool HttpRequestParser::queryParam(const char* name, const char*& value) const {
+    const char* n;
+    const char* v;
+    for (uint8_t i = 0; queryParamAt(i, n, v); i++) {
+        if (strcmp(n, name) == 0) {
+            value = v;
+            return true;
+        }
+    }
+    return false;
+}
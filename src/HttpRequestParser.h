@@ -0,0 +1,61 @@
+#ifndef HTTP_REQUEST_PARSER_H
+#define HTTP_REQUEST_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Incremental HTTP/1.x request-head parser over a fixed buffer. Never
+// allocates: method, path and query values are NUL-terminated in place and
+// returned as pointers into the buffer. Only Content-Length is kept from the
+// headers; any body bytes that arrive with the head are left for the caller.
+class HttpRequestParser {
+public:
+    enum Status : uint8_t {
+        NEED_MORE = 0,
+        COMPLETE,
+        TOO_LARGE,   // Head does not fit in HTTP_MAX_REQUEST_HEAD
+        BAD_REQUEST
+    };
+
+    HttpRequestParser();
+
+    void reset();
+
+    // Append received bytes; returns COMPLETE once the blank line is seen
+    Status feed(const char* data, size_t len);
+
+    const char* method() const { return methodPtr; }
+    const char* path() const { return pathPtr; }
+    uint32_t contentLength() const { return bodyLength; }
+
+    // Bytes after the head that arrived in the same reads
+    const char* bodyStart() const { return buffer + headLength; }
+    size_t bodyBytes() const { return used - headLength; }
+
+    // Looks up ?name=value in the query string (%XX decoded); value points
+    // into the buffer
+    bool queryParam(const char* name, const char*& value) const;
+
+    // Iterate all query parameters; index from 0 until it returns false
+    bool queryParamAt(uint8_t index, const char*& name, const char*& value) const;
+
+private:
+    Status parseHead();
+
+    char buffer[HTTP_MAX_REQUEST_HEAD + 1];
+    size_t used;
+    size_t headLength;
+    Status status;
+
+    const char* methodPtr;
+    const char* pathPtr;
+    uint32_t bodyLength;
+
+    // Query parameters as offsets into buffer
+    uint8_t paramCount;
+    uint16_t paramName[HTTP_MAX_QUERY_PARAMS];
+    uint16_t paramValue[HTTP_MAX_QUERY_PARAMS];
+};
+
+#endif // HTTP_REQUEST_PARSER_H
@@ -0,0 +1,64 @@
+#ifndef LOG_EVENTS_H
+#define LOG_EVENTS_H
+
+// Every message the firmware logs, as X(name, format). A record only carries
+// the position in this list plus its arguments; the text is filled in later
+// by the drain task, or by tools/log_decode.py (which parses this file) when
+// LOG_BINARY is set. So only ever append, and keep each format one literal.
+//
+// Arguments are 32-bit: %d %i %u %x %X %c with the usual flags and width,
+// %s (copied into the record, truncated to the space left) and %B (ON/OFF).
+#define LOG_EVENTS(X) \
+    X(DROPPED,          "Log: %u records dropped") \
+    X(BOOT,             "=== Binary Clock (Optimized) ===") \
+    X(DISPLAY_READY,    "Display initialized") \
+    X(BUTTONS_READY,    "Buttons initialized") \
+    X(READY,            "=== Binary Clock Ready ===") \
+    X(HELP_DIGITS,      "GPIO 0: Toggle time display") \
+    X(HELP_REPORT,      "GPIO 0 double tap: Status report") \
+    X(HELP_AUTO,        "GPIO 0 long press: Toggle auto brightness") \
+    X(HELP_BRIGHTNESS,  "GPIO 14: Cycle brightness (hold to keep stepping)") \
+    X(HELP_RESYNC,      "Both buttons: Force NTP resync") \
+    X(WIFI_CONNECTING,  "Connecting to WiFi") \
+    X(WIFI_FAILED,      "WiFi connection failed!") \
+    X(WIFI_FAST,        "WiFi fast reconnect (ch %u, %02X:%02X:%02X:%02X:%02X:%02X)") \
+    X(WIFI_FAST_FAILED, "WiFi fast reconnect failed, falling back to full scan") \
+    X(WIFI_ASSOCIATED,  "WiFi associated via %s path in %u ms") \
+    X(WIFI_CONNECTED,   "WiFi connected, IP %u.%u.%u.%u") \
+    X(NTP_NO_SERVER,    "NTP: no server could be resolved") \
+    X(NTP_FAILED,       "NTP sync failed (%u servers answered)") \
+    X(NTP_SYNCED,       "NTP sync: %u/%u servers agreed") \
+    X(SYNC_NEVER,       "Sync: never synced, %u failures") \
+    X(SYNC_REPORT,      "Sync: offset %d us, delay %u us, jitter %u us, ok %u, failed %u (%u in a row)") \
+    X(PRESS_LATENCY,    "Press-to-pixel: %u us (min %u, avg %u, max %u, n=%u)") \
+    X(AUTO_BRIGHTNESS,  "Auto brightness: %B") \
+    X(TIME_DISPLAY,     "Time display: %B") \
+    X(BRIGHTNESS,       "Brightness: level %u/%u (duty %u/%u), loop blocked %u us") \
+    X(FORCE_RESYNC,     "Forcing NTP resync") \
+    X(LOG_STATS,        "Log: %u calls, %u dropped, %u cycles per call avg, %u max") \
+    X(HTTP_READY,       "HTTP status on port %u") \
+    X(HTTP_CONTROL,     "HTTP control: %s=%s") \
+    X(HTTP_CONFIG,      "HTTP config: %s=%s") \
+    X(CONFIG_UNUSABLE,  "Config: stored settings unusable, using defaults") \
+    X(CONFIG_SAVED,     "Config saved (%u writes since boot)") \
+    X(MQTT_UNRESOLVED,  "MQTT: broker not resolved yet, will retry") \
+    X(MIRROR_READY,     "Mirror ready for %s:%u") \
+    X(MIRROR_FAILED,    "Mirror: no memory for the canvas or viewer host not resolved") \
+    X(OTA_PENDING,      "OTA: running new firmware, pending verification") \
+    X(OTA_CONFIRMED,    "OTA: new firmware confirmed") \
+    X(OTA_ROLLBACK,     "OTA: new firmware never got online, rolling back") \
+    X(OTA_VERIFIED,     "OTA: %u bytes verified, rebooting") \
+    X(GPS_READY,        "GPS on RX %d, PPS %d, %u baud") \
+    X(GPS_SYNCED,       "GPS sync via %s, %u seconds seen") \
+    X(GPS_STATS,        "GPS: %u sentences, %u times, %u bad checksums, %u malformed") \
+    X(TIMER_MODE,       "Timer: %s") \
+    X(TIMER_START,      "Timer: started at %u.%03u s") \
+    X(TIMER_STOP,       "Timer: stopped at %u.%03u s") \
+    X(TIMER_LAP,        "Timer: lap %u %u.%03u s, total %u.%03u s") \
+    X(TIMER_DONE,       "Timer: countdown of %u s done") \
+    X(TIMER_RESET,      "Timer: reset") \
+    X(HELP_TIMER,       "Timer: GPIO 0 start/stop, GPIO 14 lap/reset, GPIO 0 long press: back to clock") \
+    X(NIGHT_MODE,       "Night panel mode: %B") \
+    X(SYNC_STEPPED,     "Sync: stepped %c%u.%06u s, delay %u us, jitter %u us, ok %u, failed %u (%u in a row)")
+
+#endif // LOG_EVENTS_H
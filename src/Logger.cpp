@@ -0,0 +1,188 @@
+#include "Logger.h"
+#include <string.h>
+
+static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of two");
+
+// Binary frame: LOG_FRAME_MAGIC, event, words, time (4), words x 4, then an
+// 8-bit sum of everything after the magic. Little-endian, as in memory.
+static const uint8_t LOG_FRAME_MAGIC = 0xA5;
+
+Logger logger;
+
+Logger::Logger()
+    : head(0), tail(0), dropped(0), calls(0), cycleSum(0), maxCycles(0),
+      droppedReported(0) {}
+
+void Logger::begin() {
+    xTaskCreatePinnedToCore(drainTask, "log", LOG_TASK_STACK, this, LOG_TASK_PRIORITY,
+                            nullptr, LOG_TASK_CORE);
+}
+
+void Logger::drainTask(void* arg) {
+    Logger* self = static_cast<Logger*>(arg);
+    for (;;) {
+        self->drain(Serial);
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+void Logger::pack(Record& r, uint8_t& n, const char* text) {
+    // NUL-terminated in place, cut to whatever words are left
+    size_t room = (size_t)(LOG_MAX_WORDS - n) * 4;
+    if (room == 0) {
+        return;
+    }
+    size_t len = strlen(text);
+    if (len > room - 1) {
+        len = room - 1;
+    }
+    char* dst = (char*)&r.args[n];
+    memcpy(dst, text, len);
+    dst[len] = '\0';
+    n += (uint8_t)((len + 4) / 4);
+}
+
+size_t Logger::drain(Print& out) {
+    size_t written = 0;
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    while (t != head.load(std::memory_order_acquire)) {
+        // Copy out first so the slot is free again before the UART blocks
+        Record record = ring[t & (LOG_RING_RECORDS - 1)];
+        tail.store(++t, std::memory_order_release);
+        emit(out, record);
+        written++;
+    }
+
+    // Drops are only known here, so they get a record of their own
+    uint32_t lost = dropped.load(std::memory_order_relaxed);
+    if (lost != droppedReported) {
+        Record note;
+        note.timeUs = (uint32_t)esp_timer_get_time();
+        note.event = LOG_DROPPED;
+        note.words = 1;
+        note.args[0] = lost - droppedReported;
+        droppedReported = lost;
+        emit(out, note);
+        written++;
+    }
+    return written;
+}
+
+void Logger::flush(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (tail.load(std::memory_order_acquire) != head.load(std::memory_order_relaxed) &&
+           millis() - start < timeoutMs) {
+        delay(1);
+    }
+    // The last records may still be in the UART FIFO
+    Serial.flush();
+}
+
+void Logger::emit(Print& out, const Record& record) {
+#if LOG_BINARY
+    uint8_t frame[3 + 4 + LOG_MAX_WORDS * 4 + 1];
+    size_t len = 0;
+    frame[len++] = LOG_FRAME_MAGIC;
+    frame[len++] = record.event;
+    frame[len++] = record.words;
+    memcpy(&frame[len], &record.timeUs, 4);
+    len += 4;
+    memcpy(&frame[len], record.args, (size_t)record.words * 4);
+    len += (size_t)record.words * 4;
+    uint8_t sum = 0;
+    for (size_t i = 1; i < len; i++) {
+        sum += frame[i];
+    }
+    frame[len++] = sum;
+    out.write(frame, len);
+#else
+    // Records are drained long before the 32-bit time wraps (71 minutes),
+    // so the full time is the latest one ending in these 32 bits. Tracking
+    // wraps between records misses every wrap in a quiet hour.
+    uint64_t nowUs = (uint64_t)esp_timer_get_time();
+    uint64_t ms = (nowUs - (uint32_t)((uint32_t)nowUs - record.timeUs)) / 1000;
+
+    char line[160];
+    int n = snprintf(line, sizeof(line), "[%5lu.%03lu] ",
+                     (unsigned long)(ms / 1000), (unsigned long)(ms % 1000));
+    size_t len = n > 0 ? (size_t)n : 0;
+    len += format(line + len, sizeof(line) - len - 1, record);
+    line[len++] = '\n';
+    out.write((const uint8_t*)line, len);
+#endif
+}
+
+size_t Logger::format(char* buf, size_t cap, const Record& record) {
+    if (cap == 0) {
+        return 0;
+    }
+    if (record.event >= LOG_EVENT_COUNT) {
+        int n = snprintf(buf, cap, "Unknown log event %u", record.event);
+        return n < 0 ? 0 : ((size_t)n < cap ? (size_t)n : cap - 1);
+    }
+    const char* fmt = FORMATS[record.event];
+    const uint32_t* args = record.args;
+    uint8_t words = record.words < LOG_MAX_WORDS ? record.words : LOG_MAX_WORDS;
+    uint8_t word = 0;
+
+    size_t len = 0;
+    for (const char* p = fmt; *p && len + 1 < cap;) {
+        if (*p != '%') {
+            buf[len++] = *p++;
+            continue;
+        }
+
+        // One conversion at a time through snprintf, flags and width intact
+        char spec[8];
+        size_t specLen = 0;
+        spec[specLen++] = *p++;
+        while (*p && strchr("-+ 0#.123456789", *p) && specLen < sizeof(spec) - 2) {
+            spec[specLen++] = *p++;
+        }
+        char conv = *p ? *p++ : '%';
+        int n;
+        if (conv == '%') {
+            n = snprintf(buf + len, cap - len, "%%");
+        } else if (conv == 's') {
+            // Missing words (cut short by an earlier string) print as empty
+            const char* text = "";
+            if (word < words) {
+                text = (const char*)&args[word];
+                size_t maxLen = (size_t)(words - word) * 4;
+                size_t textLen = strnlen(text, maxLen);
+                word += (uint8_t)((textLen + 4) / 4);
+                if (textLen == maxLen) {
+                    text = "";  // Not terminated: damaged record
+                }
+            }
+            spec[specLen++] = 's';
+            spec[specLen] = '\0';
+            n = snprintf(buf + len, cap - len, spec, text);
+        } else {
+            uint32_t value = word < words ? args[word] : 0;
+            word++;
+            if (conv == 'B') {
+                spec[specLen++] = 's';
+                spec[specLen] = '\0';
+                n = snprintf(buf + len, cap - len, spec, value ? "ON" : "OFF");
+            } else if (conv == 'd' || conv == 'i' || conv == 'c') {
+                spec[specLen++] = conv;
+                spec[specLen] = '\0';
+                n = snprintf(buf + len, cap - len, spec, (int)(int32_t)value);
+            } else {
+                spec[specLen++] = conv;
+                spec[specLen] = '\0';
+                n = snprintf(buf + len, cap - len, spec, (unsigned int)value);
+            }
+        }
+        if (n < 0) {
+            break;
+        }
+        len += (size_t)n;
+        if (len >= cap) {
+            len = cap - 1;
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,173 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include "config.h"
+#include "LogEvents.h"
+
+#define LOG_EVENT_ID(name, format) LOG_##name,
+#define LOG_EVENT_FORMAT(name, format) format,
+
+enum LogEvent : uint8_t {
+    LOG_EVENTS(LOG_EVENT_ID)
+    LOG_EVENT_COUNT
+};
+
+// Logs an event from LogEvents.h, e.g. LOG_EVENT(NTP_SYNCED, survivors, servers)
+#define LOG_EVENT(name, ...) logger.log<LOG_##name>(__VA_ARGS__)
+
+// Deferred-formatting logger. A log call only copies the event ID, a
+// timestamp and its raw arguments into a lock-free ring; a low-priority task
+// turns them into text (or binary frames for tools/log_decode.py) and pays
+// for the UART. When the ring is full the record is dropped and counted,
+// the caller never waits. Single producer: log only from the loop task.
+class Logger {
+public:
+    struct Record {
+        uint32_t timeUs;                  // Low 32 bits of esp_timer_get_time()
+        uint8_t event;
+        uint8_t words;                    // Argument words in use
+        uint16_t reserved;
+        uint32_t args[LOG_MAX_WORDS];     // Integers, then strings in place
+    };
+
+    static constexpr const char* FORMATS[LOG_EVENT_COUNT] = {LOG_EVENTS(LOG_EVENT_FORMAT)};
+
+    Logger();
+
+    // Starts the drain task; records logged before this wait in the ring
+    void begin();
+
+    template <LogEvent E, typename... Args>
+    void log(Args... args) {
+        static_assert(countArgs(FORMATS[E]) == sizeof...(Args),
+                      "Argument count does not match the format in LogEvents.h");
+        static_assert(typesMatch<E, Args...>(std::index_sequence_for<Args...>{}),
+                      "Argument types do not match the format in LogEvents.h");
+        uint32_t start = ESP.getCycleCount();
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= LOG_RING_RECORDS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            Record& r = ring[h & (LOG_RING_RECORDS - 1)];
+            r.timeUs = (uint32_t)esp_timer_get_time();
+            r.event = E;
+            uint8_t n = 0;
+            (pack(r, n, args), ...);
+            r.words = n;
+            head.store(h + 1, std::memory_order_release);
+        }
+        account(ESP.getCycleCount() - start);
+    }
+
+    // Moves waiting records to out; the drain task's job, or for hosts
+    // without one. Returns the number written.
+    size_t drain(Print& out);
+    // Waits (up to timeoutMs) until the drain task has caught up, e.g.
+    // before a reboot
+    void flush(uint32_t timeoutMs);
+
+    // Renders one record as text, without a newline
+    static size_t format(char* buf, size_t cap, const Record& record);
+
+    uint32_t getCalls() const { return calls; }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t getAvgCycles() const { return calls ? (uint32_t)(cycleSum / calls) : 0; }
+    uint32_t getMaxCycles() const { return maxCycles; }
+
+private:
+    // Conversion character of the n-th argument in a format, 0 if none
+    static constexpr char conversion(const char* fmt, size_t n) {
+        for (size_t i = 0; fmt[i]; i++) {
+            if (fmt[i] != '%') {
+                continue;
+            }
+            i++;
+            while (fmt[i] == '-' || fmt[i] == '+' || fmt[i] == ' ' || fmt[i] == '0' ||
+                   fmt[i] == '#' || fmt[i] == '.' || (fmt[i] >= '1' && fmt[i] <= '9')) {
+                i++;
+            }
+            if (fmt[i] == 0) {
+                break;
+            }
+            if (fmt[i] == '%') {
+                continue;
+            }
+            if (n-- == 0) {
+                return fmt[i];
+            }
+        }
+        return 0;
+    }
+
+    static constexpr size_t countArgs(const char* fmt) {
+        size_t n = 0;
+        while (conversion(fmt, n) != 0) {
+            n++;
+        }
+        return n;
+    }
+
+    template <typename T>
+    static constexpr bool isString() {
+        return std::is_same<typename std::decay<T>::type, const char*>::value ||
+               std::is_same<typename std::decay<T>::type, char*>::value;
+    }
+
+    // %s takes a string, the other conversions an integer of at most 32 bits
+    template <typename T>
+    static constexpr bool argMatches(char conv) {
+        if (conv == 's') {
+            return isString<T>();
+        }
+        return (conv == 'd' || conv == 'i' || conv == 'u' || conv == 'x' || conv == 'X' ||
+                conv == 'c' || conv == 'B') &&
+               (std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4;
+    }
+
+    template <LogEvent E, typename... Args, size_t... I>
+    static constexpr bool typesMatch(std::index_sequence<I...>) {
+        return (argMatches<Args>(conversion(FORMATS[E], I)) && ... && true);
+    }
+
+    template <typename T>
+    static void pack(Record& r, uint8_t& n, T value) {
+        if (n < LOG_MAX_WORDS) {
+            r.args[n++] = (uint32_t)value;
+        }
+    }
+    static void pack(Record& r, uint8_t& n, const char* text);
+    static void pack(Record& r, uint8_t& n, char* text) { pack(r, n, (const char*)text); }
+
+    void account(uint32_t cycles) {
+        calls++;
+        cycleSum += cycles;
+        if (cycles > maxCycles) {
+            maxCycles = cycles;
+        }
+    }
+
+    void emit(Print& out, const Record& record);
+    static void drainTask(void* arg);
+
+    Record ring[LOG_RING_RECORDS];
+    std::atomic<uint32_t> head;       // Next slot the producer fills
+    std::atomic<uint32_t> tail;       // Next slot the drain reads
+    std::atomic<uint32_t> dropped;
+
+    // Hot-path cost, producer side only
+    uint32_t calls;
+    uint64_t cycleSum;
+    uint32_t maxCycles;
+
+    // Drain side
+    uint32_t droppedReported;
+};
+
+extern Logger logger;
+
+#endif // LOGGER_H
@@ -0,0 +1,173 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+// Longest single line; HELP text and label sets must fit in this
+static const size_t MAX_LINE = 192;
+
+Metric* Metric::head = nullptr;
+Metric* Metric::tail = nullptr;
+
+Metric::Metric(Type type, const char* name, const char* labels, const char* help, double scale)
+    : type(type), name(name), labels(labels), help(help), scale(scale), next(nullptr) {
+    // Static construction only, so no locking; append to keep definition order
+    if (tail) {
+        tail->next = this;
+    } else {
+        head = this;
+    }
+    tail = this;
+}
+
+int Metric::writeName(char* buf, size_t cap, const char* suffix, const char* extraLabel) const {
+    bool hasLabels = labels && labels[0];
+    bool hasExtra = extraLabel && extraLabel[0];
+    if (!hasLabels && !hasExtra) {
+        return snprintf(buf, cap, "%s%s ", name, suffix);
+    }
+    return snprintf(buf, cap, "%s%s{%s%s%s} ", name, suffix,
+                    hasLabels ? labels : "", hasLabels && hasExtra ? "," : "",
+                    hasExtra ? extraLabel : "");
+}
+
+int Metric::writeLine(char* buf, size_t cap, uint8_t line, bool withHeader) const {
+    if (line > 0) {
+        return writeSample(buf, cap, line - 1);
+    }
+    if (!withHeader) {
+        return 0;
+    }
+    static const char* const typeNames[] = {"counter", "gauge", "histogram"};
+    return snprintf(buf, cap, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, typeNames[type]);
+}
+
+size_t Metric::serialize(char* buf, size_t cap, uint32_t& cursor) {
+    uint16_t index = (uint16_t)(cursor >> 16);
+    uint16_t line = (uint16_t)(cursor & 0xFFFF);
+
+    Metric* prev = nullptr;
+    Metric* m = head;
+    for (uint16_t i = 0; m && i < index; i++) {
+        prev = m;
+        m = m->next;
+    }
+
+    size_t used = 0;
+    char scratch[MAX_LINE];
+    while (m) {
+        bool withHeader = !prev || strcmp(prev->name, m->name) != 0;
+        while (line <= m->sampleLines()) {
+            int n = m->writeLine(scratch, sizeof(scratch), (uint8_t)line, withHeader);
+            if (n < 0 || (size_t)n >= sizeof(scratch) || (size_t)n > cap) {
+                n = 0;  // Oversized line: skip rather than emit a truncated one
+            }
+            if (used + (size_t)n > cap) {
+                cursor = ((uint32_t)index << 16) | line;
+                return used;
+            }
+            memcpy(buf + used, scratch, (size_t)n);
+            used += (size_t)n;
+            line++;
+        }
+        prev = m;
+        m = m->next;
+        index++;
+        line = 0;
+    }
+
+    cursor = ((uint32_t)index << 16);
+    return used;
+}
+
+// One sample line (sampleLines() is 1), so the line index is always 0
+int Counter::writeSample(char* buf, size_t cap, uint8_t) const {
+    int n = writeName(buf, cap, "", nullptr);
+    if (n < 0 || (size_t)n >= cap) {
+        return n;
+    }
+    if (scale == 1.0) {
+        return n + snprintf(buf + n, cap - n, "%lu\n", (unsigned long)get());
+    }
+    return n + snprintf(buf + n, cap - n, "%.9g\n", get() * scale);
+}
+
+int Gauge::writeSample(char* buf, size_t cap, uint8_t) const {
+    int n = writeName(buf, cap, "", nullptr);
+    if (n < 0 || (size_t)n >= cap) {
+        return n;
+    }
+    if (scale == 1.0) {
+        return n + snprintf(buf + n, cap - n, "%ld\n", (long)get());
+    }
+    return n + snprintf(buf + n, cap - n, "%.9g\n", get() * scale);
+}
+
+HistogramBase::HistogramBase(const char* name, const char* labels, const char* help, double scale,
+                             const uint32_t* bounds, uint8_t boundCount,
+                             std::atomic<uint32_t>* counts)
+    : Metric(HISTOGRAM, name, labels, help, scale),
+      bounds(bounds), boundCount(boundCount), counts(counts), sumLow(0), sumHigh(0) {
+}
+
+void HistogramBase::observe(uint32_t v) {
+    uint8_t bucket = 0;
+    while (bucket < boundCount && v > bounds[bucket]) {
+        bucket++;
+    }
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // Carry into the high word when the low word wraps
+    uint32_t old = sumLow.fetch_add(v, std::memory_order_relaxed);
+    if (old + v < old) {
+        sumHigh.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t HistogramBase::sum() const {
+    uint32_t high;
+    uint32_t low;
+    do {
+        high = sumHigh.load(std::memory_order_relaxed);
+        low = sumLow.load(std::memory_order_relaxed);
+    } while (high != sumHigh.load(std::memory_order_relaxed));
+    return ((uint64_t)high << 32) | low;
+}
+
+uint32_t HistogramBase::cumulative(uint8_t bucket) const {
+    // Re-read per line: later lines only ever see larger counts, so the
+    // exported buckets stay monotonic even while observe() runs
+    uint32_t total = 0;
+    for (uint8_t i = 0; i <= bucket; i++) {
+        total += counts[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+int HistogramBase::writeSample(char* buf, size_t cap, uint8_t line) const {
+    char le[24];
+    int n;
+    if (line <= boundCount) {
+        if (line < boundCount) {
+            snprintf(le, sizeof(le), "le=\"%g\"", bounds[line] * scale);
+        } else {
+            snprintf(le, sizeof(le), "le=\"+Inf\"");
+        }
+        n = writeName(buf, cap, "_bucket", le);
+        if (n < 0 || (size_t)n >= cap) {
+            return n;
+        }
+        return n + snprintf(buf + n, cap - n, "%lu\n", (unsigned long)cumulative(line));
+    }
+    if (line == boundCount + 1) {
+        n = writeName(buf, cap, "_sum", nullptr);
+        if (n < 0 || (size_t)n >= cap) {
+            return n;
+        }
+        return n + snprintf(buf + n, cap - n, "%.9g\n", (double)sum() * scale);
+    }
+    n = writeName(buf, cap, "_count", nullptr);
+    if (n < 0 || (size_t)n >= cap) {
+        return n;
+    }
+    return n + snprintf(buf + n, cap - n, "%lu\n", (unsigned long)cumulative(boundCount));
+}
@@ -0,0 +1,118 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Prometheus-style metrics. Each metric is a statically allocated object that
+// links itself into a registry list when constructed; updates are relaxed
+// 32-bit atomics (lock-free on both ESP32 cores and on the host), so they can
+// be called from any task without locks or allocation.
+//
+// Values are stored as integers in a base unit (e.g. microseconds) and
+// multiplied by `scale` only when serialized (e.g. 1e-6 to export seconds).
+// Metrics sharing a name must be defined next to each other; HELP/TYPE lines
+// are written once per name, with the per-metric `labels` on each sample.
+class Metric {
+public:
+    enum Type : uint8_t {
+        COUNTER = 0,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    // Writes the exposition text into buf, resuming from cursor (start at 0).
+    // Only whole lines are written; returns 0 once everything has been sent.
+    static size_t serialize(char* buf, size_t cap, uint32_t& cursor);
+
+protected:
+    Metric(Type type, const char* name, const char* labels, const char* help, double scale);
+
+    // Number of sample lines (excluding HELP/TYPE) and one line of them
+    virtual uint8_t sampleLines() const { return 1; }
+    virtual int writeSample(char* buf, size_t cap, uint8_t line) const = 0;
+
+    int writeName(char* buf, size_t cap, const char* suffix, const char* extraLabel) const;
+
+    Type type;
+    const char* name;
+    const char* labels;  // e.g. "button=\"boot\"", or nullptr
+    const char* help;
+    double scale;
+
+private:
+    int writeLine(char* buf, size_t cap, uint8_t line, bool withHeader) const;
+
+    Metric* next;
+    static Metric* head;
+    static Metric* tail;
+};
+
+class Counter : public Metric {
+public:
+    Counter(const char* name, const char* labels, const char* help, double scale = 1.0)
+        : Metric(COUNTER, name, labels, help, scale), value(0) {}
+
+    void add(uint32_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t get() const { return value.load(std::memory_order_relaxed); }
+
+protected:
+    int writeSample(char* buf, size_t cap, uint8_t line) const override;
+
+private:
+    std::atomic<uint32_t> value;
+};
+
+class Gauge : public Metric {
+public:
+    Gauge(const char* name, const char* labels, const char* help, double scale = 1.0)
+        : Metric(GAUGE, name, labels, help, scale), value(0) {}
+
+    void set(int32_t v) { value.store(v, std::memory_order_relaxed); }
+    int32_t get() const { return value.load(std::memory_order_relaxed); }
+
+protected:
+    int writeSample(char* buf, size_t cap, uint8_t line) const override;
+
+private:
+    std::atomic<int32_t> value;
+};
+
+// Fixed upper bounds (base units, ascending); an implicit +Inf bucket follows.
+// The 64-bit sum is kept as two 32-bit atomics so it stays lock-free on
+// targets without 64-bit atomics.
+class HistogramBase : public Metric {
+public:
+    void observe(uint32_t v);
+
+protected:
+    HistogramBase(const char* name, const char* labels, const char* help, double scale,
+                  const uint32_t* bounds, uint8_t boundCount, std::atomic<uint32_t>* counts);
+
+    uint8_t sampleLines() const override { return boundCount + 3; }  // buckets, +Inf, sum, count
+    int writeSample(char* buf, size_t cap, uint8_t line) const override;
+
+private:
+    uint64_t sum() const;
+    uint32_t cumulative(uint8_t bucket) const;
+
+    const uint32_t* bounds;
+    uint8_t boundCount;
+    std::atomic<uint32_t>* counts;  // boundCount + 1 entries
+    std::atomic<uint32_t> sumLow;
+    std::atomic<uint32_t> sumHigh;
+};
+
+template <size_t N>
+class Histogram : public HistogramBase {
+public:
+    Histogram(const char* name, const char* labels, const char* help, double scale,
+              const uint32_t (&upperBounds)[N])
+        : HistogramBase(name, labels, help, scale, upperBounds, (uint8_t)N, buckets), buckets() {}
+
+private:
+    std::atomic<uint32_t> buckets[N + 1];
+};
+
+#endif // METRICS_H
@@ -0,0 +1,155 @@
+#include "MirrorEncoder.h"
+#include <string.h>
+
+static_assert(MIRROR_DATAGRAM_SIZE >= MirrorEncoder::HEADER_SIZE + SCREEN_W * 2 + (SCREEN_W + 127) / 128,
+              "A mirror datagram must hold at least one full screen row");
+
+static uint32_t area(const MirrorEncoder::Rect& r) {
+    return (uint32_t)r.w * r.h;
+}
+
+static MirrorEncoder::Rect unite(const MirrorEncoder::Rect& a, const MirrorEncoder::Rect& b) {
+    uint16_t x0 = a.x < b.x ? a.x : b.x;
+    uint16_t y0 = a.y < b.y ? a.y : b.y;
+    uint16_t x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    uint16_t y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    return {x0, y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+}
+
+static bool contains(const MirrorEncoder::Rect& outer, const MirrorEncoder::Rect& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+}
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) {
+    *p++ = (uint8_t)v;
+    *p++ = (uint8_t)(v >> 8);
+    return p;
+}
+
+MirrorEncoder::MirrorEncoder(uint16_t w, uint16_t h)
+    : width(w), height(h), count(0), active{0, 0, 0, 0}, activeRow(0), hasActive(false), sequence(0) {
+}
+
+void MirrorEncoder::clear() {
+    count = 0;
+    hasActive = false;
+}
+
+void MirrorEncoder::addDamage(int16_t x, int16_t y, int16_t w, int16_t h) {
+    int32_t x0 = x < 0 ? 0 : x;
+    int32_t y0 = y < 0 ? 0 : y;
+    int32_t x1 = (int32_t)x + w > width ? width : (int32_t)x + w;
+    int32_t y1 = (int32_t)y + h > height ? height : (int32_t)y + h;
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+    Rect r = {(uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+
+    // Already covered, or swallows rects that are
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (contains(rects[i], r)) {
+            return;
+        }
+        if (!contains(r, rects[i])) {
+            rects[kept++] = rects[i];
+        }
+    }
+    count = kept;
+
+    if (count < MIRROR_MAX_RECTS) {
+        rects[count++] = r;
+        return;
+    }
+
+    // Full: grow whichever rect needs the fewest extra pixels
+    uint8_t best = 0;
+    uint32_t bestGrowth = UINT32_MAX;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t growth = area(unite(rects[i], r)) - area(rects[i]);
+        if (growth < bestGrowth) {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    rects[best] = unite(rects[best], r);
+}
+
+uint8_t* MirrorEncoder::encodeRow(const uint16_t* pixels, uint16_t w, uint8_t* p) {
+    uint16_t i = 0;
+    while (i < w) {
+        uint16_t run = 1;
+        while (i + run < w && run < 129 && pixels[i + run] == pixels[i]) {
+            run++;
+        }
+        if (run >= 2) {
+            *p++ = (uint8_t)(0x80 + run - 2);
+            memcpy(p, &pixels[i], 2);
+            p += 2;
+            i += run;
+            continue;
+        }
+
+        // Literal until the next pair of equal pixels
+        uint8_t* control = p++;
+        uint16_t start = i;
+        while (i < w && i - start < 128 && !(i + 1 < w && pixels[i + 1] == pixels[i])) {
+            i++;
+        }
+        *control = (uint8_t)(i - start - 1);
+        memcpy(p, &pixels[start], (size_t)(i - start) * 2);
+        p += (i - start) * 2;
+    }
+    return p;
+}
+
+size_t MirrorEncoder::encode(const uint16_t* frame, uint8_t* out, size_t capacity, Rect* strip) {
+    if (!hasActive) {
+        if (count == 0) {
+            return 0;
+        }
+        active = rects[0];
+        memmove(rects, rects + 1, (count - 1) * sizeof(Rect));
+        count--;
+        activeRow = 0;
+        hasActive = true;
+    }
+
+    const size_t bound = rowBound(active.w);
+    if (capacity < HEADER_SIZE + bound) {
+        return 0;
+    }
+
+    // Pixels are copied as stored, which is already the panel's byte order
+    uint8_t* p = out + HEADER_SIZE;
+    const uint8_t* end = out + capacity;
+    const uint16_t firstRow = activeRow;
+    while (activeRow < active.h && (size_t)(end - p) >= bound) {
+        const uint16_t* row = frame + (size_t)(active.y + activeRow) * width + active.x;
+        p = encodeRow(row, active.w, p);
+        activeRow++;
+    }
+
+    Rect done = {active.x, (uint16_t)(active.y + firstRow), active.w, (uint16_t)(activeRow - firstRow)};
+    uint8_t* h = out;
+    *h++ = 'B';
+    *h++ = 'M';
+    *h++ = VERSION;
+    *h++ = 0;
+    h = putU16(h, sequence++);
+    h = putU16(h, width);
+    h = putU16(h, height);
+    h = putU16(h, done.x);
+    h = putU16(h, done.y);
+    h = putU16(h, done.w);
+    putU16(h, done.h);
+
+    if (activeRow == active.h) {
+        hasActive = false;
+    }
+    if (strip) {
+        *strip = done;
+    }
+    return (size_t)(p - out);
+}
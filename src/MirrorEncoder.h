@@ -0,0 +1,64 @@
+#ifndef MIRROR_ENCODER_H
+#define MIRROR_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+// Turns damaged screen areas into self-contained datagrams. Each datagram
+// carries one strip (whole rows of one damage rect) so a lost packet only
+// leaves that strip stale:
+//
+//   0  'B' 'M'          magic
+//   2  version (1)
+//   3  flags (0)
+//   4  sequence         uint16, little-endian like every header field
+//   6  screen w, h      uint16 each
+//  10  strip x, y, w, h uint16 each
+//  18  rows, row-major, PackBits over big-endian RGB565 pixels:
+//        c < 0x80   c+1 literal pixels follow
+//        c >= 0x80  next pixel repeated c-0x80+2 times
+//      runs never cross a row
+//
+// Pending damage is a fixed list; when it is full the new rect is merged
+// into the one it grows least, so memory stays bounded and no damage is
+// ever forgotten.
+class MirrorEncoder {
+public:
+    struct Rect {
+        uint16_t x, y, w, h;
+    };
+
+    static const size_t HEADER_SIZE = 18;
+    static const uint8_t VERSION = 1;
+
+    MirrorEncoder(uint16_t width, uint16_t height);
+
+    // Clipped to the screen
+    void addDamage(int16_t x, int16_t y, int16_t w, int16_t h);
+    void clear();
+    bool pending() const { return count > 0 || hasActive; }
+    uint8_t rectCount() const { return count; }
+
+    // Worst-case encoded size of one row of w pixels
+    static size_t rowBound(uint16_t w) { return (size_t)w * 2 + (w + 127) / 128; }
+
+    // Next strip of damaged pixels from frame (panel byte order, stride =
+    // screen width) into out; 0 when nothing is pending. strip, if given,
+    // receives the area covered so the caller can requeue it.
+    size_t encode(const uint16_t* frame, uint8_t* out, size_t capacity, Rect* strip = nullptr);
+
+private:
+    static uint8_t* encodeRow(const uint16_t* pixels, uint16_t w, uint8_t* p);
+
+    uint16_t width;
+    uint16_t height;
+    Rect rects[MIRROR_MAX_RECTS];
+    uint8_t count;
+    Rect active;          // Rect being sent, no longer merged into
+    uint16_t activeRow;   // Rows of it already encoded
+    bool hasActive;
+    uint16_t sequence;
+};
+
+#endif // MIRROR_ENCODER_H
@@ -0,0 +1,469 @@
+#include "MqttPublisher.h"
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/tcp.h>
+#include <sys/time.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Anything before 2020-01-01 means the clock was never set
+static const time_t MIN_VALID_EPOCH = 1577836800;
+
+// Room for the fixed header: type byte + up to 2 remaining-length bytes
+// (MQTT_TX_BUFFER is below 16 KB)
+static const uint16_t FIXED_HEADER_MAX = 3;
+
+static uint8_t* putString(uint8_t* p, const char* s) {
+    size_t len = strlen(s);
+    *p++ = (uint8_t)(len >> 8);
+    *p++ = (uint8_t)len;
+    memcpy(p, s, len);
+    return p + len;
+}
+
+MqttPublisher::MqttPublisher()
+    : host(""), port(0), resolved(false), lookup(LOOKUP_PENDING), lookupAddr(0), started(false),
+      clientId(""), user(nullptr), pass(nullptr),
+      sock(-1), state(STATE_IDLE), stateSinceMs(0), retryDelayMs(0),
+      lastTxMs(0), pingSentMs(0), pingOutstanding(false), announceOnline(false),
+      txStart(0), txEnd(0), rxLength(0), batchTaken(0),
+      head(0), count(0), flushRequested(false),
+      batchesSent(0), samplesSent(0), samplesDropped(0), reconnects(0) {
+    memset(&broker, 0, sizeof(broker));
+    telemetryTopic[0] = '\0';
+    statusTopic[0] = '\0';
+}
+
+// An IP literal or a name in lwIP's cache is answered at once. Anything
+// else goes to the DNS server, and onDnsFound() gets the reply, or the
+// failure once lwIP gives up, while update() carries on.
+void MqttPublisher::startLookup(uint32_t nowMs) {
+    ip_addr_t addr;
+    lookup.store(LOOKUP_PENDING, std::memory_order_relaxed);
+    err_t err = dns_gethostbyname(host, &addr, onDnsFound, this);
+    if (err == ERR_OK && IP_IS_V4(&addr)) {
+        broker.sin_addr.s_addr = ip4_addr_get_u32(ip_2_ip4(&addr));
+        resolved = true;
+    } else if (err == ERR_INPROGRESS) {
+        state = STATE_RESOLVING;
+        stateSinceMs = nowMs;
+    } else {
+        fail(nowMs);
+    }
+}
+
+void MqttPublisher::onDnsFound(const char* name, const ip_addr_t* ipaddr, void* arg) {
+    (void)name;
+    MqttPublisher* self = static_cast<MqttPublisher*>(arg);
+    if (ipaddr && IP_IS_V4(ipaddr)) {
+        self->lookupAddr.store(ip4_addr_get_u32(ip_2_ip4(ipaddr)), std::memory_order_relaxed);
+        self->lookup.store(LOOKUP_FOUND, std::memory_order_release);
+    } else {
+        self->lookup.store(LOOKUP_FAILED, std::memory_order_release);
+    }
+}
+
+bool MqttPublisher::begin(const char* brokerHost, uint16_t brokerPort, const char* id,
+                          const char* username, const char* password) {
+    end();
+
+    host = brokerHost;
+    port = brokerPort;
+    clientId = id;
+    user = username && username[0] ? username : nullptr;
+    pass = password && password[0] ? password : nullptr;
+    snprintf(telemetryTopic, sizeof(telemetryTopic), "%s/%s/telemetry", MQTT_TOPIC_ROOT, id);
+    snprintf(statusTopic, sizeof(statusTopic), "%s/%s/status", MQTT_TOPIC_ROOT, id);
+
+    memset(&broker, 0, sizeof(broker));
+    broker.sin_family = AF_INET;
+    broker.sin_port = htons(port);
+    resolved = false;
+    started = true;
+    stateSinceMs = 0;
+    retryDelayMs = 0;  // First attempt on the next update()
+    startLookup(0);
+    return resolved;
+}
+
+void MqttPublisher::end() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    state = STATE_IDLE;
+    started = false;
+    txStart = txEnd = 0;
+    rxLength = 0;
+    samplesDropped += batchTaken;
+    batchTaken = 0;
+}
+
+void MqttPublisher::enqueue(const char* key, int32_t value, uint32_t atMs, bool flushNow) {
+    if (count == MQTT_QUEUE_SIZE) {
+        // Full: the oldest sample is the least interesting one
+        head = (uint8_t)((head + 1) % MQTT_QUEUE_SIZE);
+        count--;
+        samplesDropped++;
+    }
+    Sample& s = queue[(head + count) % MQTT_QUEUE_SIZE];
+    s.key = key;
+    s.value = value;
+    s.atMs = atMs;
+    count++;
+    flushRequested |= flushNow;
+}
+
+void MqttPublisher::startConnect(uint32_t nowMs) {
+    stateSinceMs = nowMs;
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        fail(nowMs);
+        return;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(sock, (sockaddr*)&broker, sizeof(broker)) != 0 && errno != EINPROGRESS) {
+        fail(nowMs);
+        return;
+    }
+    state = STATE_CONNECTING;
+}
+
+void MqttPublisher::fail(uint32_t nowMs) {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    if (state == STATE_CONNECTED) {
+        reconnects++;
+    }
+    state = STATE_IDLE;
+    stateSinceMs = nowMs;
+    txStart = txEnd = 0;
+    rxLength = 0;
+    // A batch still in tx left the queue in buildBatch(); it goes with the
+    // connection (QoS 0 has no resend), so count it as dropped
+    samplesDropped += batchTaken;
+    batchTaken = 0;
+    pingOutstanding = false;
+
+    // Exponential backoff, reset by a successful CONNACK
+    if (retryDelayMs < MQTT_RETRY_MIN_MS) {
+        retryDelayMs = MQTT_RETRY_MIN_MS;
+    } else {
+        retryDelayMs = retryDelayMs * 2 > MQTT_RETRY_MAX_MS ? MQTT_RETRY_MAX_MS : retryDelayMs * 2;
+    }
+}
+
+bool MqttPublisher::flushTx(uint32_t nowMs) {
+    if (txStart == txEnd) {
+        return true;
+    }
+    ssize_t sent = send(sock, tx + txStart, txEnd - txStart, MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            fail(nowMs);
+        }
+        return false;
+    }
+    txStart += (uint16_t)sent;
+    if (txStart < txEnd) {
+        return false;
+    }
+
+    lastTxMs = nowMs;
+    if (batchTaken > 0) {
+        batchesSent++;
+        samplesSent += batchTaken;
+        batchTaken = 0;
+    }
+    txStart = txEnd = 0;
+    return true;
+}
+
+void MqttPublisher::receive(uint32_t nowMs) {
+    ssize_t n = recv(sock, rx + rxLength, sizeof(rx) - rxLength, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        fail(nowMs);
+        return;
+    }
+    if (n < 0) {
+        return;
+    }
+    rxLength += (uint8_t)n;
+
+    // We never subscribe, so only CONNACK and PINGRESP are expected; both
+    // are tiny and anything that doesn't fit rx is a protocol error here
+    while (rxLength >= 2) {
+        if (rx[1] & 0x80) {
+            fail(nowMs);
+            return;
+        }
+        uint8_t total = (uint8_t)(2 + rx[1]);
+        if (total > sizeof(rx)) {
+            fail(nowMs);
+            return;
+        }
+        if (rxLength < total) {
+            return;
+        }
+
+        uint8_t type = rx[0] & 0xF0;
+        if (type == 0x20 && state == STATE_AWAIT_CONNACK) {
+            if (total < 4 || rx[3] != 0) {
+                fail(nowMs);  // Refused (bad credentials, id rejected, ...)
+                return;
+            }
+            state = STATE_CONNECTED;
+            stateSinceMs = nowMs;
+            retryDelayMs = 0;
+            announceOnline = true;
+        } else if (type == 0xD0) {
+            pingOutstanding = false;
+        }
+
+        memmove(rx, rx + total, rxLength - total);
+        rxLength -= total;
+    }
+}
+
+bool MqttPublisher::batchDue(uint32_t nowMs) const {
+    if (count == 0) {
+        return false;
+    }
+    return flushRequested || count >= MQTT_BATCH_MAX_SAMPLES ||
+           nowMs - queue[head].atMs >= MQTT_BATCH_INTERVAL_MS;
+}
+
+void MqttPublisher::update(uint32_t nowMs) {
+    switch (state) {
+        case STATE_IDLE:
+            if (!started || nowMs - stateSinceMs < retryDelayMs) {
+                return;
+            }
+            if (!resolved) {
+                startLookup(nowMs);
+                if (!resolved) {
+                    return;
+                }
+            }
+            startConnect(nowMs);
+            return;
+
+        case STATE_RESOLVING:
+            switch (lookup.load(std::memory_order_acquire)) {
+                case LOOKUP_PENDING:
+                    return;
+                case LOOKUP_FOUND:
+                    broker.sin_addr.s_addr = lookupAddr.load(std::memory_order_relaxed);
+                    resolved = true;
+                    startConnect(nowMs);
+                    return;
+                default:
+                    fail(nowMs);
+                    return;
+            }
+
+        case STATE_CONNECTING: {
+            // Writable means the TCP handshake finished, one way or the other
+            fd_set writable;
+            FD_ZERO(&writable);
+            FD_SET(sock, &writable);
+            timeval zero = {0, 0};
+            if (select(sock + 1, nullptr, &writable, nullptr, &zero) <= 0) {
+                if (nowMs - stateSinceMs >= MQTT_CONNECT_TIMEOUT_MS) {
+                    fail(nowMs);
+                }
+                return;
+            }
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                fail(nowMs);
+                return;
+            }
+            buildConnect();
+            state = STATE_AWAIT_CONNACK;
+            flushTx(nowMs);
+            return;
+        }
+
+        case STATE_AWAIT_CONNACK:
+            if (flushTx(nowMs)) {
+                receive(nowMs);
+            }
+            if (state == STATE_AWAIT_CONNACK && nowMs - stateSinceMs >= MQTT_CONNECT_TIMEOUT_MS) {
+                fail(nowMs);
+            }
+            return;
+
+        case STATE_CONNECTED:
+            receive(nowMs);
+            if (state != STATE_CONNECTED || !flushTx(nowMs)) {
+                return;
+            }
+            if (pingOutstanding && nowMs - pingSentMs >= MQTT_KEEPALIVE_S * 1000UL) {
+                fail(nowMs);  // Broker went quiet
+                return;
+            }
+
+            // Tx is empty: queue at most one packet and start sending it
+            if (announceOnline) {
+                announceOnline = false;
+                buildStatus("online");
+            } else if (batchDue(nowMs)) {
+                buildBatch(nowMs);
+            } else if (!pingOutstanding && nowMs - lastTxMs >= MQTT_KEEPALIVE_S * 500UL) {
+                buildPing();
+                pingOutstanding = true;
+                pingSentMs = nowMs;
+            } else {
+                return;
+            }
+            flushTx(nowMs);
+            return;
+    }
+}
+
+void MqttPublisher::buildConnect() {
+    static const char* const OFFLINE = "offline";
+
+    // Clean session, retained will on the status topic
+    uint8_t flags = 0x02 | 0x04 | 0x20;
+    size_t remaining = 10 + 2 + strlen(clientId) + 2 + strlen(statusTopic) + 2 + strlen(OFFLINE);
+    if (user) {
+        flags |= 0x80;
+        remaining += 2 + strlen(user);
+    }
+    if (pass) {
+        flags |= 0x40;
+        remaining += 2 + strlen(pass);
+    }
+
+    uint8_t* p = tx;
+    *p++ = 0x10;
+    if (remaining >= 128) {
+        *p++ = (uint8_t)(0x80 | (remaining & 0x7F));
+        *p++ = (uint8_t)(remaining >> 7);
+    } else {
+        *p++ = (uint8_t)remaining;
+    }
+    p = putString(p, "MQTT");
+    *p++ = 4;  // Protocol level 3.1.1
+    *p++ = flags;
+    *p++ = (uint8_t)(MQTT_KEEPALIVE_S >> 8);
+    *p++ = (uint8_t)MQTT_KEEPALIVE_S;
+    p = putString(p, clientId);
+    p = putString(p, statusTopic);
+    p = putString(p, OFFLINE);
+    if (user) {
+        p = putString(p, user);
+    }
+    if (pass) {
+        p = putString(p, pass);
+    }
+
+    txStart = 0;
+    txEnd = (uint16_t)(p - tx);
+}
+
+size_t MqttPublisher::beginPublish(const char* topic, uint8_t** payload) {
+    // Topic goes right after the reserved fixed-header bytes
+    uint8_t* p = putString(tx + FIXED_HEADER_MAX, topic);
+    *payload = p;
+    return sizeof(tx) - (size_t)(p - tx);
+}
+
+void MqttPublisher::finishPublish(size_t payloadLength, bool retain) {
+    size_t topicLength = ((size_t)tx[FIXED_HEADER_MAX] << 8) | tx[FIXED_HEADER_MAX + 1];
+    size_t remaining = 2 + topicLength + payloadLength;
+
+    // Right-align the fixed header against the variable header
+    uint16_t start;
+    if (remaining >= 128) {
+        start = FIXED_HEADER_MAX - 3;
+        tx[start + 1] = (uint8_t)(0x80 | (remaining & 0x7F));
+        tx[start + 2] = (uint8_t)(remaining >> 7);
+    } else {
+        start = FIXED_HEADER_MAX - 2;
+        tx[start + 1] = (uint8_t)remaining;
+    }
+    tx[start] = (uint8_t)(0x30 | (retain ? 0x01 : 0x00));
+
+    txStart = start;
+    txEnd = (uint16_t)(FIXED_HEADER_MAX + remaining);
+}
+
+void MqttPublisher::buildStatus(const char* text) {
+    uint8_t* payload;
+    beginPublish(statusTopic, &payload);
+    size_t len = strlen(text);
+    memcpy(payload, text, len);
+    finishPublish(len, true);
+}
+
+void MqttPublisher::buildBatch(uint32_t nowMs) {
+    uint8_t* payload;
+    size_t cap = beginPublish(telemetryTopic, &payload);
+    char* out = (char*)payload;
+
+    // Timestamp of the first sample, wall clock if we have one
+    uint32_t firstAtMs = queue[head].atMs;
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    bool wall = tv.tv_sec >= MIN_VALID_EPOCH;
+    unsigned long long baseMs = wall
+        ? (unsigned long long)tv.tv_sec * 1000ULL + tv.tv_usec / 1000 - (nowMs - firstAtMs)
+        : (unsigned long long)firstAtMs;
+
+    // Reserve 2 bytes for the closing "]}"
+    size_t room = cap - 2;
+    int n = snprintf(out, room, "{\"%s\":%llu,\"s\":[", wall ? "t" : "up", baseMs);
+    size_t used = n > 0 && (size_t)n < room ? (size_t)n : room;
+
+    uint8_t taken = 0;
+    while (taken < count) {
+        const Sample& s = queue[(head + taken) % MQTT_QUEUE_SIZE];
+        n = snprintf(out + used, room - used, "%s[%lu,\"%s\",%ld]", taken ? "," : "",
+                     (unsigned long)(s.atMs - firstAtMs), s.key, (long)s.value);
+        if (n < 0 || (size_t)n >= room - used) {
+            break;  // Rest goes in the next batch
+        }
+        used += (size_t)n;
+        taken++;
+    }
+    uint8_t consumed = taken;
+    if (taken == 0) {
+        // A single sample that can never fit: drop it rather than stall
+        consumed = 1;
+        samplesDropped++;
+    }
+    out[used++] = ']';
+    out[used++] = '}';
+
+    head = (uint8_t)((head + consumed) % MQTT_QUEUE_SIZE);
+    count -= consumed;
+    batchTaken = taken;
+    if (count == 0) {
+        flushRequested = false;
+    }
+    finishPublish(used, false);
+}
+
+void MqttPublisher::buildPing() {
+    tx[0] = 0xC0;
+    tx[1] = 0x00;
+    txStart = 0;
+    txEnd = 2;
+}
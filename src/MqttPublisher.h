@@ -0,0 +1,122 @@
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "config.h"
+#include <netinet/in.h>
+#include <lwip/dns.h>
+
+// Publish-only MQTT 3.1.1 client (QoS 0) for telemetry. Samples go into a
+// bounded ring (oldest dropped when full) and leave as compact JSON batches:
+//
+//   <root>/<id>/telemetry  {"t":1718000000123,"s":[[0,"heap",201344],[15,"rssi",-61]]}
+//   <root>/<id>/status     "online" / "offline" (retained, offline is the will)
+//
+// "t" is the wall-clock time of the first sample in ms ("up" = uptime ms when
+// the clock was never set); each entry is [ms after it, key, value].
+// update() is a non-blocking state machine doing at most one connect step,
+// one recv and one send per call. No heap use; POSIX sockets and lwIP's
+// DNS API only, so it builds on Linux against the sim/ stand-ins.
+class MqttPublisher {
+public:
+    MqttPublisher();
+
+    // Starts looking up the broker, without waiting for DNS: true if it is
+    // an IP literal or already cached. A lookup that fails is retried on the
+    // backoff schedule; connecting happens in update(). Strings must outlive
+    // this.
+    bool begin(const char* host, uint16_t port, const char* clientId,
+               const char* user = nullptr, const char* pass = nullptr);
+    void end();
+
+    // key must point to a string that outlives the queue (a literal).
+    // flushNow sends the batch on the next update() instead of waiting.
+    void enqueue(const char* key, int32_t value, uint32_t atMs, bool flushNow = false);
+
+    void update(uint32_t nowMs);
+
+    bool connected() const { return state == STATE_CONNECTED; }
+    uint8_t queued() const { return count; }
+    uint32_t getBatchesSent() const { return batchesSent; }
+    uint32_t getSamplesSent() const { return samplesSent; }
+    uint32_t getSamplesDropped() const { return samplesDropped; }
+    uint32_t getReconnects() const { return reconnects; }
+
+private:
+    enum State : uint8_t {
+        STATE_IDLE = 0,      // Not started, or waiting out the retry backoff
+        STATE_RESOLVING,     // DNS lookup in flight, answered by onDnsFound()
+        STATE_CONNECTING,    // Non-blocking TCP connect in progress
+        STATE_AWAIT_CONNACK,
+        STATE_CONNECTED
+    };
+
+    struct Sample {
+        const char* key;
+        int32_t value;
+        uint32_t atMs;
+    };
+
+    enum Lookup : uint8_t { LOOKUP_PENDING = 0, LOOKUP_FOUND, LOOKUP_FAILED };
+
+    void startLookup(uint32_t nowMs);
+    static void onDnsFound(const char* name, const ip_addr_t* ipaddr, void* arg);
+    void startConnect(uint32_t nowMs);
+    void fail(uint32_t nowMs);
+    bool flushTx(uint32_t nowMs);
+    void receive(uint32_t nowMs);
+    bool batchDue(uint32_t nowMs) const;
+
+    void buildConnect();
+    size_t beginPublish(const char* topic, uint8_t** payload);
+    void finishPublish(size_t payloadLength, bool retain);
+    void buildStatus(const char* text);
+    void buildBatch(uint32_t nowMs);
+    void buildPing();
+
+    const char* host;
+    uint16_t port;
+    sockaddr_in broker;
+    bool resolved;
+    // Set by onDnsFound() on the lwIP thread, read by update()
+    std::atomic<uint8_t> lookup;
+    std::atomic<uint32_t> lookupAddr;  // Network byte order
+    bool started;
+    const char* clientId;
+    const char* user;
+    const char* pass;
+    char telemetryTopic[64];
+    char statusTopic[64];
+
+    int sock;
+    State state;
+    uint32_t stateSinceMs;
+    uint32_t retryDelayMs;
+    uint32_t lastTxMs;
+    uint32_t pingSentMs;
+    bool pingOutstanding;
+    bool announceOnline;
+
+    // Outbound packet; the fixed header is right-aligned into the first
+    // bytes so the remaining length can be written last
+    uint8_t tx[MQTT_TX_BUFFER];
+    uint16_t txStart;
+    uint16_t txEnd;
+    uint8_t rx[16];
+    uint8_t rxLength;
+    uint8_t batchTaken;  // Samples in the packet being sent, dropped if it fails
+
+    Sample queue[MQTT_QUEUE_SIZE];
+    uint8_t head;        // Oldest sample
+    uint8_t count;
+    bool flushRequested;
+
+    uint32_t batchesSent;
+    uint32_t samplesSent;
+    uint32_t samplesDropped;
+    uint32_t reconnects;
+};
+
+#endif // MQTT_PUBLISHER_H
@@ -0,0 +1,199 @@
+#include "NmeaParser.h"
+#include <string.h>
+
+static const int64_t US_PER_DAY = 86400LL * 1000000LL;
+
+NmeaParser::NmeaParser() : state(SEEK), pos(0), start(0), sum(0), expected(0), fieldCount(0) {
+    memset(fieldStart, 0, sizeof(fieldStart));
+    memset(&stats, 0, sizeof(stats));
+}
+
+void NmeaParser::begin(uint32_t at) {
+    state = BODY;
+    start = at;
+    sum = 0;
+    fieldCount = 0;
+    fieldStart[0] = 1;
+}
+
+void NmeaParser::drop() {
+    state = SEEK;
+    stats.malformed++;
+}
+
+int8_t NmeaParser::hexValue(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return (int8_t)(c - '0');
+    }
+    if (c >= 'A' && c <= 'F') {
+        return (int8_t)(c - 'A' + 10);
+    }
+    if (c >= 'a' && c <= 'f') {
+        return (int8_t)(c - 'a' + 10);
+    }
+    return -1;
+}
+
+bool NmeaParser::scan(const uint8_t* ring, uint32_t mask, uint32_t end, Time& out) {
+    for (; pos != end; pos++) {
+        uint8_t c = ring[pos & mask];
+        if (state == SEEK) {
+            if (c == '$') {
+                begin(pos);
+            }
+            continue;
+        }
+        if (c == '$') {
+            // A new sentence cut this one short
+            stats.malformed++;
+            begin(pos);
+            continue;
+        }
+        if (pos - start >= MAX_SENTENCE) {
+            drop();
+            continue;
+        }
+
+        uint8_t offset = (uint8_t)(pos - start);
+        if (state == BODY) {
+            if (c == '*') {
+                fieldStart[fieldCount + 1] = (uint8_t)(offset + 1);
+                state = CHECK_HI;
+            } else if (c < 0x20 || c > 0x7E) {
+                drop();  // Includes CR/LF before any checksum
+            } else {
+                sum ^= c;
+                if (c == ',' && fieldCount < MAX_FIELDS - 1) {
+                    // Fields past the last slot run together; none are used
+                    fieldStart[++fieldCount] = (uint8_t)(offset + 1);
+                }
+            }
+            continue;
+        }
+
+        int8_t digit = hexValue(c);
+        if (digit < 0) {
+            drop();
+            continue;
+        }
+        if (state == CHECK_HI) {
+            expected = (uint8_t)(digit << 4);
+            state = CHECK_LO;
+            continue;
+        }
+
+        state = SEEK;
+        if ((expected | (uint8_t)digit) != sum) {
+            stats.badChecksum++;
+            continue;
+        }
+        stats.sentences++;
+        if (decode(ring, mask, out)) {
+            stats.times++;
+            pos++;
+            return true;
+        }
+    }
+    return false;
+}
+
+NmeaParser::Span NmeaParser::field(uint8_t i) const {
+    Span span = {start, 0};
+    if (i <= fieldCount) {
+        span.at = start + fieldStart[i];
+        span.len = (uint8_t)(fieldStart[i + 1] - 1 - fieldStart[i]);
+    }
+    return span;
+}
+
+bool NmeaParser::digitsAt(const uint8_t* ring, uint32_t mask, uint32_t at, uint8_t count, uint32_t& value) {
+    value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t c = ring[(at + i) & mask];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (uint32_t)(c - '0');
+    }
+    return true;
+}
+
+bool NmeaParser::parseTime(const uint8_t* ring, uint32_t mask, Span f, int64_t& us) {
+    // hhmmss, optionally .s to .ssssss
+    uint32_t h, m, s;
+    if (f.len < 6 || !digitsAt(ring, mask, f.at, 2, h) || !digitsAt(ring, mask, f.at + 2, 2, m) ||
+        !digitsAt(ring, mask, f.at + 4, 2, s) || h > 23 || m > 59 || s > 59) {
+        return false;  // Leap second 60 included: Unix time has no room for it
+    }
+    uint32_t frac = 0;
+    uint32_t scale = 1000000;
+    if (f.len > 6) {
+        if (ring[(f.at + 6) & mask] != '.') {
+            return false;
+        }
+        for (uint8_t i = 7; i < f.len; i++) {
+            uint32_t digit;
+            if (!digitsAt(ring, mask, f.at + i, 1, digit)) {
+                return false;
+            }
+            if (scale > 1) {
+                scale /= 10;
+                frac += digit * scale;
+            }
+        }
+    }
+    us = ((int64_t)h * 3600 + m * 60 + s) * 1000000LL + frac;
+    return true;
+}
+
+int32_t NmeaParser::daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+    // H. Hinnant's days_from_civil, years starting in March
+    y -= m <= 2;
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+bool NmeaParser::decode(const uint8_t* ring, uint32_t mask, Time& out) const {
+    // Address: two-letter talker and three-letter type; $P... is proprietary
+    Span address = field(0);
+    if (address.len != 5 || ring[address.at & mask] == 'P') {
+        return false;
+    }
+    char type[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        type[i] = (char)ring[(address.at + 2 + i) & mask];
+    }
+
+    int64_t timeOfDayUs;
+    uint32_t day, month, year;
+    if (memcmp(type, "RMC", 3) == 0) {
+        Span status = field(2);
+        Span date = field(9);
+        if (status.len != 1 || ring[status.at & mask] != 'A' || date.len != 6 ||
+            !digitsAt(ring, mask, date.at, 2, day) || !digitsAt(ring, mask, date.at + 2, 2, month) ||
+            !digitsAt(ring, mask, date.at + 4, 2, year)) {
+            return false;
+        }
+        year += 2000;
+        out.kind = KIND_RMC;
+    } else if (memcmp(type, "ZDA", 3) == 0) {
+        Span d = field(2);
+        Span m = field(3);
+        Span y = field(4);
+        if (d.len != 2 || m.len != 2 || y.len != 4 || !digitsAt(ring, mask, d.at, 2, day) ||
+            !digitsAt(ring, mask, m.at, 2, month) || !digitsAt(ring, mask, y.at, 4, year)) {
+            return false;
+        }
+        out.kind = KIND_ZDA;
+    } else {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || !parseTime(ring, mask, field(1), timeOfDayUs)) {
+        return false;
+    }
+    out.utcUs = (int64_t)daysFromCivil((int32_t)year, month, day) * US_PER_DAY + timeOfDayUs;
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef NMEA_PARSER_H
+#define NMEA_PARSER_H
+
+#include <stdint.h>
+
+// NMEA 0183 time sentences, parsed where they lie in a receive ring. The
+// scan keeps only the offsets of the fields in the current sentence and
+// the running checksum; once "*hh" matches, the fields are decoded straight
+// from the ring. Nothing is copied or allocated, and a sentence may wrap
+// around the end of the ring.
+//
+// Only time is extracted, from any talker ($GP, $GN, $GL, ...):
+//   RMC  hhmmss.ss,A/V,lat,N,lon,E,speed,course,ddmmyy,...  (A = valid fix)
+//   ZDA  hhmmss.ss,dd,mm,yyyy,zone h,zone m
+// Everything else is checked and counted, then skipped.
+class NmeaParser {
+public:
+    // Longest sentence kept, '$' to checksum; the standard allows 82 with
+    // CR LF, but some receivers go past it
+    static const uint8_t MAX_SENTENCE = 120;
+    static const uint8_t MAX_FIELDS = 16;
+
+    enum Kind : uint8_t {
+        KIND_RMC = 0,
+        KIND_ZDA
+    };
+
+    struct Time {
+        int64_t utcUs;       // Unix time, including the fractional seconds
+        Kind kind;
+    };
+
+    struct Stats {
+        uint32_t sentences;    // Checksum OK
+        uint32_t times;        // ...of which gave a valid time
+        uint32_t badChecksum;
+        uint32_t malformed;    // Too long, no checksum, stray characters
+    };
+
+    NmeaParser();
+
+    // Scans ring bytes from where the last call stopped up to end (indices
+    // run freely, the ring has mask + 1 bytes). Returns true as soon as a
+    // sentence yields a time, so call until it returns false.
+    bool scan(const uint8_t* ring, uint32_t mask, uint32_t end, Time& out);
+
+    // Bytes before this index are no longer needed by the parser
+    uint32_t keepFrom() const { return state == SEEK ? pos : start; }
+
+    const Stats& getStats() const { return stats; }
+
+    // Days since 1970-01-01 of a proleptic Gregorian date
+    static int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d);
+
+private:
+    enum State : uint8_t {
+        SEEK = 0,   // Waiting for '$'
+        BODY,       // Address and fields, XORed into sum
+        CHECK_HI,   // First checksum digit
+        CHECK_LO
+    };
+
+    // Field i of the sentence that just completed, as ring indices
+    struct Span {
+        uint32_t at;
+        uint8_t len;
+    };
+
+    void begin(uint32_t at);
+    void drop();
+    Span field(uint8_t i) const;
+    bool decode(const uint8_t* ring, uint32_t mask, Time& out) const;
+    static bool parseTime(const uint8_t* ring, uint32_t mask, Span f, int64_t& us);
+    static bool digitsAt(const uint8_t* ring, uint32_t mask, uint32_t at, uint8_t count, uint32_t& value);
+    static int8_t hexValue(uint8_t c);
+
+    State state;
+    uint32_t pos;           // Next byte to look at
+    uint32_t start;         // The '$' of the current sentence
+    uint8_t sum;
+    uint8_t expected;
+    uint8_t fieldCount;
+    uint8_t fieldStart[MAX_FIELDS + 1];  // Offsets from start; one past the last is its end
+    Stats stats;
+};
+
+#endif // NMEA_PARSER_H
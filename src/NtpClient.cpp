@@ -0,0 +1,359 @@
+#include "NtpClient.h"
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+static const uint16_t NTP_PORT = 123;
+static const uint8_t NTP_PACKET_SIZE = 48;
+static const int64_t NTP_UNIX_DELTA_S = 2208988800LL;  // 1900-01-01 to 1970-01-01
+static const int64_t NTP_PRECISION_US = 1000;          // Allowance for our own timestamping
+
+NtpClient::NtpClient()
+    : serverCount(0), sock(-1), running(false), roundStartMs(0) {
+    memset(servers, 0, sizeof(servers));
+    memset(&result, 0, sizeof(result));
+}
+
+bool NtpClient::resolve(const char* spec, sockaddr_in& addr) {
+    char host[64];
+    uint16_t port = NTP_PORT;
+
+    strncpy(host, spec, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    char* colon = strchr(host, ':');
+    if (colon) {
+        *colon = '\0';
+        port = (uint16_t)atoi(colon + 1);
+    }
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || res == nullptr) {
+        return false;
+    }
+    memcpy(&addr, res->ai_addr, sizeof(addr));
+    addr.sin_port = htons(port);
+    freeaddrinfo(res);
+    return true;
+}
+
+bool NtpClient::begin(const char* const serverSpecs[], uint8_t count) {
+    end();
+
+    serverCount = count > NTP_MAX_SERVERS ? NTP_MAX_SERVERS : count;
+    uint8_t resolved = 0;
+    for (uint8_t i = 0; i < serverCount; i++) {
+        memset(&servers[i], 0, sizeof(servers[i]));
+        servers[i].resolved = resolve(serverSpecs[i], servers[i].addr);
+        if (servers[i].resolved) {
+            resolved++;
+        }
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    return resolved > 0;
+}
+
+void NtpClient::end() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    running = false;
+}
+
+bool NtpClient::ready() const {
+    if (sock < 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < serverCount; i++) {
+        if (servers[i].resolved) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t NtpClient::nowUs() {
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+uint64_t NtpClient::usToNtp(int64_t us) {
+    uint64_t secs = (uint64_t)(us / 1000000LL + NTP_UNIX_DELTA_S);
+    uint64_t frac = ((uint64_t)(us % 1000000LL) << 32) / 1000000ULL;
+    return (secs << 32) | frac;
+}
+
+int64_t NtpClient::ntpToUs(uint64_t ntp) {
+    int64_t secs = (int64_t)(ntp >> 32) - NTP_UNIX_DELTA_S;
+    int64_t frac = (int64_t)(((ntp & 0xFFFFFFFFULL) * 1000000ULL) >> 32);
+    return secs * 1000000LL + frac;
+}
+
+static uint64_t readTimestamp(const uint8_t* p) {
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static int64_t readShortUs(const uint8_t* p) {
+    // NTP short format: 16.16 fixed point seconds
+    uint32_t v = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    return (int64_t)(((uint64_t)v * 1000000ULL) >> 16);
+}
+
+void NtpClient::startSync(uint32_t nowMs) {
+    if (sock < 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < serverCount; i++) {
+        servers[i].awaiting = false;
+        servers[i].sent = 0;
+        servers[i].best.valid = false;
+    }
+    running = true;
+    roundStartMs = nowMs;
+}
+
+void NtpClient::sendRequest(Server& server, uint32_t nowMs) {
+    uint8_t packet[NTP_PACKET_SIZE];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = (0 << 6) | (4 << 3) | 3;  // LI 0, version 4, mode 3 (client)
+
+    server.t1Us = nowUs();
+    server.originNtp = usToNtp(server.t1Us);
+    for (uint8_t i = 0; i < 8; i++) {
+        packet[40 + i] = (uint8_t)(server.originNtp >> (56 - 8 * i));
+    }
+
+    sendto(sock, packet, sizeof(packet), 0, (const sockaddr*)&server.addr, sizeof(server.addr));
+    server.awaiting = true;
+    server.sentAtMs = nowMs;
+    server.sent++;
+}
+
+void NtpClient::receiveReplies() {
+    uint8_t packet[NTP_PACKET_SIZE];
+    sockaddr_in from;
+
+    for (;;) {
+        socklen_t fromLen = sizeof(from);
+        ssize_t len = recvfrom(sock, packet, sizeof(packet), 0, (sockaddr*)&from, &fromLen);
+        if (len < 0) {
+            return;  // EWOULDBLOCK: nothing left to read
+        }
+        int64_t t4 = nowUs();
+        if (len < NTP_PACKET_SIZE) {
+            continue;
+        }
+
+        Server* server = nullptr;
+        for (uint8_t i = 0; i < serverCount; i++) {
+            if (servers[i].awaiting &&
+                servers[i].addr.sin_addr.s_addr == from.sin_addr.s_addr &&
+                servers[i].addr.sin_port == from.sin_port) {
+                server = &servers[i];
+                break;
+            }
+        }
+        if (!server || readTimestamp(packet + 24) != server->originNtp) {
+            continue;  // Unknown source or stale/bogus reply
+        }
+        server->awaiting = false;
+
+        uint8_t leap = packet[0] >> 6;
+        uint8_t mode = packet[0] & 0x07;
+        uint8_t stratum = packet[1];
+        if (leap == 3 || mode != 4 || stratum == 0 || stratum >= 16) {
+            continue;  // Unsynchronized server or kiss-o'-death
+        }
+
+        int64_t t2 = ntpToUs(readTimestamp(packet + 32));
+        int64_t t3 = ntpToUs(readTimestamp(packet + 40));
+        int64_t delay = (t4 - server->t1Us) - (t3 - t2);
+        if (delay < 0) {
+            delay = 0;
+        }
+
+        Sample& best = server->best;
+        if (!best.valid || delay < best.delayUs) {
+            best.valid = true;
+            best.offsetUs = ((t2 - server->t1Us) + (t3 - t4)) / 2;
+            best.delayUs = delay;
+            best.rootDistUs = delay / 2 + readShortUs(packet + 4) / 2 +
+                              readShortUs(packet + 8) + NTP_PRECISION_US;
+        }
+    }
+}
+
+bool NtpClient::roundComplete() const {
+    for (uint8_t i = 0; i < serverCount; i++) {
+        const Server& server = servers[i];
+        if (!server.resolved) {
+            continue;
+        }
+        if (server.awaiting || server.sent < NTP_SAMPLES_PER_SERVER) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NtpClient::update(uint32_t nowMs) {
+    if (!running) {
+        return false;
+    }
+
+    receiveReplies();
+
+    for (uint8_t i = 0; i < serverCount; i++) {
+        Server& server = servers[i];
+        if (!server.resolved) {
+            continue;
+        }
+        if (server.awaiting && nowMs - server.sentAtMs >= NTP_REPLY_TIMEOUT_MS) {
+            server.awaiting = false;  // Lost sample, move on
+        }
+        if (!server.awaiting && server.sent < NTP_SAMPLES_PER_SERVER &&
+            (server.sent == 0 || nowMs - server.sentAtMs >= NTP_SAMPLE_SPACING_MS)) {
+            sendRequest(server, nowMs);
+        }
+    }
+
+    if (!roundComplete()) {
+        return false;
+    }
+    finishRound();
+    return true;
+}
+
+void NtpClient::finishRound() {
+    Sample samples[NTP_MAX_SERVERS];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < serverCount; i++) {
+        if (servers[i].best.valid) {
+            samples[count++] = servers[i].best;
+        }
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.servers = count;
+    selectAndCombine(samples, count, result);
+    running = false;
+}
+
+bool NtpClient::selectAndCombine(const Sample* samples, uint8_t count, Result& out) {
+    if (count == 0) {
+        return false;
+    }
+
+    // Each sample contributes [offset - dist, offset, offset + dist]
+    struct Endpoint {
+        int64_t value;
+        int8_t type;  // -1 low edge, 0 midpoint, +1 high edge
+    };
+    Endpoint edges[3 * NTP_MAX_SERVERS];
+    uint8_t edgeCount = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        edges[edgeCount++] = {samples[i].offsetUs - samples[i].rootDistUs, -1};
+        edges[edgeCount++] = {samples[i].offsetUs, 0};
+        edges[edgeCount++] = {samples[i].offsetUs + samples[i].rootDistUs, 1};
+    }
+    // Insertion sort, at most 3 * NTP_MAX_SERVERS entries
+    for (uint8_t i = 1; i < edgeCount; i++) {
+        Endpoint e = edges[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && edges[j].value > e.value) {
+            edges[j + 1] = edges[j];
+            j--;
+        }
+        edges[j + 1] = e;
+    }
+
+    // Find the smallest number of falsetickers for which a majority of
+    // intervals share a common intersection [low, high]
+    int64_t low = 0;
+    int64_t high = 0;
+    bool found = false;
+    for (uint8_t allow = 0; 2 * allow < count; allow++) {
+        int8_t chime = 0;
+        uint8_t midpoints = 0;
+        low = INT64_MAX;
+        for (uint8_t i = 0; i < edgeCount; i++) {
+            chime -= edges[i].type;
+            if (chime >= count - allow) {
+                low = edges[i].value;
+                break;
+            }
+            if (edges[i].type == 0) {
+                midpoints++;
+            }
+        }
+
+        chime = 0;
+        high = INT64_MIN;
+        for (int8_t i = (int8_t)edgeCount - 1; i >= 0; i--) {
+            chime += edges[i].type;
+            if (chime >= count - allow) {
+                high = edges[i].value;
+                break;
+            }
+            if (edges[i].type == 0) {
+                midpoints++;
+            }
+        }
+
+        if (midpoints <= allow && low <= high) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    // Combine truechimers, weighted by inverse root distance
+    double weightSum = 0;
+    double offsetSum = 0;
+    int64_t bestDelay = INT64_MAX;
+    for (uint8_t i = 0; i < count; i++) {
+        const Sample& s = samples[i];
+        if (s.offsetUs < low || s.offsetUs > high) {
+            continue;  // Falseticker
+        }
+        double weight = 1.0 / (double)(s.rootDistUs > 0 ? s.rootDistUs : 1);
+        weightSum += weight;
+        offsetSum += weight * (double)s.offsetUs;
+        if (s.delayUs < bestDelay) {
+            bestDelay = s.delayUs;
+        }
+        out.survivors++;
+    }
+    if (out.survivors == 0) {
+        return false;
+    }
+
+    out.offsetUs = (int64_t)(offsetSum / weightSum);
+    out.delayUs = bestDelay;
+    out.valid = true;
+    return true;
+}
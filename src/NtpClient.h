@@ -0,0 +1,74 @@
+#ifndef NTP_CLIENT_H
+#define NTP_CLIENT_H
+
+#include <stdint.h>
+#include "config.h"
+#include <netinet/in.h>
+
+// Multi-server SNTP client. Takes several samples per server, keeps the
+// minimum-delay one, rejects falsetickers with the RFC 5905 intersection
+// algorithm and combines the survivors. Uses only POSIX sockets and
+// gettimeofday(), so it builds unchanged on Linux against a local server.
+class NtpClient {
+public:
+    struct Result {
+        bool valid;
+        int64_t offsetUs;    // Combined offset to add to the local clock
+        int64_t delayUs;     // Round-trip delay of the best survivor
+        uint8_t servers;     // Servers that answered
+        uint8_t survivors;   // Servers kept by the intersection algorithm
+    };
+
+    NtpClient();
+
+    // Servers are "host" or "host:port". Resolves names once (blocking DNS).
+    bool begin(const char* const servers[], uint8_t count);
+    void end();
+
+    void startSync(uint32_t nowMs);
+    // Non-blocking; returns true on the call that finishes a sync round
+    bool update(uint32_t nowMs);
+    bool busy() const { return running; }
+    bool ready() const;
+
+    const Result& lastResult() const { return result; }
+
+private:
+    struct Sample {
+        bool valid;
+        int64_t offsetUs;
+        int64_t delayUs;
+        int64_t rootDistUs;  // Half delay plus the server's root delay/dispersion
+    };
+
+    struct Server {
+        sockaddr_in addr;
+        bool resolved;
+        bool awaiting;
+        uint8_t sent;
+        uint32_t sentAtMs;
+        uint64_t originNtp;  // Our transmit timestamp, echoed back by the server
+        int64_t t1Us;
+        Sample best;
+    };
+
+    void sendRequest(Server& server, uint32_t nowMs);
+    void receiveReplies();
+    bool roundComplete() const;
+    void finishRound();
+
+    static bool resolve(const char* spec, sockaddr_in& addr);
+    static int64_t nowUs();
+    static uint64_t usToNtp(int64_t us);
+    static int64_t ntpToUs(uint64_t ntp);
+    static bool selectAndCombine(const Sample* samples, uint8_t count, Result& out);
+
+    Server servers[NTP_MAX_SERVERS];
+    uint8_t serverCount;
+    int sock;
+    bool running;
+    uint32_t roundStartMs;
+    Result result;
+};
+
+#endif // NTP_CLIENT_H
@@ -0,0 +1,161 @@
+#include "OtaUpdater.h"
+#include <string.h>
+#include "AccessToken.h"
+
+OtaUpdater::OtaUpdater(PartitionWriter& w)
+    : writer(w), uploadToken(""), chunkFill(0), flushedBytes(0), received(0), imageSize(0),
+      running(false), done(false), lastError(ERROR_NONE) {
+    memset(expected, 0, sizeof(expected));
+}
+
+bool OtaUpdater::fail(Error error) {
+    if (running) {
+        writer.abort();
+        running = false;
+    }
+    lastError = error;
+    return false;
+}
+
+bool OtaUpdater::begin(uint32_t size, const uint8_t expectedSha256[Sha256::DIGEST_SIZE]) {
+    if (running) {
+        lastError = ERROR_BUSY;
+        return false;
+    }
+    done = false;
+    lastError = ERROR_NONE;
+    if (size == 0) {
+        return fail(ERROR_BAD_REQUEST);
+    }
+    if (size > writer.capacity()) {
+        return fail(ERROR_TOO_LARGE);
+    }
+    if (!writer.begin()) {
+        return fail(ERROR_BEGIN_FAILED);
+    }
+
+    memcpy(expected, expectedSha256, sizeof(expected));
+    sha.begin();
+    imageSize = size;
+    chunkFill = 0;
+    flushedBytes = 0;
+    received = 0;
+    running = true;
+    return true;
+}
+
+uint8_t* OtaUpdater::reserve(size_t& room) {
+    room = running ? sizeof(chunk) - chunkFill : 0;
+    return chunk + chunkFill;
+}
+
+bool OtaUpdater::flushChunk() {
+    if (chunkFill == 0) {
+        return true;
+    }
+    sha.update(chunk, chunkFill);
+    if (!writer.write(flushedBytes, chunk, chunkFill)) {
+        return fail(ERROR_WRITE_FAILED);
+    }
+    flushedBytes += chunkFill;
+    chunkFill = 0;
+    return true;
+}
+
+bool OtaUpdater::commit(size_t length) {
+    if (!running) {
+        return false;
+    }
+    if (length > sizeof(chunk) - chunkFill || received + length > imageSize) {
+        return fail(ERROR_SIZE_MISMATCH);
+    }
+    chunkFill += length;
+    received += length;
+
+    // Only full chunks here; the short tail is written by finish()
+    if (chunkFill == sizeof(chunk)) {
+        return flushChunk();
+    }
+    return true;
+}
+
+bool OtaUpdater::write(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        size_t room;
+        uint8_t* dst = reserve(room);
+        if (room == 0) {
+            return false;
+        }
+        size_t take = length < room ? length : room;
+        memcpy(dst, data, take);
+        if (!commit(take)) {
+            return false;
+        }
+        data += take;
+        length -= take;
+    }
+    return true;
+}
+
+bool OtaUpdater::finish() {
+    if (!running) {
+        return false;
+    }
+    if (!flushChunk()) {
+        return false;
+    }
+    if (received != imageSize) {
+        return fail(ERROR_SIZE_MISMATCH);
+    }
+
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    sha.finish(digest);
+    if (memcmp(digest, expected, sizeof(digest)) != 0) {
+        return fail(ERROR_HASH_MISMATCH);
+    }
+
+    // Hash matched: only now may the writer make the image bootable
+    running = false;
+    if (!writer.finish()) {
+        lastError = ERROR_FINISH_FAILED;
+        return false;
+    }
+    done = true;
+    return true;
+}
+
+void OtaUpdater::abort() {
+    fail(ERROR_ABORTED);
+}
+
+bool OtaUpdater::start(const HttpRequestParser& request) {
+    if (running) {
+        lastError = ERROR_BUSY;
+        return false;
+    }
+
+    const char* token = "";
+    request.queryParam("token", token);
+    if (!accessTokenMatches(token, uploadToken)) {
+        lastError = ERROR_FORBIDDEN;
+        return false;
+    }
+
+    const char* hex;
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    if (!request.queryParam("sha256", hex) || !Sha256::parseHex(hex, digest)) {
+        lastError = ERROR_BAD_REQUEST;
+        return false;
+    }
+
+    return begin(request.contentLength(), digest);
+}
+
+const char* OtaUpdater::error() const {
+    static const char* const names[] = {
+        "none", "busy", "bad request (size or sha256)", "bad token", "image too large",
+        "cannot open partition", "flash write failed", "size mismatch",
+        "sha256 mismatch", "image rejected", "upload interrupted"
+    };
+    return names[lastError];
+}
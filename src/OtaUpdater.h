@@ -0,0 +1,81 @@
+#ifndef OTA_UPDATER_H
+#define OTA_UPDATER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "Sha256.h"
+#include "PartitionWriter.h"
+#include "UploadHandler.h"
+
+// Streams a firmware image into a PartitionWriter in OTA_CHUNK_SIZE chunks.
+// Callers receive straight into the aligned chunk buffer (reserve/commit),
+// so bytes go socket -> chunk -> flash with no intermediate copy and the
+// whole image is never held in RAM. The SHA-256 is computed as chunks are
+// flushed and must match the expected digest before the writer is asked to
+// switch the boot partition.
+class OtaUpdater : public UploadHandler {
+public:
+    enum Error : uint8_t {
+        ERROR_NONE = 0,
+        ERROR_BUSY,           // An update is already running
+        ERROR_BAD_REQUEST,    // Missing/invalid size or hash
+        ERROR_FORBIDDEN,      // Token missing or wrong, or none set
+        ERROR_TOO_LARGE,      // Image bigger than the target partition
+        ERROR_BEGIN_FAILED,
+        ERROR_WRITE_FAILED,
+        ERROR_SIZE_MISMATCH,  // More or fewer bytes than announced
+        ERROR_HASH_MISMATCH,
+        ERROR_FINISH_FAILED,  // Writer rejected the image
+        ERROR_ABORTED         // Upload interrupted
+    };
+
+    explicit OtaUpdater(PartitionWriter& writer);
+
+    // Required as &token= by start(); must outlive this. Uploads are
+    // refused while it is empty.
+    void setToken(const char* token) { uploadToken = token; }
+
+    bool begin(uint32_t imageSize, const uint8_t expectedSha256[Sha256::DIGEST_SIZE]);
+
+    // Space left in the current chunk; always > 0 while an update runs
+    uint8_t* reserve(size_t& room) override;
+    // Accounts for bytes written into reserve()'s buffer; flushes full chunks
+    bool commit(size_t length) override;
+    // Copying convenience for callers that already have the data elsewhere
+    bool write(const uint8_t* data, size_t length);
+    // Flushes the tail, checks size and hash, then lets the writer finish
+    bool finish() override;
+    void abort() override;
+
+    // UploadHandler: POST /update?sha256=<hex>&token=... with the image as body
+    bool start(const HttpRequestParser& request) override;
+    uint16_t rejectStatus() const override { return lastError == ERROR_FORBIDDEN ? 403 : 400; }
+    const char* error() const override;
+
+    bool active() const { return running; }
+    bool succeeded() const { return done; }
+    uint32_t getReceived() const { return received; }
+    uint32_t getImageSize() const { return imageSize; }
+    Error getError() const { return lastError; }
+
+private:
+    bool flushChunk();
+    bool fail(Error error);
+
+    PartitionWriter& writer;
+    const char* uploadToken;
+    Sha256 sha;
+    uint8_t expected[Sha256::DIGEST_SIZE];
+
+    alignas(4) uint8_t chunk[OTA_CHUNK_SIZE];
+    size_t chunkFill;
+    uint32_t flushedBytes;    // Written to the partition so far
+    uint32_t received;
+    uint32_t imageSize;
+    bool running;
+    bool done;
+    Error lastError;
+};
+
+#endif // OTA_UPDATER_H
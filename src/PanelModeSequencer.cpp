@@ -0,0 +1,87 @@
+#include "PanelModeSequencer.h"
+
+static const uint8_t ST7789_PTLON = 0x12;   // Partial display on
+static const uint8_t ST7789_NORON = 0x13;   // Normal display (partial off)
+static const uint8_t ST7789_PTLAR = 0x30;   // Partial area: first and last line
+static const uint8_t ST7789_IDMOFF = 0x38;  // Idle mode off, full color
+static const uint8_t ST7789_IDMON = 0x39;   // Idle mode on, 8 colors
+
+PanelModeSequencer::PanelModeSequencer(PanelPort& panel)
+    : port(panel), step(STEP_IDLE), wantNight(false), wantFirst(0), wantLast(0),
+      night(false), first(0), last(0), sentMs(0), switches(0) {
+}
+
+void PanelModeSequencer::request(bool on, uint16_t firstLine, uint16_t lastLine) {
+    wantNight = on;
+    wantFirst = firstLine;
+    wantLast = lastLine;
+}
+
+bool PanelModeSequencer::pending() const {
+    if (wantNight != night) {
+        return true;
+    }
+    return night && (wantFirst != first || wantLast != last);
+}
+
+void PanelModeSequencer::send() {
+    if (wantNight) {
+        // The area first, so partial mode never starts on a stale one
+        uint8_t area[4] = {(uint8_t)(wantFirst >> 8), (uint8_t)wantFirst,
+                           (uint8_t)(wantLast >> 8), (uint8_t)wantLast};
+        port.writeCommand(ST7789_PTLAR, area, sizeof(area));
+        if (!night) {
+            port.writeCommand(ST7789_PTLON, nullptr, 0);
+            port.writeCommand(ST7789_IDMON, nullptr, 0);
+        }
+    } else {
+        port.writeCommand(ST7789_IDMOFF, nullptr, 0);
+        port.writeCommand(ST7789_NORON, nullptr, 0);
+    }
+    night = wantNight;
+    first = wantFirst;
+    last = wantLast;
+    switches++;
+}
+
+void PanelModeSequencer::update(uint32_t nowMs) {
+    // A step that can finish now runs straight on into the next
+    for (;;) {
+        switch (step) {
+        case STEP_IDLE:
+            if (!pending()) {
+                return;
+            }
+            port.darkenBacklight(true);
+            step = STEP_DARKENING;
+            break;
+        case STEP_DARKENING:
+            if (!port.backlightSettled()) {
+                return;
+            }
+            if (!pending()) {
+                // Requested back to what the panel has
+                port.darkenBacklight(false);
+                step = STEP_RESTORING;
+                break;
+            }
+            send();
+            sentMs = nowMs;
+            step = STEP_LATCHING;
+            break;
+        case STEP_LATCHING:
+            if (nowMs - sentMs < LATCH_MS) {
+                return;
+            }
+            port.darkenBacklight(false);
+            step = STEP_RESTORING;
+            break;
+        case STEP_RESTORING:
+            if (!port.backlightSettled()) {
+                return;
+            }
+            step = STEP_IDLE;
+            break;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef PANEL_MODE_SEQUENCER_H
+#define PANEL_MODE_SEQUENCER_H
+
+#include <stdint.h>
+#include "PanelPort.h"
+
+// Night low-power mode on the ST7789: partial display drives only the
+// panel lines in a window (the rest show black), idle mode cuts the color
+// depth to 8 colors (the top bit of each channel). A switch is sent behind
+// a dark backlight: darken, send, give the panel a frame to latch the
+// change, bring the backlight back, so it is never seen. update() takes
+// the steps without blocking. No TFT code here; the sim's panel model
+// checks the sequence.
+class PanelModeSequencer {
+public:
+    static const uint32_t LATCH_MS = 20;  // Over one frame at the panel's 60 Hz default
+
+    explicit PanelModeSequencer(PanelPort& port);
+
+    // Night: lines first..last (inclusive) driven, 8 colors. A request
+    // made mid-switch is taken up when that switch ends.
+    void request(bool night, uint16_t first, uint16_t last);
+    // Call every loop pass
+    void update(uint32_t nowMs);
+
+    // What the panel has been sent
+    bool isNight() const { return night; }
+    bool busy() const { return step != STEP_IDLE; }
+    uint32_t getSwitches() const { return switches; }
+
+private:
+    enum Step : uint8_t {
+        STEP_IDLE = 0,
+        STEP_DARKENING,   // Waiting for the backlight to go dark
+        STEP_LATCHING,    // Commands sent, waiting out a frame
+        STEP_RESTORING    // Waiting for the backlight to come back
+    };
+
+    bool pending() const;
+    void send();
+
+    PanelPort& port;
+    Step step;
+    bool wantNight;
+    uint16_t wantFirst;
+    uint16_t wantLast;
+    bool night;
+    uint16_t first;
+    uint16_t last;
+    uint32_t sentMs;
+    uint32_t switches;
+};
+
+#endif // PANEL_MODE_SEQUENCER_H
@@ -0,0 +1,20 @@
+#ifndef PANEL_PORT_H
+#define PANEL_PORT_H
+
+#include <stdint.h>
+
+// What PanelModeSequencer drives: controller commands and the backlight.
+// BinaryClockDisplay implements it over TFT_eSPI and the LEDC fade; the
+// simulator's panel model sees the same calls.
+class PanelPort {
+public:
+    virtual ~PanelPort() {}
+
+    virtual void writeCommand(uint8_t command, const uint8_t* data, uint8_t length) = 0;
+    // Backlight off (dark), or back at its set level. It may fade;
+    // backlightSettled() turns true once it has got there.
+    virtual void darkenBacklight(bool dark) = 0;
+    virtual bool backlightSettled() = 0;
+};
+
+#endif // PANEL_PORT_H
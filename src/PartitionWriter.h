@@ -0,0 +1,27 @@
+#ifndef PARTITION_WRITER_H
+#define PARTITION_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Destination for a firmware image. OtaUpdater only ever writes whole
+// OTA_CHUNK_SIZE chunks at increasing, chunk-aligned offsets (the last one
+// may be short), so an implementation can erase one sector per write.
+// EspOtaWriter targets the inactive app partition; the host uses a
+// simulated partition.
+class PartitionWriter {
+public:
+    virtual ~PartitionWriter() {}
+
+    // Bytes available for an image; 0 when there is nowhere to write
+    virtual uint32_t capacity() = 0;
+    // Starts an image; OtaUpdater has already checked its size against
+    // capacity(), and sectors are erased as they are written
+    virtual bool begin() = 0;
+    virtual bool write(uint32_t offset, const uint8_t* data, size_t len) = 0;
+    // Validates the written image and selects it for the next boot
+    virtual bool finish() = 0;
+    virtual void abort() = 0;
+};
+
+#endif // PARTITION_WRITER_H
@@ -0,0 +1,31 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Incremental SHA-256 (FIPS 180-4). Self-contained so image verification
+// runs the same on the device and on the host.
+class Sha256 {
+public:
+    static const size_t DIGEST_SIZE = 32;
+
+    Sha256() { begin(); }
+
+    void begin();
+    void update(const uint8_t* data, size_t len);
+    void finish(uint8_t digest[DIGEST_SIZE]);
+
+    // Parses 64 hex digits; false on anything else
+    static bool parseHex(const char* hex, uint8_t digest[DIGEST_SIZE]);
+
+private:
+    void compress(const uint8_t block[64]);
+
+    uint32_t state[8];
+    uint64_t totalBytes;
+    uint8_t block[64];
+    uint8_t blockFill;
+};
+
+#endif // SHA256_H
@@ -0,0 +1,88 @@
+#include "SolarSchedule.h"
+#include <math.h>
+
+static const double DEG_TO_RAD_D = M_PI / 180.0;
+static const double ZENITH_DEG = 90.833;  // Sun centre below horizon incl. refraction
+
+SolarSchedule::SolarSchedule(float latitudeDeg, float longitudeDeg, uint16_t twilightMin)
+    : latitude(latitudeDeg), longitude(longitudeDeg),
+      twilightS(twilightMin > 0 ? (int32_t)twilightMin * 60 : 1),
+      computedYday(-1), computedYear(0), sunrise(0), sunset(0), polar(0) {
+}
+
+int64_t SolarSchedule::daysFromCivil(int year, int month, int mday) {
+    // Days since 1970-01-01 for a proleptic Gregorian date (month 1..12)
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + mday - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void SolarSchedule::update(const struct tm& local) {
+    if (local.tm_yday == computedYday && local.tm_year == computedYear) {
+        return;
+    }
+    compute(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_yday);
+    computedYday = (int16_t)local.tm_yday;
+    computedYear = (int16_t)local.tm_year;
+}
+
+void SolarSchedule::compute(int year, int month, int mday, int yday) {
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    double gamma = 2.0 * M_PI / (leap ? 366.0 : 365.0) * yday;
+
+    double eqTimeMin = 229.18 * (0.000075 + 0.001868 * cos(gamma) - 0.032077 * sin(gamma) -
+                                 0.014615 * cos(2 * gamma) - 0.040849 * sin(2 * gamma));
+    double decl = 0.006918 - 0.399912 * cos(gamma) + 0.070257 * sin(gamma) -
+                  0.006758 * cos(2 * gamma) + 0.000907 * sin(2 * gamma) -
+                  0.002697 * cos(3 * gamma) + 0.00148 * sin(3 * gamma);
+
+    double lat = latitude * DEG_TO_RAD_D;
+    double cosHa = cos(ZENITH_DEG * DEG_TO_RAD_D) / (cos(lat) * cos(decl)) - tan(lat) * tan(decl);
+
+    time_t midnightUtc = (time_t)(daysFromCivil(year, month, mday) * 86400);
+    double noonMin = 720.0 - 4.0 * longitude - eqTimeMin;
+
+    if (cosHa > 1.0) {
+        polar = -1;
+        sunrise = sunset = midnightUtc + (time_t)(noonMin * 60.0);
+        return;
+    }
+    if (cosHa < -1.0) {
+        polar = 1;
+        sunrise = sunset = midnightUtc + (time_t)(noonMin * 60.0);
+        return;
+    }
+    polar = 0;
+
+    double haMin = 4.0 * acos(cosHa) / DEG_TO_RAD_D;
+    sunrise = midnightUtc + (time_t)((noonMin - haMin) * 60.0);
+    sunset = midnightUtc + (time_t)((noonMin + haMin) * 60.0);
+}
+
+static float smoothstep(float x) {
+    if (x <= 0.0f) {
+        return 0.0f;
+    }
+    if (x >= 1.0f) {
+        return 1.0f;
+    }
+    return x * x * (3.0f - 2.0f * x);
+}
+
+float SolarSchedule::dayFactor(time_t now) const {
+    if (!valid()) {
+        return 1.0f;
+    }
+    if (polar != 0) {
+        return polar > 0 ? 1.0f : 0.0f;
+    }
+
+    // Ramp up across [sunrise - w/2, sunrise + w/2], down across sunset
+    float half = twilightS / 2.0f;
+    float rise = smoothstep(((float)(now - sunrise) + half) / (float)twilightS);
+    float set = smoothstep(((float)(sunset - now) + half) / (float)twilightS);
+    return rise < set ? rise : set;
+}
@@ -0,0 +1,43 @@
+#ifndef SOLAR_SCHEDULE_H
+#define SOLAR_SCHEDULE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Sunrise/sunset for a fixed location (NOAA approximation: within 2 minutes
+// at mid latitudes, a few more towards the poles), and a smooth 0..1 day
+// factor through twilight. Sun times are recomputed only when the local
+// calendar day changes; dayFactor() is a few compares per call.
+class SolarSchedule {
+public:
+    SolarSchedule(float latitudeDeg, float longitudeDeg, uint16_t twilightMin);
+
+    // Call with the current local time; recomputes only on a new day
+    void update(const struct tm& local);
+
+    // 0 = night, 1 = day, smoothstep across twilight around sunrise/sunset
+    float dayFactor(time_t now) const;
+
+    // Forces a recompute on the next update() (e.g. after a timezone change)
+    void invalidate() { computedYday = -1; }
+    bool valid() const { return computedYday >= 0; }
+    time_t getSunrise() const { return sunrise; }
+    time_t getSunset() const { return sunset; }
+
+private:
+    void compute(int year, int month, int mday, int yday);
+
+    static int64_t daysFromCivil(int year, int month, int mday);
+
+    float latitude;
+    float longitude;
+    int32_t twilightS;
+
+    int16_t computedYday;  // -1 until the first update()
+    int16_t computedYear;
+    time_t sunrise;
+    time_t sunset;
+    int8_t polar;          // 0 normal, 1 sun never sets, -1 sun never rises
+};
+
+#endif // SOLAR_SCHEDULE_H
@@ -0,0 +1,437 @@
+#include "StatusServer.h"
+#include "AccessToken.h"
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Room kept in front of the body for the status line and headers
+static const size_t HEADER_RESERVE = 160;
+
+static const char* reasonPhrase(uint16_t code) {
+    switch (code) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 422: return "Unprocessable Entity";
+        case 431: return "Request Header Fields Too Large";
+        default:  return "Internal Server Error";
+    }
+}
+
+StatusServer::StatusServer()
+    : listenFd(-1), statusWriter(nullptr), commandHandler(nullptr), metricsWriter(nullptr),
+      uploadHandler(nullptr), configWriter(nullptr), configHandler(nullptr), writeToken(""),
+      requestsServed(0), requestsRejected(0) {
+    for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+        clients[i].uploading = false;
+    }
+}
+
+int64_t StatusServer::monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+bool StatusServer::begin(uint16_t port) {
+    end();
+
+    listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenFd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listenFd, HTTP_MAX_CLIENTS) != 0) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+void StatusServer::end() {
+    for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        closeClient(clients[i]);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+}
+
+void StatusServer::poll(uint32_t nowMs, uint32_t budgetUs) {
+    if (listenFd < 0) {
+        return;
+    }
+    int64_t deadline = monotonicUs() + budgetUs;
+
+    acceptClient(nowMs);
+
+    // At most one recv or send per client per pass, so a slow or hostile
+    // peer can never hold the loop for longer than one syscall (uploads
+    // excepted: they read until the socket or the budget runs dry)
+    for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            continue;
+        }
+        if (monotonicUs() >= deadline) {
+            break;
+        }
+        serviceClient(clients[i], nowMs, deadline);
+    }
+}
+
+void StatusServer::acceptClient(uint32_t nowMs) {
+    Client* slot = nullptr;
+    for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            slot = &clients[i];
+            break;
+        }
+    }
+    if (!slot) {
+        // Full: leave the connection in the listen backlog
+        return;
+    }
+
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    slot->fd = fd;
+    slot->openedMs = nowMs;
+    slot->parser.reset();
+    slot->responseLength = 0;
+    slot->responseSent = 0;
+    slot->streaming = false;
+    slot->cursor = 0;
+    slot->uploading = false;
+    slot->bodyRemaining = 0;
+}
+
+void StatusServer::serviceClient(Client& client, uint32_t nowMs, int64_t deadlineUs) {
+    if (nowMs - client.openedMs >= HTTP_CLIENT_TIMEOUT_MS) {
+        closeClient(client);
+        return;
+    }
+
+    if (client.uploading) {
+        receiveUpload(client, nowMs, deadlineUs);
+        if (client.uploading || client.fd < 0) {
+            return;
+        }
+    } else if (client.responseLength == 0) {
+        char chunk[HTTP_RECV_CHUNK];
+        ssize_t n = recv(client.fd, chunk, sizeof(chunk), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeClient(client);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+
+        switch (client.parser.feed(chunk, (size_t)n)) {
+            case HttpRequestParser::NEED_MORE:
+                return;
+            case HttpRequestParser::COMPLETE:
+                handleRequest(client);
+                if (client.uploading) {
+                    return;
+                }
+                break;
+            case HttpRequestParser::TOO_LARGE:
+                respond(client, 431, 0);
+                break;
+            case HttpRequestParser::BAD_REQUEST:
+                respond(client, 400, 0);
+                break;
+        }
+    }
+
+    ssize_t sent = send(client.fd, client.response + client.responseSent,
+                        client.responseLength - client.responseSent, MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            closeClient(client);
+        }
+        return;
+    }
+    client.responseSent += (uint16_t)sent;
+    if (client.responseSent < client.responseLength) {
+        return;
+    }
+
+    // Streamed bodies are refilled here and go out on the next pass;
+    // without a Content-Length the body ends when the connection closes
+    size_t more = client.streaming ? metricsWriter(client.response, sizeof(client.response), client.cursor) : 0;
+    if (more == 0) {
+        closeClient(client);
+        return;
+    }
+    client.openedMs = nowMs;  // Still making progress
+    client.responseLength = (uint16_t)more;
+    client.responseSent = 0;
+}
+
+void StatusServer::handleRequest(Client& client) {
+    const HttpRequestParser& req = client.parser;
+    char* body = client.response + HEADER_RESERVE;
+    const size_t cap = sizeof(client.response) - HEADER_RESERVE;
+
+    if (strcmp(req.path(), "/status") == 0 || strcmp(req.path(), "/") == 0) {
+        if (strcmp(req.method(), "GET") != 0) {
+            respond(client, 405, 0);
+            return;
+        }
+        respond(client, 200, statusWriter ? statusWriter(body, cap) : 0);
+        return;
+    }
+
+    if (strcmp(req.path(), "/metrics") == 0) {
+        if (strcmp(req.method(), "GET") != 0 || !metricsWriter) {
+            respond(client, metricsWriter ? 405 : 404, 0);
+            return;
+        }
+        startStream(client);
+        return;
+    }
+
+    if (strcmp(req.path(), "/update") == 0) {
+        if (strcmp(req.method(), "POST") != 0 || !uploadHandler) {
+            respond(client, uploadHandler ? 405 : 404, 0);
+            return;
+        }
+        if (req.contentLength() == 0) {
+            respondError(client, 400, "empty body");
+            return;
+        }
+        if (!uploadHandler->start(req)) {
+            respondError(client, uploadHandler->rejectStatus(), uploadHandler->error());
+            return;
+        }
+        startUpload(client);
+        return;
+    }
+
+    if (strcmp(req.path(), "/control") == 0) {
+        // Side effects only on POST so crawlers and prefetch can't toggle things
+        if (strcmp(req.method(), "POST") != 0) {
+            respond(client, 405, 0);
+            return;
+        }
+        if (authorized(client) && applyParams(client, commandHandler)) {
+            respond(client, 200, statusWriter ? statusWriter(body, cap) : 0);
+        }
+        return;
+    }
+
+    if (strcmp(req.path(), "/config") == 0) {
+        if (!configWriter) {
+            respond(client, 404, 0);
+            return;
+        }
+        if (strcmp(req.method(), "POST") == 0) {
+            if (!authorized(client) || !applyParams(client, configHandler)) {
+                return;
+            }
+        } else if (strcmp(req.method(), "GET") != 0) {
+            respond(client, 405, 0);
+            return;
+        }
+        respond(client, 200, configWriter(body, cap));
+        return;
+    }
+
+    respond(client, 404, 0);
+}
+
+bool StatusServer::authorized(Client& client) {
+    const char* token = "";
+    client.parser.queryParam("token", token);
+    if (!accessTokenMatches(token, writeToken)) {
+        respondError(client, 403, *writeToken ? "bad token" : "no HTTP_TOKEN set");
+        return false;
+    }
+    return true;
+}
+
+bool StatusServer::applyParams(Client& client, CommandHandler handler) {
+    // Stops at the first rejected parameter; earlier ones stay applied
+    const char* name;
+    const char* value;
+    for (uint8_t i = 0; client.parser.queryParamAt(i, name, value); i++) {
+        if (strcmp(name, "token") == 0) {
+            continue;
+        }
+        if (!handler || !handler(name, value)) {
+            char message[48];
+            snprintf(message, sizeof(message), "bad parameter '%s'", name);
+            respondError(client, 400, message);
+            return false;
+        }
+    }
+    return true;
+}
+
+void StatusServer::startUpload(Client& client) {
+    client.uploading = true;
+    client.bodyRemaining = client.parser.contentLength();
+
+    // Body bytes that arrived together with the head
+    const uint8_t* early = (const uint8_t*)client.parser.bodyStart();
+    size_t earlyBytes = client.parser.bodyBytes();
+    if (earlyBytes > client.bodyRemaining) {
+        earlyBytes = client.bodyRemaining;
+    }
+    while (earlyBytes > 0) {
+        size_t room;
+        uint8_t* dst = uploadHandler->reserve(room);
+        size_t take = earlyBytes < room ? earlyBytes : room;
+        memcpy(dst, early, take);
+        client.bodyRemaining -= (uint32_t)take;
+        if (take == 0 || !uploadHandler->commit(take)) {
+            client.uploading = false;
+            respondError(client, 500, uploadHandler->error());
+            return;
+        }
+        early += take;
+        earlyBytes -= take;
+    }
+    if (client.bodyRemaining == 0) {
+        endUpload(client);
+    }
+}
+
+void StatusServer::receiveUpload(Client& client, uint32_t nowMs, int64_t deadlineUs) {
+    // Unlike other requests, keep reading until the socket is drained or
+    // the budget is spent; each recv lands directly in the handler's buffer.
+    // A commit that flushes to flash may overrun the budget by one write.
+    while (client.bodyRemaining > 0) {
+        size_t room;
+        uint8_t* dst = uploadHandler->reserve(room);
+        if (room > client.bodyRemaining) {
+            room = client.bodyRemaining;
+        }
+        ssize_t n = recv(client.fd, dst, room, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeClient(client);  // Aborts the upload
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+        client.openedMs = nowMs;  // Timeout counts from the last progress
+        client.bodyRemaining -= (uint32_t)n;
+        if (!uploadHandler->commit((size_t)n)) {
+            client.uploading = false;
+            respondError(client, 500, uploadHandler->error());
+            return;
+        }
+        if (monotonicUs() >= deadlineUs) {
+            return;
+        }
+    }
+    endUpload(client);
+}
+
+void StatusServer::endUpload(Client& client) {
+    client.uploading = false;
+    if (uploadHandler->finish()) {
+        char* body = client.response + HEADER_RESERVE;
+        int n = snprintf(body, sizeof(client.response) - HEADER_RESERVE, "{\"ok\":true}");
+        respond(client, 200, n > 0 ? (size_t)n : 0);
+    } else {
+        respondError(client, 422, uploadHandler->error());
+    }
+}
+
+void StatusServer::respondError(Client& client, uint16_t code, const char* message) {
+    char* body = client.response + HEADER_RESERVE;
+    int n = snprintf(body, sizeof(client.response) - HEADER_RESERVE, "{\"error\":\"%s\"}", message);
+    respond(client, code, n > 0 ? (size_t)n : 0);
+}
+
+void StatusServer::startStream(Client& client) {
+    requestsServed++;
+    int headerLength = snprintf(client.response, HEADER_RESERVE,
+                                "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: text/plain; version=0.0.4\r\n"
+                                "Cache-Control: no-store\r\n"
+                                "Connection: close\r\n\r\n");
+    client.cursor = 0;
+    size_t body = metricsWriter(client.response + headerLength,
+                                sizeof(client.response) - headerLength, client.cursor);
+    client.responseLength = (uint16_t)(headerLength + body);
+    client.responseSent = 0;
+    client.streaming = body > 0;
+}
+
+void StatusServer::respond(Client& client, uint16_t code, size_t bodyLength,
+                           const char* contentType) {
+    if (code == 200) {
+        requestsServed++;
+    } else {
+        requestsRejected++;
+    }
+
+    // snprintf-style writers report the untruncated length
+    const size_t maxBody = sizeof(client.response) - HEADER_RESERVE - 1;
+    if (bodyLength > maxBody) {
+        bodyLength = maxBody;
+    }
+
+    // The body (if any) is already at HEADER_RESERVE; slide it up behind
+    // the headers so the whole response goes out in one contiguous buffer
+    char header[HEADER_RESERVE];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 %u %s\r\n"
+                                "Content-Type: %s\r\n"
+                                "Content-Length: %u\r\n"
+                                "Cache-Control: no-store\r\n"
+                                "Connection: close\r\n\r\n",
+                                code, reasonPhrase(code), contentType, (unsigned)bodyLength);
+    if (headerLength < 0 || (size_t)headerLength >= sizeof(header)) {
+        headerLength = 0;
+    }
+
+    memmove(client.response + headerLength, client.response + HEADER_RESERVE, bodyLength);
+    memcpy(client.response, header, (size_t)headerLength);
+    client.responseLength = (uint16_t)(headerLength + bodyLength);
+    client.responseSent = 0;
+}
+
+void StatusServer::closeClient(Client& client) {
+    if (client.uploading) {
+        uploadHandler->abort();
+        client.uploading = false;
+    }
+    if (client.fd >= 0) {
+        close(client.fd);
+        client.fd = -1;
+    }
+}
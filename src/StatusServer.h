@@ -0,0 +1,104 @@
+#ifndef STATUS_SERVER_H
+#define STATUS_SERVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "HttpRequestParser.h"
+#include "UploadHandler.h"
+
+// Minimal HTTP/1.1 server for status and control. One non-blocking listening
+// socket and HTTP_MAX_CLIENTS fixed connection slots; poll() does a bounded
+// amount of accept/recv/send work and returns once its time budget is spent,
+// so it can run from the render loop. No heap use. Uses only POSIX sockets
+// and clock_gettime(), so it builds unchanged on Linux.
+//
+//   GET  /status               JSON from the status writer
+//   POST /control?name=value   each pair goes to the command handler,
+//                              replies with the updated status
+//   GET  /metrics              Prometheus text, streamed through the
+//                              response buffer as many times as needed
+//   GET  /config               runtime settings as JSON
+//   POST /config?name=value    changes them, replies with the new set
+//
+// The two POSTs that change settings need &token= matching the write
+// token, and are refused with 403 while none is set.
+//   POST /update               body handed to the upload handler as it
+//                              arrives; replies once the handler finishes
+class StatusServer {
+public:
+    // Writes the JSON status body into buf, returns its length
+    typedef size_t (*StatusWriter)(char* buf, size_t cap);
+    // Applies one control parameter; false rejects the request with 400
+    typedef bool (*CommandHandler)(const char* name, const char* value);
+    // Fills buf with the next part of a streamed body, resuming from cursor
+    // (0 on the first call); returns 0 when the body is complete
+    typedef size_t (*StreamWriter)(char* buf, size_t cap, uint32_t& cursor);
+
+    StatusServer();
+
+    bool begin(uint16_t port);
+    void end();
+    bool listening() const { return listenFd >= 0; }
+
+    // Non-blocking; returns after at most roughly budgetUs
+    void poll(uint32_t nowMs, uint32_t budgetUs);
+
+    void setStatusWriter(StatusWriter writer) { statusWriter = writer; }
+    void setCommandHandler(CommandHandler handler) { commandHandler = handler; }
+    void setMetricsWriter(StreamWriter writer) { metricsWriter = writer; }
+    void setUploadHandler(UploadHandler* handler) { uploadHandler = handler; }
+    void setConfigHandlers(StatusWriter writer, CommandHandler handler) {
+        configWriter = writer;
+        configHandler = handler;
+    }
+    // Kept by pointer; an empty token closes POST /control and /config
+    void setWriteToken(const char* token) { writeToken = token; }
+
+    uint32_t getRequestsServed() const { return requestsServed; }
+    uint32_t getRequestsRejected() const { return requestsRejected; }
+
+private:
+    struct Client {
+        int fd;                      // -1 when the slot is free
+        uint32_t openedMs;
+        HttpRequestParser parser;
+        char response[HTTP_RESPONSE_SIZE];
+        uint16_t responseLength;     // 0 while still reading the request
+        uint16_t responseSent;
+        bool streaming;              // Refill from metricsWriter when drained
+        uint32_t cursor;
+        bool uploading;              // Body is going to uploadHandler
+        uint32_t bodyRemaining;
+    };
+
+    void acceptClient(uint32_t nowMs);
+    void serviceClient(Client& client, uint32_t nowMs, int64_t deadlineUs);
+    void handleRequest(Client& client);
+    bool authorized(Client& client);
+    bool applyParams(Client& client, CommandHandler handler);
+    void startUpload(Client& client);
+    void receiveUpload(Client& client, uint32_t nowMs, int64_t deadlineUs);
+    void endUpload(Client& client);
+    void respondError(Client& client, uint16_t code, const char* message);
+    void respond(Client& client, uint16_t code, size_t bodyLength,
+                 const char* contentType = "application/json");
+    void startStream(Client& client);
+    void closeClient(Client& client);
+
+    static int64_t monotonicUs();
+
+    int listenFd;
+    Client clients[HTTP_MAX_CLIENTS];
+    StatusWriter statusWriter;
+    CommandHandler commandHandler;
+    StreamWriter metricsWriter;
+    UploadHandler* uploadHandler;
+    StatusWriter configWriter;
+    CommandHandler configHandler;
+    const char* writeToken;
+    uint32_t requestsServed;
+    uint32_t requestsRejected;
+};
+
+#endif // STATUS_SERVER_H
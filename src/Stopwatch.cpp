@@ -0,0 +1,71 @@
+#include "Stopwatch.h"
+
+Stopwatch::Stopwatch()
+    : mode(MODE_STOPWATCH), running(false), startUs(0), accumulatedUs(0), lastLapUs(0),
+      presetMs(0), laps(0) {
+}
+
+void Stopwatch::reset(Mode newMode, uint32_t newPresetMs) {
+    mode = newMode;
+    presetMs = newPresetMs;
+    running = false;
+    accumulatedUs = 0;
+    lastLapUs = 0;
+    laps = 0;
+}
+
+void Stopwatch::start(int64_t atUs) {
+    if (running || (mode == MODE_COUNTDOWN && accumulatedUs >= (int64_t)presetMs * 1000)) {
+        return;
+    }
+    startUs = atUs;
+    running = true;
+}
+
+void Stopwatch::stop(int64_t atUs) {
+    if (!running) {
+        return;
+    }
+    accumulatedUs = elapsedUs(atUs);
+    running = false;
+}
+
+int64_t Stopwatch::elapsedUs(int64_t nowUs) const {
+    int64_t us = accumulatedUs;
+    if (running && nowUs > startUs) {
+        us += nowUs - startUs;
+    }
+    if (mode == MODE_COUNTDOWN && us > (int64_t)presetMs * 1000) {
+        us = (int64_t)presetMs * 1000;
+    }
+    return us;
+}
+
+uint32_t Stopwatch::lap(int64_t atUs) {
+    int64_t now = elapsedUs(atUs);
+    uint32_t ms = (uint32_t)((now - lastLapUs) / 1000);
+    lastLapUs = now;
+    laps++;
+    return ms;
+}
+
+uint32_t Stopwatch::elapsedMs(int64_t nowUs) const {
+    return (uint32_t)(elapsedUs(nowUs) / 1000);
+}
+
+uint32_t Stopwatch::shownMs(int64_t nowUs) const {
+    if (mode == MODE_STOPWATCH) {
+        return elapsedMs(nowUs);
+    }
+    int64_t left = (int64_t)presetMs * 1000 - elapsedUs(nowUs);
+    return (uint32_t)((left + 999) / 1000);
+}
+
+bool Stopwatch::expire(int64_t nowUs) {
+    if (mode != MODE_COUNTDOWN || !running || elapsedUs(nowUs) < (int64_t)presetMs * 1000) {
+        return false;
+    }
+    accumulatedUs = (int64_t)presetMs * 1000;
+    running = false;
+    return true;
+}
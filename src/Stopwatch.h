@@ -0,0 +1,55 @@
+#ifndef STOPWATCH_H
+#define STOPWATCH_H
+
+#include <stdint.h>
+
+// Stopwatch and countdown on the monotonic clock (esp_timer_get_time()),
+// never the wall clock, so NTP steps and slews don't touch a running
+// timer. Every call takes the instant it acts at: button actions pass the
+// press edge, so gesture recognition delays don't count.
+class Stopwatch {
+public:
+    enum Mode : uint8_t {
+        MODE_STOPWATCH = 0,
+        MODE_COUNTDOWN
+    };
+
+    Stopwatch();
+
+    // Stopped and cleared; a countdown starts from presetMs
+    void reset(Mode mode, uint32_t presetMs);
+    void reset() { reset(mode, presetMs); }
+
+    void start(int64_t atUs);
+    void stop(int64_t atUs);
+    bool isRunning() const { return running; }
+
+    // Time since the previous lap (or the start); counts it
+    uint32_t lap(int64_t atUs);
+
+    uint32_t elapsedMs(int64_t nowUs) const;
+    // What the face shows: elapsed, or for a countdown what is left,
+    // rounded up so it reads zero only once the time is up
+    uint32_t shownMs(int64_t nowUs) const;
+
+    // True once when a running countdown has reached zero by nowUs; it
+    // then stops at exactly the preset
+    bool expire(int64_t nowUs);
+
+    Mode getMode() const { return mode; }
+    uint32_t getPresetMs() const { return presetMs; }
+    uint16_t getLapCount() const { return laps; }
+
+private:
+    int64_t elapsedUs(int64_t nowUs) const;
+
+    Mode mode;
+    bool running;
+    int64_t startUs;        // Of the current run
+    int64_t accumulatedUs;  // From earlier runs
+    int64_t lastLapUs;      // Elapsed time at the last lap
+    uint32_t presetMs;
+    uint16_t laps;
+};
+
+#endif // STOPWATCH_H
@@ -0,0 +1,82 @@
+#include "SyncStats.h"
+
+SyncStats::SyncStats()
+    : head(0), count(0), consecutiveFailures(0),
+      lastSuccessMs(0), successCount(0), failureCount(0) {
+    memset(samples, 0, sizeof(samples));
+}
+
+void SyncStats::recordSuccess(int64_t offsetUs, int64_t delayUs, uint32_t nowMs) {
+    Sample& s = samples[head];
+    s.offsetUs = offsetUs;
+    s.delayUs = (uint32_t)constrain(delayUs, (int64_t)0, (int64_t)UINT32_MAX);
+    s.atMs = nowMs;
+
+    head = (uint8_t)((head + 1) % SYNC_STATS_HISTORY);
+    if (count < SYNC_STATS_HISTORY) {
+        count++;
+    }
+
+    lastSuccessMs = nowMs;
+    successCount++;
+    consecutiveFailures = 0;
+}
+
+void SyncStats::recordFailure() {
+    failureCount++;
+    if (consecutiveFailures < UINT16_MAX) {
+        consecutiveFailures++;
+    }
+}
+
+const SyncStats::Sample& SyncStats::newest() const {
+    return samples[(head + SYNC_STATS_HISTORY - 1) % SYNC_STATS_HISTORY];
+}
+
+int64_t SyncStats::lastOffsetUs() const {
+    return count ? newest().offsetUs : 0;
+}
+
+uint32_t SyncStats::lastDelayUs() const {
+    return count ? newest().delayUs : 0;
+}
+
+uint32_t SyncStats::jitterUs() const {
+    // RMS of the differences between consecutive offsets. Offsets that got
+    // stepped away (the first sync after boot, the end of a long outage)
+    // are left out; next to a slewed one they would swamp it for a day.
+    uint8_t oldest = (uint8_t)((head + SYNC_STATS_HISTORY - count) % SYNC_STATS_HISTORY);
+    double sum = 0;
+    uint8_t pairs = 0;
+    for (uint8_t i = 1; i < count; i++) {
+        const Sample& prev = samples[(oldest + i - 1) % SYNC_STATS_HISTORY];
+        const Sample& cur = samples[(oldest + i) % SYNC_STATS_HISTORY];
+        if (stepped(prev) || stepped(cur)) {
+            continue;
+        }
+        double diff = (double)cur.offsetUs - (double)prev.offsetUs;
+        sum += diff * diff;
+        pairs++;
+    }
+    return pairs ? (uint32_t)sqrt(sum / pairs) : 0;
+}
+
+SyncStats::Health SyncStats::health(uint32_t nowMs) const {
+    if (!hasSynced()) {
+        return HEALTH_NEVER;
+    }
+    return syncAgeMs(nowMs) > SYNC_STALE_AFTER_MS ? HEALTH_STALE : HEALTH_OK;
+}
+
+void SyncStats::printReport(Print& out, uint32_t nowMs) const {
+    if (!hasSynced()) {
+        out.printf("Sync: never synced, %lu failures\n", (unsigned long)failureCount);
+        return;
+    }
+    out.printf("Sync: offset %lld us%s, delay %lu us, jitter %lu us, age %lu s, "
+               "ok %lu, failed %lu (%u in a row)\n",
+               (long long)lastOffsetUs(), lastStepped() ? " (stepped)" : "",
+               (unsigned long)lastDelayUs(), (unsigned long)jitterUs(),
+               (unsigned long)(syncAgeMs(nowMs) / 1000), (unsigned long)successCount,
+               (unsigned long)failureCount, consecutiveFailures);
+}
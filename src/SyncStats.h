@@ -0,0 +1,61 @@
+#ifndef SYNC_STATS_H
+#define SYNC_STATS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Clock sync quality: recent offsets/delays in a fixed ring buffer plus
+// success/failure bookkeeping. No heap use; the whole object is
+// SYNC_STATS_HISTORY * 16 bytes + 16 bytes (272 bytes at the default 16).
+class SyncStats {
+public:
+    enum Health : uint8_t {
+        HEALTH_NEVER = 0,  // No successful sync since boot
+        HEALTH_OK,         // Synced within SYNC_STALE_AFTER_MS
+        HEALTH_STALE       // Last success is too old
+    };
+
+    SyncStats();
+
+    void recordSuccess(int64_t offsetUs, int64_t delayUs, uint32_t nowMs);
+    void recordFailure();
+
+    bool hasSynced() const { return successCount > 0; }
+    uint32_t syncAgeMs(uint32_t nowMs) const { return nowMs - lastSuccessMs; }
+    int64_t lastOffsetUs() const;
+    // The last offset was too large to slew, so the clock was stepped. The
+    // first sync after boot steps by decades, beyond any 32-bit microsecond
+    // value, so callers with 32-bit outputs report such a sample apart.
+    bool lastStepped() const { return count && stepped(newest()); }
+    uint32_t lastDelayUs() const;
+    uint32_t jitterUs() const;
+    uint32_t getSuccessCount() const { return successCount; }
+    uint32_t getFailureCount() const { return failureCount; }
+    uint16_t getConsecutiveFailures() const { return consecutiveFailures; }
+    Health health(uint32_t nowMs) const;
+
+    void printReport(Print& out, uint32_t nowMs) const;
+
+private:
+    struct Sample {
+        int64_t offsetUs;   // As measured, never clamped
+        uint32_t delayUs;
+        uint32_t atMs;
+    };
+
+    static bool stepped(const Sample& s) {
+        return s.offsetUs >= NTP_STEP_THRESHOLD_US || s.offsetUs <= -NTP_STEP_THRESHOLD_US;
+    }
+
+    const Sample& newest() const;
+
+    Sample samples[SYNC_STATS_HISTORY];
+    uint8_t head;       // Next slot to write
+    uint8_t count;
+    uint16_t consecutiveFailures;
+    uint32_t lastSuccessMs;
+    uint32_t successCount;
+    uint32_t failureCount;
+};
+
+#endif // SYNC_STATS_H
@@ -0,0 +1,22 @@
+#include "TimeKeeper.h"
+
+// Anything before 2020-01-01 means the clock was never set
+static const time_t MIN_VALID_EPOCH = 1577836800;
+
+TimeKeeper::Source TimeKeeper::read(struct tm& out, uint32_t nowMs, time_t* epoch) {
+    time_t now = time(nullptr);
+    if (now >= MIN_VALID_EPOCH) {
+        localtime_r(&now, &out);
+        if (epoch) {
+            *epoch = now;
+        }
+        return SOURCE_WALL;
+    }
+
+    time_t uptime = (time_t)(nowMs / 1000);
+    gmtime_r(&uptime, &out);
+    if (epoch) {
+        *epoch = uptime;
+    }
+    return SOURCE_UPTIME;
+}
@@ -0,0 +1,24 @@
+#ifndef TIME_KEEPER_H
+#define TIME_KEEPER_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Non-blocking local time source for the face. Uses the system clock once it
+// holds a plausible wall time, otherwise counts up from boot on the
+// monotonic millisecond clock. Once set, the system clock keeps running
+// through WiFi and NTP outages (only drifting), so the face stays on wall
+// time until the next reboot.
+class TimeKeeper {
+public:
+    enum Source : uint8_t {
+        SOURCE_WALL = 0,    // System clock is valid
+        SOURCE_UPTIME       // Never had a wall time: time since boot
+    };
+
+    // Never blocks. Returns where the time came from; epoch, if given, gets
+    // the same instant as Unix time.
+    Source read(struct tm& out, uint32_t nowMs, time_t* epoch = nullptr);
+};
+
+#endif // TIME_KEEPER_H
@@ -0,0 +1,29 @@
+#ifndef UPLOAD_HANDLER_H
+#define UPLOAD_HANDLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "HttpRequestParser.h"
+
+// Receives a request body from StatusServer as it arrives. The server
+// recv()s directly into the space reserve() hands out, so a handler with
+// its own block buffer gets the bytes without an extra copy.
+class UploadHandler {
+public:
+    virtual ~UploadHandler() {}
+
+    // Request head is parsed; false rejects the request with error()
+    virtual bool start(const HttpRequestParser& request) = 0;
+    // HTTP status for a request start() rejected
+    virtual uint16_t rejectStatus() const { return 400; }
+    virtual uint8_t* reserve(size_t& room) = 0;
+    // false aborts the upload with error()
+    virtual bool commit(size_t length) = 0;
+    // Whole body received
+    virtual bool finish() = 0;
+    // Connection lost or timed out mid-body
+    virtual void abort() = 0;
+    virtual const char* error() const = 0;
+};
+
+#endif // UPLOAD_HANDLER_H
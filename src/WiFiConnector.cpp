@@ -0,0 +1,160 @@
+#include "WiFiConnector.h"
+#include <Preferences.h>
+#include "Logger.h"
+
+static const uint32_t CACHE_MAGIC = 0x57434331;  // "WCC1"
+static const char* PREFS_NAMESPACE = "wifi";
+
+WiFiConnector::WiFiConnector() {
+    memset(&cache, 0, sizeof(cache));
+    memset(histogram, 0, sizeof(histogram));
+}
+
+uint32_t WiFiConnector::hashSsid(const char* ssid) {
+    // FNV-1a, only used to notice that the configured network changed
+    uint32_t hash = 2166136261u;
+    while (*ssid) {
+        hash ^= (uint8_t)*ssid++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool WiFiConnector::waitForConnection(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delay(WIFI_POLL_INTERVAL_MS);
+    }
+    return true;
+}
+
+bool WiFiConnector::loadCache(uint32_t ssidHash) {
+    Preferences prefs;
+    if (!prefs.begin(PREFS_NAMESPACE, true)) {
+        return false;
+    }
+    size_t len = prefs.getBytes("ap", &cache, sizeof(cache));
+    prefs.end();
+
+    return len == sizeof(cache) && cache.magic == CACHE_MAGIC &&
+           cache.ssidHash == ssidHash && cache.channel != 0;
+}
+
+void WiFiConnector::saveCache(uint32_t ssidHash) {
+    ApCache fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    fresh.magic = CACHE_MAGIC;
+    fresh.ssidHash = ssidHash;
+    memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+    fresh.channel = (uint8_t)WiFi.channel();
+    fresh.ip = (uint32_t)WiFi.localIP();
+    fresh.gateway = (uint32_t)WiFi.gatewayIP();
+    fresh.subnet = (uint32_t)WiFi.subnetMask();
+    fresh.dns = (uint32_t)WiFi.dnsIP(0);
+
+    // Only touch flash when something actually changed
+    if (memcmp(&fresh, &cache, sizeof(fresh)) == 0) {
+        return;
+    }
+    cache = fresh;
+
+    Preferences prefs;
+    if (prefs.begin(PREFS_NAMESPACE, false)) {
+        prefs.putBytes("ap", &cache, sizeof(cache));
+        prefs.end();
+    }
+}
+
+void WiFiConnector::loadHistograms() {
+    Preferences prefs;
+    if (!prefs.begin(PREFS_NAMESPACE, true)) {
+        return;
+    }
+    if (prefs.getBytes("hist", histogram, sizeof(histogram)) != sizeof(histogram)) {
+        memset(histogram, 0, sizeof(histogram));
+    }
+    prefs.end();
+}
+
+void WiFiConnector::recordAssociation(Path path, uint32_t elapsedMs) {
+    uint8_t bucket = 0;
+    while (bucket < WIFI_HIST_BUCKETS - 1 && elapsedMs >= WIFI_HIST_BOUNDS_MS[bucket]) {
+        bucket++;
+    }
+    if (histogram[path][bucket] < UINT16_MAX) {
+        histogram[path][bucket]++;
+    }
+
+    Preferences prefs;
+    if (prefs.begin(PREFS_NAMESPACE, false)) {
+        prefs.putBytes("hist", histogram, sizeof(histogram));
+        prefs.end();
+    }
+
+    LOG_EVENT(WIFI_ASSOCIATED, path == PATH_FAST ? "fast" : "full", elapsedMs);
+}
+
+bool WiFiConnector::connect(const char* ssid, const char* pass) {
+    const uint32_t ssidHash = hashSsid(ssid);
+
+    WiFi.mode(WIFI_STA);
+    WiFi.persistent(false);  // We keep our own cache, avoid SDK flash writes
+    loadHistograms();
+
+    // Fast path: directed association on the cached BSSID and channel
+    if (loadCache(ssidHash)) {
+        LOG_EVENT(WIFI_FAST, cache.channel, cache.bssid[0], cache.bssid[1], cache.bssid[2],
+                  cache.bssid[3], cache.bssid[4], cache.bssid[5]);
+#if WIFI_FAST_STATIC_IP
+        if (cache.ip != 0) {
+            WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway),
+                        IPAddress(cache.subnet), IPAddress(cache.dns));
+        }
+#endif
+        uint32_t start = millis();
+        WiFi.begin(ssid, pass, cache.channel, cache.bssid, true);
+        if (waitForConnection(WIFI_FAST_CONNECT_TIMEOUT_MS)) {
+            recordAssociation(PATH_FAST, millis() - start);
+            saveCache(ssidHash);
+            return true;
+        }
+
+        LOG_EVENT(WIFI_FAST_FAILED);
+        WiFi.disconnect();
+#if WIFI_FAST_STATIC_IP
+        // Back to DHCP in case the cached lease is what failed
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+#endif
+    }
+
+    // Slow path: full scan and DHCP
+    LOG_EVENT(WIFI_CONNECTING);
+    uint32_t start = millis();
+    WiFi.begin(ssid, pass);
+    if (!waitForConnection(WIFI_CONNECT_TIMEOUT_MS)) {
+        LOG_EVENT(WIFI_FAILED);
+        return false;
+    }
+    recordAssociation(PATH_FULL, millis() - start);
+    saveCache(ssidHash);
+    return true;
+}
+
+void WiFiConnector::printHistograms(Print& out) const {
+    static const char* const names[PATH_COUNT] = {"fast", "full"};
+
+    for (uint8_t path = 0; path < PATH_COUNT; path++) {
+        out.printf("Assoc %s:", names[path]);
+        for (uint8_t i = 0; i < WIFI_HIST_BUCKETS; i++) {
+            if (i < WIFI_HIST_BUCKETS - 1) {
+                out.printf(" <%u:%u", WIFI_HIST_BOUNDS_MS[i], histogram[path][i]);
+            } else {
+                out.printf(" >=%u:%u", WIFI_HIST_BOUNDS_MS[i - 1], histogram[path][i]);
+            }
+        }
+        out.println();
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef WIFI_CONNECTOR_H
+#define WIFI_CONNECTOR_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "config.h"
+
+class WiFiConnector {
+public:
+    WiFiConnector();
+
+    // Try a directed reconnect from the cached AP, fall back to a full scan
+    bool connect(const char* ssid, const char* pass);
+    void printHistograms(Print& out) const;
+
+private:
+    // Last successful association, persisted in NVS
+    struct ApCache {
+        uint32_t magic;
+        uint32_t ssidHash;
+        uint8_t bssid[6];
+        uint8_t channel;
+        uint8_t reserved;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+    };
+
+    enum Path : uint8_t { PATH_FAST = 0, PATH_FULL = 1, PATH_COUNT = 2 };
+
+    bool waitForConnection(uint32_t timeoutMs);
+    bool loadCache(uint32_t ssidHash);
+    void saveCache(uint32_t ssidHash);
+    void loadHistograms();
+    void recordAssociation(Path path, uint32_t elapsedMs);
+    static uint32_t hashSsid(const char* ssid);
+
+    ApCache cache;
+    uint16_t histogram[PATH_COUNT][WIFI_HIST_BUCKETS];
+};
+
+#endif // WIFI_CONNECTOR_H
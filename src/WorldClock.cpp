@@ -0,0 +1,61 @@
+#include "WorldClock.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const time_t QUARTER_HOUR = 900;
+
+// Days from 1970-01-01 to the date in t (proleptic Gregorian)
+static int64_t daysSinceEpoch(const struct tm& t) {
+    int64_t y = (int64_t)t.tm_year + 1900 - 1;  // Whole years before this one
+    return y * 365 + y / 4 - y / 100 + y / 400 - 719162 + t.tm_yday;
+}
+
+WorldClock::WorldClock()
+    : zones(nullptr), count(0), validFrom(-1), refreshes(0) {
+    memset(offsets, 0, sizeof(offsets));
+}
+
+void WorldClock::begin(const char* const* list, uint8_t n) {
+    zones = list;
+    count = n > MAX_ZONES ? MAX_ZONES : n;
+    validFrom = -1;
+}
+
+void WorldClock::refresh(time_t utc) {
+    // The face's own zone has to come back afterwards
+    char home[64] = "";
+    const char* current = getenv("TZ");
+    if (current) {
+        strncpy(home, current, sizeof(home) - 1);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        setenv("TZ", zones[i], 1);
+        tzset();
+        struct tm local;
+        localtime_r(&utc, &local);
+        int64_t localSeconds = daysSinceEpoch(local) * 86400 + local.tm_hour * 3600 +
+                               local.tm_min * 60 + local.tm_sec;
+        offsets[i] = (int32_t)(localSeconds - utc);
+    }
+
+    if (current) {
+        setenv("TZ", home, 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+    refreshes++;
+}
+
+void WorldClock::convert(time_t utc, struct tm* out) {
+    time_t quarter = utc - (utc % QUARTER_HOUR + QUARTER_HOUR) % QUARTER_HOUR;
+    if (quarter != validFrom) {
+        refresh(quarter);
+        validFrom = quarter;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        time_t local = utc + offsets[i];
+        gmtime_r(&local, &out[i]);
+    }
+}
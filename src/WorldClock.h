@@ -0,0 +1,40 @@
+#ifndef WORLD_CLOCK_H
+#define WORLD_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Local times for several zones from one UTC reading. Switching TZ means
+// a tzset() parse per zone, so each zone's UTC offset is worked out that
+// way once and cached; a tick is then an add and a gmtime_r() per zone.
+//
+// Every zone in the tz database changes its offset on a UTC quarter hour
+// (offsets are whole quarter hours, changes happen on the local hour), so
+// the cache holds until the next quarter hour and is never stale. No
+// display code here, so tools/world_bench.cpp can build it on the host.
+class WorldClock {
+public:
+    static const uint8_t MAX_ZONES = 4;
+
+    WorldClock();
+
+    // zones: POSIX TZ strings, kept by reference
+    void begin(const char* const* zones, uint8_t count);
+
+    // out gets count entries
+    void convert(time_t utc, struct tm* out);
+
+    int32_t offsetSeconds(uint8_t zone) const { return offsets[zone]; }
+    uint32_t getRefreshes() const { return refreshes; }
+
+private:
+    void refresh(time_t utc);
+
+    const char* const* zones;
+    uint8_t count;
+    int32_t offsets[MAX_ZONES];
+    time_t validFrom;       // Quarter hour the offsets were taken for
+    uint32_t refreshes;
+};
+
+#endif // WORLD_CLOCK_H
@@ -10,6 +10,7 @@
 #define OFF_COLOR  0x7BEF  // Light grey
 #define ON_COLOR   TFT_WHITE
 #define TEXT_COLOR TFT_WHITE
+#define DIGIT_COLOR TFT_LIGHTGREY        // Decimal digits under the dots
 
 // ==================== PIN CONFIGURATION ====================
 #define PIN_POWER 15
@@ -20,21 +21,176 @@
 // ==================== BRIGHTNESS CONFIGURATION ====================
 #define PWM_CHANNEL 0
 #define PWM_FREQ 10000
-#define PWM_RESOLUTION 8
-#define BRIGHTNESS_LEVELS 6
+#define PWM_RESOLUTION 12                // 80MHz / 10kHz leaves room for 12 bits
+#define BRIGHTNESS_LEVELS 6              // Any count; duties generated in BacklightCurve.h
+#define BRIGHTNESS_MIN_LIGHTNESS 20.0f   // CIE L* of the lowest level (0..100)
+#define BRIGHTNESS_MAX_LIGHTNESS 100.0f  // CIE L* of the highest level
 #define DEFAULT_BRIGHTNESS_INDEX 0
+#define BACKLIGHT_FADE_MS 300            // Ramp time for a full-scale brightness change
 
-static const uint8_t BRIGHTNESS_VALUES[BRIGHTNESS_LEVELS] = {25, 75, 125, 175, 225, 255};
+// ==================== AUTOMATIC BRIGHTNESS ====================
+// Sunrise/sunset computed locally for this location, once per day
+#define AUTO_BRIGHTNESS_DEFAULT 1        // Start in auto mode (GPIO 0 long press toggles)
+#define SOLAR_LATITUDE 45.50f            // Degrees, north positive
+#define SOLAR_LONGITUDE -73.57f          // Degrees, east positive
+#define SOLAR_TWILIGHT_MIN 60            // Blend window centred on sunrise/sunset
+#define SOLAR_UPDATE_INTERVAL_MS 10000
+#define SOLAR_DAY_LEVEL 0.75f            // Perceptual level, 0..1 of the L* range
+#define SOLAR_NIGHT_LEVEL -0.15f         // Below 0 dims past the lowest manual level
+#define SOLAR_NIGHT_PALETTE 1            // Switch to the night colors after dusk
+#define NIGHT_ON_COLOR  0xF800           // Red
+#define NIGHT_OFF_COLOR 0x2000           // Very dark red
 
 // ==================== BUTTON CONFIGURATION ====================
-#define BUTTON_DEBOUNCE_MS 200
+// All buttons are active low. BOOT and IO14 must stay first; append external
+// buttons here and give each a gesture config below.
+#define BUTTON_PINS PIN_BUTTON_BOOT, PIN_BUTTON_IO14
+#define BUTTON_SAMPLE_US 5000            // Sample period while inputs are bouncing
+                                         // (debounce = 4 samples = 20ms)
+#define BUTTON_EVENT_QUEUE_SIZE 8
+
+// Gestures: {longPressMs, doubleTapMs, repeatMs} per button, 0 disables.
+// A non-zero double-tap window delays the short press by that much.
+#define GESTURE_MAX_BUTTONS 8
+#define GESTURE_CHORD_WINDOW_MS 150      // Max gap between presses of a chord
+#define GESTURE_CONFIG_BOOT {800, 250, 0}
+#define GESTURE_CONFIG_IO14 {600, 0, 300}
+#define BUTTON_GESTURES GESTURE_CONFIG_BOOT, GESTURE_CONFIG_IO14
+
+// ==================== WIFI CONFIGURATION ====================
+#define WIFI_CONNECT_TIMEOUT_MS 15000     // Full scan + DHCP
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000 // Directed reconnect to cached BSSID/channel
+#define WIFI_POLL_INTERVAL_MS 20
+#define WIFI_FAST_STATIC_IP 0             // 1 = reuse the cached DHCP lease as a static IP
+#define WIFI_HIST_BUCKETS 8
+
+// Association time histogram bucket upper bounds (ms), last bucket is open-ended
+static const uint16_t WIFI_HIST_BOUNDS_MS[WIFI_HIST_BUCKETS - 1] = {250, 500, 1000, 2000, 4000, 8000, 15000};
 
 // ==================== TIME CONFIGURATION ====================
 #define TIME_UPDATE_INTERVAL_MS 100
 #define NTP_SERVER1 "pool.ntp.org"
 #define NTP_SERVER2 "time.google.com"
+#define NTP_SERVER3 "time.cloudflare.com"
+#define NTP_MAX_SERVERS 4
+#define NTP_SERVER_COUNT 3
+#define NTP_SAMPLES_PER_SERVER 4         // Keep the minimum-delay sample of these
+#define NTP_SAMPLE_SPACING_MS 250
+#define NTP_REPLY_TIMEOUT_MS 1000
+#define NTP_SYNC_INTERVAL_MS 3600000UL   // Resync every hour
+#define NTP_RETRY_MIN_MS 2000           // First retry after a failed round, doubles each time
+#define NTP_RETRY_MAX_MS 300000UL       // Backoff cap while failing
+#define NTP_STEP_THRESHOLD_US 128000     // Step the clock above this offset, slew below
+#define NTP_POLL_INTERVAL_MS 5           // Loop delay while a sync round is in flight
+
+#define SYNC_STATS_HISTORY 16            // Ring buffer of recent sync samples (12 bytes each)
+#define SYNC_STALE_AFTER_MS (3 * NTP_SYNC_INTERVAL_MS)
+
+static const char* const NTP_SERVERS[NTP_SERVER_COUNT] = {NTP_SERVER1, NTP_SERVER2, NTP_SERVER3};
 #define TIMEZONE "EST5EDT,M3.2.0/2,M11.1.0/2"
 
+// ==================== GPS TIME SOURCE ====================
+// NMEA receiver on Serial1 (RX only), optional PPS line; results go down
+// the same step/slew path as NTP and count in SyncStats
+#ifndef GPS_ENABLED                        // The simulator turns it on (see sim/)
+#define GPS_ENABLED 0
+#endif
+#define GPS_RX_PIN 18
+#define GPS_PPS_PIN 17                   // -1 when the receiver has no PPS output
+#define GPS_BAUD 9600
+#define GPS_UART_BUFFER 512              // Driver RX buffer, a few passes' worth at 9600 baud
+#define GPS_RING_SIZE 256                // Parse ring, power of two, >= 2 sentences
+#define GPS_SYNC_INTERVAL_MS 60000UL     // Result every minute while sentences come in
+#define GPS_NMEA_LAG_MS 100              // No PPS: RMC (sent first by u-blox) is read this long after its second
+#define GPS_PPS_MAX_AGE_MS 900           // Pair a sentence with a PPS edge at most this old
+#define GPS_MAX_POLL_GAP_MS 250          // Sentences read after a longer gap are not timed
+
+// ==================== RUNTIME CONFIGURATION ====================
+// Colors, layout gaps, encoding, fade time, boot brightness, timezone and NTP
+// servers above are defaults only; the live values are in ConfigStore (/config)
+#define CONFIG_SAVE_DELAY_MS 5000        // Write to NVS once edits have been quiet this long...
+#define CONFIG_SAVE_MAX_DELAY_MS 60000UL // ...or this long after the first one at the latest
+#define CONFIG_TZ_LEN 48                 // POSIX TZ string, NUL included
+#define CONFIG_HOST_LEN 40               // NTP "host[:port]", NUL included
+
+// ==================== HTTP STATUS SERVER ====================
+#ifndef HTTP_SERVER_ENABLED                // The simulator builds without it (see sim/)
+#define HTTP_SERVER_ENABLED 1
+#endif
+#define HTTP_PORT 80
+#define HTTP_MAX_CLIENTS 2               // Concurrent connections, extra ones wait in the backlog
+#define HTTP_MAX_REQUEST_HEAD 512        // Request line + headers; larger gets 431
+#define HTTP_MAX_QUERY_PARAMS 8
+#define HTTP_RESPONSE_SIZE 768           // Per-client response buffer (headers + JSON, or one /metrics chunk)
+#define HTTP_RECV_CHUNK 256              // Bytes read per client per poll
+#define HTTP_CLIENT_TIMEOUT_MS 2000      // Idle connections are dropped after this
+#define HTTP_POLL_BUDGET_US 2000         // Max time poll() may take out of a loop pass
+#ifndef HTTP_TOKEN                       // Define in secrets.h: POST /control and /config need ?token=...
+#define HTTP_TOKEN ""                    // ...and are refused while it is empty
+#endif
+
+// ==================== OTA UPDATES ====================
+#define OTA_ENABLED 0                    // Set OTA_TOKEN first; POST /update needs HTTP_SERVER_ENABLED
+#ifndef OTA_TOKEN                        // Define in secrets.h: uploads need ?token=..., and the
+#define OTA_TOKEN ""                     // ...build stops if OTA_ENABLED is set without one
+#endif
+#define OTA_CHUNK_SIZE 4096              // One flash sector per write, buffered in RAM
+#define OTA_POLL_INTERVAL_MS 1           // Loop sleep while an upload is running
+#define OTA_REBOOT_DELAY_MS 1000         // Lets the 200 reply go out before restarting
+#define OTA_CONFIRM_AFTER_MS 30000       // New image is kept once it has run this long with WiFi...
+#define OTA_ROLLBACK_AFTER_MS 180000UL   // ...or rolled back if it hasn't by now
+
+// ==================== MQTT TELEMETRY ====================
+#define MQTT_ENABLED 0                   // Set MQTT_BROKER first
+#define MQTT_BROKER "192.168.1.10"
+#define MQTT_PORT 1883
+#ifndef MQTT_USER                        // Define both in secrets.h to log in
+#define MQTT_USER ""
+#define MQTT_PASS ""
+#endif
+#define MQTT_TOPIC_ROOT "binclock"       // <root>/<client id>/telemetry and .../status
+#define MQTT_KEEPALIVE_S 60
+#define MQTT_CONNECT_TIMEOUT_MS 5000     // TCP connect + CONNACK
+#define MQTT_RETRY_MIN_MS 1000           // First reconnect delay, doubles each failure
+#define MQTT_RETRY_MAX_MS 60000UL
+#define MQTT_QUEUE_SIZE 32               // Samples held while batching or offline (12 bytes each)
+#define MQTT_BATCH_MAX_SAMPLES 16        // Send once this many are queued...
+#define MQTT_BATCH_INTERVAL_MS 10000     // ...or the oldest has waited this long
+#define MQTT_TX_BUFFER 512               // One PUBLISH packet
+#define MQTT_HEALTH_INTERVAL_MS 60000    // Periodic heap/RSSI/sync samples
+
+// ==================== DISPLAY MIRROR ====================
+// Remote view of the panel for tools/mirror_viewer.py; POST /control?mirror=on starts it
+#define MIRROR_ENABLED 0                 // Off-screen canvas costs SCREEN_W*SCREEN_H*2 bytes (PSRAM if present)
+#define MIRROR_HOST "192.168.1.10"       // Machine running the viewer
+#define MIRROR_PORT 5005
+#define MIRROR_RATE_BYTES_PER_S 32768    // Bandwidth cap, UDP/IP headers included
+#define MIRROR_BURST_BYTES 8192          // Token bucket depth
+#define MIRROR_DATAGRAM_SIZE 1200        // Stays under a 1500 byte MTU; must hold one screen row
+#define MIRROR_MAX_RECTS 12              // Pending damage rects; further ones are merged
+#define MIRROR_DATAGRAMS_PER_UPDATE 4    // Encoding/sending cap per loop pass
+#define MIRROR_REFRESH_ROWS 5            // Rows re-sent per refresh step (heals lost packets)...
+#define MIRROR_REFRESH_INTERVAL_MS 100   // ...so the whole screen is re-sent every 3.4 s
+
+// ==================== METRICS ====================
+#define METRICS_GAUGE_INTERVAL_MS 1000   // Heap/RSSI sampling period
+
+// Histogram bucket upper bounds (us), a +Inf bucket is added automatically
+static const uint32_t METRICS_LOOP_BOUNDS_US[] = {1000, 5000, 10000, 25000, 50000, 100000, 150000, 250000, 500000, 1000000};
+static const uint32_t METRICS_DRAW_BOUNDS_US[] = {250, 500, 1000, 2000, 4000, 8000, 16000, 32000};
+
+// ==================== LOGGING ====================
+#ifndef LOG_BINARY                         // tools/logger_test.cpp is built both ways
+#define LOG_BINARY 0                     // 1: binary frames for tools/log_decode.py instead of text
+#endif
+#define LOG_RING_RECORDS 128             // Records waiting for the drain task (power of two)
+#define LOG_MAX_WORDS 8                  // 32-bit argument words per record (strings use several)
+#define LOG_DRAIN_INTERVAL_MS 20
+#define LOG_TASK_STACK 3072
+#define LOG_TASK_PRIORITY 1              // Lowest above idle; WiFi/lwIP on core 0 run far higher
+#define LOG_TASK_CORE 0
+#define LOG_FLUSH_TIMEOUT_MS 500         // Catching up before a reboot or a direct report
+
 // ==================== CLOCK DISPLAY CONFIGURATION ====================
 #define CLOCK_TOP 20
 #define CLOCK_BOTTOM 135
@@ -42,9 +198,77 @@ static const uint8_t BRIGHTNESS_VALUES[BRIGHTNESS_LEVELS] = {25, 75, 125, 175, 2
 #define CLOCK_GAP_LARGE 20
 #define CLOCK_DOT_RADIUS 10
 #define CLOCK_COL_WIDTH 30
+#define CLOCK_ENCODING 0                 // ClockEncoding::Type: 0 BCD, 1 binary, 2 seconds, 3 epoch, 4 Gray
 
 #define TEXT_AREA_TOP 145
 #define TEXT_AREA_HEIGHT 25
 #define TEXT_Y_POSITION 155
 
+// ==================== DATE PANEL ====================
+// "Wed 30 Sep" centered in the top strip, between the "NTP?" marker and the
+// status dot. Rendered once a day into a 16-bit sprite and pushed from there.
+#define DATE_PANEL_ENABLED 1
+#define DATE_PANEL_W 128
+#define DATE_PANEL_H 18                  // Fits above CLOCK_TOP
+#define DATE_PANEL_X ((SCREEN_W - DATE_PANEL_W) / 2)
+#define DATE_PANEL_Y 1
+#define DATE_PANEL_BUDGET_BYTES 4608     // Cached image, W*H*2 must stay within it
+
+// ==================== WORLD CLOCK ====================
+// Compact BCD faces for several zones below the top strip, switched with
+// /control?world=on. The first WORLD_CLOCK_ZONES entries are shown.
+#ifndef WORLD_CLOCK_ZONES
+#define WORLD_CLOCK_ZONES 4              // 1-4 faces; the layout is fixed at compile time
+#endif
+#ifndef WORLD_CLOCK_DEFAULT
+#define WORLD_CLOCK_DEFAULT 0            // 1: boot into the world clock
+#endif
+#define WORLD_LABEL_H 20                 // Zone name above each face
+static const char* const WORLD_CLOCK_LABELS[] = {"New York", "London", "Tokyo", "Sydney"};
+static const char* const WORLD_CLOCK_TZ[] = {
+    "EST5EDT,M3.2.0,M11.1.0",
+    "GMT0BST,M3.5.0/1,M10.5.0",
+    "JST-9",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+};
+
+// ==================== STOPWATCH & COUNTDOWN ====================
+// /control?timer=stopwatch|countdown; BOOT starts/stops, IO14 laps or resets
+#define TIMER_FRAME_MS 20                // Redraw period while running (50 fps)
+#define COUNTDOWN_DEFAULT_S 300          // Preset for timer=countdown; countdown=<s> sets another
+#define COUNTDOWN_MAX_S 5999             // 99:59, what MM SS can show
+
+// ==================== BURN-IN SHIFT ====================
+// The whole face walks sideways and back, a step every interval, moved by
+// the ST7789's vertical scroll (the screen's x axis in landscape) instead
+// of being redrawn. A step repaints only the edge columns that wrap round.
+// Things within BURNIN_SHIFT_MAX of the edges (status dot) are cut at the
+// ends of the walk, as if the face had really moved.
+#ifndef BURNIN_SHIFT_ENABLED
+#define BURNIN_SHIFT_ENABLED 1
+#endif
+#ifndef BURNIN_SHIFT_INTERVAL_S
+#define BURNIN_SHIFT_INTERVAL_S 120      // Time between steps
+#endif
+#define BURNIN_SHIFT_MAX 4               // Walk bounds, +-pixels from the home position
+#define BURNIN_SHIFT_STEP 1              // Pixels per step
+
+// ==================== NIGHT PANEL MODE ====================
+// After dusk (auto brightness) or with /control?night=on, the panel drives
+// only the lines under the dots (partial mode, the rest black) in 8 colors
+// (idle mode), backlight at SOLAR_NIGHT_LEVEL. Only lit dots show: the
+// night off color has no top bits, and the corner marker and status dot
+// are outside the driven lines.
+#define NIGHT_MODE_AUTO 1                // Follow the solar schedule, like SOLAR_NIGHT_PALETTE
+
+// ==================== STATUS INDICATOR ====================
+#define SHOW_SYNC_INDICATOR 1            // Small dot in the top-right corner
+#define STATUS_DOT_X (SCREEN_W - 6)
+#define STATUS_DOT_Y 6
+#define STATUS_DOT_RADIUS 3
+#define SYNC_OK_COLOR    TFT_GREEN
+#define SYNC_STALE_COLOR TFT_YELLOW
+#define SYNC_NEVER_COLOR TFT_RED
+#define UNSYNCED_MARKER_W 48             // "NTP?" in font18, top-left corner
+
 #endif // CONFIG_H
@@ -6,12 +6,71 @@
 #include "config.h"
 #include "BinaryClockDisplay.h"
 #include "ButtonController.h"
+#include "WiFiConnector.h"
+#include "NtpClient.h"
+#include "SyncStats.h"
+#include "TimeKeeper.h"
+#include "SolarSchedule.h"
+#include "BacklightCurve.h"
+#include "StatusServer.h"
+#include "Metrics.h"
+#include "MqttPublisher.h"
+#include "EspOtaWriter.h"
+#include "OtaUpdater.h"
+#include "DisplayMirror.h"
+#include "ConfigStore.h"
+#include "Logger.h"
+#include "GpsClock.h"
+#include "WorldClock.h"
+#include "Stopwatch.h"
 #include "font18.h"
 
 // ==================== GLOBAL OBJECTS ====================
+ConfigStore configStore;
 TFT_eSPI tft;
 BinaryClockDisplay clockDisplay(tft);
 ButtonController buttonController;
+WiFiConnector wifiConnector;
+NtpClient ntpClient;
+SyncStats syncStats;
+TimeKeeper timeKeeper;
+SolarSchedule solarSchedule(SOLAR_LATITUDE, SOLAR_LONGITUDE, SOLAR_TWILIGHT_MIN);
+StatusServer statusServer;
+MqttPublisher mqttPublisher;
+EspOtaWriter otaWriter;
+OtaUpdater otaUpdater(otaWriter);
+TFT_eSprite mirrorCanvas(&tft);
+DisplayMirror displayMirror;
+WorldClock worldClock;
+Stopwatch stopwatch;
+#if GPS_ENABLED
+GpsClock gpsClock;
+#endif
+
+// ==================== METRICS ====================
+// Served at /metrics; definition order is exposition order
+static Histogram loopPeriodMetric("binclock_loop_period_seconds", nullptr,
+                                  "Time between starts of consecutive main loop passes",
+                                  1e-6, METRICS_LOOP_BOUNDS_US);
+static Histogram drawTimeMetric("binclock_draw_clock_seconds", nullptr,
+                                "Time spent in drawClock() or drawWorld()", 1e-6, METRICS_DRAW_BOUNDS_US);
+static Counter pixelsMetric("binclock_pixels_pushed_total", nullptr,
+                            "Pixels written to the panel");
+static Counter dotsMetric("binclock_dots_drawn_total", nullptr,
+                          "Clock dots repainted (only changed bits are)");
+static Counter timerFramesMetric("binclock_timer_frames_total", nullptr,
+                                 "Stopwatch/countdown frames drawn");
+static Gauge freeHeapMetric("binclock_free_heap_bytes", nullptr, "Free heap");
+static Gauge rssiMetric("binclock_wifi_rssi_dbm", nullptr, "WiFi signal strength");
+static Gauge ntpOffsetMetric("binclock_ntp_offset_seconds", nullptr,
+                             "Clock offset slewed away by the last NTP or GPS sync that did not step", 1e-6);
+static Counter ntpStepsMetric("binclock_ntp_steps_total", nullptr,
+                              "NTP or GPS syncs that stepped the clock, the offset too large to slew");
+static Counter bootButtonMetric("binclock_button_events_total", "button=\"boot\"",
+                                "Button gestures handled");
+static Counter io14ButtonMetric("binclock_button_events_total", "button=\"io14\"",
+                                "Button gestures handled");
+static Counter* const buttonMetrics[ButtonController::BUTTON_COUNT] = {&bootButtonMetric, &io14ButtonMetric};
 
 // ==================== STATE VARIABLES ====================
 static struct {
@@ -19,123 +78,894 @@ static struct {
     int8_t lastMinute = -1;
     int8_t lastSecond = -1;
     bool showTimeDigits = false;
+    bool worldClock = WORLD_CLOCK_DEFAULT;
+    bool timer = false;             // Stopwatch/countdown on the face
+    uint32_t lastTimerMs = UINT32_MAX;
+    uint32_t lastShiftMs = 0;
     bool needsRedraw = true;
+    uint32_t lastSyncStart = 0;
+    uint32_t nextSyncDelay = NTP_SYNC_INTERVAL_MS;
+    int64_t pendingPressUs = 0;     // Press waiting for its first pixel change
+    bool autoBrightness = AUTO_BRIGHTNESS_DEFAULT;
+    bool nightPalette = false;
+    bool nightMode = false;         // Low-power panel mode
+    uint32_t lastSolarUpdate = 0;
+    bool solarApplied = false;
+    int64_t lastLoopUs = 0;
+    uint32_t lastGaugeUpdate = 0;
+    uint32_t lastHealthPublish = 0;
+    bool otaPendingVerify = false;  // Running a new image that isn't confirmed yet
+    uint32_t otaFinishedAt = 0;
 } appState;
 
+// Press-to-pixel latency, from the first raw edge to the end of the redraw
+static struct {
+    uint32_t count = 0;
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+} latencyStats;
+
+// ==================== TELEMETRY ====================
+#if MQTT_ENABLED
+static char mqttClientId[24];
+#endif
+
+// State changes go out on the next publisher update
+static inline void publishState(const char* key, int32_t value) {
+#if MQTT_ENABLED
+    mqttPublisher.enqueue(key, value, millis(), true);
+#else
+    (void)key, (void)value;
+#endif
+}
+
+#if MQTT_ENABLED
+static void publishHealth() {
+    uint32_t now = millis();
+    if (now - appState.lastHealthPublish < MQTT_HEALTH_INTERVAL_MS) {
+        return;
+    }
+    appState.lastHealthPublish = now;
+    mqttPublisher.enqueue("heap", freeHeapMetric.get(), now);
+    mqttPublisher.enqueue("rssi", rssiMetric.get(), now);
+    if (!syncStats.lastStepped()) {
+        mqttPublisher.enqueue("offset_us", (int32_t)syncStats.lastOffsetUs(), now);
+    }
+    mqttPublisher.enqueue("jitter_us", (int32_t)syncStats.jitterUs(), now);
+    mqttPublisher.enqueue("sync_health", syncStats.health(now), now);
+    mqttPublisher.enqueue("mqtt_dropped", (int32_t)mqttPublisher.getSamplesDropped(), now);
+}
+#endif
+
+// ==================== RUNTIME CONFIGURATION ====================
+static const char* const* ntpServers() {
+    static const char* list[NTP_SERVER_COUNT];
+    for (uint8_t i = 0; i < NTP_SERVER_COUNT; i++) {
+        list[i] = configStore.get().ntpServers[i];
+    }
+    return list;
+}
+
+static void applyPalette() {
+    const ConfigStore::Settings& cfg = configStore.get();
+    if (appState.nightPalette) {
+        clockDisplay.setPalette(cfg.nightOnColor, cfg.nightOffColor);
+    } else {
+        clockDisplay.setPalette(cfg.onColor, cfg.offColor);
+    }
+}
+
+// Hands changed settings to their users; the display repaints only the
+// parts a group affects
+static void applyConfig(uint8_t groups) {
+    const ConfigStore::Settings& cfg = configStore.get();
+    if (groups & ConfigStore::GROUP_PALETTE) {
+        applyPalette();
+    }
+    if (groups & ConfigStore::GROUP_BACKGROUND) {
+        clockDisplay.setBackground(cfg.bgColor);
+    }
+    if (groups & ConfigStore::GROUP_DIGITS) {
+        clockDisplay.setDigitColor(cfg.digitColor);
+    }
+    if (groups & ConfigStore::GROUP_LAYOUT) {
+        clockDisplay.setLayout(cfg.colWidth, cfg.dotRadius, cfg.gapSmall, cfg.gapLarge);
+        clockDisplay.setEncoding((ClockEncoding::Type)cfg.encoding);
+    }
+    if (groups & ConfigStore::GROUP_BACKLIGHT) {
+        clockDisplay.setFadeTime(cfg.fadeMs);  // The boot level waits for the next boot
+    }
+    if (groups & ConfigStore::GROUP_TIMEZONE) {
+        setenv("TZ", cfg.timezone, 1);
+        tzset();
+        solarSchedule.invalidate();
+        appState.solarApplied = false;
+    }
+    if (groups & ConfigStore::GROUP_NTP) {
+        // Dropped now, re-resolved by an immediate resync
+        ntpClient.end();
+        appState.nextSyncDelay = 0;
+    }
+    appState.needsRedraw = true;
+}
+
 // ==================== WIFI & TIME FUNCTIONS ====================
 static inline void connectWiFi() {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
-    
-    Serial.print("Connecting to WiFi");
-    uint8_t attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
+    if (wifiConnector.connect(WIFI_SSID, WIFI_PASS)) {
+        IPAddress ip = WiFi.localIP();
+        LOG_EVENT(WIFI_CONNECTED, ip[0], ip[1], ip[2], ip[3]);
     }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nWiFi connected");
-        Serial.print("IP: ");
-        Serial.println(WiFi.localIP());
+    // Reports print directly, after whatever is still queued
+    logger.flush(LOG_FLUSH_TIMEOUT_MS);
+    wifiConnector.printHistograms(Serial);
+}
+
+static void applyClockOffset(int64_t offsetUs) {
+    if (offsetUs >= NTP_STEP_THRESHOLD_US || offsetUs <= -NTP_STEP_THRESHOLD_US) {
+        // Large error: step the clock
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        int64_t us = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec + offsetUs;
+        tv.tv_sec = (time_t)(us / 1000000LL);
+        tv.tv_usec = (suseconds_t)(us % 1000000LL);
+        settimeofday(&tv, nullptr);
     } else {
-        Serial.println("\nWiFi connection failed!");
+        // Small error: slew so the seconds never jump
+        struct timeval delta;
+        delta.tv_sec = (time_t)(offsetUs / 1000000LL);
+        delta.tv_usec = (suseconds_t)(offsetUs % 1000000LL);
+        adjtime(&delta, nullptr);
     }
 }
 
+static void scheduleNextSync() {
+    // Regular interval when healthy, exponential backoff while failing
+    uint16_t failures = syncStats.getConsecutiveFailures();
+    if (failures == 0) {
+        appState.nextSyncDelay = NTP_SYNC_INTERVAL_MS;
+        return;
+    }
+    uint8_t shift = failures - 1 > 16 ? 16 : (uint8_t)(failures - 1);
+    uint32_t backoff = (uint32_t)NTP_RETRY_MIN_MS << shift;
+    appState.nextSyncDelay = backoff > NTP_RETRY_MAX_MS ? NTP_RETRY_MAX_MS : backoff;
+}
+
+// A measured offset from any source (NTP or GPS)
+static void applyTimeSample(int64_t offsetUs, int64_t delayUs) {
+    applyClockOffset(offsetUs);
+    syncStats.recordSuccess(offsetUs, delayUs, millis());
+    if (syncStats.lastStepped()) {
+        // Past 32 bits of microseconds after boot: count it, send seconds
+        ntpStepsMetric.add();
+        publishState("sync_step", (int32_t)(offsetUs / 1000000));
+    } else {
+        ntpOffsetMetric.set((int32_t)offsetUs);
+        publishState("sync_ok", (int32_t)offsetUs);
+    }
+}
+
+static void logSyncReport() {
+    if (syncStats.lastStepped()) {
+        int64_t offsetUs = syncStats.lastOffsetUs();
+        uint64_t stepUs = (uint64_t)(offsetUs < 0 ? -offsetUs : offsetUs);
+        LOG_EVENT(SYNC_STEPPED, offsetUs < 0 ? '-' : '+', (uint32_t)(stepUs / 1000000),
+                  (uint32_t)(stepUs % 1000000), syncStats.lastDelayUs(), syncStats.jitterUs(),
+                  syncStats.getSuccessCount(), syncStats.getFailureCount(),
+                  syncStats.getConsecutiveFailures());
+    } else if (syncStats.hasSynced()) {
+        LOG_EVENT(SYNC_REPORT, (int32_t)syncStats.lastOffsetUs(), syncStats.lastDelayUs(),
+                  syncStats.jitterUs(), syncStats.getSuccessCount(), syncStats.getFailureCount(),
+                  syncStats.getConsecutiveFailures());
+    } else {
+        LOG_EVENT(SYNC_NEVER, syncStats.getFailureCount());
+    }
+}
+
+static void handleSyncResult() {
+    const NtpClient::Result& result = ntpClient.lastResult();
+    if (!result.valid) {
+        syncStats.recordFailure();
+        publishState("sync_fail", syncStats.getConsecutiveFailures());
+        LOG_EVENT(NTP_FAILED, result.servers);
+    } else {
+        applyTimeSample(result.offsetUs, result.delayUs);
+        LOG_EVENT(NTP_SYNCED, result.survivors, result.servers);
+    }
+    logSyncReport();
+    scheduleNextSync();
+}
+
+#if GPS_ENABLED
+static void updateGps() {
+    // No failures from here: a receiver without a fix just stays quiet,
+    // and NTP keeps its own schedule either way
+    if (gpsClock.update(millis())) {
+        const GpsClock::Result& result = gpsClock.lastResult();
+        applyTimeSample(result.offsetUs, 0);
+        LOG_EVENT(GPS_SYNCED, result.pps ? "PPS" : "NMEA", result.seconds);
+        logSyncReport();
+    }
+}
+#endif
+
 static void initTime() {
-    configTzTime(TIMEZONE, NTP_SERVER1, NTP_SERVER2);
-    
-    time_t now = time(nullptr);
-    uint32_t start = millis();
-    while (now < 8 * 3600 * 2 && millis() - start < 10000) {
-        delay(200);
-        now = time(nullptr);
+    // TZ is already set by applyConfig()
+    if (!ntpClient.begin(ntpServers(), NTP_SERVER_COUNT)) {
+        LOG_EVENT(NTP_NO_SERVER);
+    }
+
+    appState.lastSyncStart = millis();
+    ntpClient.startSync(appState.lastSyncStart);
+    while (!ntpClient.update(millis()) && millis() - appState.lastSyncStart < 10000) {
+        delay(NTP_POLL_INTERVAL_MS);
+    }
+    handleSyncResult();
+}
+
+static void updateTimeSync() {
+    uint32_t now = millis();
+    if (!ntpClient.busy() && now - appState.lastSyncStart >= appState.nextSyncDelay) {
+        appState.lastSyncStart = now;
+        if (WiFi.status() != WL_CONNECTED ||
+            (!ntpClient.ready() && !ntpClient.begin(ntpServers(), NTP_SERVER_COUNT))) {
+            // Nothing to talk to yet, count it and back off
+            syncStats.recordFailure();
+            scheduleNextSync();
+            return;
+        }
+        ntpClient.startSync(now);
+    }
+    if (ntpClient.update(now)) {
+        handleSyncResult();
+    }
+}
+
+static void reportPressLatency() {
+    if (appState.pendingPressUs == 0) {
+        return;
+    }
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - appState.pendingPressUs);
+    appState.pendingPressUs = 0;
+
+    latencyStats.count++;
+    latencyStats.sumUs += latency;
+    latencyStats.minUs = min(latencyStats.minUs, latency);
+    latencyStats.maxUs = max(latencyStats.maxUs, latency);
+    LOG_EVENT(PRESS_LATENCY, latency, latencyStats.minUs,
+              (uint32_t)(latencyStats.sumUs / latencyStats.count), latencyStats.maxUs,
+              latencyStats.count);
+}
+
+// ==================== AUTOMATIC BRIGHTNESS ====================
+static void setNightPalette(bool night) {
+    if (night == appState.nightPalette) {
+        return;
     }
+    appState.nightPalette = night;
+    publishState("night", night);
+    applyPalette();
+    appState.needsRedraw = true;
+}
+
+static void setNightMode(bool night) {
+    if (night == appState.nightMode) {
+        return;
+    }
+    appState.nightMode = night;
+    clockDisplay.setNightMode(night);
+    publishState("night_mode", night);
+    LOG_EVENT(NIGHT_MODE, night);
+}
+
+static void updateAutoBrightness(const struct tm& timeinfo) {
+    uint32_t now = millis();
+    if (!appState.autoBrightness ||
+        (appState.solarApplied && now - appState.lastSolarUpdate < SOLAR_UPDATE_INTERVAL_MS)) {
+        return;
+    }
+    appState.lastSolarUpdate = now;
+    appState.solarApplied = true;
+    
+    // Sun times are only recomputed when the local day changes
+    solarSchedule.update(timeinfo);
+    float day = solarSchedule.dayFactor(time(nullptr));
     
-    Serial.println("Time synchronized");
+    // Blend in perceptual space so the ramp looks even
+    float level = SOLAR_NIGHT_LEVEL + (SOLAR_DAY_LEVEL - SOLAR_NIGHT_LEVEL) * day;
+    clockDisplay.setBacklightDuty(BacklightCurve::dutyForFraction(level));
+#if SOLAR_NIGHT_PALETTE
+    setNightPalette(day < 0.5f);
+#endif
+#if NIGHT_MODE_AUTO
+    setNightMode(day < 0.5f);
+#endif
+}
+
+static void setAutoBrightness(bool enabled) {
+    appState.autoBrightness = enabled;
+    appState.solarApplied = false;
+    publishState("auto", enabled);
+    if (!enabled) {
+        setNightPalette(false);
+        setNightMode(false);
+        clockDisplay.setBrightness(buttonController.getCurrentBrightnessLevel());
+    }
+    LOG_EVENT(AUTO_BRIGHTNESS, enabled);
+}
+
+// ==================== FACES ====================
+// The face shows the clock, the world clock or the stopwatch/countdown
+static const char* const timerModeNames[] = {"stopwatch", "countdown"};
+
+static void showTimer(bool on) {
+    appState.timer = on;
+    clockDisplay.setTimerFace(on);
+    buttonController.setBrightnessButton(!on);  // IO14 laps instead
+    appState.needsRedraw = true;
+    publishState("timer", on ? stopwatch.getMode() + 1 : 0);
+}
+
+static void setWorldClock(bool on) {
+    if (on && appState.timer) {
+        showTimer(false);
+        LOG_EVENT(TIMER_MODE, "off");
+    }
+    appState.worldClock = on;
+    clockDisplay.setWorldMode(on);
+    appState.needsRedraw = true;
+    publishState("world", on);
+}
+
+static void setTimer(bool on, Stopwatch::Mode mode, uint32_t presetMs) {
+    if (on) {
+        if (appState.worldClock) {
+            setWorldClock(false);
+        }
+        stopwatch.reset(mode, presetMs);
+    }
+    showTimer(on);
+    LOG_EVENT(TIMER_MODE, on ? timerModeNames[mode] : "off");
+    if (on) {
+        LOG_EVENT(HELP_TIMER);
+    }
+}
+
+// Both act at the press edge, however long the gesture took to recognize
+static void timerStartStop(int64_t atUs) {
+    if (stopwatch.isRunning()) {
+        stopwatch.stop(atUs);
+        uint32_t ms = stopwatch.elapsedMs(atUs);
+        LOG_EVENT(TIMER_STOP, ms / 1000, ms % 1000);
+    } else {
+        stopwatch.start(atUs);
+        uint32_t ms = stopwatch.elapsedMs(atUs);
+        LOG_EVENT(TIMER_START, ms / 1000, ms % 1000);
+    }
+    publishState("timer_running", stopwatch.isRunning());
+    appState.needsRedraw = true;
+}
+
+static void timerLapOrReset(int64_t atUs) {
+    if (!stopwatch.isRunning()) {
+        stopwatch.reset();
+        LOG_EVENT(TIMER_RESET);
+    } else if (stopwatch.getMode() == Stopwatch::MODE_STOPWATCH) {
+        uint32_t lapMs = stopwatch.lap(atUs);
+        uint32_t totalMs = stopwatch.elapsedMs(atUs);
+        LOG_EVENT(TIMER_LAP, stopwatch.getLapCount(), lapMs / 1000, lapMs % 1000, totalMs / 1000,
+                  totalMs % 1000);
+    }
+    appState.needsRedraw = true;
+}
+
+// From the monotonic clock, redrawn whenever the shown millisecond changes
+static void drawTimerFrame() {
+    int64_t nowUs = esp_timer_get_time();
+    if (stopwatch.expire(nowUs)) {
+        LOG_EVENT(TIMER_DONE, stopwatch.getPresetMs() / 1000);
+        publishState("timer_done", stopwatch.getPresetMs() / 1000);
+    }
+    uint32_t ms = stopwatch.shownMs(nowUs);
+    if (ms == appState.lastTimerMs && !appState.needsRedraw) {
+        return;
+    }
+    clockDisplay.drawTimer(ms, appState.showTimeDigits);
+    drawTimeMetric.observe((uint32_t)(esp_timer_get_time() - nowUs));
+    timerFramesMetric.add();
+    appState.lastTimerMs = ms;
+    appState.needsRedraw = false;
+    reportPressLatency();
 }
 
 // ==================== CALLBACK FUNCTIONS ====================
 void onTimeToggle() {
+    bootButtonMetric.add();
+    if (appState.timer) {
+        appState.pendingPressUs = buttonController.getPressedAtUs(ButtonController::BUTTON_BOOT);
+        timerStartStop(appState.pendingPressUs);
+        return;
+    }
     appState.showTimeDigits = !appState.showTimeDigits;
     appState.needsRedraw = true;
-    Serial.printf("Time display: %s\n", appState.showTimeDigits ? "ON" : "OFF");
+    appState.pendingPressUs = buttonController.getPressedAtUs(ButtonController::BUTTON_BOOT);
+    publishState("digits", appState.showTimeDigits);
+    LOG_EVENT(TIME_DISPLAY, appState.showTimeDigits);
 }
 
 void onBrightnessChange(uint8_t level) {
+    io14ButtonMetric.add();
+    // A manual level overrides the solar schedule until re-enabled
+    appState.autoBrightness = false;
+    setNightPalette(false);
+    setNightMode(false);
+    appState.pendingPressUs = buttonController.getPressedAtUs(ButtonController::BUTTON_IO14);
+    int64_t start = esp_timer_get_time();
     clockDisplay.setBrightness(level);
-    Serial.printf("Brightness: level %d/%d (%d/255)\n", 
-                  level + 1, BRIGHTNESS_LEVELS, BRIGHTNESS_VALUES[level]);
+    uint32_t blockedUs = (uint32_t)(esp_timer_get_time() - start);
+    reportPressLatency();
+    publishState("level", level + 1);
+    LOG_EVENT(BRIGHTNESS, level + 1, BRIGHTNESS_LEVELS, BacklightCurve::LEVEL_DUTY[level],
+              BacklightCurve::MAX_DUTY, blockedUs);
+}
+
+void onGesture(uint8_t button, GestureRecognizer::Gesture gesture, uint8_t chordMask) {
+    if (button < ButtonController::BUTTON_COUNT) {
+        buttonMetrics[button]->add();
+    }
+    if (appState.timer && button == ButtonController::BUTTON_IO14 &&
+        gesture != GestureRecognizer::GESTURE_CHORD) {
+        // IO14 while timing: lap, or reset when stopped; holds do nothing
+        if (gesture == GestureRecognizer::GESTURE_SHORT) {
+            appState.pendingPressUs = buttonController.getPressedAtUs(button);
+            timerLapOrReset(appState.pendingPressUs);
+        }
+    } else if (gesture == GestureRecognizer::GESTURE_CHORD) {
+        // GPIO 0 with GPIO 14: resync now. Chords with buttons added to
+        // BUTTON_PINS are left unbound.
+        if (chordMask == ((1u << ButtonController::BUTTON_BOOT) | (1u << ButtonController::BUTTON_IO14))) {
+            LOG_EVENT(FORCE_RESYNC);
+            appState.nextSyncDelay = 0;
+        }
+    } else if (button == ButtonController::BUTTON_BOOT &&
+               gesture == GestureRecognizer::GESTURE_LONG) {
+        // Long press GPIO 0: back to the clock from the timer, otherwise
+        // toggle automatic (solar) brightness
+        if (appState.timer) {
+            setTimer(false, stopwatch.getMode(), 0);
+        } else {
+            setAutoBrightness(!appState.autoBrightness);
+        }
+    } else if (button == ButtonController::BUTTON_BOOT &&
+               gesture == GestureRecognizer::GESTURE_DOUBLE) {
+        // Double tap GPIO 0: status report
+        logger.flush(LOG_FLUSH_TIMEOUT_MS);
+        syncStats.printReport(Serial, millis());
+        wifiConnector.printHistograms(Serial);
+#if GPS_ENABLED
+        const NmeaParser::Stats& gps = gpsClock.getStats();
+        LOG_EVENT(GPS_STATS, gps.sentences, gps.times, gps.badChecksum, gps.malformed);
+#endif
+        LOG_EVENT(LOG_STATS, logger.getCalls(), logger.getDropped(), logger.getAvgCycles(),
+                  logger.getMaxCycles());
+    }
+}
+
+// ==================== HTTP STATUS & CONTROL ====================
+#if HTTP_SERVER_ENABLED
+static size_t writeStatus(char* buf, size_t cap) {
+    static const char* const sourceNames[] = {"wall", "uptime"};
+    static const char* const healthNames[] = {"never", "ok", "stale"};
+
+    uint32_t now = millis();
+    struct tm timeinfo;
+    TimeKeeper::Source source = timeKeeper.read(timeinfo, now);
+    int n = snprintf(buf, cap,
+                     "{\"time\":\"%02d:%02d:%02d\",\"source\":\"%s\","
+                     "\"sync\":{\"health\":\"%s\",\"offset_us\":%lld,\"stepped\":%s,\"age_ms\":%lu,\"failures\":%u},"
+                     "\"brightness\":{\"level\":%u,\"duty\":%lu,\"auto\":%s},"
+                     "\"display\":{\"digits\":%s,\"world\":%s,\"shift\":%d,\"night_palette\":%s,\"night_mode\":%s,\"mirror\":%s},"
+                     "\"timer\":{\"mode\":\"%s\",\"running\":%s,\"ms\":%lu,\"laps\":%u},"
+                     "\"ota\":{\"active\":%s,\"received\":%lu,\"size\":%lu},"
+                     "\"log\":{\"calls\":%lu,\"dropped\":%lu,\"avg_cycles\":%lu,\"max_cycles\":%lu},"
+                     "\"uptime_ms\":%lu}",
+                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, sourceNames[source],
+                     healthNames[syncStats.health(now)], (long long)syncStats.lastOffsetUs(),
+                     syncStats.lastStepped() ? "true" : "false",
+                     (unsigned long)(syncStats.hasSynced() ? syncStats.syncAgeMs(now) : 0),
+                     syncStats.getConsecutiveFailures(),
+                     buttonController.getCurrentBrightnessLevel() + 1,
+                     (unsigned long)clockDisplay.getTargetDuty(),
+                     appState.autoBrightness ? "true" : "false",
+                     appState.showTimeDigits ? "true" : "false",
+                     appState.worldClock ? "true" : "false", clockDisplay.getShift(),
+                     appState.nightPalette ? "true" : "false",
+                     appState.nightMode ? "true" : "false",
+                     displayMirror.isEnabled() ? "true" : "false",
+                     appState.timer ? timerModeNames[stopwatch.getMode()] : "off",
+                     stopwatch.isRunning() ? "true" : "false",
+                     (unsigned long)stopwatch.shownMs(esp_timer_get_time()), stopwatch.getLapCount(),
+                     otaUpdater.active() ? "true" : "false",
+                     (unsigned long)otaUpdater.getReceived(), (unsigned long)otaUpdater.getImageSize(),
+                     (unsigned long)logger.getCalls(), (unsigned long)logger.getDropped(),
+                     (unsigned long)logger.getAvgCycles(), (unsigned long)logger.getMaxCycles(),
+                     (unsigned long)now);
+    return n > 0 ? (size_t)n : 0;
+}
+#endif
+
+static bool parseFlag(const char* value, bool current, bool& out) {
+    if (strcmp(value, "1") == 0 || strcmp(value, "on") == 0) {
+        out = true;
+    } else if (strcmp(value, "0") == 0 || strcmp(value, "off") == 0) {
+        out = false;
+    } else if (strcmp(value, "toggle") == 0) {
+        out = !current;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool onHttpCommand(const char* name, const char* value) {
+    bool flag;
+    if (strcmp(name, "digits") == 0) {
+        if (!parseFlag(value, appState.showTimeDigits, flag)) {
+            return false;
+        }
+        appState.showTimeDigits = flag;
+        appState.needsRedraw = true;
+        publishState("digits", flag);
+    } else if (strcmp(name, "world") == 0) {
+        if (!parseFlag(value, appState.worldClock, flag)) {
+            return false;
+        }
+        setWorldClock(flag);
+    } else if (strcmp(name, "timer") == 0) {
+        if (strcmp(value, "stopwatch") == 0) {
+            setTimer(true, Stopwatch::MODE_STOPWATCH, 0);
+        } else if (strcmp(value, "countdown") == 0) {
+            setTimer(true, Stopwatch::MODE_COUNTDOWN, COUNTDOWN_DEFAULT_S * 1000UL);
+        } else if (strcmp(value, "off") == 0) {
+            setTimer(false, stopwatch.getMode(), 0);
+        } else {
+            return false;
+        }
+    } else if (strcmp(name, "countdown") == 0) {
+        int seconds = atoi(value);
+        if (seconds < 1 || seconds > COUNTDOWN_MAX_S) {
+            return false;
+        }
+        setTimer(true, Stopwatch::MODE_COUNTDOWN, (uint32_t)seconds * 1000);
+    } else if (strcmp(name, "brightness") == 0) {
+        // 1-based, same numbering as the Serial log
+        int level = atoi(value);
+        if (level < 1 || level > BRIGHTNESS_LEVELS) {
+            return false;
+        }
+        buttonController.setCurrentBrightnessLevel((uint8_t)(level - 1));
+        appState.autoBrightness = false;
+        setNightPalette(false);
+        setNightMode(false);
+        clockDisplay.setBrightness((uint8_t)(level - 1));
+        publishState("level", level);
+    } else if (strcmp(name, "night") == 0) {
+        if (!parseFlag(value, appState.nightMode, flag)) {
+            return false;
+        }
+        // A manual choice, like a brightness level, stops the solar schedule
+        appState.autoBrightness = false;
+        setNightPalette(flag);
+        setNightMode(flag);
+        if (flag) {
+            clockDisplay.setBacklightDuty(BacklightCurve::dutyForFraction(SOLAR_NIGHT_LEVEL));
+        } else {
+            clockDisplay.setBrightness(buttonController.getCurrentBrightnessLevel());
+        }
+    } else if (strcmp(name, "auto") == 0) {
+        if (!parseFlag(value, appState.autoBrightness, flag)) {
+            return false;
+        }
+        setAutoBrightness(flag);
+    } else if (strcmp(name, "sync") == 0) {
+        appState.nextSyncDelay = 0;
+    } else if (strcmp(name, "mirror") == 0) {
+        if (!parseFlag(value, displayMirror.isEnabled(), flag)) {
+            return false;
+        }
+        displayMirror.setEnabled(flag);
+        if (displayMirror.isEnabled() != flag) {
+            return false;  // Not compiled in, or the viewer host never resolved
+        }
+    } else {
+        return false;
+    }
+    LOG_EVENT(HTTP_CONTROL, name, value);
+    return true;
+}
+
+#if HTTP_SERVER_ENABLED
+static size_t writeConfig(char* buf, size_t cap) {
+    return configStore.writeJson(buf, cap);
+}
+
+// Applied on the next loop pass, saved once edits settle
+static bool onConfigCommand(const char* name, const char* value) {
+    if (strcmp(name, "reset") == 0) {
+        configStore.resetToDefaults(millis());
+    } else if (!configStore.set(name, value, millis())) {
+        return false;
+    }
+    LOG_EVENT(HTTP_CONFIG, name, value);
+    return true;
+}
+#endif
+
+// ==================== OTA UPDATES ====================
+#if OTA_ENABLED
+static_assert(sizeof(OTA_TOKEN) > 1, "OTA_ENABLED needs OTA_TOKEN defined in secrets.h");
+
+// Leave a freshly flashed image in PENDING_VERIFY; by default the core
+// confirms it before setup() even runs, which makes rollback impossible
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+static void updateOta() {
+    uint32_t now = millis();
+
+    // A new image has to come back on the network (so it can be updated
+    // again) before it is kept; otherwise the bootloader gets the old one
+    if (appState.otaPendingVerify) {
+        if (now >= OTA_CONFIRM_AFTER_MS && WiFi.status() == WL_CONNECTED) {
+            EspOtaWriter::markRunningImageValid();
+            appState.otaPendingVerify = false;
+            LOG_EVENT(OTA_CONFIRMED);
+        } else if (now >= OTA_ROLLBACK_AFTER_MS) {
+            LOG_EVENT(OTA_ROLLBACK);
+            logger.flush(LOG_FLUSH_TIMEOUT_MS);
+            EspOtaWriter::rollBackAndReboot();
+        }
+    }
+
+    if (otaUpdater.succeeded()) {
+        if (appState.otaFinishedAt == 0) {
+            appState.otaFinishedAt = now | 1;
+            LOG_EVENT(OTA_VERIFIED, otaUpdater.getImageSize());
+        } else if (now - appState.otaFinishedAt >= OTA_REBOOT_DELAY_MS) {
+            logger.flush(LOG_FLUSH_TIMEOUT_MS);
+            ESP.restart();
+        }
+    }
 }
+#endif
 
 // ==================== SETUP ====================
 void setup() {
     Serial.begin(115200);
-    Serial.println("\n\n=== Binary Clock (Optimized) ===");
+    Serial.print("\n\n");
+    logger.begin();
+    LOG_EVENT(BOOT);
+    
+    // Saved settings first, so the very first frame uses them
+    configStore.load();
+    applyConfig(ConfigStore::GROUP_ALL);
     
     // Initialize display
     clockDisplay.init();
-    Serial.println("Display initialized");
+    worldClock.begin(WORLD_CLOCK_TZ, WORLD_CLOCK_ZONES);
+    clockDisplay.setWorldMode(appState.worldClock);
+    LOG_EVENT(DISPLAY_READY);
     
     // Initialize buttons
     buttonController.init();
     buttonController.setTimeToggleCallback(onTimeToggle);
     buttonController.setBrightnessCallback(onBrightnessChange);
-    Serial.println("Buttons initialized");
+    buttonController.setGestureCallback(onGesture);
+    buttonController.setCurrentBrightnessLevel(configStore.get().brightnessLevel - 1);
+    clockDisplay.setBrightness(configStore.get().brightnessLevel - 1);
+    LOG_EVENT(BUTTONS_READY);
+    
+#if GPS_ENABLED
+    // Starts collecting sentences now; the first result follows a fix
+    gpsClock.begin(Serial1, GPS_BAUD, GPS_RX_PIN, GPS_PPS_PIN);
+    LOG_EVENT(GPS_READY, GPS_RX_PIN, GPS_PPS_PIN, GPS_BAUD);
+#endif
     
     // Connect WiFi and sync time
     connectWiFi();
     initTime();
     
+#if HTTP_SERVER_ENABLED
+    // Status/control endpoint, served from the main loop
+    statusServer.setStatusWriter(writeStatus);
+    statusServer.setCommandHandler(onHttpCommand);
+    statusServer.setMetricsWriter(Metric::serialize);
+    statusServer.setConfigHandlers(writeConfig, onConfigCommand);
+    statusServer.setWriteToken(HTTP_TOKEN);
+#if OTA_ENABLED
+    otaUpdater.setToken(OTA_TOKEN);
+    statusServer.setUploadHandler(&otaUpdater);
+    appState.otaPendingVerify = EspOtaWriter::runningImagePendingVerify();
+    if (appState.otaPendingVerify) {
+        LOG_EVENT(OTA_PENDING);
+    }
+#endif
+    if (statusServer.begin(HTTP_PORT)) {
+        LOG_EVENT(HTTP_READY, HTTP_PORT);
+    }
+#endif
+    
+#if MQTT_ENABLED
+    // Telemetry; connects in the background from loop()
+    snprintf(mqttClientId, sizeof(mqttClientId), "binclock-%06lx",
+             (unsigned long)((ESP.getEfuseMac() >> 24) & 0xFFFFFF));
+    if (!mqttPublisher.begin(MQTT_BROKER, MQTT_PORT, mqttClientId, MQTT_USER, MQTT_PASS)) {
+        LOG_EVENT(MQTT_UNRESOLVED);
+    }
+#endif
+    
+#if MIRROR_ENABLED
+    // Off-screen copy of the panel; sending starts with /control?mirror=on
+    mirrorCanvas.setColorDepth(16);
+    uint16_t* mirrorPixels = (uint16_t*)mirrorCanvas.createSprite(SCREEN_W, SCREEN_H);
+    if (mirrorPixels && displayMirror.begin(MIRROR_HOST, MIRROR_PORT, mirrorPixels)) {
+        clockDisplay.attachMirror(&mirrorCanvas, &displayMirror);
+        LOG_EVENT(MIRROR_READY, MIRROR_HOST, MIRROR_PORT);
+    } else {
+        LOG_EVENT(MIRROR_FAILED);
+        mirrorCanvas.deleteSprite();
+    }
+#endif
+    
     // Show startup message (unload custom font to use built-in font)
     tft.unloadFont();  // Unload font18 to use built-in fonts
     tft.setTextDatum(MC_DATUM);
-    tft.setTextColor(TEXT_COLOR, BG_COLOR);
+    tft.setTextColor(TEXT_COLOR, configStore.get().bgColor);
     tft.drawString("Binary Clock Station", SCREEN_W/2, SCREEN_H/2 - 10, 4);
     delay(1000);
-    tft.fillScreen(BG_COLOR);
+    tft.fillScreen(configStore.get().bgColor);
     
     // Reload font18 for time digits display
     tft.loadFont(font18);
     
-    Serial.println("=== Binary Clock Ready ===");
-    Serial.println("GPIO 0: Toggle time display");
-    Serial.println("GPIO 14: Cycle brightness");
+    LOG_EVENT(READY);
+    LOG_EVENT(HELP_DIGITS);
+    LOG_EVENT(HELP_REPORT);
+    LOG_EVENT(HELP_AUTO);
+    LOG_EVENT(HELP_BRIGHTNESS);
+    LOG_EVENT(HELP_RESYNC);
 }
 
 // ==================== MAIN LOOP ====================
 void loop() {
+    int64_t loopStartUs = esp_timer_get_time();
+    if (appState.lastLoopUs != 0) {
+        loopPeriodMetric.observe((uint32_t)(loopStartUs - appState.lastLoopUs));
+    }
+    appState.lastLoopUs = loopStartUs;
+    
     // Update button states
     buttonController.update();
     
-    // Get current time
+    // Settings changed over HTTP; NVS writes are coalesced in update()
+    uint8_t configChanges = configStore.takeChanges();
+    if (configChanges) {
+        applyConfig(configChanges);
+    }
+    configStore.update(millis());
+    
+    // Background NTP resync
+    updateTimeSync();
+#if GPS_ENABLED
+    updateGps();
+#endif
+    
+    // Start any backlight fade that was retargeted mid-ramp
+    clockDisplay.update();
+    
+#if BURNIN_SHIFT_ENABLED
+    // Burn-in walk; whatever the step scrolls back in is redrawn below
+    if (millis() - appState.lastShiftMs >= BURNIN_SHIFT_INTERVAL_S * 1000UL) {
+        appState.lastShiftMs = millis();
+        clockDisplay.stepShift();
+        appState.needsRedraw = true;
+    }
+#endif
+    
+    // Get current time (never blocks; falls back to the monotonic clock)
     struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        tft.setTextDatum(TR_DATUM);
-        tft.setTextColor(TFT_RED, BG_COLOR);
-        tft.drawString("NTP?", SCREEN_W - 4, 4, 2);
-        delay(500);
-        return;
+    time_t epoch;
+    TimeKeeper::Source source = timeKeeper.read(timeinfo, millis(), &epoch);
+    clockDisplay.drawUnsyncedMarker(source != TimeKeeper::SOURCE_WALL);
+    if (source == TimeKeeper::SOURCE_WALL) {
+        updateAutoBrightness(timeinfo);
+    }
+    
+#if DATE_PANEL_ENABLED
+    // Uptime has no date to show
+    if (source != TimeKeeper::SOURCE_UPTIME) {
+        clockDisplay.drawDate(timeinfo);
     }
+#endif
+    
+#if SHOW_SYNC_INDICATOR
+    static const uint16_t healthColors[] = {SYNC_NEVER_COLOR, SYNC_OK_COLOR, SYNC_STALE_COLOR};
+    clockDisplay.drawStatusDot(healthColors[syncStats.health(millis())]);
+#endif
     
     // Check if time has changed
     int8_t h = (int8_t)timeinfo.tm_hour;
     int8_t m = (int8_t)timeinfo.tm_min;
     int8_t s = (int8_t)timeinfo.tm_sec;
     
-    if (h != appState.lastHour || m != appState.lastMinute || s != appState.lastSecond || appState.needsRedraw) {
+    if (appState.timer) {
+        drawTimerFrame();
+    } else if (h != appState.lastHour || m != appState.lastMinute || s != appState.lastSecond ||
+               appState.needsRedraw) {
         // Update display
-        clockDisplay.drawClock((uint8_t)h, (uint8_t)m, (uint8_t)s, appState.showTimeDigits);
+        int64_t drawStartUs = esp_timer_get_time();
+        if (appState.worldClock) {
+            // The same UTC reading for every zone, through cached offsets
+            struct tm zones[WORLD_CLOCK_ZONES];
+            worldClock.convert(epoch, zones);
+            clockDisplay.drawWorld(zones);
+        } else {
+            clockDisplay.drawClock(timeinfo, (uint32_t)epoch, appState.showTimeDigits);
+        }
+        drawTimeMetric.observe((uint32_t)(esp_timer_get_time() - drawStartUs));
         
         // Update state
         appState.lastHour = h;
         appState.lastMinute = m;
         appState.lastSecond = s;
         appState.needsRedraw = false;
+        reportPressLatency();
+    }
+    
+    // Every panel write this pass, including the status dot and marker
+    pixelsMetric.add(clockDisplay.takePixelsPushed());
+    dotsMetric.add(clockDisplay.takeDotsDrawn());
+    if (millis() - appState.lastGaugeUpdate >= METRICS_GAUGE_INTERVAL_MS) {
+        appState.lastGaugeUpdate = millis();
+        freeHeapMetric.set((int32_t)ESP.getFreeHeap());
+        if (WiFi.status() == WL_CONNECTED) {
+            rssiMetric.set(WiFi.RSSI());
+        }
     }
     
-    // Small delay
-    delay(TIME_UPDATE_INTERVAL_MS);
+#if HTTP_SERVER_ENABLED
+    // After the frame, so requests only ever use the time left over
+    statusServer.poll(millis(), HTTP_POLL_BUDGET_US);
+#endif
+    
+#if OTA_ENABLED
+    // Reboot into a verified upload, confirm or roll back a new image
+    updateOta();
+#endif
+    
+#if MQTT_ENABLED
+    // One non-blocking step: connect, flush a batch or keepalive
+    publishHealth();
+    mqttPublisher.update(millis());
+#endif
+    
+#if MIRROR_ENABLED
+    // Send what was drawn, within the bandwidth cap
+    displayMirror.update(millis());
+#endif
+    
+    // Sleep until the next tick or button event (short while a timer runs,
+    // NTP replies are being timestamped or a firmware upload is streaming in)
+    uint32_t waitMs = TIME_UPDATE_INTERVAL_MS;
+    if (appState.timer && stopwatch.isRunning()) {
+        waitMs = TIMER_FRAME_MS;
+    }
+    if (ntpClient.busy()) {
+        waitMs = NTP_POLL_INTERVAL_MS;
+    }
+    if (otaUpdater.active()) {
+        waitMs = OTA_POLL_INTERVAL_MS;
+    }
+    buttonController.waitForEvent(waitMs);
 }
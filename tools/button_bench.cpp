@@ -0,0 +1,186 @@
+// Cost of one debounce sample against the number of buttons, as
+// ButtonController::onSample() does it: ButtonBank::step() on one register
+// read, then a visit to each bit that flipped. "per-pin" is the same
+// debounce done one button at a time (a bit read and a 4-sample counter
+// each), which is what the bank replaces. Inputs are a generated stream of
+// presses with a few samples of contact bounce on both edges, replayed
+// from memory so only the debounce is timed. Both must report the same
+// number of debounced edges. Builds on the host against the sim's register
+// stand-ins:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc tools/button_bench.cpp -o button_bench
+//   ./button_bench [samples]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <utility>
+#include <vector>
+#include "ButtonBank.h"
+
+// Register stand-ins: the bench feeds GPIO_IN/GPIO_IN1 from its stream
+static uint32_t inReg = 0xFFFFFFFFu;
+static uint32_t in1Reg = 0xFFFFFFFFu;
+
+uint32_t simReadRegister(uint32_t address) {
+    return address == GPIO_IN1_REG ? in1Reg : inReg;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+static const uint32_t SAMPLE_US = 5000;  // BUTTON_SAMPLE_US
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom(uint32_t range) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % range;
+}
+
+// Raw active-low levels for `samples` periods on pins [first, first + count):
+// each button is pressed now and then for 80-1500 ms, with bounce
+static std::vector<uint64_t> makeStream(uint8_t first, uint8_t count, size_t samples, uint32_t busyPct) {
+    std::vector<uint64_t> stream(samples, ~0ULL);
+    for (uint8_t b = 0; b < count; b++) {
+        uint64_t bit = 1ULL << (first + b);
+        size_t t = nextRandom(200);
+        while (t < samples) {
+            if (nextRandom(100) >= busyPct) {
+                t += 200;  // A second of nothing
+                continue;
+            }
+            size_t hold = (80 + nextRandom(1420)) * 1000 / SAMPLE_US;
+            for (size_t i = t; i < t + hold && i < samples; i++) {
+                stream[i] &= ~bit;
+            }
+            // Bounce: a few samples of the opposite level at each edge
+            for (uint32_t n = nextRandom(3); n > 0; n--) {
+                size_t at = t + 1 + nextRandom(2);
+                if (at < samples) {
+                    stream[at] |= bit;
+                }
+                at = t + hold + nextRandom(2);
+                if (at < samples) {
+                    stream[at] &= ~bit;
+                }
+            }
+            t += hold + 40 + nextRandom(400);
+        }
+    }
+    return stream;
+}
+
+template <uint8_t First, uint8_t... I>
+static ButtonBank<(uint8_t)(First + I)...> bankFor(std::integer_sequence<uint8_t, I...>);
+
+template <uint8_t First, uint8_t Count>
+using BankOf = decltype(bankFor<First>(std::make_integer_sequence<uint8_t, Count>()));
+
+struct Result {
+    double nsPerSample;
+    uint64_t events;
+};
+
+template <uint8_t First, uint8_t Count>
+static Result runBank(const std::vector<uint64_t>& stream) {
+    using Bank = BankOf<First, Count>;
+    static Bank bank;
+    inReg = in1Reg = 0xFFFFFFFFu;
+    bank.init();
+
+    uint64_t events = 0;
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t raw : stream) {
+        inReg = (uint32_t)raw;
+        in1Reg = (uint32_t)(raw >> 32);
+        typename Bank::Word toggled = bank.step();
+        typename Bank::Word pressed = bank.pressed();
+        while (toggled) {
+            uint8_t bit = Bank::lowestBit(toggled);
+            toggled &= toggled - 1;
+            sink += bank.indexOfBit(bit) + (uint32_t)((pressed >> bit) & 1);
+            events++;
+        }
+        sink += bank.settled();
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sink == 0xFFFFFFFFu) {
+        printf("?");
+    }
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return {ns / (double)stream.size(), events};
+}
+
+// One button at a time: a bit per pin and a counter that must reach 4
+template <uint8_t First, uint8_t Count>
+static Result runPerPin(const std::vector<uint64_t>& stream) {
+    static bool state[Count];
+    static uint8_t counter[Count];
+    memset(state, 0, sizeof(state));
+    memset(counter, 0, sizeof(counter));
+
+    uint64_t events = 0;
+    uint32_t sink = 0;
+    volatile uint64_t reg;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t raw : stream) {
+        reg = raw;
+        for (uint8_t i = 0; i < Count; i++) {
+            bool pressed = !((reg >> (First + i)) & 1);  // One digitalRead() per pin
+            if (pressed == state[i]) {
+                counter[i] = 0;
+                continue;
+            }
+            if (++counter[i] >= 4) {
+                state[i] = pressed;
+                counter[i] = 0;
+                sink += i + pressed;
+                events++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sink == 0xFFFFFFFFu) {
+        printf("?");
+    }
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return {ns / (double)stream.size(), events};
+}
+
+template <uint8_t First, uint8_t Count>
+static void row(size_t samples, uint32_t busyPct) {
+    std::vector<uint64_t> stream = makeStream(First, Count, samples, busyPct);
+    Result bank = runBank<First, Count>(stream);
+    Result perPin = runPerPin<First, Count>(stream);
+    printf("%7u %5u%s %4u%%   %8.2f ns %9llu   %8.2f ns %9llu\n", (unsigned)Count, (unsigned)First,
+           First + Count > 32 ? "+" : " ", (unsigned)busyPct, bank.nsPerSample,
+           (unsigned long long)bank.events, perPin.nsPerSample, (unsigned long long)perPin.events);
+    if (bank.events != perPin.events) {
+        printf("        event counts differ\n");
+    }
+}
+
+template <uint32_t BusyPct>
+static void table(size_t samples) {
+    row<0, 1>(samples, BusyPct);
+    row<0, 2>(samples, BusyPct);
+    row<0, 4>(samples, BusyPct);
+    row<0, 8>(samples, BusyPct);
+    row<0, 16>(samples, BusyPct);
+    row<0, 32>(samples, BusyPct);
+    row<30, 8>(samples, BusyPct);
+}
+
+int main(int argc, char** argv) {
+    size_t samples = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    printf("%zu samples of %u us (%.1f h) per row; \"+\" spans both GPIO registers\n\n", samples,
+           (unsigned)SAMPLE_US, samples * (SAMPLE_US / 1e6) / 3600);
+    printf("buttons first  busy        bank    events       per-pin    events\n");
+    table<10>(samples);
+    table<100>(samples);
+    return 0;
+}
@@ -0,0 +1,291 @@
+// ConfigStore validation and persistence against an in-memory NVS. The
+// layout checks go through ClockEncoding::fit(), the arithmetic the
+// display places its columns with, so a width the display would have to
+// scale down is judged after scaling, for the stored encoding and for the
+// timer face. Exits non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc -o config_test
+//       tools/config_test.cpp src/ConfigStore.cpp src/ClockEncoding.cpp src/Logger.cpp
+//   ./config_test
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <stdarg.h>
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include "ConfigStore.h"
+#include "ClockEncoding.h"
+#include "Logger.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+// ==================== Platform ====================
+// What ConfigStore and the logger touch, without the simulator's world.
+// Log records stay in the ring until a case drains them.
+EspClass ESP;
+HardwareSerial Serial;
+
+uint32_t EspClass::getCycleCount() { return 0; }
+int64_t esp_timer_get_time() { return 0; }
+unsigned long millis() { return 0; }
+void delay(unsigned long) {}
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, UBaseType_t,
+                                   TaskHandle_t*, BaseType_t) {
+    return pdPASS;
+}
+void vTaskDelay(TickType_t) {}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return n > 0 ? write((const uint8_t*)buf, strnlen(buf, sizeof(buf))) : 0;
+}
+
+void HardwareSerial::flush() {}
+size_t HardwareSerial::write(uint8_t) { return 1; }
+size_t HardwareSerial::write(const uint8_t*, size_t size) { return size; }
+
+// Log text since the last call
+struct Capture : Print {
+    std::string text;
+    size_t write(uint8_t c) override {
+        text += (char)c;
+        return 1;
+    }
+    using Print::write;
+};
+
+static std::string drainLog() {
+    Capture out;
+    logger.drain(out);
+    return out.text;
+}
+
+// ==================== NVS ====================
+static std::map<std::string, std::string> nvs;
+
+bool Preferences::begin(const char* name, bool ro) {
+    ns = name;
+    readOnly = ro;
+    return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!ns || readOnly) {
+        return 0;
+    }
+    nvs[std::string(ns) + "/" + key].assign((const char*)value, len);
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!ns) {
+        return 0;
+    }
+    auto it = nvs.find(std::string(ns) + "/" + key);
+    if (it == nvs.end() || it->second.size() > maxLen) {
+        return 0;
+    }
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+// ==================== Cases ====================
+static void testFit() {
+    printf("fit\n");
+    const ClockEncoding::Layout* faces[ClockEncoding::TYPE_COUNT + 1];
+    for (uint8_t t = 0; t < ClockEncoding::TYPE_COUNT; t++) {
+        faces[t] = &ClockEncoding::layout((ClockEncoding::Type)t);
+    }
+    faces[ClockEncoding::TYPE_COUNT] = &ClockEncoding::durationLayout();
+
+    for (const ClockEncoding::Layout* face : faces) {
+        for (int w = 8; w <= 60; w++) {
+            for (int small = 0; small <= 60; small += 4) {
+                for (int large = 0; large <= 60; large += 4) {
+                    ClockEncoding::Fit f = ClockEncoding::fit(*face, SCREEN_W, w, small, large);
+                    bool scaled = f.width != w || f.gapSmall != small || f.gapLarge != large;
+                    CHECK(f.total <= SCREEN_W, "%s %d/%d/%d: total %d", face->name, w, small, large, f.total);
+                    CHECK(f.width <= w && f.gapSmall <= small && f.gapLarge <= large,
+                          "%s %d/%d/%d grew", face->name, w, small, large);
+                    if (!scaled) {
+                        continue;
+                    }
+                    // Only scaled when it had to be, and then no more than
+                    // rounding down each term loses
+                    ClockEncoding::Fit unscaled = ClockEncoding::fit(*face, 1 << 15, w, small, large);
+                    CHECK(unscaled.total > SCREEN_W, "%s %d/%d/%d scaled needlessly", face->name, w, small, large);
+                    CHECK(f.width >= w * SCREEN_W / unscaled.total, "%s %d/%d/%d: width %d",
+                          face->name, w, small, large, f.width);
+                }
+            }
+        }
+    }
+
+    // BCD at the defaults fits as is; epoch has two more columns and a
+    // third wide gap, so it is scaled
+    ClockEncoding::Fit bcd = ClockEncoding::fit(ClockEncoding::layout(ClockEncoding::BCD), SCREEN_W, 30, 8, 20);
+    CHECK(bcd.width == 30 && bcd.total == 6 * 30 + 3 * 8 + 2 * 20, "bcd %d/%d", bcd.width, bcd.total);
+    ClockEncoding::Fit epoch = ClockEncoding::fit(ClockEncoding::layout(ClockEncoding::EPOCH), SCREEN_W, 30, 8, 20);
+    CHECK(epoch.width == 30 * SCREEN_W / (8 * 30 + 4 * 8 + 3 * 20), "epoch width %d", epoch.width);
+}
+
+static void testDefaults() {
+    printf("defaults\n");
+    ConfigStore store;
+    const ConfigStore::Settings& s = store.get();
+    CHECK(s.colWidth == CLOCK_COL_WIDTH && s.dotRadius == CLOCK_DOT_RADIUS, "layout %u/%u", s.colWidth, s.dotRadius);
+    CHECK(strcmp(s.timezone, TIMEZONE) == 0, "timezone '%s'", s.timezone);
+
+    // Every encoding works with the default layout
+    for (uint8_t t = 0; t < ClockEncoding::TYPE_COUNT; t++) {
+        const char* name = ClockEncoding::layout((ClockEncoding::Type)t).name;
+        CHECK(store.set("encoding", name, 0), "encoding=%s refused", name);
+        CHECK(store.get().encoding == t, "encoding %u, want %u", store.get().encoding, t);
+    }
+}
+
+static void testLayoutChecks() {
+    printf("layout checks\n");
+    ConfigStore store;
+    store.takeChanges();
+
+    // Too wide for six columns, but the display scales it down and the
+    // dots still fit: 6 * 60 + 3 * 8 + 2 * 20 = 424 wide, columns 45 px
+    CHECK(store.set("col_width", "60", 0), "col_width=60 refused");
+    CHECK(store.set("col_width", "30", 0), "col_width=30 refused");
+
+    // Wide gaps between groups: six and seven columns fit, eight (epoch)
+    // get scaled to 22 px, too narrow for a radius-13 dot (27 px)
+    CHECK(store.set("gap_small", "0", 0), "gap_small=0 refused");
+    CHECK(store.set("gap_large", "60", 0), "gap_large=60 refused");
+    CHECK(store.set("col_width", "28", 0), "col_width=28 refused");
+    CHECK(store.set("dot_radius", "13", 0), "dot_radius=13 refused");
+    store.takeChanges();
+    CHECK(!store.set("encoding", "epoch", 0), "epoch accepted with 22 px columns");
+    CHECK(store.get().encoding == ClockEncoding::BCD, "encoding changed on refusal");
+    CHECK(store.takeChanges() == 0, "refusal recorded a change");
+
+    // A dot that fits the scaled columns is fine, and the other way round
+    // the radius can't grow past them once epoch is stored
+    CHECK(store.set("dot_radius", "10", 0), "dot_radius=10 refused");
+    CHECK(store.set("encoding", "epoch", 0), "epoch refused with 22 px columns");
+    CHECK(!store.set("dot_radius", "11", 0), "dot_radius=11 accepted with 22 px columns");
+    CHECK(store.takeChanges() == (ConfigStore::GROUP_LAYOUT), "changes");
+
+    // The timer face shares the widths: BCD fits unscaled in 320 px with
+    // 30 px columns, the seven timer columns only get 25 px (30 * 320 / 370)
+    store.resetToDefaults(0);
+    CHECK(store.set("gap_small", "20", 0) && store.set("gap_large", "40", 0), "gaps refused");
+    CHECK(!store.set("dot_radius", "13", 0), "dot_radius=13 accepted, timer columns are 25 px");
+    CHECK(store.set("dot_radius", "12", 0), "dot_radius=12 refused");
+
+    // Unscaled, the column must hold the dot as before
+    store.resetToDefaults(0);
+    CHECK(store.set("dot_radius", "13", 0), "dot_radius=13 refused");
+    CHECK(!store.set("col_width", "26", 0), "col_width=26 accepted with a 27 px dot");
+    CHECK(store.get().colWidth == CLOCK_COL_WIDTH, "col_width %u", store.get().colWidth);
+
+    // Field ranges and unknown names
+    CHECK(!store.set("col_width", "7", 0), "col_width=7 accepted");
+    CHECK(!store.set("encoding", "roman", 0), "encoding=roman accepted");
+    CHECK(!store.set("nonsense", "1", 0), "unknown name accepted");
+}
+
+static void testPersistence() {
+    printf("persistence\n");
+    nvs.clear();
+    drainLog();
+    {
+        ConfigStore store;
+        store.load();
+        CHECK(drainLog().empty(), "first boot logged");
+        CHECK(store.set("encoding", "epoch", 1000), "encoding=epoch refused");
+        CHECK(store.set("bg_color", "#102030", 2000), "bg_color refused");
+        store.update(2000 + CONFIG_SAVE_DELAY_MS - 1);
+        CHECK(store.getSaves() == 0 && store.savePending(), "saved before the edits settled");
+        store.update(2000 + CONFIG_SAVE_DELAY_MS);
+        CHECK(store.getSaves() == 1 && !store.savePending(), "saves %u", store.getSaves());
+        CHECK(drainLog().find("Config saved (1 writes") != std::string::npos, "save not logged");
+
+        // Back and forth again is a no-op for flash
+        CHECK(store.set("encoding", "bcd", 10000) && store.set("encoding", "epoch", 10001), "set");
+        store.update(10001 + CONFIG_SAVE_DELAY_MS);
+        CHECK(store.getSaves() == 1, "no-op edit saved (%u)", store.getSaves());
+    }
+    {
+        ConfigStore store;
+        store.load();
+        CHECK(store.get().encoding == ClockEncoding::EPOCH, "encoding %u after reload", store.get().encoding);
+        CHECK(store.get().bgColor == 0x1106, "bg_color 0x%04X after reload", store.get().bgColor);
+    }
+
+    // A stored blob whose layout no longer fits its encoding (as the old
+    // six-column check let through) falls back to the defaults
+    std::string& blob = nvs["config/cfg"];
+    CHECK(blob.size() == 4 + sizeof(ConfigStore::Settings), "blob %zu bytes", blob.size());
+    ConfigStore::Settings bad;
+    memcpy(&bad, &blob[4], sizeof(bad));
+    bad.colWidth = 28;
+    bad.dotRadius = 13;
+    bad.gapSmall = 0;
+    bad.gapLarge = 60;
+    memcpy(&blob[4], &bad, sizeof(bad));
+    {
+        ConfigStore store;
+        store.load();
+        CHECK(store.get().encoding == CLOCK_ENCODING && store.get().dotRadius == CLOCK_DOT_RADIUS,
+              "unfitting blob loaded");
+        CHECK(!store.savePending(), "fallback scheduled a write");
+        CHECK(drainLog().find("stored settings unusable") != std::string::npos, "fallback not logged");
+    }
+    bad.encoding = ClockEncoding::BCD;
+    memcpy(&blob[4], &bad, sizeof(bad));
+    {
+        ConfigStore store;
+        store.load();
+        CHECK(store.get().dotRadius == 13 && store.get().gapLarge == 60, "fitting blob refused");
+    }
+
+    // Wrong size, as from an older layout
+    blob.resize(blob.size() - 1);
+    {
+        ConfigStore store;
+        store.load();
+        CHECK(store.get().dotRadius == CLOCK_DOT_RADIUS, "short blob loaded");
+        CHECK(drainLog().find("stored settings unusable") != std::string::npos, "fallback not logged");
+    }
+}
+
+int main() {
+    testFit();
+    testDefaults();
+    testLayoutChecks();
+    testPersistence();
+    printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+    return failures ? 1 : 0;
+}
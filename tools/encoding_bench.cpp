@@ -0,0 +1,87 @@
+// Dots repainted per one-second tick for each ClockEncoding, as
+// BinaryClockDisplay::drawClock() does it (only bits that flipped), against
+// repainting every dot, and what the date panel adds (a render and push
+// only on the ticks where the local day changes). Builds on the host from
+// the firmware source:
+//
+//   g++ -O2 -std=gnu++17 -Isrc tools/encoding_bench.cpp src/ClockEncoding.cpp -o encoding_bench
+//   ./encoding_bench [days] [start-epoch]     (TZ from the environment)
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ClockEncoding.h"
+
+using namespace ClockEncoding;
+
+static uint8_t popcount8(uint8_t v) {
+    uint8_t n = 0;
+    for (; v; v &= (uint8_t)(v - 1)) {
+        n++;
+    }
+    return n;
+}
+
+int main(int argc, char** argv) {
+    uint32_t days = argc > 1 ? (uint32_t)atoi(argv[1]) : 7;
+    time_t start = argc > 2 ? (time_t)atoll(argv[2]) : (time_t)1772755200;  // 2026-03-06 00:00Z
+    uint32_t ticks = days * 86400;
+
+    printf("%u ticks from %lld, TZ=%s\n\n", (unsigned)ticks, (long long)start,
+           getenv("TZ") ? getenv("TZ") : "(unset)");
+    printf("%-8s %5s %10s %10s %9s\n", "encoding", "dots", "avg/tick", "max/tick", "vs full");
+
+    for (uint8_t t = 0; t < TYPE_COUNT; t++) {
+        Type type = (Type)t;
+        const Layout& l = layout(type);
+        uint32_t dots = 0;
+        for (uint8_t c = 0; c < l.columns; c++) {
+            dots += l.bits[c];
+        }
+
+        Frame previous;
+        Frame frame;
+        struct tm local;
+        time_t now = start;
+        localtime_r(&now, &local);
+        encode(type, local, (uint32_t)now, previous);
+
+        uint64_t flipped = 0;
+        uint32_t worst = 0;
+        for (uint32_t i = 1; i <= ticks; i++) {
+            now = start + i;
+            localtime_r(&now, &local);
+            encode(type, local, (uint32_t)now, frame);
+
+            uint32_t n = 0;
+            for (uint8_t c = 0; c < l.columns; c++) {
+                uint8_t mask = (uint8_t)((1u << l.bits[c]) - 1);
+                n += popcount8((uint8_t)((frame.bits[c] ^ previous.bits[c]) & mask));
+            }
+            flipped += n;
+            worst = n > worst ? n : worst;
+            previous = frame;
+        }
+
+        double avg = (double)flipped / ticks;
+        printf("%-8s %5u %10.3f %10u %8.1f%%\n", l.name, (unsigned)dots, avg, (unsigned)worst,
+               100.0 * avg / dots);
+    }
+
+    // BinaryClockDisplay::drawDate() keys its cached image on the same day
+    uint32_t renders = 0;
+    int32_t renderedDay = -1;
+    for (uint32_t i = 0; i <= ticks; i++) {
+        time_t now = start + i;
+        struct tm local;
+        localtime_r(&now, &local);
+        int32_t day = local.tm_year * 366 + local.tm_yday;
+        if (day != renderedDay) {
+            renderedDay = day;
+            renders++;
+        }
+    }
+    printf("\ndate panel: %u renders, %u of %u ticks with no date work\n", (unsigned)renders,
+           (unsigned)(ticks + 1 - renders), (unsigned)(ticks + 1));
+    return 0;
+}
@@ -0,0 +1,185 @@
+// GestureRecognizer against scripted edge sequences, with the timing from
+// config.h (BOOT: 800 ms long press, 250 ms double tap; IO14: 600 ms long
+// press, repeat every 300 ms, no double tap). Each script is run twice: once
+// polled every millisecond, and once jumping from edge to deadline with
+// msUntilDeadline() the way the loop sleeps. Both must give the expected
+// gestures at the expected milliseconds. Exits non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc tools/gesture_test.cpp src/GestureRecognizer.cpp -o gesture_test
+//   ./gesture_test
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "GestureRecognizer.h"
+
+enum { BOOT = 0, IO14 = 1 };
+
+struct Edge {
+    uint32_t atMs;  // From the script's start
+    uint8_t button;
+    bool pressed;
+};
+
+struct Fired {
+    uint32_t atMs;
+    uint8_t button;
+    GestureRecognizer::Gesture gesture;
+    uint8_t chordMask;
+};
+
+struct Script {
+    const char* name;
+    std::vector<Edge> edges;
+    std::vector<Fired> expected;
+};
+
+static const GestureRecognizer::ButtonConfig CONFIGS[] = {BUTTON_GESTURES};
+static const char* const GESTURE_NAMES[] = {"short", "long", "double", "repeat", "chord"};
+
+static std::vector<Fired> fired;
+static uint32_t firedAt;
+
+static void onGesture(void* context, uint8_t button, GestureRecognizer::Gesture gesture, uint8_t chordMask) {
+    (void)context;
+    fired.push_back({firedAt, button, gesture, chordMask});
+}
+
+// Polled: every millisecond, edges first, as ButtonController delivers them
+static void runPolled(const Script& s, uint32_t startMs, uint32_t endMs) {
+    GestureRecognizer g;
+    g.begin(CONFIGS, 2);
+    g.setCallback(onGesture, nullptr);
+    size_t next = 0;
+    for (uint32_t t = 0; t <= endMs; t++) {
+        firedAt = t;
+        while (next < s.edges.size() && s.edges[next].atMs == t) {
+            g.feed(s.edges[next].button, s.edges[next].pressed, startMs + t);
+            next++;
+        }
+        g.poll(startMs + t);
+    }
+}
+
+// Event-driven: sleep until the next edge or msUntilDeadline(), then poll
+static void runSleeping(const Script& s, uint32_t startMs, uint32_t endMs) {
+    GestureRecognizer g;
+    g.begin(CONFIGS, 2);
+    g.setCallback(onGesture, nullptr);
+    size_t next = 0;
+    uint32_t t = 0;
+    while (t <= endMs) {
+        firedAt = t;
+        while (next < s.edges.size() && s.edges[next].atMs == t) {
+            g.feed(s.edges[next].button, s.edges[next].pressed, startMs + t);
+            next++;
+        }
+        g.poll(startMs + t);
+        uint32_t wait = g.msUntilDeadline(startMs + t, endMs + 1 - t);
+        if (next < s.edges.size() && s.edges[next].atMs - t < wait) {
+            wait = s.edges[next].atMs - t;
+        }
+        t += wait ? wait : 1;
+    }
+}
+
+static bool same(const std::vector<Fired>& a, const std::vector<Fired>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].atMs != b[i].atMs || a[i].button != b[i].button || a[i].gesture != b[i].gesture ||
+            a[i].chordMask != b[i].chordMask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print(const char* label, const std::vector<Fired>& list) {
+    printf("    %-9s", label);
+    for (const Fired& f : list) {
+        printf(" %s %s@%u", f.button == BOOT ? "boot" : "io14", GESTURE_NAMES[f.gesture], (unsigned)f.atMs);
+        if (f.gesture == GestureRecognizer::GESTURE_CHORD) {
+            printf("(mask %u)", (unsigned)f.chordMask);
+        }
+    }
+    printf("\n");
+}
+
+int main() {
+    using G = GestureRecognizer;
+    const Script scripts[] = {
+        {"boot short",
+         {{0, BOOT, true}, {100, BOOT, false}},
+         {{350, BOOT, G::GESTURE_SHORT, 1}}},
+        {"boot double tap",
+         {{0, BOOT, true}, {100, BOOT, false}, {200, BOOT, true}, {300, BOOT, false}},
+         {{300, BOOT, G::GESTURE_DOUBLE, 1}}},
+        {"second tap past the window",
+         {{0, BOOT, true}, {100, BOOT, false}, {400, BOOT, true}, {500, BOOT, false}},
+         {{350, BOOT, G::GESTURE_SHORT, 1}, {750, BOOT, G::GESTURE_SHORT, 1}}},
+        {"second tap on the deadline",
+         {{0, BOOT, true}, {100, BOOT, false}, {350, BOOT, true}, {400, BOOT, false}},
+         {{350, BOOT, G::GESTURE_SHORT, 1}, {650, BOOT, G::GESTURE_SHORT, 1}}},
+        {"boot long press",
+         {{0, BOOT, true}, {1500, BOOT, false}},
+         {{800, BOOT, G::GESTURE_LONG, 1}}},
+        {"boot released just before long",
+         {{0, BOOT, true}, {799, BOOT, false}},
+         {{1049, BOOT, G::GESTURE_SHORT, 1}}},
+        {"io14 short on release",
+         {{0, IO14, true}, {100, IO14, false}},
+         {{100, IO14, G::GESTURE_SHORT, 2}}},
+        {"io14 hold and repeat",
+         {{0, IO14, true}, {1450, IO14, false}},
+         {{600, IO14, G::GESTURE_LONG, 2}, {900, IO14, G::GESTURE_REPEAT, 2}, {1200, IO14, G::GESTURE_REPEAT, 2}}},
+        {"io14 released on a repeat",
+         {{0, IO14, true}, {1200, IO14, false}},
+         {{600, IO14, G::GESTURE_LONG, 2}, {900, IO14, G::GESTURE_REPEAT, 2}, {1200, IO14, G::GESTURE_REPEAT, 2}}},
+        {"chord",
+         {{0, BOOT, true}, {100, IO14, true}, {300, BOOT, false}, {350, IO14, false}},
+         {{100, IO14, G::GESTURE_CHORD, 3}}},
+        {"chord held past long press",
+         {{0, IO14, true}, {150, BOOT, true}, {2000, IO14, false}, {2100, BOOT, false}},
+         {{150, BOOT, G::GESTURE_CHORD, 3}}},
+        {"presses too far apart",
+         {{0, BOOT, true}, {151, IO14, true}, {300, IO14, false}, {400, BOOT, false}},
+         {{300, IO14, G::GESTURE_SHORT, 2}, {650, BOOT, G::GESTURE_SHORT, 1}}},
+        {"taps interleaved",
+         {{0, BOOT, true}, {50, BOOT, false}, {200, IO14, true}, {260, IO14, false}, {280, BOOT, true},
+          {330, BOOT, false}},
+         {{260, IO14, G::GESTURE_SHORT, 2}, {330, BOOT, G::GESTURE_DOUBLE, 1}}},
+    };
+    // Uptime in ms wraps after 49.7 days; run everything across the wrap too
+    const uint32_t starts[] = {0, 1000, 0xFFFFFF00u};
+
+    int failures = 0;
+    for (const Script& s : scripts) {
+        uint32_t endMs = s.edges.back().atMs + 3000;
+        bool ok = true;
+        for (uint32_t start : starts) {
+            fired.clear();
+            runPolled(s, start, endMs);
+            std::vector<Fired> polled = fired;
+            fired.clear();
+            runSleeping(s, start, endMs);
+            if (!same(polled, s.expected) || !same(fired, s.expected)) {
+                if (ok) {
+                    printf("FAIL %s (start %u)\n", s.name, (unsigned)start);
+                    print("expected", s.expected);
+                    print("polled", polled);
+                    print("sleeping", fired);
+                }
+                ok = false;
+            }
+        }
+        if (ok) {
+            printf("ok   %s\n", s.name);
+        } else {
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
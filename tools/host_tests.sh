@@ -0,0 +1,31 @@
+#!/bin/sh
+# Builds and runs the host tests in tools/. Each one exits non-zero on a
+# failure; this stops at the first. Run from the repository root:
+#
+#   sh tools/host_tests.sh
+set -e
+out=${TMPDIR:-/tmp}/binclock-host-tests
+mkdir -p "$out"
+CXX=${CXX:-g++}
+FLAGS="-O2 -std=gnu++17 -Wall -Wextra -Isim -Isrc"
+
+run() {
+    name=$1
+    shift
+    echo "== $name"
+    $CXX $FLAGS "$@" -o "$out/$name"
+    "$out/$name"
+}
+
+run ntp_test tools/ntp_test.cpp src/NtpClient.cpp
+run sync_stats_test tools/sync_stats_test.cpp src/SyncStats.cpp
+run gesture_test tools/gesture_test.cpp src/GestureRecognizer.cpp
+run mirror_test tools/mirror_test.cpp src/MirrorEncoder.cpp src/DisplayMirror.cpp
+run ota_test tools/ota_test.cpp src/OtaUpdater.cpp src/Sha256.cpp src/HttpRequestParser.cpp
+run nmea_test tools/nmea_test.cpp src/NmeaParser.cpp
+run logger_test tools/logger_test.cpp src/Logger.cpp
+run logger_binary_test -DLOG_BINARY=1 tools/logger_test.cpp src/Logger.cpp
+run config_test tools/config_test.cpp src/ConfigStore.cpp src/ClockEncoding.cpp src/Logger.cpp
+run solar_test tools/solar_test.cpp src/SolarSchedule.cpp
+run http_load_test -pthread tools/http_load_test.cpp src/StatusServer.cpp src/HttpRequestParser.cpp
+run mqtt_load_test -pthread tools/mqtt_load_test.cpp src/MqttPublisher.cpp
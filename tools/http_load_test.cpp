@@ -0,0 +1,357 @@
+// StatusServer under load on Linux. The server runs in a loop like the
+// firmware's (poll() with HTTP_POLL_BUDGET_US, then a short wait) while
+// client threads hammer it at once:
+//
+//   status   GET /status, body checked
+//   metrics  GET /metrics, a streamed body several buffers long, checked
+//            byte for byte
+//   control  POST /control with the right token, a wrong one, none, and a
+//            bad parameter: 200, 403, 403, 400
+//   config   POST /config with the token, then GET /config
+//   slow     opens a connection and trickles a byte every 300 ms; must be
+//            dropped after HTTP_CLIENT_TIMEOUT_MS without starving the rest
+//   large    a request head over HTTP_MAX_REQUEST_HEAD: 431
+//   nul      a NUL byte in the request line, then in a header: 400
+//
+// Every response must be the expected one. Each client must get through,
+// and 99% of poll() calls must stay within a millisecond of the budget. Exits
+// non-zero on a failure. Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -pthread -Isim -Isrc -o http_load_test
+//       tools/http_load_test.cpp src/StatusServer.cpp src/HttpRequestParser.cpp
+//   ./http_load_test [seconds]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "StatusServer.h"
+
+static const char* const TOKEN = "s3cret-token";
+static const uint32_t METRIC_CHUNKS = 6;
+
+static std::atomic<bool> running(true);
+static std::atomic<int> clientsLeft(0);
+static std::atomic<uint32_t> commands(0);
+static uint16_t port = 0;
+
+// ==================== SERVER SIDE ====================
+static size_t writeStatus(char* buf, size_t cap) {
+    return (size_t)snprintf(buf, cap, "{\"ok\":true,\"commands\":%u}", (unsigned)commands.load());
+}
+
+static bool onCommand(const char* name, const char* value) {
+    if (strcmp(name, "digits") != 0 || (strcmp(value, "on") != 0 && strcmp(value, "off") != 0)) {
+        return false;
+    }
+    commands++;
+    return true;
+}
+
+static size_t writeConfig(char* buf, size_t cap) {
+    return (size_t)snprintf(buf, cap, "{\"fade_ms\":300}");
+}
+
+static bool onConfig(const char* name, const char* value) {
+    (void)value;
+    return strcmp(name, "fade_ms") == 0;
+}
+
+// Six 400-byte lines, the first in the first buffer after the headers
+static std::string metricLine(uint32_t i) {
+    std::string line = "metric_" + std::to_string(i) + " ";
+    line.append(400 - line.size() - 1, (char)('a' + i));
+    return line + "\n";
+}
+
+static size_t writeMetrics(char* buf, size_t cap, uint32_t& cursor) {
+    if (cursor >= METRIC_CHUNKS) {
+        return 0;
+    }
+    std::string line = metricLine(cursor);
+    if (line.size() > cap) {
+        return 0;
+    }
+    memcpy(buf, line.data(), line.size());
+    cursor++;
+    return line.size();
+}
+
+static uint32_t steadyMs() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ==================== CLIENT SIDE ====================
+struct Tally {
+    const char* name;
+    std::atomic<uint32_t> ok{0};
+    std::atomic<uint32_t> bad{0};
+};
+
+static int connectServer() {
+    // Eight clients for two slots and a backlog of two: Linux drops the SYNs
+    // that don't fit and the client resends after 1, 2, 4 s. Slow, not wrong.
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    timeval tv = {20, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One request on a fresh connection; returns the status code, 0 on failure
+static int request(const std::string& head, std::string& body) {
+    int fd = connectServer();
+    if (fd < 0) {
+        return 0;
+    }
+    if (send(fd, head.data(), head.size(), MSG_NOSIGNAL) != (ssize_t)head.size()) {
+        close(fd);
+        return 0;
+    }
+    std::string reply;
+    char buf[1024];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        reply.append(buf, (size_t)n);
+    }
+    close(fd);
+
+    size_t split = reply.find("\r\n\r\n");
+    int code = 0;
+    if (split == std::string::npos || sscanf(reply.c_str(), "HTTP/1.1 %d", &code) != 1) {
+        return 0;
+    }
+    body = reply.substr(split + 4);
+    return code;
+}
+
+static std::string get(const char* path) {
+    return std::string("GET ") + path + " HTTP/1.1\r\nHost: clock\r\n\r\n";
+}
+
+static std::string post(const std::string& path) {
+    return "POST " + path + " HTTP/1.1\r\nHost: clock\r\nContent-Length: 0\r\n\r\n";
+}
+
+static void expect(Tally& t, bool ok, const char* what, int code, const std::string& body) {
+    if (ok) {
+        t.ok++;
+        return;
+    }
+    if (t.bad++ < 3) {
+        printf("  %s: unexpected reply to %s: %d %.80s\n", t.name, what, code, body.c_str());
+    }
+}
+
+static void statusClient(Tally& t) {
+    while (running) {
+        std::string body;
+        int code = request(get("/status"), body);
+        expect(t, code == 200 && body.find("\"ok\":true") != std::string::npos, "GET /status", code, body);
+    }
+}
+
+static void metricsClient(Tally& t) {
+    std::string expected;
+    for (uint32_t i = 0; i < METRIC_CHUNKS; i++) {
+        expected += metricLine(i);
+    }
+    while (running) {
+        std::string body;
+        int code = request(get("/metrics"), body);
+        expect(t, code == 200 && body == expected, "GET /metrics", code, body);
+    }
+}
+
+static void controlClient(Tally& t) {
+    std::string token = std::string("&token=") + TOKEN;
+    while (running) {
+        std::string body;
+        int code = request(post("/control?digits=on" + token), body);
+        expect(t, code == 200 && body.find("\"commands\":") != std::string::npos, "control with token", code,
+               body);
+        code = request(post("/control?digits=off&token=s3cret-tokeN"), body);
+        expect(t, code == 403, "control with a wrong token", code, body);
+        code = request(post("/control?digits=off"), body);
+        expect(t, code == 403, "control without a token", code, body);
+        code = request(post("/control?brightness=9" + token), body);
+        expect(t, code == 400, "control with a bad parameter", code, body);
+    }
+}
+
+static void configClient(Tally& t) {
+    while (running) {
+        std::string body;
+        int code = request(post(std::string("/config?fade_ms=250&token=") + TOKEN), body);
+        expect(t, code == 200 && body == "{\"fade_ms\":300}", "POST /config", code, body);
+        code = request(post("/config?fade_ms=250"), body);
+        expect(t, code == 403, "POST /config without a token", code, body);
+        code = request(get("/config"), body);
+        expect(t, code == 200, "GET /config", code, body);
+    }
+}
+
+// Holds a slot by trickling a valid-looking head; the server must hang up.
+// The connection may wait in the listen backlog before the server's timer
+// starts, hence the slack on the upper bound. Runs at least once.
+static void slowClient(Tally& t) {
+    const char* head = "GET /status HTTP/1.1\r\nX-Slow: aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+    do {
+        int fd = connectServer();
+        if (fd < 0) {
+            continue;
+        }
+        uint32_t start = steadyMs();
+        bool dropped = false;
+        for (const char* p = head; *p; p++) {
+            if (send(fd, p, 1, MSG_NOSIGNAL) != 1) {
+                dropped = true;
+                break;
+            }
+            char c;
+            if (recv(fd, &c, 1, MSG_DONTWAIT) == 0) {
+                dropped = true;
+                break;
+            }
+            usleep(300000);
+        }
+        close(fd);
+        uint32_t heldMs = steadyMs() - start;
+        std::string none;
+        expect(t, dropped && heldMs >= HTTP_CLIENT_TIMEOUT_MS && heldMs < HTTP_CLIENT_TIMEOUT_MS + 5000,
+               "a trickled head", (int)heldMs, none);
+    } while (running);
+}
+
+static void largeClient(Tally& t) {
+    while (running) {
+        std::string head = "GET /status HTTP/1.1\r\nX-Pad: " + std::string(HTTP_MAX_REQUEST_HEAD, 'x') + "\r\n\r\n";
+        std::string body;
+        int code = request(head, body);
+        expect(t, code == 431, "an oversized head", code, body);
+        usleep(20000);
+    }
+}
+
+// A NUL ends the parser's string searches early; the head must still be
+// refused rather than walked past
+static void nulClient(Tally& t) {
+    static const char lineNul[] = "GET\0/status HTTP/1.1\r\nHost: clock\r\n\r\n";
+    static const char headerNul[] = "GET /status HTTP/1.1\r\nHost: cl\0ock\r\nX-A: b\r\n\r\n";
+    while (running) {
+        std::string body;
+        int code = request(std::string(lineNul, sizeof(lineNul) - 1), body);
+        expect(t, code == 400, "a NUL in the request line", code, body);
+        code = request(std::string(headerNul, sizeof(headerNul) - 1), body);
+        expect(t, code == 400, "a NUL in a header", code, body);
+        usleep(20000);
+    }
+}
+
+int main(int argc, char** argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 5;
+
+    StatusServer server;
+    server.setStatusWriter(writeStatus);
+    server.setCommandHandler(onCommand);
+    server.setMetricsWriter(writeMetrics);
+    server.setConfigHandlers(writeConfig, onConfig);
+    server.setWriteToken(TOKEN);
+    for (port = 18080; port < 18180 && !server.begin(port); port++) {
+    }
+    if (!server.listening()) {
+        printf("cannot listen\n");
+        return 1;
+    }
+
+    Tally tallies[7];
+    tallies[0].name = "status";
+    tallies[1].name = "metrics";
+    tallies[2].name = "control";
+    tallies[3].name = "config";
+    tallies[4].name = "slow";
+    tallies[5].name = "large";
+    tallies[6].name = "nul";
+    std::vector<std::thread> threads;
+    auto start = [&threads](void (*client)(Tally&), Tally& t) {
+        clientsLeft++;
+        threads.emplace_back([client, &t]() {
+            client(t);
+            clientsLeft--;
+        });
+    };
+    start(statusClient, tallies[0]);
+    start(statusClient, tallies[0]);
+    start(metricsClient, tallies[1]);
+    start(controlClient, tallies[2]);
+    start(configClient, tallies[3]);
+    start(slowClient, tallies[4]);
+    start(largeClient, tallies[5]);
+    start(nulClient, tallies[6]);
+
+    // The loop: poll with the firmware's budget, then wait a little
+    std::vector<uint32_t> pollUs;
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        auto before = std::chrono::steady_clock::now();
+        server.poll(steadyMs(), HTTP_POLL_BUDGET_US);
+        auto took = std::chrono::steady_clock::now() - before;
+        pollUs.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(took).count());
+        usleep(200);
+    }
+    running = false;
+    // Let the clients finish what they started
+    auto drain = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (clientsLeft > 0 && std::chrono::steady_clock::now() < drain) {
+        server.poll(steadyMs(), HTTP_POLL_BUDGET_US);
+        usleep(200);
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    server.end();
+
+    std::sort(pollUs.begin(), pollUs.end());
+    uint32_t p50 = pollUs[pollUs.size() / 2];
+    uint32_t p99 = pollUs[pollUs.size() * 99 / 100];
+    uint32_t max = pollUs.back();
+
+    int failures = 0;
+    uint32_t total = 0;
+    for (Tally& t : tallies) {
+        printf("%-8s %6u ok %4u unexpected\n", t.name, (unsigned)t.ok.load(), (unsigned)t.bad.load());
+        total += t.ok;
+        if (t.bad || t.ok == 0) {
+            failures++;
+        }
+    }
+    printf("\n%u requests in %d s (%.0f/s), %u served, %u rejected\n", (unsigned)total, seconds,
+           (double)total / seconds, (unsigned)server.getRequestsServed(), (unsigned)server.getRequestsRejected());
+    printf("poll()   %zu calls, p50 %u us, p99 %u us, max %u us (budget %u us)\n", pollUs.size(), (unsigned)p50,
+           (unsigned)p99, (unsigned)max, (unsigned)HTTP_POLL_BUDGET_US);
+    if (p99 > HTTP_POLL_BUDGET_US + 1000) {
+        printf("  poll() p99 over budget\n");
+        failures++;
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
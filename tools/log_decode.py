@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Decoder for the clock's binary log frames (LOG_BINARY 1, see src/Logger.h).
+
+Reads the serial stream, turns each frame back into the text line the clock
+would have printed itself, and passes anything else (boot ROM output, crash
+dumps, direct reports) through unchanged. Formats come from src/LogEvents.h,
+so decode with the same source tree the firmware was built from:
+
+    python3 tools/log_decode.py /dev/ttyACM0            # needs pyserial
+    python3 tools/log_decode.py capture.bin
+    cat /dev/ttyACM0 | python3 tools/log_decode.py -
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+MAGIC = 0xA5
+HEADER = struct.Struct("<BBI")  # event, words, time (us, low 32 bits)
+SPEC = re.compile(r"%([-+ 0#.1-9]*)([diuxXcsB%])")
+
+
+def load_formats(path):
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+    entries = re.findall(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', source)
+    if not entries:
+        raise SystemExit("no LOG_EVENTS entries found in %s" % path)
+    return [(name, bytes(fmt, "utf-8").decode("unicode_escape")) for name, fmt in entries]
+
+
+def render(fmt, args):
+    """Same rules as Logger::format(): 32-bit words, strings in place."""
+    state = {"word": 0}
+
+    def take_int():
+        w = state["word"]
+        state["word"] += 1
+        return args[w] if w < len(args) else 0
+
+    def take_text():
+        w = state["word"]
+        if w >= len(args):
+            return ""
+        raw = b"".join(struct.pack("<I", a) for a in args[w:])
+        end = raw.find(b"\0")
+        if end < 0:
+            state["word"] = len(args)
+            return ""
+        state["word"] += end // 4 + 1
+        return raw[:end].decode("utf-8", "replace")
+
+    def convert(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == "%":
+            return "%"
+        if conv == "s":
+            return ("%" + flags + "s") % take_text()
+        value = take_int()
+        if conv == "B":
+            return ("%" + flags + "s") % ("ON" if value else "OFF")
+        if conv in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            conv = "d"
+        elif conv == "c":
+            return ("%" + flags + "s") % chr(value & 0xFF)
+        return ("%" + flags + conv) % value
+
+    return SPEC.sub(convert, fmt)
+
+
+class Decoder:
+    def __init__(self, formats, out, live=False):
+        self.formats = formats
+        self.out = out
+        self.live = live
+        self.buf = bytearray()
+        self.last_time = 0
+        self.wraps = 0
+        self.anchor = None  # (device us, host us) of the first live frame
+        self.frames = 0
+        self.bad = 0
+
+    def timestamp(self, time_us):
+        if self.live:
+            # Frames arrive as they are logged: the host clock says roughly
+            # where the device clock is, even across a quiet hour
+            host_us = int(time.monotonic() * 1e6)
+            if self.anchor is None:
+                self.anchor = (time_us, host_us)
+            # (plus a second, so a frame that was quicker than the first
+            # one is not taken for one from a wrap ago)
+            device_us = self.anchor[0] + host_us - self.anchor[1] + 1000000
+            full = device_us - ((device_us - time_us) & 0xFFFFFFFF)
+        else:
+            # Capture file: count a big step back as a wrap of the 32-bit
+            # counter (misses wraps across gaps over 71 minutes)
+            if time_us < self.last_time and self.last_time - time_us > 0x80000000:
+                self.wraps += 1
+            self.last_time = time_us
+            full = (self.wraps << 32) | time_us
+        ms = full // 1000
+        return "[%5d.%03d] " % (ms // 1000, ms % 1000)
+
+    def feed(self, data):
+        self.buf += data
+        while self.buf:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                self.passthrough(len(self.buf))
+                return
+            if start > 0:
+                self.passthrough(start)
+                continue
+            if len(self.buf) < 1 + HEADER.size:
+                return
+            event, words, time_us = HEADER.unpack_from(self.buf, 1)
+            length = 1 + HEADER.size + words * 4 + 1
+            if event >= len(self.formats) or words > 64:
+                self.passthrough(1)
+                continue
+            if len(self.buf) < length:
+                return
+            if sum(self.buf[1:length - 1]) & 0xFF != self.buf[length - 1]:
+                self.bad += 1
+                self.passthrough(1)
+                continue
+            args = struct.unpack_from("<%dI" % words, self.buf, 1 + HEADER.size)
+            name, fmt = self.formats[event]
+            self.out.write(self.timestamp(time_us) + render(fmt, args) + "\n")
+            self.frames += 1
+            del self.buf[:length]
+        self.out.flush()
+
+    def passthrough(self, n):
+        self.out.write(self.buf[:n].decode("utf-8", "replace"))
+        del self.buf[:n]
+
+
+def open_input(path, baud):
+    if path == "-":
+        return sys.stdin.buffer
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        try:
+            import serial
+        except ImportError:
+            raise SystemExit("reading a serial port needs pyserial (pip install pyserial)")
+        return serial.Serial(path, baud, timeout=0.1)
+    return open(path, "rb")
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="serial port, capture file, or - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--events", default=os.path.join(here, "..", "src", "LogEvents.h"))
+    args = parser.parse_args()
+
+    stream = open_input(args.input, args.baud)
+    decoder = Decoder(load_formats(args.events), sys.stdout, live=args.input == "-" or hasattr(stream, "port"))
+    try:
+        while True:
+            data = stream.read(4096)
+            if data is None:
+                continue
+            if not data:
+                if hasattr(stream, "port"):
+                    continue  # Serial read timeout
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    print("%d frames, %d bad checksums" % (decoder.frames, decoder.bad), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,298 @@
+// Logger on a fake esp_timer, drained by hand (the drain task is never
+// started). Built twice by tools/host_tests.sh: with LOG_BINARY 0 the text
+// lines are read back, timestamp included; with LOG_BINARY 1 the frames
+// are checked (magic, length, checksum) and rendered with Logger::format(),
+// as tools/log_decode.py does. Either way the text must equal the format
+// filled in by snprintf(), with %B, strings cut to the words left in the
+// record, drop reports after a full ring, and times across the 32-bit
+// microsecond wrap. Exits non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc [-DLOG_BINARY=1] -o logger_test
+//       tools/logger_test.cpp src/Logger.cpp
+//   ./logger_test
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include "Logger.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+// ==================== Platform ====================
+static int64_t nowUs = 1000000;
+
+EspClass ESP;
+HardwareSerial Serial;
+
+uint32_t EspClass::getCycleCount() { return (uint32_t)nowUs; }
+int64_t esp_timer_get_time() { return nowUs; }
+unsigned long millis() { return (unsigned long)(nowUs / 1000); }
+void delay(unsigned long ms) { nowUs += (int64_t)ms * 1000; }
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, UBaseType_t,
+                                   TaskHandle_t*, BaseType_t) {
+    return pdPASS;
+}
+void vTaskDelay(TickType_t) {}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return n > 0 ? write((const uint8_t*)buf, strnlen(buf, sizeof(buf))) : 0;
+}
+
+void HardwareSerial::flush() {}
+size_t HardwareSerial::write(uint8_t) { return 1; }
+size_t HardwareSerial::write(const uint8_t*, size_t size) { return size; }
+
+struct Capture : Print {
+    std::string bytes;
+    size_t write(uint8_t c) override {
+        bytes += (char)c;
+        return 1;
+    }
+    using Print::write;
+};
+
+// ==================== Reading the output back ====================
+struct Line {
+    uint64_t ms;      // Text: the printed timestamp; binary: the frame's low 32 bits / 1000
+    uint32_t timeUs;  // Binary only
+    std::string text;
+};
+
+static std::vector<Line> drainLines() {
+    Capture out;
+    logger.drain(out);
+    std::vector<Line> lines;
+    const std::string& b = out.bytes;
+#if LOG_BINARY
+    size_t at = 0;
+    while (at < b.size()) {
+        if ((uint8_t)b[at] != 0xA5 || at + 8 > b.size()) {
+            CHECK(false, "no frame at byte %zu", at);
+            break;
+        }
+        Logger::Record record;
+        memset(&record, 0, sizeof(record));
+        record.event = (uint8_t)b[at + 1];
+        record.words = (uint8_t)b[at + 2];
+        size_t len = 7 + (size_t)record.words * 4;
+        if (record.words > LOG_MAX_WORDS || at + len + 1 > b.size()) {
+            CHECK(false, "frame at byte %zu: %u words", at, record.words);
+            break;
+        }
+        memcpy(&record.timeUs, &b[at + 3], 4);
+        memcpy(record.args, &b[at + 7], (size_t)record.words * 4);
+        uint8_t sum = 0;
+        for (size_t i = at + 1; i < at + len; i++) {
+            sum += (uint8_t)b[i];
+        }
+        CHECK(sum == (uint8_t)b[at + len], "frame at byte %zu: checksum", at);
+
+        char text[160];
+        Logger::format(text, sizeof(text), record);
+        lines.push_back({record.timeUs / 1000, record.timeUs, text});
+        at += len + 1;
+    }
+#else
+    size_t at = 0;
+    while (at < b.size()) {
+        size_t eol = b.find('\n', at);
+        if (eol == std::string::npos) {
+            CHECK(false, "unterminated line at byte %zu", at);
+            break;
+        }
+        std::string line = b.substr(at, eol - at);
+        unsigned long s, ms;
+        int prefix = 0;
+        if (sscanf(line.c_str(), "[%lu.%lu] %n", &s, &ms, &prefix) != 2 || prefix == 0) {
+            CHECK(false, "no timestamp: \"%s\"", line.c_str());
+        } else {
+            lines.push_back({(uint64_t)s * 1000 + ms, 0, line.substr((size_t)prefix)});
+        }
+        at = eol + 1;
+    }
+#endif
+    return lines;
+}
+
+static std::string expected(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static std::string expected(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return buf;
+}
+
+static void expectLines(const char* what, const std::vector<std::string>& want) {
+    std::vector<Line> got = drainLines();
+    CHECK(got.size() == want.size(), "%s: %zu lines, want %zu", what, got.size(), want.size());
+    for (size_t i = 0; i < got.size() && i < want.size(); i++) {
+        CHECK(got[i].text == want[i], "%s: line %zu \"%s\", want \"%s\"", what, i, got[i].text.c_str(),
+              want[i].c_str());
+    }
+}
+
+// ==================== Cases ====================
+static void testFormats() {
+    printf("formats\n");
+    LOG_EVENT(BOOT);
+    LOG_EVENT(WIFI_FAST, 6u, 0xA4u, 0xCFu, 0x12u, 0x0u, 0x9u, 0xFFu);
+    LOG_EVENT(SYNC_REPORT, -1234, 5678u, 90u, 17u, 2u, 0u);
+    LOG_EVENT(GPS_READY, 18, -1, 9600u);
+    LOG_EVENT(TIMER_LAP, 3u, 61u, 7u, 125u, 40u);
+    LOG_EVENT(WIFI_CONNECTED, 192u, 168u, 1u, 42u);
+    LOG_EVENT(AUTO_BRIGHTNESS, true);
+    LOG_EVENT(NIGHT_MODE, false);
+    LOG_EVENT(TIME_DISPLAY, 7);
+    LOG_EVENT(SYNC_STEPPED, '-', 1773000000u, 4521u, 14970u, 0u, 1u, 0u, 0u);
+    expectLines("formats", {
+        "=== Binary Clock (Optimized) ===",
+        expected(Logger::FORMATS[LOG_WIFI_FAST], 6u, 0xA4u, 0xCFu, 0x12u, 0x0u, 0x9u, 0xFFu),
+        expected(Logger::FORMATS[LOG_SYNC_REPORT], -1234, 5678u, 90u, 17u, 2u, 0u),
+        expected(Logger::FORMATS[LOG_GPS_READY], 18, -1, 9600u),
+        expected(Logger::FORMATS[LOG_TIMER_LAP], 3u, 61u, 7u, 125u, 40u),
+        "WiFi connected, IP 192.168.1.42",
+        "Auto brightness: ON",
+        "Night panel mode: OFF",
+        "Time display: ON",
+        "Sync: stepped -1773000000.004521 s, delay 14970 us, jitter 0 us, ok 1, failed 0 (0 in a row)",
+    });
+    CHECK(expected(Logger::FORMATS[LOG_WIFI_FAST], 6u, 0xA4u, 0xCFu, 0x12u, 0x0u, 0x9u, 0xFFu) ==
+              "WiFi fast reconnect (ch 6, A4:CF:12:00:09:FF)",
+          "snprintf disagrees with itself");
+}
+
+static void testStrings() {
+    printf("strings\n");
+    // LOG_MAX_WORDS words of room: a string takes its length plus the NUL,
+    // rounded up to whole words, and is cut to what is left
+    static_assert(LOG_MAX_WORDS == 8, "Expectations below assume 32 bytes of arguments");
+    const std::string long40(40, 'n');
+    const std::string name27(27, 'k');
+    const std::string exact32(32, 'x');
+    LOG_EVENT(HTTP_CONTROL, "digits", "on");
+    LOG_EVENT(HTTP_CONTROL, name27.c_str(), "toggle");
+    LOG_EVENT(HTTP_CONTROL, long40.c_str(), "on");
+    LOG_EVENT(HTTP_CONTROL, exact32.c_str(), "on");
+    LOG_EVENT(HTTP_CONTROL, "", "");
+    LOG_EVENT(MIRROR_READY, "192.168.1.10", 5005u);
+    LOG_EVENT(GPS_SYNCED, "pps", 61u);
+    expectLines("strings", {
+        "HTTP control: digits=on",
+        "HTTP control: " + name27 + "=tog",
+        "HTTP control: " + long40.substr(0, 31) + "=",
+        "HTTP control: " + exact32.substr(0, 31) + "=",
+        "HTTP control: =",
+        "Mirror ready for 192.168.1.10:5005",
+        "GPS sync via pps, 61 seconds seen",
+    });
+
+    // Damaged records, rendered without reading past them
+    Logger::Record r;
+    memset(&r, 0x41, sizeof(r));
+    r.event = LOG_TIMER_MODE;
+    r.words = 2;  // "AAAAAAAA" and no NUL
+    char buf[64];
+    Logger::format(buf, sizeof(buf), r);
+    CHECK(strcmp(buf, "Timer: ") == 0, "unterminated string: \"%s\"", buf);
+    r.words = 200;
+    r.args[LOG_MAX_WORDS - 1] = 0;
+    Logger::format(buf, sizeof(buf), r);
+    CHECK(strcmp(buf, ("Timer: " + std::string(LOG_MAX_WORDS * 4 - 4, 'A')).c_str()) == 0,
+          "word count past the record: \"%s\"", buf);
+    r.event = 200;
+    Logger::format(buf, sizeof(buf), r);
+    CHECK(strcmp(buf, "Unknown log event 200") == 0, "unknown event: \"%s\"", buf);
+
+    // Output cut to the buffer, always terminated
+    r.event = LOG_BOOT;
+    size_t n = Logger::format(buf, 10, r);
+    CHECK(n == 9 && strcmp(buf, "=== Binar") == 0, "cut to 10: %zu \"%s\"", n, buf);
+}
+
+static void testDrops() {
+    printf("drops\n");
+    uint32_t droppedBefore = logger.getDropped();
+    for (uint32_t i = 0; i < LOG_RING_RECORDS + 5; i++) {
+        LOG_EVENT(CONFIG_SAVED, i);
+    }
+    CHECK(logger.getDropped() - droppedBefore == 5, "%u dropped", logger.getDropped() - droppedBefore);
+
+    std::vector<std::string> want;
+    for (uint32_t i = 0; i < LOG_RING_RECORDS; i++) {
+        want.push_back(expected(Logger::FORMATS[LOG_CONFIG_SAVED], i));
+    }
+    want.push_back("Log: 5 records dropped");
+    expectLines("full ring", want);
+    expectLines("after the report", {});
+
+    // Room again once drained
+    LOG_EVENT(FORCE_RESYNC);
+    expectLines("drained", {"Forcing NTP resync"});
+    CHECK(logger.getDropped() - droppedBefore == 5, "%u dropped", logger.getDropped() - droppedBefore);
+}
+
+static void testTimes() {
+    printf("times\n");
+    // Logged just before the 32-bit microsecond wrap (4294.967 s), drained
+    // after it; then a record an hour later, drained at once; then one
+    // drained 70 minutes after it was logged
+    const int64_t WRAP_US = 1LL << 32;
+    const int64_t logged[] = {WRAP_US - 700000, WRAP_US + 3600LL * 1000000 + 250000,
+                              3 * WRAP_US + 123456};
+    const int64_t drained[] = {WRAP_US + 500000, logged[1] + 1000, logged[2] + 70LL * 60 * 1000000};
+    for (size_t i = 0; i < 3; i++) {
+        nowUs = logged[i];
+        LOG_EVENT(FORCE_RESYNC);
+        nowUs = drained[i];
+        std::vector<Line> lines = drainLines();
+        CHECK(lines.size() == 1, "record %zu: %zu lines", i, lines.size());
+        if (lines.size() != 1) {
+            continue;
+        }
+#if LOG_BINARY
+        CHECK(lines[0].timeUs == (uint32_t)logged[i], "record %zu: frame time %u", i, lines[0].timeUs);
+#else
+        CHECK(lines[0].ms == (uint64_t)logged[i] / 1000, "record %zu: printed %llu ms, logged at %llu", i,
+              (unsigned long long)lines[0].ms, (unsigned long long)logged[i] / 1000);
+#endif
+    }
+}
+
+int main() {
+    printf("LOG_BINARY %d\n", LOG_BINARY);
+    testFormats();
+    testStrings();
+    testDrops();
+    testTimes();
+    printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+    return failures ? 1 : 0;
+}
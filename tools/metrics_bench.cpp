@@ -0,0 +1,146 @@
+// Cost of the /metrics serializer and of the update calls, with the same
+// registry main.cpp defines. "scrape" is one full Metric::serialize() pass
+// in HTTP_RESPONSE_SIZE chunks, the way StatusServer streams it; "one
+// buffer" is the same into a buffer large enough for everything. The
+// chunked text must match the single buffer byte for byte. observe() and
+// add() are timed alone and with a second thread updating the same metric,
+// as the render and button tasks do. Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -pthread -Isim -Isrc tools/metrics_bench.cpp src/Metrics.cpp -o metrics_bench
+//   ./metrics_bench [scrapes]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "Metrics.h"
+#include "config.h"
+
+static Histogram loopPeriodMetric("binclock_loop_period_seconds", nullptr,
+                                  "Time between starts of consecutive main loop passes",
+                                  1e-6, METRICS_LOOP_BOUNDS_US);
+static Histogram drawTimeMetric("binclock_draw_clock_seconds", nullptr,
+                                "Time spent in drawClock() or drawWorld()", 1e-6, METRICS_DRAW_BOUNDS_US);
+static Counter pixelsMetric("binclock_pixels_pushed_total", nullptr,
+                            "Pixels written to the panel");
+static Counter dotsMetric("binclock_dots_drawn_total", nullptr,
+                          "Clock dots repainted (only changed bits are)");
+static Counter timerFramesMetric("binclock_timer_frames_total", nullptr,
+                                 "Stopwatch/countdown frames drawn");
+static Gauge freeHeapMetric("binclock_free_heap_bytes", nullptr, "Free heap");
+static Gauge rssiMetric("binclock_wifi_rssi_dbm", nullptr, "WiFi signal strength");
+static Gauge ntpOffsetMetric("binclock_ntp_offset_seconds", nullptr,
+                             "Clock offset slewed away by the last NTP or GPS sync that did not step", 1e-6);
+static Counter ntpStepsMetric("binclock_ntp_steps_total", nullptr,
+                              "NTP or GPS syncs that stepped the clock, the offset too large to slew");
+static Counter bootButtonMetric("binclock_button_events_total", "button=\"boot\"",
+                                "Button gestures handled");
+static Counter io14ButtonMetric("binclock_button_events_total", "button=\"io14\"",
+                                "Button gestures handled");
+
+template <typename Fn>
+static double nsPerCall(size_t calls, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double)calls;
+}
+
+// One full exposition in chunks of `cap`, appended to out if given
+static size_t scrape(char* buf, size_t cap, std::string* out) {
+    uint32_t cursor = 0;
+    size_t total = 0;
+    size_t n;
+    while ((n = Metric::serialize(buf, cap, cursor)) > 0) {
+        if (out) {
+            out->append(buf, n);
+        }
+        total += n;
+    }
+    return total;
+}
+
+// Updates timed on this thread, optionally against a second one hammering
+// the same metric
+template <typename Fn>
+static double contended(size_t calls, bool withOther, Fn fn) {
+    std::atomic<bool> stop(false);
+    std::thread other;
+    if (withOther) {
+        other = std::thread([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                fn(7);
+            }
+        });
+    }
+    double ns = nsPerCall(calls, [&] {
+        for (size_t i = 0; i < calls; i++) {
+            fn((uint32_t)i);
+        }
+    });
+    if (withOther) {
+        stop = true;
+        other.join();
+    }
+    return ns;
+}
+
+int main(int argc, char** argv) {
+    size_t scrapes = argc > 1 ? (size_t)atol(argv[1]) : 20000;
+
+    // Non-trivial values, so every bucket and the scaled gauges format digits
+    for (uint32_t i = 0; i < 100000; i++) {
+        loopPeriodMetric.observe(8000 + (i * 7919) % 400000);
+        drawTimeMetric.observe(200 + (i * 104729) % 40000);
+    }
+    pixelsMetric.add(123456789);
+    dotsMetric.add(4242);
+    timerFramesMetric.add(99);
+    freeHeapMetric.set(187344);
+    rssiMetric.set(-61);
+    ntpOffsetMetric.set(-1834);
+    bootButtonMetric.add(17);
+    io14ButtonMetric.add(5);
+
+    static char chunk[HTTP_RESPONSE_SIZE];
+    static char whole[16384];
+    std::string chunked;
+    size_t bytes = scrape(chunk, sizeof(chunk), &chunked);
+    std::string single;
+    scrape(whole, sizeof(whole), &single);
+    printf("%zu bytes per scrape, %zu-byte chunks\n", bytes, sizeof(chunk));
+    if (chunked != single) {
+        printf("chunked output differs from one buffer\n");
+        return 1;
+    }
+
+    size_t sink = 0;
+    double chunkedNs = nsPerCall(scrapes, [&] {
+        for (size_t i = 0; i < scrapes; i++) {
+            sink += scrape(chunk, sizeof(chunk), nullptr);
+        }
+    });
+    double wholeNs = nsPerCall(scrapes, [&] {
+        for (size_t i = 0; i < scrapes; i++) {
+            sink += scrape(whole, sizeof(whole), nullptr);
+        }
+    });
+    printf("scrape      %8.2f us  (%.1f ns/byte)\n", chunkedNs / 1000, chunkedNs / (double)bytes);
+    printf("one buffer  %8.2f us\n\n", wholeNs / 1000);
+
+    const size_t calls = 20000000;
+    printf("              alone    contended\n");
+    auto observe = [](uint32_t v) { loopPeriodMetric.observe(v * 13 % 600000); };
+    auto add = [](uint32_t v) { pixelsMetric.add(v & 0xFF); };
+    auto set = [](uint32_t v) { freeHeapMetric.set((int32_t)v); };
+    printf("observe()  %7.2f ns %9.2f ns\n", contended(calls, false, observe), contended(calls, true, observe));
+    printf("add()      %7.2f ns %9.2f ns\n", contended(calls, false, add), contended(calls, true, add));
+    printf("set()      %7.2f ns %9.2f ns\n", contended(calls, false, set), contended(calls, true, set));
+    if (sink == 0) {
+        printf("?");
+    }
+    return 0;
+}
@@ -0,0 +1,336 @@
+// MirrorEncoder and DisplayMirror round trips. A decoder with the same
+// rules as tools/mirror_viewer.py patches every datagram into a viewer copy
+// of the screen, which must then match the canvas pixel for pixel:
+//
+//   encoder  a canvas full of runs, noise and run/literal boundary cases
+//            is changed in random rects (some off-screen, more than
+//            MIRROR_MAX_RECTS at a time so they merge). Every change is
+//            reported as damage and encoded at a range of datagram sizes.
+//   mirror   DisplayMirror sends over loopback UDP on a virtual clock.
+//            The first sync must finish, later damage must arrive, and
+//            the bytes sent must stay within MIRROR_RATE_BYTES_PER_S. With
+//            one in ten dropped at random, the refresh sweep must still
+//            bring the viewer back in step.
+//
+// The decoder also rejects any datagram with a bad header, a run crossing
+// a row, or bytes left over. Exits non-zero on a failure. Builds on the
+// host:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc -o mirror_test
+//       tools/mirror_test.cpp src/MirrorEncoder.cpp src/DisplayMirror.cpp
+//   ./mirror_test
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <vector>
+#include "DisplayMirror.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static const size_t PIXELS = (size_t)SCREEN_W * SCREEN_H;
+
+static uint32_t rng = 2024;
+static uint32_t nextRandom(uint32_t range) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % range;
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// The viewer's side of the protocol
+struct Viewer {
+    std::vector<uint16_t> pixels;
+    uint32_t datagrams = 0;
+    uint32_t bad = 0;
+    uint32_t lost = 0;
+    bool anySeq = false;
+    uint16_t lastSeq = 0;
+
+    Viewer() : pixels(PIXELS, 0) {}
+
+    bool apply(const uint8_t* data, size_t len) {
+        if (len < MirrorEncoder::HEADER_SIZE || data[0] != 'B' || data[1] != 'M' ||
+            data[2] != MirrorEncoder::VERSION || data[3] != 0) {
+            bad++;
+            return false;
+        }
+        uint16_t seq = getU16(data + 4);
+        uint16_t sw = getU16(data + 6);
+        uint16_t sh = getU16(data + 8);
+        uint16_t x = getU16(data + 10);
+        uint16_t y = getU16(data + 12);
+        uint16_t w = getU16(data + 14);
+        uint16_t h = getU16(data + 16);
+        if (sw != SCREEN_W || sh != SCREEN_H || w == 0 || h == 0 || x + w > sw || y + h > sh) {
+            bad++;
+            return false;
+        }
+        if (anySeq) {
+            lost += (uint16_t)(seq - lastSeq - 1);
+        }
+        anySeq = true;
+        lastSeq = seq;
+
+        size_t pos = MirrorEncoder::HEADER_SIZE;
+        for (uint16_t row = y; row < y + h; row++) {
+            uint16_t* out = &pixels[(size_t)row * sw + x];
+            uint16_t left = w;
+            while (left > 0) {
+                if (pos >= len) {
+                    bad++;
+                    return false;
+                }
+                uint8_t c = data[pos++];
+                uint16_t n = c < 0x80 ? (uint16_t)(c + 1) : (uint16_t)(c - 0x80 + 2);
+                size_t bytes = c < 0x80 ? (size_t)n * 2 : 2;
+                if (n > left || pos + bytes > len) {
+                    bad++;  // Run crosses the row, or the datagram ends early
+                    return false;
+                }
+                for (uint16_t i = 0; i < n; i++) {
+                    memcpy(out + i, data + pos + (c < 0x80 ? (size_t)i * 2 : 0), 2);
+                }
+                pos += bytes;
+                out += n;
+                left -= n;
+            }
+        }
+        if (pos != len) {
+            bad++;
+            return false;
+        }
+        datagrams++;
+        return true;
+    }
+};
+
+static size_t differing(const std::vector<uint16_t>& a, const uint16_t* b) {
+    size_t n = 0;
+    for (size_t i = 0; i < PIXELS; i++) {
+        n += a[i] != b[i];
+    }
+    return n;
+}
+
+// Paints a rect with one of the patterns the encoder has to get right
+static void paint(uint16_t* canvas, int x, int y, int w, int h, uint32_t pattern) {
+    uint16_t base = (uint16_t)nextRandom(0x10000);
+    for (int row = y; row < y + h; row++) {
+        for (int col = x; col < x + w; col++) {
+            if (row < 0 || col < 0 || row >= SCREEN_H || col >= SCREEN_W) {
+                continue;
+            }
+            uint16_t v;
+            switch (pattern % 6) {
+                case 0: v = base; break;                                        // Solid: long runs
+                case 1: v = (uint16_t)nextRandom(0x10000); break;              // Noise: literals
+                case 2: v = (uint16_t)(base + (col / 2)); break;                // Pairs: runs of 2
+                case 3: v = (uint16_t)(base + (col % 131 < 129 ? 0 : col)); break;  // 129-pixel runs
+                case 4: v = (uint16_t)(base + col * (col % 130 < 128)); break;  // 128-literal edges
+                default: v = (uint16_t)(base + (nextRandom(4) == 0 ? 1 : 0)); break;  // Mostly runs
+            }
+            canvas[(size_t)row * SCREEN_W + col] = v;
+        }
+    }
+}
+
+static void encoderRoundTrip() {
+    static uint16_t canvas[PIXELS];
+    static uint8_t datagram[4096];
+    const size_t minCapacity = MirrorEncoder::HEADER_SIZE + MirrorEncoder::rowBound(SCREEN_W);
+    const size_t capacities[] = {minCapacity, MIRROR_DATAGRAM_SIZE, 1500, sizeof(datagram)};
+
+    MirrorEncoder encoder(SCREEN_W, SCREEN_H);
+    Viewer viewer;
+    memcpy(viewer.pixels.data(), canvas, sizeof(canvas));  // Both start black
+
+    uint32_t datagrams = 0;
+    size_t encodedBytes = 0;
+    size_t changedPixels = 0;
+    uint16_t expectSeq = 0;
+    for (uint32_t round = 0; round < 400; round++) {
+        uint32_t rects = 1 + nextRandom(round % 10 == 0 ? 40 : 6);
+        for (uint32_t r = 0; r < rects; r++) {
+            int w = 1 + (int)nextRandom(r % 3 == 0 ? SCREEN_W + 40 : 60);
+            int h = 1 + (int)nextRandom(r % 3 == 0 ? SCREEN_H : 30);
+            int x = (int)nextRandom(SCREEN_W + 20) - 20;
+            int y = (int)nextRandom(SCREEN_H + 20) - 20;
+            paint(canvas, x, y, w, h, nextRandom(6));
+            encoder.addDamage((int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h);
+            changedPixels += (size_t)w * h;
+        }
+        CHECK(encoder.rectCount() <= MIRROR_MAX_RECTS, "%u rects", (unsigned)encoder.rectCount());
+
+        size_t capacity = capacities[round % 4];
+        size_t length;
+        MirrorEncoder::Rect strip;
+        while ((length = encoder.encode(canvas, datagram, capacity, &strip)) > 0) {
+            CHECK(length <= capacity, "datagram %zu > %zu", length, capacity);
+            CHECK(getU16(datagram + 4) == expectSeq, "sequence %u, expected %u", getU16(datagram + 4),
+                  (unsigned)expectSeq);
+            CHECK(strip.x == getU16(datagram + 10) && strip.y == getU16(datagram + 12) &&
+                      strip.w == getU16(datagram + 14) && strip.h == getU16(datagram + 16),
+                  "strip out of step with the header");
+            CHECK(length - MirrorEncoder::HEADER_SIZE <= MirrorEncoder::rowBound(strip.w) * strip.h,
+                  "%zu bytes for %ux%u", length, strip.w, strip.h);
+            CHECK(viewer.apply(datagram, length), "round %u: datagram rejected", (unsigned)round);
+            expectSeq++;
+            datagrams++;
+            encodedBytes += length;
+        }
+        CHECK(!encoder.pending(), "damage left after encode() returned 0");
+        size_t diff = differing(viewer.pixels, canvas);
+        CHECK(diff == 0, "round %u: %zu pixels differ", (unsigned)round, diff);
+        if (diff) {
+            break;
+        }
+    }
+    printf("encoder   %u datagrams, %zu bytes for %zu damaged pixels (%.2f bytes/pixel)\n",
+           (unsigned)datagrams, encodedBytes, changedPixels, (double)encodedBytes / (double)changedPixels);
+
+    // A datagram too small for one row encodes nothing and loses nothing
+    encoder.addDamage(0, 0, SCREEN_W, 1);
+    CHECK(encoder.encode(canvas, datagram, minCapacity - 1) == 0 && encoder.pending(), "undersized datagram");
+    CHECK(encoder.encode(canvas, datagram, minCapacity) > 0 && !encoder.pending(), "minimum datagram");
+}
+
+// Loopback receiver for DisplayMirror; drain() throws away dropPercent of
+// the datagrams at random (a fixed period could line up with the refresh
+// sweep and lose the same band every time)
+struct Link {
+    int rx;
+    uint16_t port;
+    uint32_t received = 0;
+    uint32_t dropped = 0;
+    size_t bytes = 0;
+
+    Link() {
+        rx = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        int big = 1 << 22;
+        setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &big, sizeof(big));
+        bind(rx, (sockaddr*)&addr, sizeof(addr));
+        getsockname(rx, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+    }
+    ~Link() { close(rx); }
+
+    void drain(Viewer& viewer, uint32_t dropPercent) {
+        uint8_t buf[2048];
+        ssize_t n;
+        while ((n = recv(rx, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            received++;
+            bytes += (size_t)n;
+            if (nextRandom(100) < dropPercent) {
+                dropped++;
+                continue;
+            }
+            CHECK(viewer.apply(buf, (size_t)n), "mirror datagram rejected");
+        }
+    }
+};
+
+// Updates every 5 virtual ms until the viewer matches the canvas; false if
+// it doesn't within limitMs. tookMs is the virtual time it took.
+static bool runUntilSynced(DisplayMirror& mirror, Link& link, Viewer& viewer, const uint16_t* canvas,
+                           uint32_t& nowMs, uint32_t limitMs, uint32_t dropPercent, uint32_t& tookMs) {
+    uint32_t start = nowMs;
+    for (; nowMs - start < limitMs; nowMs += 5) {
+        mirror.update(nowMs);
+        link.drain(viewer, dropPercent);
+        if (differing(viewer.pixels, canvas) == 0) {
+            tookMs = nowMs - start;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void mirrorRoundTrip() {
+    // Mostly flat like the clock face. A screen of pure noise would not
+    // work: the refresh sweep alone would need more than
+    // MIRROR_RATE_BYTES_PER_S, and damage would wait behind it.
+    static uint16_t canvas[PIXELS];
+    paint(canvas, 0, 0, SCREEN_W, SCREEN_H, 0);
+    paint(canvas, 20, 20, 200, 100, 5);
+    paint(canvas, 100, 0, 50, SCREEN_H, 3);
+    paint(canvas, 240, 100, 60, 40, 1);
+
+    Link link;
+    Viewer viewer;
+    DisplayMirror mirror;
+    CHECK(mirror.begin("127.0.0.1", link.port, canvas), "begin");
+    mirror.setEnabled(true);
+
+    // First sync: the whole noisy screen through the token bucket
+    uint32_t nowMs = 100000;
+    uint32_t firstSync = 0;
+    bool synced = runUntilSynced(mirror, link, viewer, canvas, nowMs, 20000, 0, firstSync);
+    double budget = MIRROR_BURST_BYTES + (double)MIRROR_RATE_BYTES_PER_S * (firstSync + 5) / 1000.0;
+    double wire = (double)link.bytes + 28.0 * link.received;
+    CHECK(synced, "first sync never completed, %zu pixels differ", differing(viewer.pixels, canvas));
+    CHECK(wire <= budget, "%.0f bytes on the wire, %.0f allowed", wire, budget);
+    CHECK(viewer.bad == 0 && viewer.lost == 0, "bad %u lost %u", (unsigned)viewer.bad, (unsigned)viewer.lost);
+    printf("mirror    first sync %u ms, %u datagrams, %.0f of %.0f bytes allowed, %u throttled passes\n",
+           (unsigned)firstSync, (unsigned)link.received, wire, budget, (unsigned)mirror.getThrottled());
+
+    // Clock-sized changes, reported the way BinaryClockDisplay does
+    for (int i = 0; i < 20; i++) {
+        int x = (int)nextRandom(SCREEN_W - 30);
+        int y = (int)nextRandom(SCREEN_H - 30);
+        paint(canvas, x, y, 24, 24, nextRandom(6));
+        mirror.addDamage((int16_t)x, (int16_t)y, 24, 24);
+        uint32_t took;
+        CHECK(runUntilSynced(mirror, link, viewer, canvas, nowMs, 1000, 0, took), "change %d never arrived", i);
+    }
+    printf("mirror    20 damage rects delivered\n");
+
+    // Lossy: changes arrive or are healed by the refresh sweep, which
+    // covers the screen every SCREEN_H / MIRROR_REFRESH_ROWS steps. A band
+    // lost again on the next sweep waits for the one after, so allow a few.
+    const uint32_t sweepMs = (SCREEN_H / MIRROR_REFRESH_ROWS + 1) * MIRROR_REFRESH_INTERVAL_MS;
+    uint32_t worst = 0;
+    for (int i = 0; i < 10; i++) {
+        int x = (int)nextRandom(SCREEN_W - 100);
+        int y = (int)nextRandom(SCREEN_H - 60);
+        paint(canvas, x, y, 100, 60, nextRandom(6));
+        mirror.addDamage((int16_t)x, (int16_t)y, 100, 60);
+        uint32_t took = 0;
+        CHECK(runUntilSynced(mirror, link, viewer, canvas, nowMs, 5 * sweepMs, 10, took),
+              "lossy change %d never healed", i);
+        worst = took > worst ? took : worst;
+    }
+    CHECK(link.dropped > 0, "nothing dropped");
+    printf("mirror    %u datagrams dropped, healed within %u ms (sweep %u ms)\n", (unsigned)link.dropped,
+           (unsigned)worst, (unsigned)sweepMs);
+    CHECK(mirror.getSendErrors() == 0, "%u send errors", (unsigned)mirror.getSendErrors());
+    CHECK(viewer.bad == 0, "%u bad datagrams", (unsigned)viewer.bad);
+    mirror.end();
+}
+
+int main() {
+    encoderRoundTrip();
+    mirrorRoundTrip();
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
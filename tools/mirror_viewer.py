@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Live viewer for the clock's display mirror (see src/MirrorEncoder.h).
+
+Listens for mirror datagrams, patches each strip into a local copy of the
+screen and shows it in a Tk window. With --dump the screen is written as a
+PPM instead (no display needed), e.g. for loopback tests:
+
+    python3 tools/mirror_viewer.py                    # window, port 5005
+    python3 tools/mirror_viewer.py --scale 3
+    python3 tools/mirror_viewer.py --dump screen.ppm --seconds 5
+
+Then enable mirroring on the clock: curl -X POST "http://<ip>/control?mirror=on"
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+HEADER = struct.Struct("<2sBBHHHHHHH")
+
+
+class Screen:
+    def __init__(self):
+        self.width = 0
+        self.height = 0
+        self.pixels = bytearray()  # Big-endian RGB565, as sent
+        self.datagrams = 0
+        self.lost = 0
+        self.bad = 0
+        self.last_seq = None
+
+    def apply(self, data):
+        if len(data) < HEADER.size:
+            self.bad += 1
+            return False
+        magic, version, _flags, seq, sw, sh, x, y, w, h = HEADER.unpack_from(data)
+        if magic != b"BM" or version != 1 or x + w > sw or y + h > sh:
+            self.bad += 1
+            return False
+        if (sw, sh) != (self.width, self.height):
+            self.width, self.height = sw, sh
+            self.pixels = bytearray(sw * sh * 2)
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+
+        # Slice assignment would silently resize the buffer, so every run is
+        # checked against the row and the datagram before it is applied
+        pos = HEADER.size
+        for row in range(y, y + h):
+            out = (row * sw + x) * 2
+            end = out + w * 2
+            while out < end:
+                if pos >= len(data):
+                    self.bad += 1
+                    return False
+                c = data[pos]
+                pos += 1
+                if c < 0x80:
+                    nbytes = (c + 1) * 2
+                    run = data[pos:pos + nbytes]
+                else:
+                    nbytes = (c - 0x80 + 2) * 2
+                    run = data[pos:pos + 2] * (nbytes // 2)
+                pos += nbytes if c < 0x80 else 2
+                if out + nbytes > end or len(run) != nbytes:
+                    self.bad += 1
+                    return False
+                self.pixels[out:out + nbytes] = run
+                out += nbytes
+        self.datagrams += 1
+        return True
+
+    def ppm(self):
+        rgb = bytearray(self.width * self.height * 3)
+        px = self.pixels
+        for i in range(self.width * self.height):
+            v = (px[2 * i] << 8) | px[2 * i + 1]
+            r, g, b = v >> 11, (v >> 5) & 0x3F, v & 0x1F
+            rgb[3 * i] = (r << 3) | (r >> 2)
+            rgb[3 * i + 1] = (g << 2) | (g >> 4)
+            rgb[3 * i + 2] = (b << 3) | (b >> 2)
+        return b"P6 %d %d 255\n" % (self.width, self.height) + bytes(rgb)
+
+
+def receive(sock, screen):
+    """Drain whatever is waiting; True if the screen changed."""
+    changed = False
+    while True:
+        try:
+            data = sock.recv(65535)
+        except BlockingIOError:
+            return changed
+        changed |= screen.apply(data)
+
+
+def run_dump(sock, screen, path, seconds):
+    deadline = time.monotonic() + seconds
+    sock.settimeout(0.1)
+    while time.monotonic() < deadline:
+        try:
+            screen.apply(sock.recv(65535))
+        except socket.timeout:
+            pass
+    if not screen.width:
+        print("no mirror datagrams received", file=sys.stderr)
+        return 1
+    with open(path, "wb") as f:
+        f.write(screen.ppm())
+    return 0
+
+
+def run_window(sock, screen, scale):
+    import tkinter as tk
+
+    sock.setblocking(False)
+    root = tk.Tk()
+    root.title("Binary clock mirror")
+    label = tk.Label(root, text="waiting for datagrams...")
+    label.pack()
+    status = tk.Label(root, anchor="w")
+    status.pack(fill="x")
+    state = {"image": None}
+
+    def tick():
+        if receive(sock, screen) and screen.width:
+            image = tk.PhotoImage(data=screen.ppm(), format="PPM")
+            if scale > 1:
+                image = image.zoom(scale)
+            label.configure(image=image, text="")
+            state["image"] = image  # Tk keeps no reference of its own
+        status.configure(text="%d datagrams, %d lost, %d bad"
+                         % (screen.datagrams, screen.lost, screen.bad))
+        root.after(30, tick)
+
+    tick()
+    root.mainloop()
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=5005)
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--scale", type=int, default=2)
+    parser.add_argument("--dump", metavar="FILE.ppm", help="write the screen instead of showing it")
+    parser.add_argument("--seconds", type=float, default=5.0, help="how long to listen with --dump")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind((args.bind, args.port))
+    screen = Screen()
+
+    if args.dump:
+        rc = run_dump(sock, screen, args.dump, args.seconds)
+    else:
+        rc = run_window(sock, screen, args.scale)
+    print("%d datagrams, %d lost, %d bad" % (screen.datagrams, screen.lost, screen.bad), file=sys.stderr)
+    return rc
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,433 @@
+// MqttPublisher against a stand-in broker on loopback. The broker thread
+// speaks enough MQTT 3.1.1 for the publisher (CONNECT/CONNACK, PUBLISH,
+// PINGREQ/PINGRESP) and checks every telemetry batch it gets. The samples
+// are sequence numbers, so it can tell a lost sample from a duplicated or
+// reordered one. The publisher runs in a loop like the firmware's,
+// enqueueing one sample per update() as fast as it can:
+//
+//   dns      the broker is given by name and DNS is down, then back; no
+//            update() may wait for the resolver, and lookups must be
+//            retried on the backoff schedule
+//   steady   no interference: reports samples/s, wire bytes per sample
+//            and heap use (none allowed once begin() has returned)
+//   close    the broker drops the connection; the publisher must back
+//            off, reconnect and announce itself online again
+//   stall    the broker stops reading until the socket buffers fill and a
+//            batch sits half sent in tx, then drops the connection
+//   drain    enqueueing stops and the queue must empty on the last
+//            connection
+//
+// Every enqueued sample must end up sent, dropped or still queued, and the
+// broker must see exactly what was sent on a connection that closed
+// cleanly. Exits non-zero on a failure. Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -pthread -Isim -Isrc -o mqtt_load_test
+//       tools/mqtt_load_test.cpp src/MqttPublisher.cpp
+//   ./mqtt_load_test [seconds]
+#include <malloc.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "MqttPublisher.h"
+
+static const char* const CLIENT_ID = "loadtest";
+
+enum Command { RUN = 0, CLOSE, STALL };
+
+static std::atomic<bool> running(true);
+static std::atomic<int> command(RUN);
+static uint16_t port = 0;
+
+static int failures = 0;
+
+static const char* const BROKER_NAME = "broker.test";
+static const uint32_t DNS_REPLY_MS = 300;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static uint32_t nowMs() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ==================== BROKER ====================
+struct BrokerStats {
+    std::atomic<uint32_t> connects{0};
+    std::atomic<uint32_t> onlines{0};
+    std::atomic<uint32_t> pings{0};
+    std::atomic<uint32_t> batches{0};
+    std::atomic<uint32_t> samples{0};      // All connections
+    std::atomic<uint32_t> connSamples{0};  // Current connection
+    std::atomic<uint64_t> telemetryBytes{0};
+    uint32_t lastSeq = 0;
+    bool any = false;
+    uint32_t badPackets = 0;
+    uint32_t duplicates = 0;
+};
+
+static BrokerStats broker;
+
+static bool readExact(const uint8_t* p, const char* s, size_t len) {
+    return memcmp(p, s, len) == 0;
+}
+
+static bool isTopic(const uint8_t* p, size_t len, const char* suffix) {
+    char topic[64];
+    snprintf(topic, sizeof(topic), "binclock/%s/%s", CLIENT_ID, suffix);
+    return len == strlen(topic) && readExact(p, topic, len);
+}
+
+// Checks one telemetry payload: {"t":...,"s":[[dt,"seq",n],...]}
+static void onTelemetry(const char* json, size_t len, size_t wireBytes) {
+    static char text[MQTT_TX_BUFFER + 1];
+    if (len >= sizeof(text)) {
+        broker.badPackets++;
+        return;
+    }
+    memcpy(text, json, len);
+    text[len] = '\0';
+    const char* p = text;
+    if (strncmp(p, "{\"t\":", 5) != 0 && strncmp(p, "{\"up\":", 6) != 0) {
+        broker.badPackets++;
+        return;
+    }
+    p = strstr(p, "\"s\":[");
+    if (!p) {
+        broker.badPackets++;
+        return;
+    }
+    p += 5;
+    uint32_t count = 0;
+    while (*p == '[') {
+        unsigned long dt;
+        char key[16];
+        long value;
+        int used = 0;
+        if (sscanf(p, "[%lu,\"%15[^\"]\",%ld]%n", &dt, key, &value, &used) != 3 || used == 0 ||
+            strcmp(key, "seq") != 0) {
+            broker.badPackets++;
+            return;
+        }
+        uint32_t seq = (uint32_t)value;
+        if (broker.any && seq <= broker.lastSeq) {
+            broker.duplicates++;  // Or out of order: both mean a resend
+        }
+        broker.lastSeq = seq;
+        broker.any = true;
+        count++;
+        p += used;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    if (strcmp(p, "]}") != 0 || count == 0) {
+        broker.badPackets++;
+        return;
+    }
+    broker.batches++;
+    broker.samples += count;
+    broker.connSamples += count;
+    broker.telemetryBytes += wireBytes;
+}
+
+// Handles every whole packet in buf; returns the bytes consumed
+static size_t onPackets(int fd, const uint8_t* buf, size_t len) {
+    size_t at = 0;
+    while (len - at >= 2) {
+        size_t remaining = 0;
+        size_t header = 1;
+        for (int shift = 0;; shift += 7) {
+            if (at + header >= len) {
+                return at;  // Length not all here yet
+            }
+            uint8_t b = buf[at + header++];
+            remaining |= (size_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        if (len - at < header + remaining) {
+            return at;
+        }
+        const uint8_t* body = buf + at + header;
+        uint8_t type = buf[at] & 0xF0;
+        if (type == 0x10) {
+            // CONNECT: 3.1.1, clean session with a retained will
+            if (remaining < 10 || !readExact(body, "\x00\x04MQTT\x04", 7) || (body[7] & 0x26) != 0x26) {
+                broker.badPackets++;
+            }
+            static const uint8_t CONNACK[] = {0x20, 0x02, 0x00, 0x00};
+            send(fd, CONNACK, sizeof(CONNACK), MSG_NOSIGNAL);
+            broker.connects++;
+        } else if (type == 0x30) {
+            size_t topicLength = ((size_t)body[0] << 8) | body[1];
+            const char* payload = (const char*)body + 2 + topicLength;
+            size_t payloadLength = remaining - 2 - topicLength;
+            if (isTopic(body + 2, topicLength, "telemetry")) {
+                onTelemetry(payload, payloadLength, header + remaining);
+            } else if (isTopic(body + 2, topicLength, "status") && (buf[at] & 0x01) &&
+                       payloadLength == 6 && readExact((const uint8_t*)payload, "online", 6)) {
+                broker.onlines++;
+            } else {
+                broker.badPackets++;
+            }
+        } else if (type == 0xC0) {
+            static const uint8_t PINGRESP[] = {0xD0, 0x00};
+            send(fd, PINGRESP, sizeof(PINGRESP), MSG_NOSIGNAL);
+            broker.pings++;
+        } else {
+            broker.badPackets++;
+        }
+        at += header + remaining;
+    }
+    return at;
+}
+
+static void serveConnection(int fd) {
+    static uint8_t buf[65536];
+    size_t len = 0;
+    broker.connSamples = 0;
+    while (running) {
+        int cmd = command.load();
+        if (cmd == CLOSE) {
+            break;
+        }
+        if (cmd == STALL) {
+            // Not reading: the publisher's sends back up into its tx buffer
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            break;
+        }
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 5) <= 0) {
+            continue;
+        }
+        ssize_t n = recv(fd, buf + len, sizeof(buf) - len, 0);
+        if (n <= 0) {
+            break;  // The publisher closed
+        }
+        len += (size_t)n;
+        size_t used = onPackets(fd, buf, len);
+        memmove(buf, buf + used, len - used);
+        len -= used;
+    }
+    close(fd);
+    command = RUN;
+}
+
+static void brokerThread(int listenFd) {
+    while (running) {
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd >= 0) {
+            serveConnection(fd);
+        }
+    }
+}
+
+// ==================== DNS ====================
+// lwIP's resolver as the publisher sees it: IP literals at once, names
+// answered DNS_REPLY_MS later from another thread (lwIP's), and with NULL
+// while DNS is down, as lwIP reports a timeout
+static std::atomic<bool> dnsUp(false);
+static std::atomic<uint32_t> lookups(0);
+static std::thread resolver;
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* arg) {
+    in_addr literal;
+    if (inet_aton(hostname, &literal)) {
+        addr->type = IPADDR_TYPE_V4;
+        addr->u_addr.ip4.addr = literal.s_addr;
+        return ERR_OK;
+    }
+    if (strcmp(hostname, BROKER_NAME) != 0) {
+        return ERR_ARG;
+    }
+    lookups++;
+    if (resolver.joinable()) {
+        resolver.join();  // Answered already: one lookup at a time
+    }
+    resolver = std::thread([found, arg]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(DNS_REPLY_MS));
+        ip_addr_t reply;
+        reply.type = IPADDR_TYPE_V4;
+        reply.u_addr.ip4.addr = htonl(INADDR_LOOPBACK);
+        found(BROKER_NAME, dnsUp ? &reply : nullptr, arg);
+    });
+    return ERR_INPROGRESS;
+}
+
+// ==================== PUBLISHER ====================
+struct Run {
+    MqttPublisher* publisher;
+    uint32_t enqueued;
+    bool adding;
+};
+
+// One firmware loop pass: a sample, then the state machine
+static void pass(Run& r) {
+    if (r.adding) {
+        r.publisher->enqueue("seq", (int32_t)r.enqueued, nowMs());
+        r.enqueued++;
+    }
+    r.publisher->update(nowMs());
+}
+
+// Passes until cond() holds or the time runs out
+template <typename Cond>
+static bool runUntil(Run& r, uint32_t timeoutMs, Cond cond) {
+    uint32_t start = nowMs();
+    while (!cond()) {
+        if (nowMs() - start > timeoutMs) {
+            return false;
+        }
+        pass(r);
+    }
+    return true;
+}
+
+// Exact only while no batch is in tx, e.g. right after CONNACK
+static bool accounted(const MqttPublisher& p, uint32_t enqueued) {
+    return p.getSamplesSent() + p.getSamplesDropped() + p.queued() == enqueued;
+}
+
+int main(int argc, char** argv) {
+    uint32_t steadyMs = argc > 1 ? (uint32_t)(atof(argv[1]) * 1000) : 2000;
+
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 4) != 0 ||
+        getsockname(listenFd, (sockaddr*)&addr, &addrLen) != 0) {
+        perror("listen");
+        return 1;
+    }
+    port = ntohs(addr.sin_port);
+    std::thread brokerRunner(brokerThread, listenFd);
+
+    static MqttPublisher publisher;
+    Run r = {&publisher, 0, true};
+
+    // DNS: down for two lookups (at 0 and after the first backoff step),
+    // then back for the third. No pass may sit out a reply.
+    CHECK(!publisher.begin(BROKER_NAME, port, CLIENT_ID), "begin: a name answered at once");
+    uint32_t slowestPassUs = 0;
+    auto timedPass = [&]() {
+        auto before = std::chrono::steady_clock::now();
+        pass(r);
+        auto took = std::chrono::steady_clock::now() - before;
+        slowestPassUs = std::max(slowestPassUs,
+                                 (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(took).count());
+    };
+    uint32_t dnsStart = nowMs();
+    while (nowMs() - dnsStart < 2 * DNS_REPLY_MS + MQTT_RETRY_MIN_MS + 200) {
+        timedPass();
+    }
+    uint32_t lookupsDown = lookups;
+    CHECK(lookupsDown == 2 && !publisher.connected(), "dns down: %u lookups", (unsigned)lookupsDown);
+    dnsUp = true;
+    while (!publisher.connected() && nowMs() - dnsStart < 4 * DNS_REPLY_MS + 3 * MQTT_RETRY_MIN_MS + 1000) {
+        timedPass();
+    }
+    CHECK(publisher.connected() && lookups == 3, "dns back: connected %d after %u lookups",
+          publisher.connected(), (unsigned)lookups.load());
+    CHECK(slowestPassUs < DNS_REPLY_MS * 1000 / 2, "dns: a pass took %u us", (unsigned)slowestPassUs);
+    resolver.join();
+    size_t heapBefore = mallinfo2().uordblks;
+
+    // Steady: full speed on one connection
+    CHECK(publisher.connected(), "first connect");
+    uint32_t sentAtStart = publisher.getSamplesSent();
+    uint32_t steadyStart = nowMs();
+    runUntil(r, steadyMs, [] { return false; });
+    double seconds = (nowMs() - steadyStart) / 1000.0;
+    uint32_t steadySent = publisher.getSamplesSent() - sentAtStart;
+    size_t heapAfter = mallinfo2().uordblks;
+
+    // Close: dropped at once, reconnect after the first backoff step
+    uint32_t reconnects = publisher.getReconnects();
+    command = CLOSE;
+    CHECK(runUntil(r, MQTT_RETRY_MIN_MS + MQTT_CONNECT_TIMEOUT_MS,
+                   [&] { return publisher.getReconnects() > reconnects && publisher.connected(); }),
+          "close: reconnect");
+    CHECK(accounted(publisher, r.enqueued), "close: %u enqueued", (unsigned)r.enqueued);
+
+    // Stall: tx fills, then the connection goes with a batch in it
+    reconnects = publisher.getReconnects();
+    uint32_t droppedBeforeStall = publisher.getSamplesDropped();
+    command = STALL;
+    CHECK(runUntil(r, MQTT_RETRY_MIN_MS + MQTT_CONNECT_TIMEOUT_MS + 1000,
+                   [&] { return publisher.getReconnects() > reconnects && publisher.connected(); }),
+          "stall: reconnect");
+    CHECK(publisher.getSamplesDropped() > droppedBeforeStall, "stall: the full queue must drop");
+    CHECK(accounted(publisher, r.enqueued), "stall: %u enqueued, %u sent, %u dropped, %u queued",
+          (unsigned)r.enqueued, (unsigned)publisher.getSamplesSent(), (unsigned)publisher.getSamplesDropped(),
+          (unsigned)publisher.queued());
+
+    // Drain: everything sent on this connection must arrive
+    uint32_t sentOnLast = publisher.getSamplesSent();
+    r.adding = false;
+    publisher.enqueue("seq", (int32_t)r.enqueued++, nowMs(), true);  // Flushes the rest
+    CHECK(runUntil(r, 1000,
+                   [&] { return publisher.getSamplesSent() + publisher.getSamplesDropped() == r.enqueued; }),
+          "drain: %u still queued", (unsigned)publisher.queued());
+    sentOnLast = publisher.getSamplesSent() - sentOnLast;
+    publisher.end();
+    uint32_t waitStart = nowMs();
+    while (broker.connSamples < sentOnLast && nowMs() - waitStart < 2000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    running = false;
+    brokerRunner.join();
+    close(listenFd);
+    CHECK(broker.connSamples == sentOnLast, "drain: broker got %u of %u", (unsigned)broker.connSamples.load(),
+          (unsigned)sentOnLast);
+
+    CHECK(broker.connects == 3 && broker.onlines == 3, "%u connects, %u online", (unsigned)broker.connects.load(),
+          (unsigned)broker.onlines.load());
+    CHECK(publisher.getReconnects() == 2, "%u reconnects", (unsigned)publisher.getReconnects());
+    CHECK(broker.samples <= publisher.getSamplesSent(), "broker got %u, %u sent", (unsigned)broker.samples.load(),
+          (unsigned)publisher.getSamplesSent());
+    CHECK(broker.badPackets == 0, "%u bad packets", (unsigned)broker.badPackets);
+    CHECK(broker.duplicates == 0, "%u resent or reordered samples", (unsigned)broker.duplicates);
+    CHECK(heapAfter == heapBefore, "heap %zu -> %zu bytes", heapBefore, heapAfter);
+    CHECK(steadySent > 0, "nothing sent");
+
+    printf("dns      %u lookups, slowest pass %u us while resolving\n", (unsigned)lookups.load(),
+           (unsigned)slowestPassUs);
+    printf("steady   %.0f samples/s, %.1f wire bytes/sample, %u per batch, %zu B heap growth\n",
+           steadySent / seconds, (double)broker.telemetryBytes / (double)broker.samples,
+           (unsigned)(broker.samples / (broker.batches ? broker.batches.load() : 1)), heapAfter - heapBefore);
+    printf("total    %u enqueued, %u sent, %u dropped, %u received, %u batches\n", (unsigned)r.enqueued,
+           (unsigned)publisher.getSamplesSent(), (unsigned)publisher.getSamplesDropped(),
+           (unsigned)broker.samples.load(), (unsigned)broker.batches.load());
+    printf("memory   sizeof(MqttPublisher) %zu B (tx %u, queue %u x %zu)\n", sizeof(MqttPublisher),
+           (unsigned)MQTT_TX_BUFFER, (unsigned)MQTT_QUEUE_SIZE, sizeof(int32_t) * 2 + sizeof(const char*));
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+// NmeaParser throughput on the streams in tools/nmea/. "ring" is the
+// firmware's path: bytes copied into a 256-byte ring (GPS_RING_SIZE) a
+// loop pass's worth at a time (96 bytes: 100 ms at 9600 baud) and scanned
+// there, the copy included. "scan" is the parser alone over a buffer that
+// never wraps. The per-second column is the cost of one second of the
+// receiver's output, from the stream's time span.
+// Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -Isrc tools/nmea_bench.cpp src/NmeaParser.cpp -o nmea_bench
+//   ./nmea_bench [repeats] [stream directory, default tools/nmea]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "NmeaParser.h"
+
+static const char* const STREAMS[] = {
+    "ublox-m8-new-year.nmea",
+    "mtk-5hz-leap-day.nmea",
+    "ublox6-noisy-leap-second.nmea",
+};
+
+static const uint32_t RING_SIZE = 256;  // GPS_RING_SIZE
+static const uint32_t PASS_BYTES = 96;  // 100 ms at 9600 baud
+
+template <typename Fn>
+static double nsPerCall(size_t calls, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double)calls;
+}
+
+static bool readFile(const std::string& path, std::string& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.append(buf, n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Seconds of receiver output, from the "# times" header line
+static double streamSeconds(const std::string& data) {
+    size_t at = data.find("# times ");
+    char first[32], last[32];
+    unsigned count;
+    if (at == std::string::npos ||
+        sscanf(data.c_str() + at, "# times %u first %31s last %31s", &count, first, last) != 3) {
+        return 0;
+    }
+    struct tm a = {}, b = {};
+    strptime(first, "%Y-%m-%dT%H:%M:%S", &a);
+    strptime(last, "%Y-%m-%dT%H:%M:%S", &b);
+    return difftime(timegm(&b), timegm(&a)) + 1;
+}
+
+int main(int argc, char** argv) {
+    int repeats = argc > 1 ? atoi(argv[1]) : 50;
+    std::string dir = argc > 2 ? argv[2] : "tools/nmea";
+
+    uint64_t sink = 0;
+    printf("%-30s %8s %10s %10s %10s %12s\n", "stream", "bytes", "ring ns/B", "scan ns/B", "ring MB/s",
+           "us/second");
+    for (const char* name : STREAMS) {
+        std::string data;
+        if (!readFile(dir + "/" + name, data)) {
+            printf("can't read %s/%s\n", dir.c_str(), name);
+            return 1;
+        }
+        size_t total = data.size() * (size_t)repeats;
+
+        uint8_t ring[RING_SIZE];
+        double ringNs = nsPerCall(total, [&]() {
+            for (int r = 0; r < repeats; r++) {
+                NmeaParser parser;
+                NmeaParser::Time time;
+                uint32_t head = 0;
+                size_t fed = 0;
+                while (fed < data.size()) {
+                    uint32_t room = RING_SIZE - (head - parser.keepFrom());
+                    uint32_t at = head & (RING_SIZE - 1);
+                    size_t n = std::min((size_t)PASS_BYTES, data.size() - fed);
+                    n = std::min(n, (size_t)std::min(room, RING_SIZE - at));
+                    memcpy(&ring[at], data.data() + fed, n);
+                    head += (uint32_t)n;
+                    fed += n;
+                    while (parser.scan(ring, RING_SIZE - 1, head, time)) {
+                        sink += (uint64_t)time.utcUs;
+                    }
+                }
+                sink += parser.getStats().sentences;
+            }
+        });
+
+        uint32_t size = 1;
+        while (size < data.size()) {
+            size <<= 1;
+        }
+        std::vector<uint8_t> flat(size);
+        memcpy(flat.data(), data.data(), data.size());
+        double scanNs = nsPerCall(total, [&]() {
+            for (int r = 0; r < repeats; r++) {
+                NmeaParser parser;
+                NmeaParser::Time time;
+                while (parser.scan(flat.data(), size - 1, (uint32_t)data.size(), time)) {
+                    sink += (uint64_t)time.utcUs;
+                }
+                sink += parser.getStats().sentences;
+            }
+        });
+
+        double seconds = streamSeconds(data);
+        double perSecondUs = seconds > 0 ? ringNs * (double)data.size() / seconds / 1000.0 : 0;
+        printf("%-30s %8zu %10.2f %10.2f %10.0f %12.2f\n", name, data.size(), ringNs, scanNs,
+               1000.0 / ringNs, perSecondUs);
+    }
+    if (sink == 1) {
+        printf("?");
+    }
+    return 0;
+}
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""Writes the NMEA streams in tools/nmea/ that nmea_test and nmea_bench read.
+
+Each stream follows one receiver's default output: sentence set and order,
+talker, time format, what it sends before it has a fix, and (for the noisy
+one) the binary frames and line damage seen on a shared UART. The header
+of each file ends with the times a parser should get out of it:
+
+    # times <count> first <ISO time> last <ISO time>
+
+Output is the same on every run (fixed seeds), so regenerate and commit
+the files together with any change here:
+
+    python3 tools/nmea_streams.py            # writes tools/nmea/*.nmea
+"""
+
+import argparse
+import datetime
+import os
+import random
+import sys
+
+
+def checksum(body):
+    total = 0
+    for c in body.encode("ascii"):
+        total ^= c
+    return total
+
+
+def sentence(body, lower=False):
+    return ("$%s*%02x" if lower else "$%s*%02X") % (body, checksum(body))
+
+
+def hms(t, decimals):
+    whole = t.strftime("%H%M%S")
+    if decimals == 0:
+        return whole
+    frac = "%06d" % t.microsecond
+    return whole + "." + frac[:decimals]
+
+
+def ddmmyy(t):
+    return t.strftime("%d%m%y")
+
+
+def iso(t):
+    return t.strftime("%Y-%m-%dT%H:%M:%S.") + "%03d" % (t.microsecond // 1000)
+
+
+class Stream:
+    """Bytes for one file, plus the times a parser should decode"""
+
+    def __init__(self, title, notes):
+        self.title = title
+        self.notes = notes
+        self.parts = []
+        self.times = []
+
+    def add(self, body, time=None, lower=False):
+        self.parts.append((sentence(body, lower) + "\r\n").encode("ascii"))
+        if time is not None:
+            self.times.append(time)
+
+    def raw(self, data):
+        self.parts.append(data)
+
+    def write(self, path):
+        header = ["# " + self.title]
+        header += ["# " + line for line in self.notes]
+        header.append("# Generated by tools/nmea_streams.py")
+        header.append("# times %d first %s last %s" % (len(self.times), iso(self.times[0]), iso(self.times[-1])))
+        with open(path, "wb") as f:
+            f.write(("\n".join(header) + "\n").encode("ascii"))
+            for part in self.parts:
+                f.write(part)
+
+
+class Sky:
+    """Satellites drifting slowly, for GSA/GSV and fix quality"""
+
+    def __init__(self, rng, prns):
+        self.rng = rng
+        self.sats = [[prn, rng.randint(5, 85), rng.randint(0, 359), rng.randint(18, 46)] for prn in prns]
+
+    def step(self):
+        for sat in self.sats:
+            sat[2] = (sat[2] + self.rng.choice((0, 0, 1))) % 360
+            sat[3] = max(0, min(50, sat[3] + self.rng.randint(-1, 1)))
+
+    def used(self):
+        return [s[0] for s in self.sats if s[3] >= 25][:12]
+
+    def gsv(self, talker):
+        bodies = []
+        count = len(self.sats)
+        messages = (count + 3) // 4
+        for m in range(messages):
+            fields = ["%sGSV" % talker, str(messages), str(m + 1), "%02d" % count]
+            for prn, elev, azim, snr in self.sats[4 * m:4 * m + 4]:
+                fields += ["%02d" % prn, "%02d" % elev, "%03d" % azim, "%02d" % snr if snr else ""]
+            bodies.append(",".join(fields))
+        return bodies
+
+
+def position(rng, t0, t):
+    # Around Montreal, wandering a few metres
+    drift = (t - t0).total_seconds()
+    lat = 4530.0000 + 0.00002 * drift + rng.uniform(-0.0003, 0.0003)
+    lon = 7334.2000 + rng.uniform(-0.0003, 0.0003)
+    return "%010.5f" % lat, "%011.5f" % lon
+
+
+def ublox_m8(path):
+    """u-blox M8 (GNSS talker GN), 1 Hz, ZDA enabled: cold start, new year, fix lost"""
+    rng = random.Random(8)
+    s = Stream("u-blox M8 (protocol 18), 1 Hz, 9600 baud, ZDA enabled",
+               ["Cold start: 5 s with no time, 15 s with time but no fix (RMC V, ZDA",
+                "filled), then a fix through midnight into 2026; the fix drops for 20 s",
+                "at 00:01:00 while the time goes on."])
+    for text in ("GNTXT,01,01,02,u-blox AG - www.u-blox.com",
+                 "GNTXT,01,01,02,HW UBX-M8030 00080000",
+                 "GNTXT,01,01,02,ROM CORE 3.01 (107888)",
+                 "GNTXT,01,01,02,FWVER=SPG 3.01",
+                 "GNTXT,01,01,02,PROTVER=18.00",
+                 "GNTXT,01,01,02,GPS;GLO;GAL;BDS",
+                 "GNTXT,01,01,02,ANTSTATUS=OK"):
+        s.add(text)
+
+    gps = Sky(rng, (2, 5, 12, 15, 18, 24, 25, 29, 31))
+    glo = Sky(rng, (65, 66, 72, 73, 80, 81))
+    t0 = datetime.datetime(2025, 12, 31, 23, 58, 0)
+    for second in range(240):
+        t = t0 + datetime.timedelta(seconds=second)
+        gps.step()
+        glo.step()
+        known = second >= 5
+        fix = second >= 20 and not (180 <= second < 200)
+        tm = hms(t, 2) if known else ""
+        date = ddmmyy(t) if known else ""
+        if fix:
+            lat, lon = position(rng, t0, t)
+            speed = "%.3f" % rng.uniform(0, 0.05)
+            s.add("GNRMC,%s,A,%s,N,%s,W,%s,,%s,,,A,V" % (tm, lat, lon, speed, date), t)
+            s.add("GNVTG,,T,,M,%s,N,%.3f,K,A" % (speed, float(speed) * 1.852))
+            used = gps.used() + glo.used()
+            s.add("GNGGA,%s,%s,N,%s,W,1,%02d,%.2f,36.%d,M,-32.9,M,," % (
+                tm, lat, lon, len(used), rng.uniform(0.8, 1.1), rng.randint(0, 9)))
+            for talker, sky, system in (("GN", gps, 1), ("GN", glo, 2)):
+                prns = ["%02d" % p for p in sky.used()]
+                prns += [""] * (12 - len(prns))
+                s.add("%sGSA,A,3,%s,1.62,0.95,1.31,%d" % (talker, ",".join(prns), system))
+        else:
+            s.add("GNRMC,%s,V,,,,,,,%s,,,N,V" % (tm, date))
+            s.add("GNVTG,,,,,,,,,N")
+            s.add("GNGGA,%s,,,,,0,00,99.99,,,,,," % tm)
+            s.add("GNGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99,1")
+            s.add("GNGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99,2")
+        for body in gps.gsv("GP") + glo.gsv("GL"):
+            s.add(body)
+        if fix:
+            s.add("GNGLL,%s,N,%s,W,%s,A,A" % (lat, lon, tm))
+        else:
+            s.add("GNGLL,,,,,%s,V,N" % tm)
+        # No validity flag: filled as soon as the receiver knows the time
+        if known:
+            s.add("GNZDA,%s,%02d,%02d,%04d,00,00" % (tm, t.day, t.month, t.year), t)
+        else:
+            s.add("GNZDA,,,,,,")
+    s.write(path)
+
+
+def mtk_5hz(path):
+    """MediaTek MT3339 (GP talker), 5 Hz RMC and GGA, no ZDA, across a leap day"""
+    rng = random.Random(3339)
+    s = Stream("MediaTek MT3339, 5 Hz (PMTK220,200), 57600 baud, no ZDA",
+               ["Millisecond fractions; RMC and GGA every 200 ms, GSA and GSV once a",
+                "second. Starts 2024-02-29 23:59:00 and runs into March 1."])
+    s.add("PMTK011,MTKGPS")
+    s.add("PMTK010,001")
+    s.add("PMTK001,220,3")
+    s.add("PMTK001,314,3")
+    sky = Sky(rng, (1, 3, 6, 11, 14, 17, 19, 22, 28, 32))
+    t0 = datetime.datetime(2024, 2, 29, 23, 59, 0)
+    for tick in range(600):
+        t = t0 + datetime.timedelta(milliseconds=200 * tick)
+        tm = hms(t, 3)
+        lat, lon = position(rng, t0, t)
+        speed = "%.2f" % rng.uniform(0, 0.3)
+        used = sky.used()
+        s.add("GPGGA,%s,%s,N,%s,W,1,%d,%.2f,41.3,M,-32.9,M,," % (
+            tm, lat[:-1], lon[:-1], len(used), rng.uniform(0.8, 1.2)))
+        if tick % 5 == 0:
+            sky.step()
+            prns = ["%02d" % p for p in used] + [""] * (12 - len(used))
+            s.add("GPGSA,A,3,%s,1.72,0.97,1.42" % ",".join(prns))
+            for body in sky.gsv("GP"):
+                s.add(body)
+        s.add("GPRMC,%s,A,%s,N,%s,W,%s,%.2f,%s,,,A" % (
+            tm, lat[:-1], lon[:-1], speed, rng.uniform(0, 360), ddmmyy(t)), t)
+        if tick % 50 == 49:
+            s.add("PGTOP,11,3")
+    s.write(path)
+
+
+def ubx_frame(rng):
+    # NAV-PVT sized, with the real header and Fletcher checksum; the
+    # payload is random, so it holds '$', '*' and CR/LF now and then
+    payload = bytes(rng.randrange(256) for _ in range(92))
+    body = bytes((0x01, 0x07, len(payload) & 0xFF, len(payload) >> 8)) + payload
+    a = b = 0
+    for c in body:
+        a = (a + c) & 0xFF
+        b = (b + a) & 0xFF
+    return b"\xb5\x62" + body + bytes((a, b))
+
+
+def noisy(path):
+    """u-blox 6 (GP talker) with NMEA and UBX on one port, line damage, a leap second"""
+    rng = random.Random(6)
+    s = Stream("u-blox 6, 1 Hz, 9600 baud, NMEA and UBX NAV-PVT on the same port",
+               ["Line damage: 2% of sentences with a changed byte (checksum fails), 1%",
+                "cut off by the next sentence, some without CR LF or with a lowercase",
+                "checksum; a PUBX,03 past the length limit every 10 s. Runs through the",
+                "2016-12-31 23:59:60 leap second, which is sent and must not give a time."])
+    sky = Sky(rng, (2, 5, 12, 15, 18, 24, 25, 29, 31, 33, 40))
+    start = datetime.datetime(2016, 12, 31, 23, 58, 0)
+    for second in range(241):
+        # Second 120 is the leap second, 23:59:60; after it the clock is
+        # one second behind the count
+        leap = second == 120
+        t = start + datetime.timedelta(seconds=second if second < 120 else second - 1)
+        tm = "235960.00" if leap else hms(t, 2)
+        sky.step()
+        lat, lon = position(rng, start, t)
+        used = sky.used()
+        prns = ["%02d" % p for p in used] + [""] * (12 - len(used))
+        epoch = [
+            ("GPRMC,%s,A,%s,N,%s,W,0.004,,%s,,,A" % (tm, lat, lon, ddmmyy(t)), not leap),
+            ("GPVTG,,T,,M,0.004,N,0.007,K,A", False),
+            ("GPGGA,%s,%s,N,%s,W,1,%02d,0.92,36.2,M,-32.9,M,," % (tm, lat, lon, len(used)), False),
+            ("GPGSA,A,3,%s,1.62,0.92,1.33" % ",".join(prns), False),
+        ]
+        epoch += [(body, False) for body in sky.gsv("GP")]
+        epoch.append(("GPGLL,%s,N,%s,W,%s,A,A" % (lat, lon, tm), False))
+        epoch.append(("GPZDA,%s,%02d,%02d,%04d,00,00" % (tm, t.day, t.month, t.year), not leap))
+        if second % 10 == 5:
+            sats = ",".join("%d,U,%03d,%02d,%02d,064" % (p, a, e, c) for p, e, a, c in sky.sats)
+            epoch.append(("PUBX,03,%02d,%s" % (len(sky.sats), sats), False))
+
+        for body, timed in epoch:
+            roll = rng.random()
+            text = sentence(body, lower=rng.random() < 0.05)
+            ending = b"" if rng.random() < 0.02 else b"\r\n"
+            if roll < 0.02:
+                # One body byte changed to another printable, which is
+                # never a '$' or '*'; the checksum no longer matches
+                i = rng.randrange(1, text.index("*"))
+                choices = [c for c in "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ,.-" if c != text[i]]
+                text = text[:i] + rng.choice(choices) + text[i + 1:]
+                timed = False
+            elif roll < 0.03:
+                # Cut off: the next '$' comes before the checksum
+                text = text[:rng.randrange(2, text.index("*"))]
+                ending = b""
+                timed = False
+            s.raw(text.encode("ascii") + ending)
+            if timed:
+                s.times.append(t)
+        s.raw(ubx_frame(rng))
+    s.write(path)
+
+
+STREAMS = {
+    "ublox-m8-new-year.nmea": ublox_m8,
+    "mtk-5hz-leap-day.nmea": mtk_5hz,
+    "ublox6-noisy-leap-second.nmea": noisy,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--out", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "nmea"),
+                        help="directory to write to (default: tools/nmea)")
+    args = parser.parse_args()
+    os.makedirs(args.out, exist_ok=True)
+    for name, make in STREAMS.items():
+        path = os.path.join(args.out, name)
+        make(path)
+        print("%s: %d bytes" % (path, os.path.getsize(path)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
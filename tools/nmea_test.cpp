@@ -0,0 +1,582 @@
+// NmeaParser against the streams in tools/nmea/ and against a plain
+// parser that copies each sentence out and splits it with the standard
+// library. Each stream must give the times its header lists, and the same
+// times and counts from both parsers, whether it is parsed in one piece or
+// fed through a 256-byte ring (GPS_RING_SIZE) in random chunks the way
+// GpsClock::fill() does. Ring bytes the parser has given back with
+// keepFrom() are overwritten with noise at once, so a decode from stale
+// bytes shows up as a mismatch.
+//
+// The fuzz pass then takes sentences from the streams, cuts, splices and
+// corrupts them (fixing the checksum half the time, so the damage reaches
+// the field decoding) and compares the two parsers on each. Add
+// -fsanitize=address,undefined to catch reads outside the ring. Exits
+// non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc -o nmea_test
+//       tools/nmea_test.cpp src/NmeaParser.cpp
+//   ./nmea_test [stream directory, default tools/nmea]
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "NmeaParser.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static const char* const STREAMS[] = {
+    "ublox-m8-new-year.nmea",
+    "mtk-5hz-leap-day.nmea",
+    "ublox6-noisy-leap-second.nmea",
+};
+
+static const uint32_t RING_SIZE = 256;  // GPS_RING_SIZE
+static const uint32_t FUZZ_ROUNDS = 200000;
+
+static uint32_t rngState = 0x2545F491;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t randomBelow(uint32_t n) {
+    return nextRandom() % n;
+}
+
+// What a parser got out of some input
+struct Outcome {
+    std::vector<NmeaParser::Time> times;
+    NmeaParser::Stats stats;
+};
+
+static bool sameOutcome(const Outcome& a, const Outcome& b) {
+    if (a.times.size() != b.times.size() || memcmp(&a.stats, &b.stats, sizeof(a.stats)) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < a.times.size(); i++) {
+        if (a.times[i].utcUs != b.times[i].utcUs || a.times[i].kind != b.times[i].kind) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printOutcome(const char* name, const Outcome& o) {
+    printf("    %-9s %zu times, %u sentences, %u bad checksum, %u malformed\n", name, o.times.size(),
+           o.stats.sentences, o.stats.badChecksum, o.stats.malformed);
+    for (const NmeaParser::Time& t : o.times) {
+        printf("      %lld %s\n", (long long)t.utcUs, t.kind == NmeaParser::KIND_RMC ? "RMC" : "ZDA");
+    }
+}
+
+static void printInput(const std::string& input) {
+    printf("    input: \"");
+    for (unsigned char c : input) {
+        if (c >= 0x20 && c <= 0x7E && c != '"' && c != '\\') {
+            putchar(c);
+        } else {
+            printf("\\x%02X", c);
+        }
+    }
+    printf("\"\n");
+}
+
+// ==================== Parsers ====================
+// The whole input in a ring big enough that it never wraps
+static Outcome parseWhole(const std::string& input) {
+    uint32_t size = 1;
+    while (size < input.size()) {
+        size <<= 1;
+    }
+    std::vector<uint8_t> ring(size);
+    memcpy(ring.data(), input.data(), input.size());
+
+    Outcome out;
+    NmeaParser parser;
+    NmeaParser::Time time;
+    while (parser.scan(ring.data(), size - 1, (uint32_t)input.size(), time)) {
+        out.times.push_back(time);
+    }
+    out.stats = parser.getStats();
+    return out;
+}
+
+// Through a RING_SIZE ring in chunks of 1 to maxChunk bytes, noise written
+// over every byte the parser no longer holds
+static Outcome parseRing(const std::string& input, uint32_t maxChunk) {
+    uint8_t ring[RING_SIZE];
+    const uint32_t mask = RING_SIZE - 1;
+    for (uint32_t i = 0; i < RING_SIZE; i++) {
+        ring[i] = (uint8_t)nextRandom();
+    }
+
+    Outcome out;
+    NmeaParser parser;
+    NmeaParser::Time time;
+    uint32_t head = 0;
+    size_t fed = 0;
+    while (fed < input.size()) {
+        uint32_t room = RING_SIZE - (head - parser.keepFrom());
+        if (room == 0) {
+            CHECK(room > 0, "ring full at byte %zu", fed);
+            break;
+        }
+        uint32_t at = head & mask;
+        size_t n = 1 + randomBelow(maxChunk);
+        n = std::min(n, std::min((size_t)room, (size_t)(RING_SIZE - at)));
+        n = std::min(n, input.size() - fed);
+        memcpy(&ring[at], input.data() + fed, n);
+        head += (uint32_t)n;
+        fed += n;
+
+        while (parser.scan(ring, mask, head, time)) {
+            out.times.push_back(time);
+        }
+        for (uint32_t i = head; i != parser.keepFrom() + RING_SIZE; i++) {
+            ring[i & mask] = (uint8_t)nextRandom();
+        }
+    }
+    out.stats = parser.getStats();
+    return out;
+}
+
+// Reference: sentences copied into strings, split on commas, dates through
+// timegm(). Same rules as NmeaParser, written the obvious way.
+static bool allDigits(const std::string& s) {
+    if (s.empty()) {
+        return false;
+    }
+    for (char c : s) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isHex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+static std::vector<std::string> splitFields(const std::string& body) {
+    std::vector<std::string> fields;
+    size_t from = 0;
+    for (;;) {
+        size_t comma = body.find(',', from);
+        fields.push_back(body.substr(from, comma == std::string::npos ? std::string::npos : comma - from));
+        if (comma == std::string::npos) {
+            return fields;
+        }
+        from = comma + 1;
+    }
+}
+
+static bool referenceTime(const std::string& body, NmeaParser::Time& out) {
+    std::vector<std::string> f = splitFields(body);
+    if (f[0].size() != 5 || f[0][0] == 'P') {
+        return false;
+    }
+    std::string type = f[0].substr(2);
+    int day, month, year;
+    if (type == "RMC") {
+        if (f.size() < 10 || f[2] != "A" || f[9].size() != 6 || !allDigits(f[9])) {
+            return false;
+        }
+        day = std::stoi(f[9].substr(0, 2));
+        month = std::stoi(f[9].substr(2, 2));
+        year = 2000 + std::stoi(f[9].substr(4, 2));
+        out.kind = NmeaParser::KIND_RMC;
+    } else if (type == "ZDA") {
+        if (f.size() < 5 || f[2].size() != 2 || f[3].size() != 2 || f[4].size() != 4 ||
+            !allDigits(f[2]) || !allDigits(f[3]) || !allDigits(f[4])) {
+            return false;
+        }
+        day = std::stoi(f[2]);
+        month = std::stoi(f[3]);
+        year = std::stoi(f[4]);
+        out.kind = NmeaParser::KIND_ZDA;
+    } else {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    const std::string& t = f[1];
+    if (t.size() < 6 || !allDigits(t.substr(0, 6))) {
+        return false;
+    }
+    int h = std::stoi(t.substr(0, 2));
+    int m = std::stoi(t.substr(2, 2));
+    int s = std::stoi(t.substr(4, 2));
+    if (h > 23 || m > 59 || s > 59) {
+        return false;
+    }
+    int64_t frac = 0;
+    if (t.size() > 6) {
+        std::string digits = t.substr(7);
+        if (t[6] != '.' || (!digits.empty() && !allDigits(digits))) {
+            return false;
+        }
+        digits = (digits + "000000").substr(0, 6);
+        frac = std::stoll(digits);
+    }
+
+    struct tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = h;
+    tm.tm_min = m;
+    tm.tm_sec = s;
+    out.utcUs = (int64_t)timegm(&tm) * 1000000 + frac;
+    return true;
+}
+
+static Outcome parseReference(const std::string& input) {
+    Outcome out;
+    memset(&out.stats, 0, sizeof(out.stats));
+    std::string sentence;  // From '$', empty while looking for one
+    for (char c : input) {
+        if (c == '$') {
+            if (!sentence.empty()) {
+                out.stats.malformed++;
+            }
+            sentence = "$";
+            continue;
+        }
+        if (sentence.empty()) {
+            continue;
+        }
+        if (sentence.size() >= NmeaParser::MAX_SENTENCE) {
+            out.stats.malformed++;
+            sentence.clear();
+            continue;
+        }
+        sentence += c;
+
+        size_t star = sentence.find('*');
+        if (star == std::string::npos) {
+            if ((unsigned char)c < 0x20 || (unsigned char)c > 0x7E) {
+                out.stats.malformed++;
+                sentence.clear();
+            }
+            continue;
+        }
+        if (star + 1 == sentence.size()) {
+            continue;
+        }
+        if (!isHex(c)) {
+            out.stats.malformed++;
+            sentence.clear();
+            continue;
+        }
+        if (sentence.size() < star + 3) {
+            continue;
+        }
+
+        std::string body = sentence.substr(1, star - 1);
+        unsigned long expected = std::stoul(sentence.substr(star + 1, 2), nullptr, 16);
+        sentence.clear();
+        uint8_t sum = 0;
+        for (char b : body) {
+            sum ^= (uint8_t)b;
+        }
+        if (expected != sum) {
+            out.stats.badChecksum++;
+            continue;
+        }
+        out.stats.sentences++;
+        NmeaParser::Time time;
+        if (referenceTime(body, time)) {
+            out.stats.times++;
+            out.times.push_back(time);
+        }
+    }
+    return out;
+}
+
+// ==================== Streams ====================
+static bool readFile(const std::string& path, std::string& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.append(buf, n);
+    }
+    fclose(f);
+    return true;
+}
+
+// "2024-03-01T00:00:59.800" as Unix microseconds
+static int64_t parseIso(const char* text) {
+    struct tm tm = {};
+    int ms = 0;
+    if (sscanf(text, "%d-%d-%dT%d:%d:%d.%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour,
+               &tm.tm_min, &tm.tm_sec, &ms) != 7) {
+        return -1;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return (int64_t)timegm(&tm) * 1000000 + ms * 1000;
+}
+
+static void testStreams(const std::string& dir, std::vector<std::string>& sentences) {
+    printf("streams\n");
+    for (const char* name : STREAMS) {
+        std::string data;
+        if (!readFile(dir + "/" + name, data)) {
+            CHECK(false, "can't read %s/%s", dir.c_str(), name);
+            continue;
+        }
+
+        unsigned count = 0;
+        char first[32] = "", last[32] = "";
+        size_t at = 0;
+        while (at < data.size() && data[at] == '#') {
+            size_t eol = data.find('\n', at);
+            sscanf(data.c_str() + at, "# times %u first %31s last %31s", &count, first, last);
+            at = eol == std::string::npos ? data.size() : eol + 1;
+        }
+        CHECK(count > 0, "%s: no \"# times\" line", name);
+
+        Outcome whole = parseWhole(data);
+        Outcome reference = parseReference(data);
+        printf("  %-30s %6zu bytes %5u sentences %4u times %3u bad %3u malformed\n", name, data.size(),
+               whole.stats.sentences, whole.stats.times, whole.stats.badChecksum, whole.stats.malformed);
+        CHECK(whole.times.size() == count, "%s: %zu times, header says %u", name, whole.times.size(), count);
+        if (!whole.times.empty()) {
+            CHECK(whole.times.front().utcUs == parseIso(first), "%s: first %lld, header says %s", name,
+                  (long long)whole.times.front().utcUs, first);
+            CHECK(whole.times.back().utcUs == parseIso(last), "%s: last %lld, header says %s", name,
+                  (long long)whole.times.back().utcUs, last);
+        }
+        for (size_t i = 1; i < whole.times.size(); i++) {
+            CHECK(whole.times[i].utcUs >= whole.times[i - 1].utcUs, "%s: time %zu goes back", name, i);
+        }
+        CHECK(sameOutcome(whole, reference), "%s: reference parser disagrees", name);
+
+        static const uint32_t chunks[] = {1, 7, 64, RING_SIZE};
+        for (uint32_t maxChunk : chunks) {
+            Outcome ring = parseRing(data, maxChunk);
+            CHECK(sameOutcome(whole, ring), "%s: fed in chunks of up to %u, outcome differs", name, maxChunk);
+        }
+
+        // Sentences for the fuzz pass, without their line endings
+        for (size_t from = data.find('$', at); from != std::string::npos;) {
+            size_t next = data.find('$', from + 1);
+            std::string s = data.substr(from, next == std::string::npos ? std::string::npos : next - from);
+            while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) {
+                s.pop_back();
+            }
+            sentences.push_back(s);
+            from = next;
+        }
+    }
+}
+
+// ==================== Edge cases ====================
+static std::string withSum(const std::string& body, const char* ending = "\r\n") {
+    uint8_t sum = 0;
+    for (char c : body) {
+        sum ^= (uint8_t)c;
+    }
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X", sum);
+    return "$" + body + tail + ending;
+}
+
+static void expectTimes(const char* what, const std::string& input, std::vector<int64_t> expected) {
+    Outcome whole = parseWhole(input);
+    Outcome reference = parseReference(input);
+    bool ok = whole.times.size() == expected.size();
+    for (size_t i = 0; ok && i < expected.size(); i++) {
+        ok = whole.times[i].utcUs == expected[i];
+    }
+    CHECK(ok, "%s: %zu times", what, whole.times.size());
+    CHECK(sameOutcome(whole, reference), "%s: reference parser disagrees", what);
+    if (!ok) {
+        printInput(input);
+        printOutcome("parser", whole);
+    }
+}
+
+static void testEdges() {
+    printf("edge cases\n");
+    const int64_t noon = parseIso("2026-06-01T12:00:00.000");
+    const std::string rmc = "GPRMC,120000.00,A,4530.0000,N,07334.2000,W,0.0,,010626,,,A";
+    expectTimes("RMC", withSum(rmc), {noon});
+    expectTimes("ZDA", withSum("GNZDA,120000.25,01,06,2026,00,00"), {noon + 250000});
+    expectTimes("no fix", withSum("GPRMC,120000.00,V,,,,,,,010626,,,N"), {});
+    expectTimes("proprietary", withSum("PxRMC,120000.00,A,,,,,,,010626,,,A"), {});
+    std::string lower = withSum("GNZDA,120000,01,06,2026,00,00", "");
+    lower.back() = (char)tolower(lower.back());
+    lower[lower.size() - 2] = (char)tolower(lower[lower.size() - 2]);
+    expectTimes("lowercase checksum", lower, {noon});
+    expectTimes("seven fraction digits", withSum("GNZDA,120000.1234567,01,06,2026,00,00"), {noon + 123456});
+    expectTimes("leap second", withSum("GNZDA,235960.00,31,12,2016,00,00"), {});
+    expectTimes("two-digit year", withSum("GPRMC,000000,A,,,,,,,010199,,,A"), {parseIso("2099-01-01T00:00:00.000")});
+    expectTimes("no line ending", withSum(rmc, "") + withSum(rmc, ""), {noon, noon});
+    expectTimes("cut off", "$GPRMC,1200" + withSum(rmc), {noon});
+    expectTimes("CR before checksum", "$GPRMC,120000.00,A\r\n" + withSum(rmc), {noon});
+    expectTimes("bad checksum", "$" + rmc + "*00\r\n", {});
+
+    // MAX_SENTENCE counts '$' to the last checksum digit: a body of
+    // MAX_SENTENCE - 4 bytes fits, one more doesn't
+    std::string padded = rmc + ",";
+    padded += std::string(NmeaParser::MAX_SENTENCE - 4 - padded.size(), 'X');
+    expectTimes("longest sentence", withSum(padded), {noon});
+    expectTimes("one byte too long", withSum(padded + "X") + withSum(rmc), {noon});
+}
+
+// ==================== Fuzz ====================
+static const char INTERESTING[] = "$*,.\r\n0123456789AVPZRMCDa";
+
+static void mutate(std::string& s) {
+    if (s.empty()) {
+        s.push_back('$');
+        return;
+    }
+    size_t at = randomBelow((uint32_t)s.size());
+    switch (randomBelow(7)) {
+        case 0:
+            s[at] ^= (char)(1u << randomBelow(8));
+            break;
+        case 1:
+            s[at] = INTERESTING[randomBelow(sizeof(INTERESTING) - 1)];
+            break;
+        case 2:
+            s.insert(s.begin() + at, INTERESTING[randomBelow(sizeof(INTERESTING) - 1)]);
+            break;
+        case 3:
+            s.erase(at, 1 + randomBelow(4));
+            break;
+        case 4:
+            s.resize(at);
+            break;
+        case 5: {
+            // A run of digits, to push fields past their lengths
+            size_t n = 1 + randomBelow(8);
+            for (size_t i = 0; i < n; i++) {
+                s.insert(s.begin() + at, (char)('0' + randomBelow(10)));
+            }
+            break;
+        }
+        default: {
+            // A piece of the string repeated elsewhere
+            size_t from = randomBelow((uint32_t)s.size());
+            size_t n = std::min((size_t)1 + randomBelow(24), s.size() - from);
+            s.insert(at, s.substr(from, n));
+            break;
+        }
+    }
+}
+
+// Rewrites every "*hh" to match the bytes since the '$' before it
+static void fixChecksums(std::string& s) {
+    size_t dollar = std::string::npos;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '$') {
+            dollar = i;
+            sum = 0;
+        } else if (s[i] == '*' && dollar != std::string::npos) {
+            if (i + 2 < s.size()) {
+                char hex[3];
+                snprintf(hex, sizeof(hex), "%02X", sum);
+                s[i + 1] = hex[0];
+                s[i + 2] = hex[1];
+            }
+            dollar = std::string::npos;
+        } else if (dollar != std::string::npos) {
+            sum ^= (uint8_t)s[i];
+        }
+    }
+}
+
+static void testFuzz(const std::vector<std::string>& sentences) {
+    printf("fuzz\n");
+    if (sentences.empty()) {
+        return;
+    }
+    uint32_t mismatches = 0;
+    uint64_t times = 0;
+    uint64_t bytes = 0;
+    for (uint32_t round = 0; round < FUZZ_ROUNDS; round++) {
+        std::string input;
+        uint32_t pieces = 1 + randomBelow(4);
+        for (uint32_t p = 0; p < pieces; p++) {
+            std::string s = sentences[randomBelow((uint32_t)sentences.size())];
+            uint32_t mutations = randomBelow(4);
+            for (uint32_t m = 0; m < mutations; m++) {
+                mutate(s);
+            }
+            if (randomBelow(2)) {
+                fixChecksums(s);
+            }
+            input += s;
+            switch (randomBelow(4)) {
+                case 0:
+                    break;
+                case 1:
+                    input += "\n";
+                    break;
+                default:
+                    input += "\r\n";
+                    break;
+            }
+            if (randomBelow(16) == 0) {
+                // Binary frame bytes between sentences
+                for (uint32_t n = randomBelow(32); n > 0; n--) {
+                    input.push_back((char)nextRandom());
+                }
+            }
+        }
+
+        Outcome reference = parseReference(input);
+        Outcome whole = parseWhole(input);
+        Outcome ring = parseRing(input, 1 + randomBelow(32));
+        bytes += input.size();
+        times += reference.times.size();
+        if (!sameOutcome(reference, whole) || !sameOutcome(reference, ring)) {
+            if (++mismatches <= 3) {
+                printf("  mismatch in round %u\n", round);
+                printInput(input);
+                printOutcome("reference", reference);
+                printOutcome("whole", whole);
+                printOutcome("ring", ring);
+            }
+        }
+    }
+    printf("  %u inputs, %llu bytes, %llu times decoded, %u mismatches\n", FUZZ_ROUNDS,
+           (unsigned long long)bytes, (unsigned long long)times, mismatches);
+    CHECK(mismatches == 0, "%u inputs parsed differently", mismatches);
+}
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "tools/nmea";
+    std::vector<std::string> sentences;
+    testStreams(dir, sentences);
+    testEdges();
+    testFuzz(sentences);
+    printf(failures ? "FAILED (%d)\n" : "ok\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+// NtpClient against stand-in SNTP servers on 127.0.0.1 that hold each
+// request and reply for a set time per direction (delay and asymmetry),
+// stamp with a skewed clock (falsetickers), stay silent, or claim to be
+// unsynchronized. Each case runs one real sync round (about a second) and
+// checks which servers survive selection and the combined offset. Exits
+// non-zero on a failure. Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc tools/ntp_test.cpp src/NtpClient.cpp -o ntp_test
+//   ./ntp_test
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "NtpClient.h"
+
+static const int64_t NTP_UNIX_DELTA_S = 2208988800LL;
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static int64_t wallUs() {
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static uint32_t steadyMs() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void writeTimestamp(uint8_t* p, int64_t unixUs) {
+    uint64_t secs = (uint64_t)(unixUs / 1000000 + NTP_UNIX_DELTA_S);
+    uint64_t frac = ((uint64_t)(unixUs % 1000000) << 32) / 1000000;
+    uint64_t ts = (secs << 32) | frac;
+    for (uint8_t i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(ts >> (56 - 8 * i));
+    }
+}
+
+// One server and the path to it. A request is stamped outUs after it was
+// sent, the reply arrives backUs after that; the server's clock is skewUs off.
+struct StandIn {
+    int64_t outUs;
+    int64_t backUs;
+    int64_t skewUs;
+    bool mute;
+    bool unsynced;
+
+    int sock;
+    uint16_t port;
+    struct Pending {
+        sockaddr_in to;
+        uint8_t packet[48];
+        int64_t stampAt;
+        int64_t sendAt;  // 0 until stamped
+    };
+    std::vector<Pending> pending;
+
+    StandIn(int64_t out, int64_t back, int64_t skew = 0, bool silent = false, bool unsync = false)
+        : outUs(out), backUs(back), skewUs(skew), mute(silent), unsynced(unsync), sock(-1), port(0) {}
+
+    bool open() {
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            getsockname(sock, (sockaddr*)&addr, &len) != 0) {
+            return false;
+        }
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+        port = ntohs(addr.sin_port);
+        return true;
+    }
+
+    void close() {
+        if (sock >= 0) {
+            ::close(sock);
+        }
+    }
+
+    void service() {
+        for (;;) {
+            Pending p;
+            socklen_t fromLen = sizeof(p.to);
+            ssize_t len = recvfrom(sock, p.packet, sizeof(p.packet), 0, (sockaddr*)&p.to, &fromLen);
+            if (len < 0) {
+                break;
+            }
+            if (len == sizeof(p.packet) && !mute) {
+                p.stampAt = wallUs() + outUs;
+                p.sendAt = 0;
+                pending.push_back(p);
+            }
+        }
+
+        int64_t now = wallUs();
+        for (size_t i = 0; i < pending.size();) {
+            Pending& p = pending[i];
+            if (p.sendAt == 0 && now >= p.stampAt) {
+                uint8_t reply[48];
+                memset(reply, 0, sizeof(reply));
+                reply[0] = (uint8_t)(((unsynced ? 3 : 0) << 6) | (4 << 3) | 4);
+                reply[1] = 1;
+                memcpy(reply + 24, p.packet + 40, 8);
+                writeTimestamp(reply + 32, now + skewUs);
+                writeTimestamp(reply + 40, now + skewUs + 20);
+                memcpy(p.packet, reply, sizeof(reply));
+                p.sendAt = now + backUs;
+            }
+            if (p.sendAt != 0 && now >= p.sendAt) {
+                sendto(sock, p.packet, sizeof(p.packet), 0, (const sockaddr*)&p.to, sizeof(p.to));
+                pending.erase(pending.begin() + (long)i);
+                continue;
+            }
+            i++;
+        }
+    }
+};
+
+// One sync round against the given servers
+static NtpClient::Result runRound(std::vector<StandIn>& servers) {
+    std::vector<std::string> specs;
+    for (StandIn& s : servers) {
+        if (!s.open()) {
+            printf("  cannot open a stand-in socket\n");
+            failures++;
+            return NtpClient::Result{};
+        }
+        specs.push_back("127.0.0.1:" + std::to_string(s.port));
+    }
+    const char* names[NTP_MAX_SERVERS];
+    for (size_t i = 0; i < specs.size(); i++) {
+        names[i] = specs[i].c_str();
+    }
+
+    NtpClient client;
+    client.begin(names, (uint8_t)specs.size());
+    uint32_t start = steadyMs();
+    client.startSync(start);
+    bool done = false;
+    while (!done && steadyMs() - start < 10000) {
+        for (StandIn& s : servers) {
+            s.service();
+        }
+        done = client.update(steadyMs());
+        usleep(100);
+    }
+    client.end();
+    for (StandIn& s : servers) {
+        s.close();
+    }
+    CHECK(done, "round did not finish");
+    return client.lastResult();
+}
+
+static void report(const char* name, const NtpClient::Result& r) {
+    printf("%-28s valid %d, servers %u, survivors %u, offset %+8.3f ms, delay %6.3f ms\n", name,
+           r.valid, r.servers, r.survivors, r.offsetUs / 1e3, r.delayUs / 1e3);
+}
+
+static int64_t absUs(int64_t v) {
+    return v < 0 ? -v : v;
+}
+
+int main() {
+    {
+        // Honest servers at different distances
+        std::vector<StandIn> s = {StandIn(1000, 1000), StandIn(3000, 3000), StandIn(8000, 8000)};
+        NtpClient::Result r = runRound(s);
+        report("symmetric", r);
+        CHECK(r.valid && r.servers == 3 && r.survivors == 3, "all three should survive");
+        CHECK(absUs(r.offsetUs) < 1000, "offset %lld us", (long long)r.offsetUs);
+    }
+    {
+        // A server 250 ms off: outside every honest interval
+        std::vector<StandIn> s = {StandIn(1000, 1000), StandIn(2000, 2000, 250000), StandIn(3000, 3000)};
+        NtpClient::Result r = runRound(s);
+        report("one skewed by +250 ms", r);
+        CHECK(r.valid && r.servers == 3 && r.survivors == 2, "the skewed server should be rejected");
+        CHECK(absUs(r.offsetUs) < 1000, "offset %lld us", (long long)r.offsetUs);
+    }
+    {
+        // 24 ms out, 1 ms back: that server reads +11.5 ms. Its interval
+        // still overlaps the others, but its midpoint lies outside their
+        // intersection, so selection drops it rather than averaging it in
+        std::vector<StandIn> s = {StandIn(1000, 1000), StandIn(2000, 2000), StandIn(24000, 1000)};
+        NtpClient::Result r = runRound(s);
+        report("one asymmetric path", r);
+        CHECK(r.valid && r.servers == 3 && r.survivors == 2, "the asymmetric server should be dropped");
+        CHECK(absUs(r.offsetUs) < 1000, "offset %lld us", (long long)r.offsetUs);
+    }
+    {
+        // Skewed the same way on every server: nothing to detect, offset follows
+        std::vector<StandIn> s = {StandIn(1000, 1000, 40000), StandIn(2000, 2000, 40000),
+                                  StandIn(3000, 3000, 40000)};
+        NtpClient::Result r = runRound(s);
+        report("all +40 ms", r);
+        CHECK(r.valid && r.survivors == 3, "consistent servers all survive");
+        CHECK(absUs(r.offsetUs - 40000) < 1000, "offset %lld us", (long long)r.offsetUs);
+    }
+    {
+        // Two of three wrong in different directions: no majority agrees
+        std::vector<StandIn> s = {StandIn(1000, 1000), StandIn(2000, 2000, 250000),
+                                  StandIn(3000, 3000, -300000)};
+        NtpClient::Result r = runRound(s);
+        report("two of three skewed", r);
+        CHECK(!r.valid, "no majority, the round must fail");
+    }
+    {
+        // Four configured: one mute (times out), one 1 s behind
+        std::vector<StandIn> s = {StandIn(1000, 1000), StandIn(2000, 2000), StandIn(1000, 1000, 0, true),
+                                  StandIn(1500, 1500, -1000000)};
+        NtpClient::Result r = runRound(s);
+        report("mute + skewed by -1 s", r);
+        CHECK(r.valid && r.servers == 3 && r.survivors == 2, "mute ignored, skewed rejected");
+        CHECK(absUs(r.offsetUs) < 1000, "offset %lld us", (long long)r.offsetUs);
+    }
+    {
+        // Leap indicator 3: replies are dropped like the mute server's
+        std::vector<StandIn> s = {StandIn(1000, 1000), StandIn(2000, 2000, 0, false, true),
+                                  StandIn(3000, 3000)};
+        NtpClient::Result r = runRound(s);
+        report("one unsynchronized", r);
+        CHECK(r.valid && r.servers == 2 && r.survivors == 2, "the unsynchronized server is not used");
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
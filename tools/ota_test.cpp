@@ -0,0 +1,378 @@
+// OtaUpdater against a simulated partition. The stand-in flash keeps
+// every byte written and enforces what PartitionWriter promises
+// EspOtaWriter: sequential, chunk-aligned writes of OTA_CHUNK_SIZE with
+// only the last one short, nothing written twice, nothing past capacity()
+// and nothing after finish() or abort(). Each case checks the result, the
+// error and which writer calls were made. SHA-256 is checked against the
+// FIPS 180-4 examples first. Exits non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc -o ota_test
+//       tools/ota_test.cpp src/OtaUpdater.cpp src/Sha256.cpp src/HttpRequestParser.cpp
+//   ./ota_test
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "OtaUpdater.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static const uint32_t PARTITION_SIZE = 1536 * 1024;
+
+class SimPartition : public PartitionWriter {
+public:
+    SimPartition() : flash(PARTITION_SIZE, 0xFF) { reset(); }
+
+    void reset() {
+        begins = writes = finishes = aborts = violations = 0;
+        open = bootable = shortSeen = false;
+        next = 0;
+        failWriteAt = UINT32_MAX;
+        rejectImage = false;
+        written.assign(PARTITION_SIZE / OTA_CHUNK_SIZE + 1, false);
+    }
+
+    uint32_t capacity() override { return PARTITION_SIZE; }
+
+    bool begin() override {
+        violate(open, "begin() while open");
+        begins++;
+        open = true;
+        bootable = shortSeen = false;
+        next = 0;
+        written.assign(written.size(), false);
+        return true;
+    }
+
+    bool write(uint32_t offset, const uint8_t* data, size_t len) override {
+        writes++;
+        violate(!open, "write() while closed");
+        violate(offset != next, "write at %u, expected %u", (unsigned)offset, (unsigned)next);
+        violate(offset % OTA_CHUNK_SIZE != 0, "unaligned write at %u", (unsigned)offset);
+        violate(len == 0 || len > OTA_CHUNK_SIZE, "write of %zu bytes", len);
+        violate(shortSeen, "write after a short one");
+        violate(offset + len > PARTITION_SIZE, "write past the end");
+        if (offset + len > PARTITION_SIZE || offset % OTA_CHUNK_SIZE != 0) {
+            return false;
+        }
+        if (offset >= failWriteAt) {
+            return false;
+        }
+        // One sector erased per write, as sequential mode does
+        size_t sector = offset / OTA_CHUNK_SIZE;
+        violate(written[sector], "sector %zu written twice", sector);
+        written[sector] = true;
+        memcpy(flash.data() + offset, data, len);
+        shortSeen = len < OTA_CHUNK_SIZE;
+        next = offset + (uint32_t)len;
+        return true;
+    }
+
+    bool finish() override {
+        violate(!open, "finish() while closed");
+        finishes++;
+        open = false;
+        bootable = !rejectImage;
+        return bootable;
+    }
+
+    void abort() override {
+        violate(!open, "abort() while closed");
+        aborts++;
+        open = false;
+    }
+
+    bool holds(const std::vector<uint8_t>& image) const {
+        return memcmp(flash.data(), image.data(), image.size()) == 0;
+    }
+
+    std::vector<uint8_t> flash;
+    std::vector<bool> written;
+    uint32_t begins, writes, finishes, aborts, violations;
+    bool open, bootable, shortSeen;
+    uint32_t next;
+    uint32_t failWriteAt;  // Writes at or past this offset fail
+    bool rejectImage;      // finish() refuses the image
+
+private:
+    template <typename... Args>
+    void violate(bool broken, const char* fmt, Args... args) {
+        if (broken) {
+            printf("  writer: ");
+            printf(fmt, args...);
+            printf("\n");
+            violations++;
+        }
+    }
+};
+
+static std::vector<uint8_t> makeImage(size_t size, uint32_t seed) {
+    std::vector<uint8_t> image(size);
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        image[i] = (uint8_t)(seed >> 24);
+    }
+    return image;
+}
+
+static void digestOf(const std::vector<uint8_t>& data, uint8_t digest[Sha256::DIGEST_SIZE]) {
+    Sha256 sha;
+    sha.update(data.data(), data.size());
+    sha.finish(digest);
+}
+
+static void toHex(const uint8_t digest[Sha256::DIGEST_SIZE], char hex[2 * Sha256::DIGEST_SIZE + 1]) {
+    for (size_t i = 0; i < Sha256::DIGEST_SIZE; i++) {
+        snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+    }
+}
+
+// Feeds the image in uneven pieces through write(), or through
+// reserve()/commit() the way StatusServer receives it
+static bool upload(OtaUpdater& ota, const std::vector<uint8_t>& image, size_t upTo, bool zeroCopy) {
+    static const size_t PIECES[] = {1, 1460, 4095, 4096, 4097, 700, 13000};
+    size_t at = 0;
+    for (size_t i = 0; at < upTo; i++) {
+        size_t piece = PIECES[i % (sizeof(PIECES) / sizeof(PIECES[0]))];
+        piece = piece < upTo - at ? piece : upTo - at;
+        if (zeroCopy) {
+            size_t room;
+            uint8_t* dst = ota.reserve(room);
+            piece = piece < room ? piece : room;
+            if (piece == 0) {
+                return false;
+            }
+            memcpy(dst, image.data() + at, piece);
+            if (!ota.commit(piece)) {
+                return false;
+            }
+        } else if (!ota.write(image.data() + at, piece)) {
+            return false;
+        }
+        at += piece;
+    }
+    return true;
+}
+
+static void shaVectors() {
+    struct Vector {
+        const char* message;
+        size_t repeat;
+        const char* digest;
+    };
+    static const Vector VECTORS[] = {
+        {"", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {"a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+    };
+    for (const Vector& v : VECTORS) {
+        Sha256 sha;
+        for (size_t i = 0; i < v.repeat; i++) {
+            sha.update((const uint8_t*)v.message, strlen(v.message));
+        }
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        uint8_t expected[Sha256::DIGEST_SIZE];
+        sha.finish(digest);
+        CHECK(Sha256::parseHex(v.digest, expected), "parse %s", v.digest);
+        CHECK(memcmp(digest, expected, sizeof(digest)) == 0, "sha256 of \"%.8s\" x %zu", v.message, v.repeat);
+    }
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    CHECK(!Sha256::parseHex("abc", digest), "short hex accepted");
+    CHECK(!Sha256::parseHex("g3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", digest),
+          "bad digit accepted");
+    CHECK(!Sha256::parseHex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b85500", digest),
+          "long hex accepted");
+    printf("sha256 vectors\n");
+}
+
+static void goodImage(const char* name, size_t size, bool zeroCopy) {
+    SimPartition part;
+    OtaUpdater ota(part);
+    std::vector<uint8_t> image = makeImage(size, (uint32_t)size);
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    digestOf(image, digest);
+
+    CHECK(ota.begin((uint32_t)size, digest), "%s: begin", name);
+    CHECK(upload(ota, image, size, zeroCopy), "%s: upload", name);
+    CHECK(ota.finish(), "%s: finish, %s", name, ota.error());
+    uint32_t chunks = (uint32_t)((size + OTA_CHUNK_SIZE - 1) / OTA_CHUNK_SIZE);
+    CHECK(ota.succeeded() && part.bootable && part.holds(image), "%s: image not in place", name);
+    CHECK(part.writes == chunks, "%s: %u writes for %u chunks", name, (unsigned)part.writes, (unsigned)chunks);
+    CHECK(part.begins == 1 && part.finishes == 1 && part.aborts == 0 && part.violations == 0,
+          "%s: begins %u finishes %u aborts %u violations %u", name, (unsigned)part.begins,
+          (unsigned)part.finishes, (unsigned)part.aborts, (unsigned)part.violations);
+    printf("%-28s %7zu bytes, %u writes\n", name, size, (unsigned)part.writes);
+}
+
+// An upload that must fail with `error`; `setup` breaks it
+template <typename Setup>
+static void badImage(const char* name, OtaUpdater::Error error, bool writerOpened, Setup setup) {
+    SimPartition part;
+    OtaUpdater ota(part);
+    size_t size = 300000;
+    std::vector<uint8_t> image = makeImage(size, 7);
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    digestOf(image, digest);
+    setup(ota, part, image, digest);
+    CHECK(!ota.succeeded() && !ota.active() && !part.bootable, "%s: must not succeed", name);
+    CHECK(ota.getError() == error, "%s: error \"%s\"", name, ota.error());
+    CHECK(part.begins == (writerOpened ? 1u : 0u) && !part.open && part.violations == 0,
+          "%s: begins %u open %d violations %u", name, (unsigned)part.begins, part.open, (unsigned)part.violations);
+    printf("%-28s %s\n", name, ota.error());
+}
+
+static void badImages() {
+    using O = OtaUpdater;
+    badImage("bad hash", O::ERROR_HASH_MISMATCH, true, [](O& ota, SimPartition& part, auto& image, uint8_t* d) {
+        d[5] ^= 1;
+        ota.begin((uint32_t)image.size(), d);
+        upload(ota, image, image.size(), true);
+        ota.finish();
+        CHECK(part.aborts == 1 && part.finishes == 0, "bad hash: writer not aborted");
+    });
+    badImage("truncated", O::ERROR_SIZE_MISMATCH, true, [](O& ota, SimPartition& part, auto& image, uint8_t* d) {
+        ota.begin((uint32_t)image.size(), d);
+        upload(ota, image, image.size() - 1, false);
+        ota.finish();
+        CHECK(part.aborts == 1 && part.finishes == 0, "truncated: writer not aborted");
+    });
+    badImage("overrun", O::ERROR_SIZE_MISMATCH, true, [](O& ota, SimPartition& part, auto& image, uint8_t* d) {
+        ota.begin((uint32_t)image.size() - 10, d);
+        CHECK(!upload(ota, image, image.size(), true), "overrun accepted");
+        CHECK(part.aborts == 1, "overrun: writer not aborted");
+    });
+    badImage("too large", O::ERROR_TOO_LARGE, false, [](O& ota, SimPartition&, auto&, uint8_t* d) {
+        ota.begin(PARTITION_SIZE + 1, d);
+    });
+    badImage("empty", O::ERROR_BAD_REQUEST, false, [](O& ota, SimPartition&, auto&, uint8_t* d) {
+        ota.begin(0, d);
+    });
+    badImage("flash write fails", O::ERROR_WRITE_FAILED, true,
+             [](O& ota, SimPartition& part, auto& image, uint8_t* d) {
+                 part.failWriteAt = 5 * OTA_CHUNK_SIZE;
+                 ota.begin((uint32_t)image.size(), d);
+                 CHECK(!upload(ota, image, image.size(), false), "write failure ignored");
+                 size_t room;
+                 ota.reserve(room);
+                 CHECK(part.aborts == 1 && room == 0, "write failure: not aborted");
+             });
+    badImage("image rejected", O::ERROR_FINISH_FAILED, true,
+             [](O& ota, SimPartition& part, auto& image, uint8_t* d) {
+                 part.rejectImage = true;
+                 ota.begin((uint32_t)image.size(), d);
+                 upload(ota, image, image.size(), true);
+                 ota.finish();
+                 CHECK(part.finishes == 1 && part.aborts == 0, "rejected: finishes %u", (unsigned)part.finishes);
+             });
+    badImage("interrupted", O::ERROR_ABORTED, true, [](O& ota, SimPartition& part, auto& image, uint8_t* d) {
+        ota.begin((uint32_t)image.size(), d);
+        upload(ota, image, image.size() / 2, true);
+        ota.abort();
+        size_t room;
+        ota.reserve(room);
+        CHECK(room == 0 && part.aborts == 1, "interrupted: room %zu", room);
+    });
+}
+
+// A second begin() while one runs is refused and leaves the first alone
+static void busy() {
+    SimPartition part;
+    OtaUpdater ota(part);
+    std::vector<uint8_t> image = makeImage(50000, 3);
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    digestOf(image, digest);
+    CHECK(ota.begin((uint32_t)image.size(), digest), "busy: first begin");
+    upload(ota, image, 20000, true);
+    CHECK(!ota.begin(1000, digest) && ota.getError() == OtaUpdater::ERROR_BUSY, "busy: second begin \"%s\"",
+          ota.error());
+    CHECK(ota.write(image.data() + 20000, image.size() - 20000) && ota.finish() && part.holds(image),
+          "busy: first upload disturbed, %s", ota.error());
+    CHECK(part.begins == 1 && part.violations == 0, "busy: writer begun %u times", (unsigned)part.begins);
+    printf("%-28s %s\n", "second begin while running", "busy");
+
+    // And the next one starts over cleanly
+    std::vector<uint8_t> next = makeImage(70000, 4);
+    digestOf(next, digest);
+    CHECK(ota.begin((uint32_t)next.size(), digest) && upload(ota, next, next.size(), true) && ota.finish() &&
+              part.holds(next) && part.begins == 2 && part.violations == 0,
+          "next upload: %s", ota.error());
+}
+
+// POST /update through start(): the token is checked before anything else
+static void tokens() {
+    std::vector<uint8_t> image = makeImage(10000, 9);
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    digestOf(image, digest);
+    char hex[2 * Sha256::DIGEST_SIZE + 1];
+    toHex(digest, hex);
+
+    struct Case {
+        const char* name;
+        const char* configured;
+        const char* query;  // %s is the digest
+        OtaUpdater::Error error;
+        uint16_t status;
+    };
+    const Case CASES[] = {
+        {"no token set, none sent", "", "sha256=%s", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"no token set, empty sent", "", "sha256=%s&token=", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"token missing", "s3cret", "sha256=%s", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"token wrong", "s3cret", "sha256=%s&token=s3creT", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"token a prefix", "s3cret", "sha256=%s&token=s3cre", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"token too long", "s3cret", "sha256=%s&token=s3crets", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"bad token, bad hash", "s3cret", "sha256=zz&token=nope", OtaUpdater::ERROR_FORBIDDEN, 403},
+        {"token right, bad hash", "s3cret", "sha256=zz&token=s3cret", OtaUpdater::ERROR_BAD_REQUEST, 400},
+        {"token right", "s3cret", "token=s3cret&sha256=%s", OtaUpdater::ERROR_NONE, 200},
+    };
+    for (const Case& c : CASES) {
+        SimPartition part;
+        OtaUpdater ota(part);
+        ota.setToken(c.configured);
+        char query[160];
+        snprintf(query, sizeof(query), c.query, hex);
+        char head[320];
+        int n = snprintf(head, sizeof(head), "POST /update?%s HTTP/1.1\r\nContent-Length: %zu\r\n\r\n", query,
+                         image.size());
+        HttpRequestParser req;
+        CHECK(req.feed(head, (size_t)n) == HttpRequestParser::COMPLETE, "%s: request", c.name);
+        bool started = ota.start(req);
+        uint16_t status = started ? 200 : ota.rejectStatus();
+        printf("%-28s %u %s\n", c.name, (unsigned)status, started ? "" : ota.error());
+        CHECK(started == (c.error == OtaUpdater::ERROR_NONE) && ota.getError() == c.error && status == c.status,
+              "%s: %u \"%s\"", c.name, (unsigned)status, ota.error());
+        CHECK(part.begins == (started ? 1u : 0u), "%s: writer begun %u times", c.name, (unsigned)part.begins);
+        if (started) {
+            CHECK(upload(ota, image, image.size(), true) && ota.finish() && part.holds(image), "%s: upload",
+                  c.name);
+        }
+    }
+}
+
+int main() {
+    shaVectors();
+
+    goodImage("1 MB with a short tail", 1024 * 1024 + 1234, false);
+    goodImage("zero copy", 1024 * 1024 + 1234, true);
+    goodImage("whole chunks", 64 * OTA_CHUNK_SIZE, true);
+    goodImage("one byte", 1, true);
+    goodImage("fills the partition", PARTITION_SIZE, false);
+
+    badImages();
+    busy();
+    tokens();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+// Per-call cost of the automatic dimming schedule, as updateAutoBrightness()
+// uses it on every loop pass: update() with the local time, which only
+// recomputes on a new day, then dayFactor(). "new day" forces the
+// recompute (the trigonometry) on every call, which is what the cache saves.
+// Times are a year of loop passes at Montreal, the config.h default.
+// Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -Isrc tools/solar_bench.cpp src/SolarSchedule.cpp -o solar_bench
+//   ./solar_bench [passes]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+#include <vector>
+#include "SolarSchedule.h"
+
+static const float LATITUDE = 45.50f;
+static const float LONGITUDE = -73.57f;
+static const uint16_t TWILIGHT_MIN = 60;
+
+template <typename Fn>
+static double nsPerCall(size_t calls, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double)calls;
+}
+
+int main(int argc, char** argv) {
+    size_t passes = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+
+    // Evenly spread over 2026, local time prepared up front so only the
+    // schedule is timed
+    setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+    tzset();
+    const time_t start = 1767225600;  // 2026-01-01T00:00:00Z
+    const time_t step = (time_t)(365 * 86400 / passes) + 1;
+    std::vector<time_t> times(passes);
+    std::vector<struct tm> locals(passes);
+    for (size_t i = 0; i < passes; i++) {
+        times[i] = start + (time_t)i * step;
+        localtime_r(&times[i], &locals[i]);
+    }
+
+    float sink = 0;
+    SolarSchedule cached(LATITUDE, LONGITUDE, TWILIGHT_MIN);
+    double passNs = nsPerCall(passes, [&]() {
+        for (size_t i = 0; i < passes; i++) {
+            cached.update(locals[i]);
+            sink += cached.dayFactor(times[i]);
+        }
+    });
+
+    double factorNs = nsPerCall(passes, [&]() {
+        for (size_t i = 0; i < passes; i++) {
+            sink += cached.dayFactor(times[i]);
+        }
+    });
+
+    SolarSchedule uncached(LATITUDE, LONGITUDE, TWILIGHT_MIN);
+    double newDayNs = nsPerCall(passes, [&]() {
+        for (size_t i = 0; i < passes; i++) {
+            uncached.invalidate();
+            uncached.update(locals[i]);
+            sink += uncached.dayFactor(times[i]);
+        }
+    });
+
+    printf("%zu passes over 2026, %ld s apart\n\n", passes, (long)step);
+    printf("update + dayFactor, cached   %8.2f ns per pass\n", passNs);
+    printf("dayFactor alone              %8.2f ns per call\n", factorNs);
+    printf("update + dayFactor, new day  %8.2f ns per pass\n", newDayNs);
+    if (sink < 0) {
+        printf("?");
+    }
+    return 0;
+}
@@ -0,0 +1,228 @@
+// SolarSchedule against almanac sunrise/sunset for Montreal (the config.h
+// default) and against the polar day and night at Tromsø and McMurdo. Every
+// day of the year is also checked against the longer NOAA spreadsheet
+// algorithm (Julian centuries, apparent longitude), which the class
+// approximates with a fractional-year series. Exits non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isrc tools/solar_test.cpp src/SolarSchedule.cpp -o solar_test
+//   ./solar_test
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "SolarSchedule.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static const double RAD = M_PI / 180.0;
+
+struct Place {
+    const char* name;
+    float latitude;
+    float longitude;
+    const char* tz;
+};
+
+static const Place MONTREAL = {"Montreal", 45.50f, -73.57f, "EST5EDT,M3.2.0,M11.1.0"};
+static const Place TROMSO = {"Tromso", 69.65f, 18.96f, "CET-1CEST,M3.5.0,M10.5.0/3"};
+static const Place MCMURDO = {"McMurdo", -77.85f, 166.67f, "NZST-12NZDT,M9.5.0,M4.1.0/3"};
+
+static time_t utc(int year, int month, int mday, int hour, int min) {
+    struct tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = mday;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    return timegm(&tm);
+}
+
+// Schedule updated for the place's local calendar day containing `at`
+static void updateAt(SolarSchedule& s, const Place& p, time_t at) {
+    setenv("TZ", p.tz, 1);
+    tzset();
+    struct tm local;
+    localtime_r(&at, &local);
+    s.update(local);
+}
+
+static long minutesApart(time_t a, time_t b) {
+    return labs((long)(a - b)) / 60;
+}
+
+// NOAA spreadsheet: sunrise/sunset in UTC minutes for the day starting at
+// midnightUtc; returns false on a polar day or night
+static bool reference(const Place& p, time_t midnightUtc, double& riseMin, double& setMin) {
+    double jd = midnightUtc / 86400.0 + 2440587.5 + 0.5 - p.longitude / 360.0;  // Local noon
+    double t = (jd - 2451545.0) / 36525.0;
+    double l0 = fmod(280.46646 + t * (36000.76983 + t * 0.0003032), 360.0);
+    double m = 357.52911 + t * (35999.05029 - 0.0001537 * t);
+    double e = 0.016708634 - t * (0.000042037 + 0.0000001267 * t);
+    double c = sin(m * RAD) * (1.914602 - t * (0.004817 + 0.000014 * t)) +
+               sin(2 * m * RAD) * (0.019993 - 0.000101 * t) + sin(3 * m * RAD) * 0.000289;
+    double omega = 125.04 - 1934.136 * t;
+    double lambda = l0 + c - 0.00569 - 0.00478 * sin(omega * RAD);
+    double eps0 = 23 + (26 + (21.448 - t * (46.815 + t * (0.00059 - t * 0.001813))) / 60) / 60;
+    double eps = eps0 + 0.00256 * cos(omega * RAD);
+    double decl = asin(sin(eps * RAD) * sin(lambda * RAD));
+    double y = tan(eps * RAD / 2) * tan(eps * RAD / 2);
+    double eqTime = 4 / RAD * (y * sin(2 * l0 * RAD) - 2 * e * sin(m * RAD) +
+                               4 * e * y * sin(m * RAD) * cos(2 * l0 * RAD) -
+                               0.5 * y * y * sin(4 * l0 * RAD) - 1.25 * e * e * sin(2 * m * RAD));
+    double cosHa = cos(90.833 * RAD) / (cos(p.latitude * RAD) * cos(decl)) -
+                   tan(p.latitude * RAD) * tan(decl);
+    if (cosHa > 1 || cosHa < -1) {
+        return false;
+    }
+    double noon = 720 - 4 * p.longitude - eqTime;
+    double ha = acos(cosHa) / RAD;
+    riseMin = noon - 4 * ha;
+    setMin = noon + 4 * ha;
+    return true;
+}
+
+// Almanac times (local clock time, rounded to the minute)
+static void almanac(const Place& p, int year, int month, int mday, int riseH, int riseM, int setH, int setM,
+                    int utcOffsetH) {
+    SolarSchedule s(p.latitude, p.longitude, 60);
+    updateAt(s, p, utc(year, month, mday, 12 - utcOffsetH, 0));
+    time_t rise = utc(year, month, mday, riseH - utcOffsetH, riseM);
+    time_t set = utc(year, month, mday, setH - utcOffsetH, setM);
+    long riseErr = minutesApart(s.getSunrise(), rise);
+    long setErr = minutesApart(s.getSunset(), set);
+    printf("%-9s %04d-%02d-%02d  sunrise %+3ld min, sunset %+3ld min from the almanac\n", p.name, year, month,
+           mday, (long)(s.getSunrise() - rise) / 60, (long)(s.getSunset() - set) / 60);
+    CHECK(riseErr <= 2 && setErr <= 2, "%s %d-%d", p.name, month, mday);
+}
+
+// Every day of a year against the reference; polar days must match except
+// within a day of the boundary, where the two series can disagree. In the
+// weeks around a boundary the sun grazes the horizon and a small error in
+// declination moves the times by many minutes, so those days get a wider
+// bound.
+static void wholeYear(const Place& p, int year) {
+    const int GRAZING_DAYS = 14;
+    time_t first = utc(year, 1, 1, 0, 0);
+    int days = (int)((utc(year + 1, 1, 1, 0, 0) - first) / 86400);
+    bool normalDay[400];
+    for (int d = 0; d < days; d++) {
+        double rise;
+        double set;
+        normalDay[d] = reference(p, first + (time_t)d * 86400, rise, set);
+    }
+
+    long worst = 0;
+    long worstGrazing = 0;
+    int polarDays = 0;
+    int boundaryDays = 0;
+    SolarSchedule s(p.latitude, p.longitude, 60);
+    for (int d = 0; d < days; d++) {
+        time_t day = first + (time_t)d * 86400;
+        // Local noon, so the local date is the UTC date
+        updateAt(s, p, day + 43200 - (time_t)(p.longitude * 240));
+        double riseMin;
+        double setMin;
+        bool normal = reference(p, day, riseMin, setMin);
+        bool polar = s.getSunrise() == s.getSunset();
+        if (normal != !polar) {
+            double before;
+            double after;
+            bool edge = reference(p, day - 86400, before, after) != normal ||
+                        reference(p, day + 86400, before, after) != normal;
+            CHECK(edge, "%s day %d: polar %d, reference polar %d", p.name, d, polar, !normal);
+            boundaryDays++;
+            continue;
+        }
+        if (polar) {
+            polarDays++;
+            continue;
+        }
+        long riseErr = minutesApart(s.getSunrise(), day + (time_t)(riseMin * 60));
+        long setErr = minutesApart(s.getSunset(), day + (time_t)(setMin * 60));
+        bool grazing = false;
+        for (int n = d - GRAZING_DAYS; n <= d + GRAZING_DAYS; n++) {
+            grazing = grazing || (n >= 0 && n < days && !normalDay[n]);
+        }
+        long& bound = grazing ? worstGrazing : worst;
+        bound = riseErr > bound ? riseErr : bound;
+        bound = setErr > bound ? setErr : bound;
+    }
+    printf("%-9s %d         worst %ld min from the NOAA reference (%ld near polar days), %d polar days, "
+           "%d at a boundary\n",
+           p.name, year, worst, worstGrazing, polarDays, boundaryDays);
+    // Minutes grow with latitude too, as the sun crosses the horizon at a
+    // shallower angle
+    CHECK(worst <= (fabsf(p.latitude) < 60 ? 2 : 8), "%s worst %ld min", p.name, worst);
+    CHECK(worstGrazing <= 30, "%s worst %ld min near polar days", p.name, worstGrazing);
+}
+
+// dayFactor() through one Montreal day: 0 at night, 1 at noon, 0.5 at the
+// sun times and monotonic across each twilight
+static void dayCurve() {
+    SolarSchedule s(MONTREAL.latitude, MONTREAL.longitude, 60);
+    CHECK(s.dayFactor(0) == 1.0f, "unset schedule must not dim");
+    updateAt(s, MONTREAL, utc(2026, 3, 20, 16, 0));
+    time_t rise = s.getSunrise();
+    time_t set = s.getSunset();
+    CHECK(fabsf(s.dayFactor(rise) - 0.5f) < 0.01f, "%f at sunrise", s.dayFactor(rise));
+    CHECK(fabsf(s.dayFactor(set) - 0.5f) < 0.01f, "%f at sunset", s.dayFactor(set));
+    CHECK(s.dayFactor(rise - 1800) == 0.0f && s.dayFactor(set + 1800) == 0.0f, "night outside twilight");
+    CHECK(s.dayFactor((rise + set) / 2) == 1.0f, "day at noon");
+    float last = -1;
+    bool monotonic = true;
+    for (time_t t = rise - 1800; t <= rise + 1800; t += 60) {
+        monotonic = monotonic && s.dayFactor(t) >= last;
+        last = s.dayFactor(t);
+    }
+    CHECK(monotonic, "dawn ramp must not go backwards");
+
+    // Cached within the day, recomputed on the next
+    time_t riseBefore = s.getSunrise();
+    updateAt(s, MONTREAL, utc(2026, 3, 21, 2, 0));  // Still the 20th in Montreal
+    CHECK(s.getSunrise() == riseBefore, "same local day, no recompute");
+    updateAt(s, MONTREAL, utc(2026, 3, 21, 16, 0));
+    CHECK(s.getSunrise() > riseBefore + 86000, "next day recomputed");
+}
+
+static void polar(const Place& p, int month, int mday, float expect) {
+    SolarSchedule s(p.latitude, p.longitude, 60);
+    updateAt(s, p, utc(2026, month, mday, 0, 0));
+    bool flat = true;
+    for (time_t t = utc(2026, month, mday, 0, 0); t < utc(2026, month, mday + 1, 0, 0); t += 600) {
+        flat = flat && s.dayFactor(t) == expect;
+    }
+    printf("%-9s 2026-%02d-%02d  %s all day\n", p.name, month, mday, expect > 0 ? "day" : "night");
+    CHECK(flat, "%s %d-%d should be %s all day", p.name, month, mday, expect > 0 ? "day" : "night");
+}
+
+int main() {
+    // Montreal solstices, published local times
+    almanac(MONTREAL, 2026, 6, 21, 5, 5, 20, 47, -4);
+    almanac(MONTREAL, 2026, 12, 21, 7, 31, 16, 13, -5);
+
+    polar(TROMSO, 12, 21, 0.0f);
+    polar(TROMSO, 6, 21, 1.0f);
+    polar(MCMURDO, 12, 21, 1.0f);
+    polar(MCMURDO, 6, 21, 0.0f);
+
+    wholeYear(MONTREAL, 2026);
+    wholeYear(MONTREAL, 2028);  // Leap year
+    wholeYear(TROMSO, 2026);
+    wholeYear(MCMURDO, 2026);
+
+    dayCurve();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+// SyncStats with the offsets a boot really produces: a step of decades from
+// 1970, then slewed offsets of milliseconds, a step back after an outage and
+// more slewing. The step must come back as measured, past 32 bits, and be
+// flagged; jitter must only count pairs of slewed offsets; the serial report
+// must print the full value. Exits non-zero on a failure:
+//
+//   g++ -O2 -std=gnu++17 -Isim -Isrc -o sync_stats_test
+//       tools/sync_stats_test.cpp src/SyncStats.cpp
+//   ./sync_stats_test
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <Arduino.h>
+#include "SyncStats.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("  FAIL line %d: %s: ", __LINE__, #cond);              \
+            printf(__VA_ARGS__);                                          \
+            printf("\n");                                                 \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+// ==================== Platform ====================
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return n > 0 ? write((const uint8_t*)buf, strnlen(buf, sizeof(buf))) : 0;
+}
+
+struct Capture : Print {
+    std::string text;
+    size_t write(uint8_t c) override {
+        text += (char)c;
+        return 1;
+    }
+    using Print::write;
+};
+
+// ==================== Cases ====================
+// 2026-03-06T12:00:00Z less the 2.6 s since boot, as the first NTP round sees it
+static const int64_t BOOT_STEP_US = 1772798399999162LL;
+
+static std::string report(const SyncStats& stats, uint32_t nowMs) {
+    Capture out;
+    stats.printReport(out, nowMs);
+    return out.text;
+}
+
+static void testBootStep() {
+    printf("boot step\n");
+    SyncStats stats;
+    CHECK(!stats.lastStepped() && stats.lastOffsetUs() == 0, "stepped before any sync");
+    CHECK(report(stats, 0) == "Sync: never synced, 0 failures\n", "%s", report(stats, 0).c_str());
+
+    stats.recordSuccess(BOOT_STEP_US, 14970, 2596);
+    CHECK(stats.lastOffsetUs() == BOOT_STEP_US, "offset %lld, want %lld", (long long)stats.lastOffsetUs(),
+          (long long)BOOT_STEP_US);
+    CHECK(stats.lastStepped(), "boot step not flagged");
+    CHECK(stats.jitterUs() == 0, "jitter %u from one sample", (unsigned)stats.jitterUs());
+    std::string text = report(stats, 12596);
+    CHECK(text == "Sync: offset 1772798399999162 us (stepped), delay 14970 us, jitter 0 us, age 10 s, "
+                  "ok 1, failed 0 (0 in a row)\n",
+          "%s", text.c_str());
+
+    stats.recordSuccess(-BOOT_STEP_US, 0, 3000);
+    CHECK(stats.lastOffsetUs() == -BOOT_STEP_US && stats.lastStepped(), "negative step %lld",
+          (long long)stats.lastOffsetUs());
+}
+
+static void testThreshold() {
+    printf("threshold\n");
+    SyncStats stats;
+    const int64_t cases[][2] = {
+        {NTP_STEP_THRESHOLD_US - 1, 0},  {NTP_STEP_THRESHOLD_US, 1},   {-NTP_STEP_THRESHOLD_US + 1, 0},
+        {-NTP_STEP_THRESHOLD_US, 1},     {(int64_t)INT32_MAX + 1, 1}, {0, 0},
+    };
+    for (const int64_t* c : cases) {
+        stats.recordSuccess(c[0], 1000, 0);
+        CHECK(stats.lastStepped() == (c[1] != 0), "%lld: stepped %d", (long long)c[0], stats.lastStepped());
+        CHECK(stats.lastOffsetUs() == c[0], "%lld read back as %lld", (long long)c[0],
+              (long long)stats.lastOffsetUs());
+    }
+}
+
+static void testJitter() {
+    printf("jitter\n");
+    // Boot step, slewed offsets, a step back after an outage, slewed again.
+    // Only neighbouring slewed pairs count: (-1000, 1000), (1000, -500) and
+    // (300, 700).
+    SyncStats stats;
+    const int64_t offsets[] = {BOOT_STEP_US, -1000, 1000, -500, -3600000000LL, 300, 700};
+    uint32_t at = 0;
+    for (int64_t offset : offsets) {
+        stats.recordSuccess(offset, 20000, at += 3600000);
+    }
+    double want = sqrt((2000.0 * 2000.0 + 1500.0 * 1500.0 + 400.0 * 400.0) / 3);
+    CHECK(stats.jitterUs() == (uint32_t)want, "jitter %u, want %u", (unsigned)stats.jitterUs(), (unsigned)want);
+    CHECK(!stats.lastStepped() && stats.lastOffsetUs() == 700, "last %lld", (long long)stats.lastOffsetUs());
+
+    // The history keeps SYNC_STATS_HISTORY samples: push the steps out and
+    // every pair counts
+    for (uint8_t i = 0; i < SYNC_STATS_HISTORY; i++) {
+        stats.recordSuccess(i % 2 ? 100 : -100, 20000, at += 3600000);
+    }
+    CHECK(stats.jitterUs() == 200, "jitter %u over slewed offsets only", (unsigned)stats.jitterUs());
+    CHECK(stats.getSuccessCount() == 7 + SYNC_STATS_HISTORY, "%u successes",
+          (unsigned)stats.getSuccessCount());
+}
+
+int main() {
+    testBootStep();
+    testThreshold();
+    testJitter();
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+// Per-tick cost of the world clock for 1 to 4 faces, as
+// BinaryClockDisplay::drawWorld() does it: one UTC reading converted through
+// WorldClock's cached offsets, then only the columns in each face's dirty
+// mask, and in those only the flipped dots. Pixels use the compile-time
+// face geometry for the 320x170 panel. "uncached" is the conversion alone
+// done the plain way, a TZ switch and localtime_r() per zone per tick.
+// Builds on the host:
+//
+//   g++ -O2 -std=gnu++17 -Isrc tools/world_bench.cpp src/WorldClock.cpp src/ClockEncoding.cpp -o world_bench
+//   ./world_bench [days] [start-epoch]
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "ClockEncoding.h"
+#include "FaceGeometry.h"
+#include "WorldClock.h"
+
+using namespace FaceGeometry;
+
+// As WORLD_CLOCK_TZ and the display settings in config.h
+static const char* const ZONES[MAX_WORLD_FACES] = {
+    "EST5EDT,M3.2.0,M11.1.0",
+    "GMT0BST,M3.5.0/1,M10.5.0",
+    "JST-9",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+};
+static const int16_t SCREEN_W = 320;
+static const int16_t SCREEN_H = 170;
+static const int16_t CLOCK_TOP = 20;
+static const int16_t LABEL_H = 20;
+static const int16_t MAX_R = 10;
+
+static uint8_t popcount8(uint8_t v) {
+    uint8_t n = 0;
+    for (; v; v &= (uint8_t)(v - 1)) {
+        n++;
+    }
+    return n;
+}
+
+int main(int argc, char** argv) {
+    uint32_t days = argc > 1 ? (uint32_t)atoi(argv[1]) : 7;
+    time_t start = argc > 2 ? (time_t)atoll(argv[2]) : (time_t)1772755200;  // 2026-03-06 00:00Z
+    uint32_t ticks = days * 86400;
+    const ClockEncoding::Layout& bcd = ClockEncoding::layout(ClockEncoding::BCD);
+
+    printf("%u ticks from %lld\n\n", (unsigned)ticks, (long long)start);
+    printf("%5s %3s %9s %9s %9s %9s %8s %9s %8s %9s\n", "faces", "r", "cols/tick", "dots/tick",
+           "px/tick", "max px", "secs-only", "refreshes", "ns/tick", "uncached");
+
+    for (uint8_t n = 1; n <= MAX_WORLD_FACES; n++) {
+        WorldFace faces[MAX_WORLD_FACES];
+        for (uint8_t f = 0; f < n; f++) {
+            faces[f] = worldFace(n, f, SCREEN_W, CLOCK_TOP, SCREEN_H, LABEL_H, MAX_R);
+        }
+
+        WorldClock world;
+        world.begin(ZONES, n);
+        struct tm locals[MAX_WORLD_FACES];
+        uint8_t shown[MAX_WORLD_FACES][WORLD_COLUMNS];
+        world.convert(start, locals);
+        for (uint8_t f = 0; f < n; f++) {
+            ClockEncoding::Frame frame;
+            ClockEncoding::encode(ClockEncoding::BCD, locals[f], 0, frame);
+            memcpy(shown[f], frame.bits, WORLD_COLUMNS);
+        }
+
+        uint64_t columns = 0;
+        uint64_t dots = 0;
+        uint64_t pixels = 0;
+        uint32_t worst = 0;
+        uint32_t secondsOnly = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 1; i <= ticks; i++) {
+            world.convert(start + i, locals);
+            uint32_t tickPixels = 0;
+            uint8_t touched = 0;  // Columns dirty on any face
+            for (uint8_t f = 0; f < n; f++) {
+                ClockEncoding::Frame frame;
+                ClockEncoding::encode(ClockEncoding::BCD, locals[f], 0, frame);
+                for (uint8_t c = 0; c < WORLD_COLUMNS; c++) {
+                    if (frame.bits[c] == shown[f][c]) {
+                        continue;
+                    }
+                    uint8_t mask = (uint8_t)((1u << bcd.bits[c]) - 1);
+                    uint8_t flipped = popcount8((uint8_t)((frame.bits[c] ^ shown[f][c]) & mask));
+                    columns++;
+                    dots += flipped;
+                    tickPixels += flipped * faces[f].dotPixels;
+                    touched |= (uint8_t)(1u << c);
+                    shown[f][c] = frame.bits[c];
+                }
+            }
+            pixels += tickPixels;
+            worst = tickPixels > worst ? tickPixels : worst;
+            secondsOnly += (touched & 0x0F) == 0;
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+        const uint32_t plainTicks = 3600;
+        t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < plainTicks; i++) {
+            time_t now = start + i;
+            for (uint8_t f = 0; f < n; f++) {
+                setenv("TZ", ZONES[f], 1);
+                tzset();
+                localtime_r(&now, &locals[f]);
+            }
+        }
+        double plainNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+        printf("%5u %3u %9.3f %9.3f %9.1f %9u %7.1f%% %9u %8.0f %9.0f\n", (unsigned)n,
+               (unsigned)faces[0].dotR, (double)columns / ticks, (double)dots / ticks,
+               (double)pixels / ticks, (unsigned)worst, 100.0 * secondsOnly / ticks,
+               (unsigned)world.getRefreshes(), ns / ticks, plainNs / plainTicks);
+    }
+    return 0;
+}